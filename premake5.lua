@@ -95,7 +95,54 @@ project "SMLTest"
 
     filter "configurations:Debug"
         defines { 
-            "DEBUG" 
+            "DEBUG",
+            "SML_DEBUG"
+        }
+        symbols "On"
+
+    filter "configurations:Release"
+        defines { 
+            "NDEBUG" 
+        }
+        optimize "On"
+
+project "SMLBench"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++17"
+	staticruntime "on"
+
+	targetdir (binaries)
+	objdir (intermediate)
+	
+	vectorextensions "AVX"
+
+    files {
+        "smlbench/src/**.h",
+        "smlbench/src/**.cpp" 
+    }
+
+    includedirs {
+        "%{IncludeDir.SML}",
+        "smlbench/src"
+    }
+
+    filter "system:windows"
+        toolset "msc-ClangCL"
+
+    filter "system:linux"
+        toolset "clang"
+
+        links {
+            "pthread"
+        }
+
+    filter {}
+
+    filter "configurations:Debug"
+        defines { 
+            "DEBUG",
+            "SML_DEBUG"
         }
         symbols "On"
 
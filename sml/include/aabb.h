@@ -0,0 +1,502 @@
+#ifndef sml_aabb_h__
+#define sml_aabb_h__
+
+/* aabb.h -- axis aligned bounding box implementation of the 'Simple Math Library'
+  Copyright (C) 2020 Roderick Griffioen
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <cstddef>
+#include <limits>
+#include <immintrin.h>
+
+#include "smltypes.h"
+#include "common.h"
+#include "simd.h"
+#include "vec3.h"
+#include "vec4.h"
+#include "mat4.h"
+#include "strided.h"
+
+namespace sml
+{
+    template<typename T>
+    class alignas(simdalign<T>::value) aabb
+    {
+        public:
+            // Default constructed boxes are empty, expanding an empty box by a point gives that point
+            constexpr aabb() noexcept : min(std::numeric_limits<T>::infinity()), max(-std::numeric_limits<T>::infinity())
+            {
+            }
+
+            constexpr aabb(const vec3<T>& min, const vec3<T>& max) noexcept : min(min), max(max)
+            {
+            }
+
+            constexpr explicit aabb(const vec3<T>& point) noexcept : min(point), max(point)
+            {
+            }
+
+            // Operators
+            inline constexpr bool operator == (const aabb& other) const noexcept
+            {
+                return min == other.min && max == other.max;
+            }
+
+            inline constexpr bool operator != (const aabb& other) const noexcept
+            {
+                return !(*this == other);
+            }
+
+            // Operations
+            SML_NO_DISCARD inline constexpr bool empty() const noexcept
+            {
+                return min.x > max.x || min.y > max.y || min.z > max.z;
+            }
+
+            SML_NO_DISCARD inline constexpr vec3<T> center() const noexcept
+            {
+                return (min + max) * static_cast<T>(0.5);
+            }
+
+            // Half size along every axis
+            SML_NO_DISCARD inline constexpr vec3<T> extents() const noexcept
+            {
+                return (max - min) * static_cast<T>(0.5);
+            }
+
+            SML_NO_DISCARD inline constexpr vec3<T> size() const noexcept
+            {
+                return max - min;
+            }
+
+            SML_NO_DISCARD inline constexpr T surfacearea() const noexcept
+            {
+                if (empty())
+                    return static_cast<T>(0);
+
+                vec3<T> d = max - min;
+
+                return static_cast<T>(2) * (d.x * d.y + d.y * d.z + d.z * d.x);
+            }
+
+            SML_NO_DISCARD inline constexpr T volume() const noexcept
+            {
+                if (empty())
+                    return static_cast<T>(0);
+
+                vec3<T> d = max - min;
+
+                return d.x * d.y * d.z;
+            }
+
+            inline constexpr void expand(const vec3<T>& point) noexcept
+            {
+                min = vec3<T>::min(min, point);
+                max = vec3<T>::max(max, point);
+            }
+
+            inline constexpr void expand(const aabb& other) noexcept
+            {
+                min = vec3<T>::min(min, other.min);
+                max = vec3<T>::max(max, other.max);
+            }
+
+            // Grows the box by margin on every side
+            inline constexpr void inflate(T margin) noexcept
+            {
+                vec3<T> m(margin);
+
+                min -= m;
+                max += m;
+            }
+
+            SML_NO_DISCARD inline constexpr bool overlaps(const aabb& other) const noexcept
+            {
+                if constexpr (std::is_same<T, f32>::value)
+                {
+                    __m128 a = _mm_cmple_ps(simd::load(min.v), simd::load(other.max.v));
+                    __m128 b = _mm_cmple_ps(simd::load(other.min.v), simd::load(max.v));
+
+                    return (_mm_movemask_ps(_mm_and_ps(a, b)) & 0x7) == 0x7;
+                }
+
+                if constexpr (std::is_same<T, f64>::value)
+                {
+                    __m256d a = _mm256_cmp_pd(simd::load(min.v), simd::load(other.max.v), _CMP_LE_OQ);
+                    __m256d b = _mm256_cmp_pd(simd::load(other.min.v), simd::load(max.v), _CMP_LE_OQ);
+
+                    return (_mm256_movemask_pd(_mm256_and_pd(a, b)) & 0x7) == 0x7;
+                }
+
+                return min.x <= other.max.x && other.min.x <= max.x
+                    && min.y <= other.max.y && other.min.y <= max.y
+                    && min.z <= other.max.z && other.min.z <= max.z;
+            }
+
+            SML_NO_DISCARD inline constexpr bool contains(const vec3<T>& point) const noexcept
+            {
+                return contains(aabb(point));
+            }
+
+            SML_NO_DISCARD inline constexpr bool contains(const aabb& other) const noexcept
+            {
+                if constexpr (std::is_same<T, f32>::value)
+                {
+                    __m128 a = _mm_cmple_ps(simd::load(min.v), simd::load(other.min.v));
+                    __m128 b = _mm_cmple_ps(simd::load(other.max.v), simd::load(max.v));
+
+                    return (_mm_movemask_ps(_mm_and_ps(a, b)) & 0x7) == 0x7;
+                }
+
+                if constexpr (std::is_same<T, f64>::value)
+                {
+                    __m256d a = _mm256_cmp_pd(simd::load(min.v), simd::load(other.min.v), _CMP_LE_OQ);
+                    __m256d b = _mm256_cmp_pd(simd::load(other.max.v), simd::load(max.v), _CMP_LE_OQ);
+
+                    return (_mm256_movemask_pd(_mm256_and_pd(a, b)) & 0x7) == 0x7;
+                }
+
+                return min.x <= other.min.x && other.max.x <= max.x
+                    && min.y <= other.min.y && other.max.y <= max.y
+                    && min.z <= other.min.z && other.max.z <= max.z;
+            }
+
+            // Box around the transformed box (Arvo), the center goes through the full transform and the
+            // extents through the absolute value of the upper 3x3
+            SML_NO_DISCARD inline constexpr aabb transformed(const mat4<T>& transform) const noexcept
+            {
+                if (empty())
+                    return *this;
+
+                aabb res;
+
+                if constexpr (std::is_same<T, f32>::value)
+                {
+                    __m128 signmask = _mm_set1_ps(-0.0f);
+                    __m128 onehalf = _mm_set1_ps(0.5f);
+                    __m128 lo = simd::load(min.v);
+                    __m128 hi = simd::load(max.v);
+                    __m128 c = _mm_mul_ps(_mm_add_ps(lo, hi), onehalf);
+                    __m128 e = _mm_mul_ps(_mm_sub_ps(hi, lo), onehalf);
+
+                    __m128 c0 = simd::load(&transform.m00);
+                    __m128 c1 = simd::load(&transform.m10);
+                    __m128 c2 = simd::load(&transform.m20);
+                    __m128 c3 = simd::load(&transform.m30);
+
+                    __m128 nc = _mm_add_ps(_mm_add_ps(_mm_mul_ps(simd::shuffle<0, 0, 0, 0>(c), c0), _mm_mul_ps(simd::shuffle<1, 1, 1, 1>(c), c1)),
+                                           _mm_add_ps(_mm_mul_ps(simd::shuffle<2, 2, 2, 2>(c), c2), c3));
+                    __m128 ne = _mm_add_ps(_mm_add_ps(_mm_mul_ps(simd::shuffle<0, 0, 0, 0>(e), _mm_andnot_ps(signmask, c0)), _mm_mul_ps(simd::shuffle<1, 1, 1, 1>(e), _mm_andnot_ps(signmask, c1))),
+                                           _mm_mul_ps(simd::shuffle<2, 2, 2, 2>(e), _mm_andnot_ps(signmask, c2)));
+
+                    simd::store(res.min.v, _mm_blend_ps(_mm_sub_ps(nc, ne), _mm_setzero_ps(), 0x8));
+                    simd::store(res.max.v, _mm_blend_ps(_mm_add_ps(nc, ne), _mm_setzero_ps(), 0x8));
+
+                    return res;
+                }
+
+                if constexpr (std::is_same<T, f64>::value)
+                {
+                    __m256d signmask = _mm256_set1_pd(-0.0);
+                    __m256d onehalf = _mm256_set1_pd(0.5);
+                    __m256d lo = simd::load(min.v);
+                    __m256d hi = simd::load(max.v);
+                    __m256d c = _mm256_mul_pd(_mm256_add_pd(lo, hi), onehalf);
+                    __m256d e = _mm256_mul_pd(_mm256_sub_pd(hi, lo), onehalf);
+
+                    __m256d c0 = simd::load(&transform.m00);
+                    __m256d c1 = simd::load(&transform.m10);
+                    __m256d c2 = simd::load(&transform.m20);
+                    __m256d c3 = simd::load(&transform.m30);
+
+                    __m256d nc = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(simd::shuffle<0, 0, 0, 0>(c), c0), _mm256_mul_pd(simd::shuffle<1, 1, 1, 1>(c), c1)),
+                                               _mm256_add_pd(_mm256_mul_pd(simd::shuffle<2, 2, 2, 2>(c), c2), c3));
+                    __m256d ne = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(simd::shuffle<0, 0, 0, 0>(e), _mm256_andnot_pd(signmask, c0)), _mm256_mul_pd(simd::shuffle<1, 1, 1, 1>(e), _mm256_andnot_pd(signmask, c1))),
+                                               _mm256_mul_pd(simd::shuffle<2, 2, 2, 2>(e), _mm256_andnot_pd(signmask, c2)));
+
+                    simd::store(res.min.v, _mm256_blend_pd(_mm256_sub_pd(nc, ne), _mm256_setzero_pd(), 0x8));
+                    simd::store(res.max.v, _mm256_blend_pd(_mm256_add_pd(nc, ne), _mm256_setzero_pd(), 0x8));
+
+                    return res;
+                }
+
+                vec3<T> c = center();
+                vec3<T> e = extents();
+
+                for (s32 i = 0; i < 3; i++)
+                {
+                    T nc = transform.col[0].v[i] * c.x + transform.col[1].v[i] * c.y + transform.col[2].v[i] * c.z + transform.col[3].v[i];
+                    T ne = sml::abs(transform.col[0].v[i]) * e.x + sml::abs(transform.col[1].v[i]) * e.y + sml::abs(transform.col[2].v[i]) * e.z;
+
+                    res.min.v[i] = nc - ne;
+                    res.max.v[i] = nc + ne;
+                }
+
+                return res;
+            }
+
+            // Statics
+            SML_NO_DISCARD static inline constexpr aabb merge(const aabb& a, const aabb& b) noexcept
+            {
+                return aabb(vec3<T>::min(a.min, b.min), vec3<T>::max(a.max, b.max));
+            }
+
+            // Data
+            vec3<T> min;
+            vec3<T> max;
+    };
+
+    // Bounds of a point set, empty for count == 0
+    template<typename T>
+    SML_NO_DISCARD inline aabb<T> bounds(const vec3<T>* points, size_t count) noexcept
+    {
+        aabb<T> res;
+        size_t i = 0;
+
+        if constexpr (std::is_same<T, f32>::value)
+        {
+            // Two points per register, two registers deep to hide the min/max latency
+            __m256 lo0 = _mm256_set1_ps(std::numeric_limits<f32>::infinity()), lo1 = lo0;
+            __m256 hi0 = _mm256_set1_ps(-std::numeric_limits<f32>::infinity()), hi1 = hi0;
+
+            for (; i + 4 <= count; i += 4)
+            {
+                __m256 p0 = _mm256_loadu_ps(points[i + 0].v);
+                __m256 p1 = _mm256_loadu_ps(points[i + 2].v);
+
+                lo0 = _mm256_min_ps(lo0, p0);
+                hi0 = _mm256_max_ps(hi0, p0);
+                lo1 = _mm256_min_ps(lo1, p1);
+                hi1 = _mm256_max_ps(hi1, p1);
+            }
+
+            __m256 lo = _mm256_min_ps(lo0, lo1);
+            __m256 hi = _mm256_max_ps(hi0, hi1);
+
+            __m128 l = _mm_min_ps(_mm256_castps256_ps128(lo), _mm256_extractf128_ps(lo, 1));
+            __m128 h = _mm_max_ps(_mm256_castps256_ps128(hi), _mm256_extractf128_ps(hi, 1));
+
+            simd::store(res.min.v, _mm_blend_ps(l, _mm_setzero_ps(), 0x8));
+            simd::store(res.max.v, _mm_blend_ps(h, _mm_setzero_ps(), 0x8));
+        }
+
+        for (; i < count; i++)
+        {
+            res.expand(points[i]);
+        }
+
+        return res;
+    }
+
+    // Bounds of a strided attribute such as the positions of an interleaved vertex buffer
+    template<typename T>
+    SML_NO_DISCARD inline aabb<T> bounds(strided_span<vec3<T>> points) noexcept
+    {
+        aabb<T> res;
+        size_t i = 0;
+
+        if constexpr (std::is_same<T, f32>::value)
+        {
+            __m256 lx = _mm256_set1_ps(std::numeric_limits<f32>::infinity()), ly = lx, lz = lx;
+            __m256 hx = _mm256_set1_ps(-std::numeric_limits<f32>::infinity()), hy = hx, hz = hx;
+
+            for (; i + 8 < points.count; i += 8)
+            {
+                __m256 x, y, z;
+                stridedload(points, i, x, y, z);
+
+                lx = _mm256_min_ps(lx, x);
+                ly = _mm256_min_ps(ly, y);
+                lz = _mm256_min_ps(lz, z);
+                hx = _mm256_max_ps(hx, x);
+                hy = _mm256_max_ps(hy, y);
+                hz = _mm256_max_ps(hz, z);
+            }
+
+            alignas(32) f32 l[3][8];
+            alignas(32) f32 h[3][8];
+
+            _mm256_store_ps(l[0], lx);
+            _mm256_store_ps(l[1], ly);
+            _mm256_store_ps(l[2], lz);
+            _mm256_store_ps(h[0], hx);
+            _mm256_store_ps(h[1], hy);
+            _mm256_store_ps(h[2], hz);
+
+            for (s32 k = 0; k < 8; k++)
+            {
+                res.expand(aabb<T>(vec3<T>(l[0][k], l[1][k], l[2][k]), vec3<T>(h[0][k], h[1][k], h[2][k])));
+            }
+        }
+
+        for (; i < points.count; i++)
+        {
+            res.expand(points[i].load());
+        }
+
+        return res;
+    }
+
+    // Transforms count boxes by one matrix, dst may alias src
+    template<typename T>
+    inline void transformboxes(const aabb<T>* src, aabb<T>* dst, size_t count, const mat4<T>& transform) noexcept
+    {
+        size_t i = 0;
+
+        if constexpr (std::is_same<T, f32>::value)
+        {
+            // Two boxes per register, one in each 128 bit half. Empty boxes stay empty.
+            __m256 signmask = _mm256_set1_ps(-0.0f);
+            __m256 onehalf = _mm256_set1_ps(0.5f);
+            __m256 c0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&transform.m00));
+            __m256 c1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&transform.m10));
+            __m256 c2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&transform.m20));
+            __m256 c3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&transform.m30));
+            __m256 a0 = _mm256_andnot_ps(signmask, c0);
+            __m256 a1 = _mm256_andnot_ps(signmask, c1);
+            __m256 a2 = _mm256_andnot_ps(signmask, c2);
+
+            for (; i + 2 <= count; i += 2)
+            {
+                __m256 lo = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(src[i].min.v)), simd::load(src[i + 1].min.v), 1);
+                __m256 hi = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(src[i].max.v)), simd::load(src[i + 1].max.v), 1);
+
+                __m256 c = _mm256_mul_ps(_mm256_add_ps(lo, hi), onehalf);
+                __m256 e = _mm256_mul_ps(_mm256_sub_ps(hi, lo), onehalf);
+
+                __m256 nc = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_permute_ps(c, 0x00), c0), _mm256_mul_ps(_mm256_permute_ps(c, 0x55), c1)),
+                                          _mm256_add_ps(_mm256_mul_ps(_mm256_permute_ps(c, 0xAA), c2), c3));
+                __m256 ne = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_permute_ps(e, 0x00), a0), _mm256_mul_ps(_mm256_permute_ps(e, 0x55), a1)),
+                                          _mm256_mul_ps(_mm256_permute_ps(e, 0xAA), a2));
+
+                // Lanes where min > max mark an empty box, keep those boxes as they are
+                __m256 invalid = _mm256_cmp_ps(lo, hi, _CMP_GT_OQ);
+                __m256 emptybox = _mm256_or_ps(invalid, _mm256_permute_ps(invalid, _MM_SHUFFLE(3, 0, 2, 1)));
+                emptybox = _mm256_or_ps(emptybox, _mm256_permute_ps(invalid, _MM_SHUFFLE(3, 1, 0, 2)));
+                emptybox = _mm256_permute_ps(emptybox, 0x00);
+
+                __m256 rlo = _mm256_blend_ps(simd::select(emptybox, _mm256_sub_ps(nc, ne), lo), _mm256_setzero_ps(), 0x88);
+                __m256 rhi = _mm256_blend_ps(simd::select(emptybox, _mm256_add_ps(nc, ne), hi), _mm256_setzero_ps(), 0x88);
+
+                simd::store(dst[i].min.v, _mm256_castps256_ps128(rlo));
+                simd::store(dst[i].max.v, _mm256_castps256_ps128(rhi));
+                simd::store(dst[i + 1].min.v, _mm256_extractf128_ps(rlo, 1));
+                simd::store(dst[i + 1].max.v, _mm256_extractf128_ps(rhi, 1));
+            }
+        }
+
+        for (; i < count; i++)
+        {
+            dst[i] = src[i].transformed(transform);
+        }
+    }
+
+    typedef aabb<f32> faabb;
+    typedef aabb<f64> daabb;
+
+    // Eight f32 boxes in SoA layout, unused slots hold empty boxes that no query hits
+    class alignas(32) aabb8
+    {
+        public:
+            aabb8() noexcept
+            {
+                for (s32 i = 0; i < 8; i++)
+                {
+                    set(i, aabb<f32>());
+                }
+            }
+
+            // Operations
+            inline void set(s32 i, const aabb<f32>& box) noexcept
+            {
+                minx[i] = box.min.x;
+                miny[i] = box.min.y;
+                minz[i] = box.min.z;
+                maxx[i] = box.max.x;
+                maxy[i] = box.max.y;
+                maxz[i] = box.max.z;
+            }
+
+            SML_NO_DISCARD inline aabb<f32> get(s32 i) const noexcept
+            {
+                return aabb<f32>(vec3<f32>(minx[i], miny[i], minz[i]), vec3<f32>(maxx[i], maxy[i], maxz[i]));
+            }
+
+            // Union of the eight boxes, empty slots do not contribute
+            SML_NO_DISCARD inline aabb<f32> bounds() const noexcept
+            {
+                __m256 lx = _mm256_load_ps(minx), ly = _mm256_load_ps(miny), lz = _mm256_load_ps(minz);
+                __m256 hx = _mm256_load_ps(maxx), hy = _mm256_load_ps(maxy), hz = _mm256_load_ps(maxz);
+                __m256 zero = _mm256_setzero_ps();
+
+                // Rows x, y, z, 0 so every lane of the 128 bit result holds one axis
+                simd::transpose(lx, ly, lz, zero);
+                __m128 lo = _mm_min_ps(_mm_min_ps(_mm256_castps256_ps128(lx), _mm256_castps256_ps128(ly)), _mm_min_ps(_mm256_castps256_ps128(lz), _mm256_castps256_ps128(zero)));
+                lo = _mm_min_ps(lo, _mm_min_ps(_mm_min_ps(_mm256_extractf128_ps(lx, 1), _mm256_extractf128_ps(ly, 1)), _mm_min_ps(_mm256_extractf128_ps(lz, 1), _mm256_extractf128_ps(zero, 1))));
+
+                zero = _mm256_setzero_ps();
+                simd::transpose(hx, hy, hz, zero);
+                __m128 hi = _mm_max_ps(_mm_max_ps(_mm256_castps256_ps128(hx), _mm256_castps256_ps128(hy)), _mm_max_ps(_mm256_castps256_ps128(hz), _mm256_castps256_ps128(zero)));
+                hi = _mm_max_ps(hi, _mm_max_ps(_mm_max_ps(_mm256_extractf128_ps(hx, 1), _mm256_extractf128_ps(hy, 1)), _mm_max_ps(_mm256_extractf128_ps(hz, 1), _mm256_extractf128_ps(zero, 1))));
+
+                aabb<f32> res;
+                simd::store(res.min.v, _mm_blend_ps(lo, _mm_setzero_ps(), 0x8));
+                simd::store(res.max.v, _mm_blend_ps(hi, _mm_setzero_ps(), 0x8));
+
+                return res;
+            }
+
+            // Surface areas of the eight boxes, only meaningful for slots that are not empty
+            SML_NO_DISCARD inline __m256 surfaceareas() const noexcept
+            {
+                __m256 dx = _mm256_sub_ps(_mm256_load_ps(maxx), _mm256_load_ps(minx));
+                __m256 dy = _mm256_sub_ps(_mm256_load_ps(maxy), _mm256_load_ps(miny));
+                __m256 dz = _mm256_sub_ps(_mm256_load_ps(maxz), _mm256_load_ps(minz));
+                __m256 sum = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dy), _mm256_mul_ps(dy, dz)), _mm256_mul_ps(dz, dx));
+
+                return _mm256_add_ps(sum, sum);
+            }
+
+            // Data
+            f32 minx[8], miny[8], minz[8];
+            f32 maxx[8], maxy[8], maxz[8];
+    };
+
+    // Overlap of one box with eight boxes, bit i is set when box i overlaps
+    inline u32 overlaps(const aabb<f32>& box, const aabb8& boxes) noexcept
+    {
+        __m256 res = _mm256_and_ps(_mm256_cmp_ps(_mm256_load_ps(boxes.minx), _mm256_set1_ps(box.max.x), _CMP_LE_OQ), _mm256_cmp_ps(_mm256_set1_ps(box.min.x), _mm256_load_ps(boxes.maxx), _CMP_LE_OQ));
+        res = _mm256_and_ps(res, _mm256_and_ps(_mm256_cmp_ps(_mm256_load_ps(boxes.miny), _mm256_set1_ps(box.max.y), _CMP_LE_OQ), _mm256_cmp_ps(_mm256_set1_ps(box.min.y), _mm256_load_ps(boxes.maxy), _CMP_LE_OQ)));
+        res = _mm256_and_ps(res, _mm256_and_ps(_mm256_cmp_ps(_mm256_load_ps(boxes.minz), _mm256_set1_ps(box.max.z), _CMP_LE_OQ), _mm256_cmp_ps(_mm256_set1_ps(box.min.z), _mm256_load_ps(boxes.maxz), _CMP_LE_OQ)));
+
+        return static_cast<u32>(_mm256_movemask_ps(res));
+    }
+
+    // Squared distances from a point to eight boxes, zero inside and infinite for empty slots
+    inline __m256 distancesquared(const vec3<f32>& point, const aabb8& boxes) noexcept
+    {
+        __m256 zero = _mm256_setzero_ps();
+        __m256 px = _mm256_set1_ps(point.x), py = _mm256_set1_ps(point.y), pz = _mm256_set1_ps(point.z);
+
+        __m256 dx = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_load_ps(boxes.minx), px), _mm256_sub_ps(px, _mm256_load_ps(boxes.maxx))), zero);
+        __m256 dy = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_load_ps(boxes.miny), py), _mm256_sub_ps(py, _mm256_load_ps(boxes.maxy))), zero);
+        __m256 dz = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_load_ps(boxes.minz), pz), _mm256_sub_ps(pz, _mm256_load_ps(boxes.maxz))), zero);
+
+        return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+    }
+} // namespace sml
+
+#endif // sml_aabb_h__
@@ -0,0 +1,1415 @@
+#ifndef sml_bvh_h__
+#define sml_bvh_h__
+
+/* bvh.h -- bounding volume hierarchy of the 'Simple Math Library'
+  Copyright (C) 2020 Roderick Griffioen
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include <immintrin.h>
+
+#include "smltypes.h"
+#include "common.h"
+#include "simd.h"
+#include "vec3.h"
+#include "aabb.h"
+#include "ray.h"
+#include "morton.h"
+#include "parallel.h"
+
+namespace sml
+{
+    struct bvhsettings
+    {
+        // Largest leaf the builder creates, leaves are only made this large when the SAH favours them
+        u32 maxleafsize = 4;
+
+        // Bins per axis of the binned SAH sweep, at most bvh::maxbins
+        u32 bins = 16;
+
+        // Worker threads, 0 uses every hardware thread
+        u32 threads = 0;
+
+        // bvh::update rebuilds a top level subtree once its SAH cost grew by this factor since it was built
+        f32 rebuildthreshold = 1.3f;
+    };
+
+    // Eight wide node, slot i is empty when child[i] == ~0u, a leaf of count[i] primitives starting at
+    // bvh::indices[child[i]] when count[i] > 0 and an inner node otherwise
+    class alignas(32) bvhnode8
+    {
+        public:
+            bvhnode8() noexcept
+            {
+                for (s32 i = 0; i < 8; i++)
+                {
+                    child[i] = ~0u;
+                    count[i] = 0;
+                }
+            }
+
+            // Data
+            aabb8 bounds;
+            u32 child[8];
+            u32 count[8];
+    };
+
+    // Bounding volume hierarchy over f32 boxes. The builder sweeps a binned surface area heuristic
+    // over all three axes, parallelises over subtrees and over the binning of large nodes, and
+    // collapses the binary result into eight wide nodes that are traversed eight boxes at a time.
+    // Queries report primitives through callbacks, the hierarchy only stores primitive indices.
+    class bvh
+    {
+        public:
+            static constexpr u32 maxbins = 32;
+            static constexpr u32 stacksize = 512;
+
+            // Below this binary depth the SAH builder splits ranges at the median, so no build is deeper than
+            // maxsahdepth + 32 levels. The Morton builder stops at 30 code bits plus 32 halvings. Every eight
+            // wide level leaves at most 7 entries on the traversal stack, update() adds up to 2 levels above
+            // a rebuilt subtree.
+            static constexpr u32 maxsahdepth = 32;
+
+            bvh() noexcept = default;
+
+            bvh(const aabb<f32>* boxes, size_t count, const bvhsettings& settings = bvhsettings())
+            {
+                build(boxes, count, settings);
+            }
+
+            // Operations
+            void build(const aabb<f32>* boxes, size_t count, const bvhsettings& settings = bvhsettings())
+            {
+                builder b(boxes, count, settings);
+
+                indices.swap(b.indices);
+                assemble(b.nodes, settings.threads);
+                link(settings.threads);
+                measure(settings.threads, baselines, treebaseline);
+            }
+
+            // Linear build for scenes that change every frame. Centroids are sorted along a 30 bit
+            // Morton curve and every node splits its range where the highest differing code bit
+            // flips, so the build is a sort and a walk over the codes. Traversal is slower than on
+            // the SAH tree, by around a third for rays through a random triangle soup.
+            void buildlinear(const aabb<f32>* boxes, size_t count, const bvhsettings& settings = bvhsettings())
+            {
+                linearbuilder b(boxes, count, settings);
+
+                indices.swap(b.indices);
+                assemble(b.nodes, settings.threads);
+                link(settings.threads);
+                measure(settings.threads, baselines, treebaseline);
+            }
+
+            // Recomputes every node bound bottom-up from boxes, which holds the current box of every primitive
+            void refit(const aabb<f32>* boxes, u32 threads = 0)
+            {
+                if (empty())
+                    return;
+
+                std::vector<u8> dirty(nodes.size());
+                std::vector<std::vector<u32>> levels(height + 1);
+
+                for (u32 n = 0; n < static_cast<u32>(nodes.size()); n++)
+                {
+                    for (s32 i = 0; i < 8; i++)
+                    {
+                        if (nodes[n].child[i] != ~0u)
+                            dirty[n] |= static_cast<u8>(1u << i);
+                    }
+
+                    levels[depths[n]].push_back(n);
+                }
+
+                propagate(boxes, dirty, levels, threads);
+            }
+
+            // Refits only the ancestors of the changed primitives, untouched subtrees are never visited
+            void refit(const aabb<f32>* boxes, const u32* changed, size_t count, u32 threads = 0)
+            {
+                if (empty())
+                    return;
+
+                std::vector<u8> dirty(nodes.size());
+                std::vector<std::vector<u32>> levels(height + 1);
+
+                for (size_t i = 0; i < count; i++)
+                {
+                    mark(leafslots[changed[i]], dirty, levels);
+                }
+
+                propagate(boxes, dirty, levels, threads);
+            }
+
+            // Refits after the changed primitives moved, then rebuilds the top level subtrees whose SAH cost
+            // grew past settings.rebuildthreshold times their cost after they were built. Movers that cross
+            // the whole scene degrade the levels above those subtrees, so the whole tree is rebuilt when its
+            // own cost still exceeds the threshold. Returns the number of rebuilt subtrees, a full rebuild
+            // counts as all of them.
+            u32 update(const aabb<f32>* boxes, const u32* changed, size_t count, const bvhsettings& settings = bvhsettings())
+            {
+                refit(boxes, changed, count, settings.threads);
+
+                if (empty())
+                    return 0;
+
+                std::vector<f32> current;
+                f32 total;
+                measure(settings.threads, current, total);
+
+                std::vector<bool> rebuilt(subtrees.size(), false);
+                u32 res = 0;
+
+                // Back to front, splicing a subtree only moves the nodes after it
+                for (size_t i = subtrees.size(); i-- > 0;)
+                {
+                    if (current[i] > baselines[i] * settings.rebuildthreshold)
+                    {
+                        rebuild(boxes, subtrees[i], settings);
+                        rebuilt[i] = true;
+                        res++;
+                    }
+                }
+
+                if (res > 0)
+                {
+                    size_t previous = subtrees.size();
+
+                    link(settings.threads);
+                    measure(settings.threads, current, total);
+
+                    if (subtrees.size() != previous)
+                    {
+                        baselines = current;
+                    }
+                    else
+                    {
+                        for (size_t i = 0; i < subtrees.size(); i++)
+                        {
+                            if (rebuilt[i])
+                                baselines[i] = current[i];
+                        }
+                    }
+                }
+
+                if (total > treebaseline * settings.rebuildthreshold)
+                {
+                    build(boxes, indices.size(), settings);
+
+                    return static_cast<u32>(subtrees.size());
+                }
+
+                return res;
+            }
+
+            // SAH cost of the tree with traversal and intersection costs of 1, relative to the root area
+            SML_NO_DISCARD inline f32 sahcost() const noexcept
+            {
+                return empty() ? 0.0f : cost(0);
+            }
+
+            SML_NO_DISCARD inline bool empty() const noexcept
+            {
+                return indices.empty();
+            }
+
+            // Closest hit, intersect(primitive, tmax) returns true and lowers tmax when the primitive is
+            // hit closer than tmax. Children are visited front to back and skipped once behind tmax.
+            template<typename F>
+            bool closesthit(const ray<f32>& r, f32& tmax, F&& intersect) const noexcept
+            {
+                if (nodes.empty())
+                    return false;
+
+                stackentry stack[stacksize];
+                s32 top = 0;
+                bool hit = false;
+
+                stack[top++] = { 0, 0, 0.0f };
+
+                while (top > 0)
+                {
+                    stackentry e = stack[--top];
+
+                    if (e.t > tmax)
+                        continue;
+
+                    if (e.count > 0)
+                    {
+                        for (u32 i = e.node; i < e.node + e.count; i++)
+                        {
+                            hit |= intersect(indices[i], tmax);
+                        }
+
+                        continue;
+                    }
+
+                    const bvhnode8& node = nodes[e.node];
+
+                    __m256 entry, exit;
+                    u32 mask = intersects(r, node.bounds, 0.0f, tmax, entry, exit);
+
+                    alignas(32) f32 t[8];
+                    _mm256_store_ps(t, entry);
+
+                    // Push the hit children far to near so the nearest is popped first
+                    s32 first = top;
+
+                    for (; mask != 0; mask &= mask - 1)
+                    {
+                        u32 i = lowestbit(mask);
+                        stackentry child = { node.child[i], node.count[i], t[i] };
+                        s32 k = top++;
+
+                        for (; k > first && stack[k - 1].t < child.t; k--)
+                        {
+                            stack[k] = stack[k - 1];
+                        }
+
+                        stack[k] = child;
+                    }
+
+                    SML_ASSERT(top <= static_cast<s32>(stacksize) - 8);
+                }
+
+                return hit;
+            }
+
+            // Any hit within [0, tmax], intersect(primitive, tmax) returns true on a hit and ends the query
+            template<typename F>
+            bool anyhit(const ray<f32>& r, f32 tmax, F&& intersect) const noexcept
+            {
+                if (nodes.empty())
+                    return false;
+
+                stackentry stack[stacksize];
+                s32 top = 0;
+
+                stack[top++] = { 0, 0, 0.0f };
+
+                while (top > 0)
+                {
+                    stackentry e = stack[--top];
+
+                    if (e.count > 0)
+                    {
+                        for (u32 i = e.node; i < e.node + e.count; i++)
+                        {
+                            if (intersect(indices[i], tmax))
+                                return true;
+                        }
+
+                        continue;
+                    }
+
+                    const bvhnode8& node = nodes[e.node];
+
+                    __m256 entry, exit;
+                    u32 mask = intersects(r, node.bounds, 0.0f, tmax, entry, exit);
+
+                    for (; mask != 0; mask &= mask - 1)
+                    {
+                        u32 i = lowestbit(mask);
+
+                        stack[top++] = { node.child[i], node.count[i], 0.0f };
+                    }
+
+                    SML_ASSERT(top <= static_cast<s32>(stacksize) - 8);
+                }
+
+                return false;
+            }
+
+            // Calls visit(primitive) for every primitive in a leaf whose bounds overlap box, the callback
+            // does the exact test
+            template<typename F>
+            void overlaps(const aabb<f32>& box, F&& visit) const noexcept
+            {
+                if (nodes.empty())
+                    return;
+
+                u32 stack[stacksize];
+                s32 top = 0;
+
+                stack[top++] = 0;
+
+                while (top > 0)
+                {
+                    const bvhnode8& node = nodes[stack[--top]];
+                    u32 mask = sml::overlaps(box, node.bounds);
+
+                    for (; mask != 0; mask &= mask - 1)
+                    {
+                        u32 i = lowestbit(mask);
+
+                        if (node.count[i] > 0)
+                        {
+                            for (u32 k = node.child[i]; k < node.child[i] + node.count[i]; k++)
+                            {
+                                visit(indices[k]);
+                            }
+                        }
+                        else
+                        {
+                            stack[top++] = node.child[i];
+                        }
+                    }
+
+                    SML_ASSERT(top <= static_cast<s32>(stacksize) - 8);
+                }
+            }
+
+            // Nearest primitive to point, distance(primitive) returns the squared distance to it. Returns
+            // ~0u when there is no primitive closer than sqrt(distancesq), which receives the result.
+            template<typename F>
+            u32 nearest(const vec3<f32>& point, f32& distancesq, F&& distance) const noexcept
+            {
+                if (nodes.empty())
+                    return ~0u;
+
+                stackentry stack[stacksize];
+                s32 top = 0;
+                u32 best = ~0u;
+
+                stack[top++] = { 0, 0, 0.0f };
+
+                while (top > 0)
+                {
+                    stackentry e = stack[--top];
+
+                    if (e.t >= distancesq)
+                        continue;
+
+                    if (e.count > 0)
+                    {
+                        for (u32 i = e.node; i < e.node + e.count; i++)
+                        {
+                            f32 d = distance(indices[i]);
+
+                            if (d < distancesq)
+                            {
+                                distancesq = d;
+                                best = indices[i];
+                            }
+                        }
+
+                        continue;
+                    }
+
+                    const bvhnode8& node = nodes[e.node];
+                    __m256 d = distancesquared(point, node.bounds);
+                    u32 mask = static_cast<u32>(_mm256_movemask_ps(_mm256_cmp_ps(d, _mm256_set1_ps(distancesq), _CMP_LT_OQ)));
+
+                    alignas(32) f32 t[8];
+                    _mm256_store_ps(t, d);
+
+                    s32 first = top;
+
+                    for (; mask != 0; mask &= mask - 1)
+                    {
+                        u32 i = lowestbit(mask);
+                        stackentry child = { node.child[i], node.count[i], t[i] };
+                        s32 k = top++;
+
+                        for (; k > first && stack[k - 1].t < child.t; k--)
+                        {
+                            stack[k] = stack[k - 1];
+                        }
+
+                        stack[k] = child;
+                    }
+
+                    SML_ASSERT(top <= static_cast<s32>(stacksize) - 8);
+                }
+
+                return best;
+            }
+
+            // Data
+            std::vector<bvhnode8> nodes;
+            std::vector<u32> indices;
+
+            // Refit links, parents[n] and leafslots[primitive] hold node * 8 + slot, parents[0] is ~0u
+            std::vector<u32> parents;
+            std::vector<u32> leafslots;
+            std::vector<u8> depths;
+            u32 height = 0;
+
+            // Roots of the subtrees update() may rebuild and their SAH costs after they were built
+            std::vector<u32> subtrees;
+            std::vector<f32> baselines;
+            f32 treebaseline = 0.0f;
+
+        private:
+            static_assert(7 * (maxsahdepth + 32 + 2) + 8 <= stacksize, "deepest tree overflows the traversal stack");
+
+            struct stackentry
+            {
+                u32 node;
+                u32 count;
+                f32 t;
+            };
+
+            struct buildnode
+            {
+                aabb<f32> bounds;
+                u32 left = 0;
+                u32 first = 0;
+                u32 count = 0;
+            };
+
+            // Bounds and primitive count of one bin, also used for plain bounds while building
+            struct bin
+            {
+                __m128 min;
+                __m128 max;
+                u32 count;
+
+                inline void clear() noexcept
+                {
+                    min = _mm_set1_ps(std::numeric_limits<f32>::infinity());
+                    max = _mm_set1_ps(-std::numeric_limits<f32>::infinity());
+                    count = 0;
+                }
+
+                inline void add(__m128 lo, __m128 hi) noexcept
+                {
+                    min = _mm_min_ps(min, lo);
+                    max = _mm_max_ps(max, hi);
+                    count++;
+                }
+
+                inline void merge(const bin& other) noexcept
+                {
+                    min = _mm_min_ps(min, other.min);
+                    max = _mm_max_ps(max, other.max);
+                    count += other.count;
+                }
+
+                SML_NO_DISCARD inline f32 area() const noexcept
+                {
+                    __m128 d = _mm_sub_ps(max, min);
+                    __m128 products = _mm_mul_ps(d, simd::shuffle<1, 2, 0, 3>(d));
+
+                    products = _mm_add_ps(products, simd::shuffle<1, 2, 0, 3>(products));
+                    products = _mm_add_ps(products, simd::shuffle<2, 0, 1, 3>(products));
+
+                    return 2.0f * _mm_cvtss_f32(products);
+                }
+
+                SML_NO_DISCARD inline aabb<f32> bounds() const noexcept
+                {
+                    aabb<f32> res;
+
+                    simd::store(res.min.v, _mm_blend_ps(min, _mm_setzero_ps(), 0x8));
+                    simd::store(res.max.v, _mm_blend_ps(max, _mm_setzero_ps(), 0x8));
+
+                    return res;
+                }
+            };
+
+            // Binary binned SAH build, nodes[left] and nodes[left + 1] are the children of an inner node.
+            // The builder partitions copies of the primitive boxes rather than indices so every pass streams
+            // through memory, lane 3 of min (unused by aabb) carries the primitive index along. Centroids
+            // are kept doubled as min + max.
+            class builder
+            {
+                public:
+                    builder(const aabb<f32>* boxes, size_t count, const bvhsettings& settings) : settings(settings), threads(threadcount(settings.threads)),
+                        refs(count), indices(count), nodes(count > 0 ? 2 * count - 1 : 0), next(1)
+                    {
+                        SML_ASSERT(settings.bins >= 2 && settings.bins <= maxbins);
+                        SML_ASSERT(settings.maxleafsize >= 1);
+
+                        if (count == 0)
+                            return;
+
+                        std::vector<bin> partial(threads * 2);
+
+                        parallelfor(0, count, 16384, [&](size_t begin, size_t end, u32 thread)
+                        {
+                            bin& bounds = partial[thread * 2];
+                            bin& centroids = partial[thread * 2 + 1];
+
+                            bounds.clear();
+                            centroids.clear();
+
+                            for (size_t i = begin; i < end; i++)
+                            {
+                                aabb<f32>& ref = refs[i];
+                                u32 index = static_cast<u32>(i);
+
+                                ref = boxes[i];
+                                std::memcpy(&ref.min.v[3], &index, sizeof(index));
+
+                                __m128 lo = simd::load(ref.min.v), hi = simd::load(ref.max.v);
+                                __m128 c = _mm_add_ps(lo, hi);
+
+                                bounds.add(lo, hi);
+                                centroids.add(c, c);
+                            }
+                        }, threads);
+
+                        bin bounds, centroids;
+                        bounds.clear();
+                        centroids.clear();
+
+                        for (u32 t = 0; t < threads; t++)
+                        {
+                            if (partial[t * 2].count == 0)
+                                continue;
+
+                            bounds.merge(partial[t * 2]);
+                            centroids.merge(partial[t * 2 + 1]);
+                        }
+
+                        // Enough subtrees to keep every thread busy, with some slack for imbalance
+                        u32 depth = 0;
+                        while ((1u << depth) < threads * 4)
+                        {
+                            depth++;
+                        }
+
+                        subdivide(0, 0, static_cast<u32>(count), bounds, centroids, threads > 1 ? depth : 0, 0);
+
+                        parallelfor(0, count, 65536, [&](size_t begin, size_t end, u32)
+                        {
+                            for (size_t i = begin; i < end; i++)
+                            {
+                                std::memcpy(&indices[i], &refs[i].min.v[3], sizeof(u32));
+                            }
+                        }, threads);
+                    }
+
+                    void subdivide(u32 node, u32 begin, u32 end, const bin& bounds, const bin& centroids, u32 paralleldepth, u32 depth)
+                    {
+                        u32 count = end - begin;
+                        buildnode& n = nodes[node];
+                        n.bounds = bounds.bounds();
+
+                        alignas(16) f32 origin[4], extent[4];
+                        simd::store(origin, centroids.min);
+                        simd::store(extent, _mm_sub_ps(centroids.max, centroids.min));
+
+                        s32 axis = -1;
+                        u32 split = 0;
+                        f32 cost = std::numeric_limits<f32>::infinity();
+                        bin left, right;
+
+                        if (count > 1 && depth < maxsahdepth && (extent[0] > 0.0f || extent[1] > 0.0f || extent[2] > 0.0f))
+                            findsplit(begin, end, centroids, axis, split, cost, left, right);
+
+                        // Traversal and intersection costs are both 1, the sweep cost is relative to this node's area
+                        f32 splitcost = 1.0f + cost / bounds.area();
+
+                        if (count <= settings.maxleafsize && (axis < 0 || static_cast<f32>(count) <= splitcost))
+                        {
+                            n.first = begin;
+                            n.count = count;
+
+                            return;
+                        }
+
+                        u32 mid = begin;
+                        bin leftcentroids, rightcentroids;
+
+                        if (axis >= 0)
+                            mid = partition(begin, end, axis, origin[axis], static_cast<f32>(settings.bins) / extent[axis], split, leftcentroids, rightcentroids);
+
+                        // Coincident centroids, a sweep that could not separate them or a range below maxsahdepth split in half
+                        if (mid == begin || mid == end)
+                        {
+                            mid = begin + count / 2;
+                            left = boundsof(begin, mid, leftcentroids);
+                            right = boundsof(mid, end, rightcentroids);
+                        }
+
+                        u32 l = next.fetch_add(2);
+                        n.left = l;
+
+                        u32 childdepth = paralleldepth > 0 ? paralleldepth - 1 : 0;
+
+                        parallelinvoke(paralleldepth > 0 && count > 4096,
+                            [&]() { subdivide(l, begin, mid, left, leftcentroids, childdepth, depth + 1); },
+                            [&]() { subdivide(l + 1, mid, end, right, rightcentroids, childdepth, depth + 1); });
+                    }
+
+                    static inline u32 binindex(f32 c, f32 origin, f32 scale, u32 last) noexcept
+                    {
+                        s32 b = static_cast<s32>((c - origin) * scale);
+
+                        return b < 0 ? 0 : (static_cast<u32>(b) > last ? last : static_cast<u32>(b));
+                    }
+
+                    // Hoare partition on the split plane that also gathers the centroid bounds of both sides
+                    u32 partition(u32 begin, u32 end, s32 axis, f32 origin, f32 scale, u32 split, bin& leftcentroids, bin& rightcentroids) noexcept
+                    {
+                        u32 last = settings.bins - 1;
+                        u32 i = begin, j = end;
+
+                        leftcentroids.clear();
+                        rightcentroids.clear();
+
+                        auto isleft = [&](const aabb<f32>& ref)
+                        {
+                            return binindex(ref.min.v[axis] + ref.max.v[axis], origin, scale, last) <= split;
+                        };
+
+                        while (true)
+                        {
+                            for (; i < j && isleft(refs[i]); i++)
+                            {
+                                __m128 c = _mm_add_ps(simd::load(refs[i].min.v), simd::load(refs[i].max.v));
+
+                                leftcentroids.add(c, c);
+                            }
+
+                            for (; i < j && !isleft(refs[j - 1]); j--)
+                            {
+                                __m128 c = _mm_add_ps(simd::load(refs[j - 1].min.v), simd::load(refs[j - 1].max.v));
+
+                                rightcentroids.add(c, c);
+                            }
+
+                            if (i >= j)
+                                return i;
+
+                            // vec3 copies clear lane 3, so the refs are swapped as raw registers to keep the index
+                            __m128 lo = simd::load(refs[i].min.v), hi = simd::load(refs[i].max.v);
+
+                            simd::store(refs[i].min.v, simd::load(refs[j - 1].min.v));
+                            simd::store(refs[i].max.v, simd::load(refs[j - 1].max.v));
+                            simd::store(refs[j - 1].min.v, lo);
+                            simd::store(refs[j - 1].max.v, hi);
+                        }
+                    }
+
+                    bin boundsof(u32 begin, u32 end, bin& centroids) const noexcept
+                    {
+                        bin res;
+                        res.clear();
+                        centroids.clear();
+
+                        for (u32 i = begin; i < end; i++)
+                        {
+                            __m128 lo = simd::load(refs[i].min.v), hi = simd::load(refs[i].max.v);
+                            __m128 c = _mm_add_ps(lo, hi);
+
+                            res.add(lo, hi);
+                            centroids.add(c, c);
+                        }
+
+                        return res;
+                    }
+
+                    // Bins [first, last) on all three axes at once
+                    void accumulate(u32 first, u32 last, __m128 origin, __m128 scale, bin (*grid)[maxbins]) const noexcept
+                    {
+                        __m128i zero = _mm_setzero_si128();
+                        __m128i top = _mm_set1_epi32(static_cast<s32>(settings.bins - 1));
+
+                        for (u32 i = first; i < last; i++)
+                        {
+                            __m128 lo = simd::load(refs[i].min.v), hi = simd::load(refs[i].max.v);
+                            __m128i b = _mm_cvttps_epi32(_mm_mul_ps(_mm_sub_ps(_mm_add_ps(lo, hi), origin), scale));
+
+                            b = _mm_min_epi32(_mm_max_epi32(b, zero), top);
+
+                            grid[0][_mm_cvtsi128_si32(b)].add(lo, hi);
+                            grid[1][_mm_extract_epi32(b, 1)].add(lo, hi);
+                            grid[2][_mm_extract_epi32(b, 2)].add(lo, hi);
+                        }
+                    }
+
+                    void findsplit(u32 begin, u32 end, const bin& centroids, s32& bestaxis, u32& bestsplit, f32& bestcost, bin& bestleft, bin& bestright)
+                    {
+                        u32 bins = settings.bins;
+
+                        alignas(16) f32 extent[4], scale[4];
+                        simd::store(extent, _mm_sub_ps(centroids.max, centroids.min));
+
+                        for (s32 a = 0; a < 4; a++)
+                        {
+                            scale[a] = a < 3 && extent[a] > 0.0f ? static_cast<f32>(bins) / extent[a] : 0.0f;
+                        }
+
+                        bin grid[3][maxbins];
+
+                        for (u32 a = 0; a < 3; a++)
+                        {
+                            for (u32 b = 0; b < bins; b++)
+                            {
+                                grid[a][b].clear();
+                            }
+                        }
+
+                        u32 count = end - begin;
+
+                        if (count >= 65536 && threads > 1)
+                        {
+                            std::vector<bin> partial(threads * 3 * maxbins);
+
+                            parallelfor(begin, end, 16384, [&](size_t first, size_t last, u32 thread)
+                            {
+                                bin (*local)[maxbins] = reinterpret_cast<bin (*)[maxbins]>(partial.data() + thread * 3 * maxbins);
+
+                                for (u32 a = 0; a < 3; a++)
+                                {
+                                    for (u32 b = 0; b < bins; b++)
+                                    {
+                                        local[a][b].clear();
+                                    }
+                                }
+
+                                accumulate(static_cast<u32>(first), static_cast<u32>(last), centroids.min, simd::load(scale), local);
+                            }, threads);
+
+                            for (u32 t = 0; t < threads; t++)
+                            {
+                                for (u32 a = 0; a < 3; a++)
+                                {
+                                    for (u32 b = 0; b < bins; b++)
+                                    {
+                                        const bin& p = partial[(t * 3 + a) * maxbins + b];
+
+                                        if (p.count != 0)
+                                            grid[a][b].merge(p);
+                                    }
+                                }
+                            }
+                        }
+                        else
+                        {
+                            accumulate(begin, end, centroids.min, simd::load(scale), grid);
+                        }
+
+                        for (s32 a = 0; a < 3; a++)
+                        {
+                            if (extent[a] <= 0.0f)
+                                continue;
+
+                            // Suffix sweep from the right, then a prefix sweep that evaluates every plane
+                            bin suffix[maxbins];
+                            bin acc;
+                            acc.clear();
+
+                            for (u32 b = bins - 1; b > 0; b--)
+                            {
+                                acc.merge(grid[a][b]);
+                                suffix[b] = acc;
+                            }
+
+                            acc.clear();
+
+                            for (u32 b = 0; b + 1 < bins; b++)
+                            {
+                                acc.merge(grid[a][b]);
+
+                                const bin& r = suffix[b + 1];
+
+                                if (acc.count == 0 || r.count == 0)
+                                    continue;
+
+                                f32 cost = acc.area() * static_cast<f32>(acc.count) + r.area() * static_cast<f32>(r.count);
+
+                                if (cost < bestcost)
+                                {
+                                    bestcost = cost;
+                                    bestaxis = a;
+                                    bestsplit = b;
+                                    bestleft = acc;
+                                    bestright = r;
+                                }
+                            }
+                        }
+                    }
+
+                    // Data
+                    bvhsettings settings;
+                    u32 threads;
+                    std::vector<aabb<f32>> refs;
+                    std::vector<u32> indices;
+                    std::vector<buildnode> nodes;
+                    std::atomic<u32> next;
+            };
+
+            // Morton ordered build, nodes use the same layout as the SAH builder
+            class linearbuilder
+            {
+                public:
+                    linearbuilder(const aabb<f32>* boxes, size_t count, const bvhsettings& settings) : boxes(boxes), settings(settings),
+                        threads(threadcount(settings.threads)), codes(count), indices(count), nodes(count > 0 ? 2 * count - 1 : 0), next(1)
+                    {
+                        SML_ASSERT(settings.maxleafsize >= 1);
+
+                        if (count == 0)
+                            return;
+
+                        // Codes are computed from doubled centroids, so the grid spans the doubled centroid bounds
+                        std::vector<bin> partial(threads);
+
+                        parallelfor(0, count, 16384, [&](size_t begin, size_t end, u32 thread)
+                        {
+                            bin& centroids = partial[thread];
+                            centroids.clear();
+
+                            for (size_t i = begin; i < end; i++)
+                            {
+                                __m128 c = _mm_add_ps(simd::load(boxes[i].min.v), simd::load(boxes[i].max.v));
+
+                                centroids.add(c, c);
+                            }
+                        }, threads);
+
+                        bin centroids;
+                        centroids.clear();
+
+                        for (u32 t = 0; t < threads; t++)
+                        {
+                            if (partial[t].count != 0)
+                                centroids.merge(partial[t]);
+                        }
+
+                        // Same quantisation as morton30(point, bounds) with the scale hoisted out of the loop
+                        __m128 extent = _mm_sub_ps(centroids.max, centroids.min);
+                        __m128 scale = _mm_and_ps(_mm_div_ps(_mm_set1_ps(1024.0f), extent), _mm_cmpgt_ps(extent, _mm_setzero_ps()));
+                        __m128 top = _mm_set1_ps(1023.0f);
+
+                        parallelfor(0, count, 16384, [&](size_t begin, size_t end, u32)
+                        {
+                            for (size_t i = begin; i < end; i++)
+                            {
+                                __m128 c = _mm_add_ps(simd::load(boxes[i].min.v), simd::load(boxes[i].max.v));
+                                __m128 q = _mm_mul_ps(_mm_sub_ps(c, centroids.min), scale);
+                                __m128i cell = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(q, _mm_setzero_ps()), top));
+
+                                codes[i] = morton30(static_cast<u32>(_mm_cvtsi128_si32(cell)), static_cast<u32>(_mm_extract_epi32(cell, 1)), static_cast<u32>(_mm_extract_epi32(cell, 2)));
+                                indices[i] = static_cast<u32>(i);
+                            }
+                        }, threads);
+
+                        radixsort(codes.data(), indices.data(), count, threads);
+
+                        u32 depth = 0;
+                        while ((1u << depth) < threads * 4)
+                        {
+                            depth++;
+                        }
+
+                        emit(0, 0, static_cast<u32>(count), threads > 1 ? depth : 0);
+                    }
+
+                    void emit(u32 node, u32 begin, u32 end, u32 paralleldepth)
+                    {
+                        u32 count = end - begin;
+                        buildnode& n = nodes[node];
+
+                        if (count <= settings.maxleafsize)
+                        {
+                            bin bounds;
+                            bounds.clear();
+
+                            for (u32 i = begin; i < end; i++)
+                            {
+                                bounds.add(simd::load(boxes[indices[i]].min.v), simd::load(boxes[indices[i]].max.v));
+                            }
+
+                            n.bounds = bounds.bounds();
+                            n.first = begin;
+                            n.count = count;
+
+                            return;
+                        }
+
+                        u32 mid = begin + count / 2;
+                        u32 first = codes[begin], last = codes[end - 1];
+
+                        // Codes are sorted, so the range shares every bit above the highest differing one
+                        // and that bit is clear in a prefix of the range and set in the rest
+                        if (first != last)
+                        {
+                            u32 bit = 1u << highestbit(first ^ last);
+
+                            mid = static_cast<u32>(std::partition_point(codes.begin() + begin, codes.begin() + end,
+                                [bit](u32 code) { return (code & bit) == 0; }) - codes.begin());
+                        }
+
+                        u32 l = next.fetch_add(2);
+                        n.left = l;
+
+                        u32 childdepth = paralleldepth > 0 ? paralleldepth - 1 : 0;
+
+                        parallelinvoke(paralleldepth > 0 && count > 4096,
+                            [&]() { emit(l, begin, mid, childdepth); },
+                            [&]() { emit(l + 1, mid, end, childdepth); });
+
+                        n.bounds = nodes[l].bounds;
+                        n.bounds.expand(nodes[l + 1].bounds);
+                    }
+
+                    // Data
+                    const aabb<f32>* boxes;
+                    bvhsettings settings;
+                    u32 threads;
+                    std::vector<u32> codes;
+                    std::vector<u32> indices;
+                    std::vector<buildnode> nodes;
+                    std::atomic<u32> next;
+            };
+
+            // Turns the binary tree of a builder into the eight wide node array. The first pass counts the
+            // wide nodes of every subtree so the second can place them in depth first order from any thread,
+            // which keeps the layout identical for every thread count.
+            void assemble(std::vector<buildnode>& source, u32 threads)
+            {
+                nodes.clear();
+
+                if (source.empty())
+                {
+                    nodes.emplace_back();
+
+                    return;
+                }
+
+                if (source[0].count > 0)
+                {
+                    // The whole tree is one leaf
+                    nodes.emplace_back();
+                    nodes[0].bounds.set(0, source[0].bounds);
+                    nodes[0].child[0] = source[0].first;
+                    nodes[0].count[0] = source[0].count;
+
+                    return;
+                }
+
+                // Two levels of eight wide nodes give up to 64 independent subtrees
+                u32 paralleldepth = threadcount(threads) > 1 ? 2 : 0;
+
+                nodes.resize(plan(source, 0, paralleldepth));
+                collapse(source, 0, 0, paralleldepth);
+            }
+
+            // Pulls grandchildren up into the slots of a wide node, always opening the largest inner child
+            static u32 gather(const std::vector<buildnode>& source, u32 node, u32 (&slots)[8]) noexcept
+            {
+                f32 areas[8];
+                u32 used = 2;
+
+                slots[0] = source[node].left;
+                slots[1] = source[node].left + 1;
+
+                for (u32 i = 0; i < used; i++)
+                {
+                    const buildnode& s = source[slots[i]];
+                    areas[i] = s.count == 0 ? s.bounds.surfacearea() : -1.0f;
+                }
+
+                while (used < 8)
+                {
+                    s32 largest = -1;
+                    f32 area = -1.0f;
+
+                    for (u32 i = 0; i < used; i++)
+                    {
+                        if (areas[i] > area)
+                        {
+                            largest = static_cast<s32>(i);
+                            area = areas[i];
+                        }
+                    }
+
+                    if (largest < 0)
+                        break;
+
+                    u32 open = slots[largest];
+                    slots[largest] = source[open].left;
+                    slots[used] = source[open].left + 1;
+
+                    for (u32 i : { static_cast<u32>(largest), used })
+                    {
+                        const buildnode& s = source[slots[i]];
+                        areas[i] = s.count == 0 ? s.bounds.surfacearea() : -1.0f;
+                    }
+
+                    used++;
+                }
+
+                return used;
+            }
+
+            // Counts the wide nodes of the subtree below node, inner binary nodes do not use first so the
+            // count of every wide subtree root is kept there for collapse
+            static u32 plan(std::vector<buildnode>& source, u32 node, u32 paralleldepth)
+            {
+                u32 slots[8];
+                u32 used = gather(source, node, slots);
+                u32 sizes[8] = {};
+
+                parallelfor(0, used, 1, [&](size_t begin, size_t end, u32)
+                {
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        if (source[slots[i]].count == 0)
+                            sizes[i] = plan(source, slots[i], paralleldepth > 0 ? paralleldepth - 1 : 0);
+                    }
+                }, paralleldepth > 0 ? used : 1);
+
+                u32 total = 1;
+                for (u32 i = 0; i < used; i++)
+                {
+                    total += sizes[i];
+                }
+
+                source[node].first = total;
+
+                return total;
+            }
+
+            void collapse(const std::vector<buildnode>& source, u32 node, u32 index, u32 paralleldepth)
+            {
+                u32 slots[8];
+                u32 used = gather(source, node, slots);
+                u32 next = index + 1;
+
+                for (u32 i = 0; i < used; i++)
+                {
+                    const buildnode& s = source[slots[i]];
+
+                    nodes[index].bounds.set(static_cast<s32>(i), s.bounds);
+                    nodes[index].count[i] = s.count;
+
+                    if (s.count > 0)
+                    {
+                        nodes[index].child[i] = s.first;
+                    }
+                    else
+                    {
+                        nodes[index].child[i] = next;
+                        next += s.first;
+                    }
+                }
+
+                parallelfor(0, used, 1, [&](size_t begin, size_t end, u32)
+                {
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        if (source[slots[i]].count == 0)
+                            collapse(source, slots[i], nodes[index].child[i], paralleldepth > 0 ? paralleldepth - 1 : 0);
+                    }
+                }, paralleldepth > 0 ? used : 1);
+            }
+
+            // Fills parents, leafslots and depths, and picks the nodes two levels below the root as subtrees
+            void link(u32 threads)
+            {
+                parents.assign(nodes.size(), ~0u);
+                leafslots.resize(indices.size());
+                depths.assign(nodes.size(), 0);
+
+                parallelfor(0, nodes.size(), 4096, [&](size_t begin, size_t end, u32)
+                {
+                    for (size_t n = begin; n < end; n++)
+                    {
+                        const bvhnode8& node = nodes[n];
+
+                        for (u32 i = 0; i < 8; i++)
+                        {
+                            if (node.child[i] == ~0u)
+                                continue;
+
+                            u32 slot = static_cast<u32>(n) * 8 + i;
+
+                            if (node.count[i] > 0)
+                            {
+                                for (u32 k = node.child[i]; k < node.child[i] + node.count[i]; k++)
+                                {
+                                    leafslots[indices[k]] = slot;
+                                }
+                            }
+                            else
+                            {
+                                parents[node.child[i]] = slot;
+                            }
+                        }
+                    }
+                }, threads);
+
+                // Parents come before their children, so one forward pass settles every depth
+                height = 0;
+
+                for (size_t n = 1; n < nodes.size(); n++)
+                {
+                    depths[n] = static_cast<u8>(depths[parents[n] >> 3] + 1);
+                    height = std::max(height, static_cast<u32>(depths[n]));
+                }
+
+                u32 level = std::min(height, 2u);
+                subtrees.clear();
+
+                for (u32 n = 0; n < static_cast<u32>(nodes.size()); n++)
+                {
+                    if (depths[n] == level)
+                        subtrees.push_back(n);
+                }
+            }
+
+            inline void mark(u32 slot, std::vector<u8>& dirty, std::vector<std::vector<u32>>& levels) const
+            {
+                u32 n = slot >> 3;
+
+                if (dirty[n] == 0)
+                    levels[depths[n]].push_back(n);
+
+                dirty[n] |= static_cast<u8>(1u << (slot & 7));
+            }
+
+            // Refits the dirty slots one level at a time from the deepest up, nodes of one level only write
+            // their own slots so each level is split across threads
+            void propagate(const aabb<f32>* boxes, std::vector<u8>& dirty, std::vector<std::vector<u32>>& levels, u32 threads)
+            {
+                for (u32 level = height + 1; level-- > 0;)
+                {
+                    const std::vector<u32>& list = levels[level];
+
+                    parallelfor(0, list.size(), 1024, [&](size_t begin, size_t end, u32)
+                    {
+                        for (size_t k = begin; k < end; k++)
+                        {
+                            bvhnode8& node = nodes[list[k]];
+
+                            for (u32 mask = dirty[list[k]]; mask != 0; mask &= mask - 1)
+                            {
+                                u32 i = lowestbit(mask);
+
+                                if (node.count[i] == 0)
+                                {
+                                    node.bounds.set(static_cast<s32>(i), nodes[node.child[i]].bounds.bounds());
+
+                                    continue;
+                                }
+
+                                __m128 lo = _mm_set1_ps(std::numeric_limits<f32>::infinity());
+                                __m128 hi = _mm_set1_ps(-std::numeric_limits<f32>::infinity());
+
+                                for (u32 p = node.child[i]; p < node.child[i] + node.count[i]; p++)
+                                {
+                                    lo = _mm_min_ps(lo, simd::load(boxes[indices[p]].min.v));
+                                    hi = _mm_max_ps(hi, simd::load(boxes[indices[p]].max.v));
+                                }
+
+                                aabb<f32> box;
+                                simd::store(box.min.v, _mm_blend_ps(lo, _mm_setzero_ps(), 0x8));
+                                simd::store(box.max.v, _mm_blend_ps(hi, _mm_setzero_ps(), 0x8));
+
+                                node.bounds.set(static_cast<s32>(i), box);
+                            }
+                        }
+                    }, threads);
+
+                    if (level == 0)
+                        break;
+
+                    for (u32 n : list)
+                    {
+                        mark(parents[n], dirty, levels);
+                    }
+                }
+            }
+
+            // SAH cost of the subtree below node relative to the area of its bounds
+            SML_NO_DISCARD f32 cost(u32 node) const noexcept
+            {
+                f32 area = nodes[node].bounds.bounds().surfacearea();
+
+                return area > 0.0f ? subtreecost(node) / area : 0.0f;
+            }
+
+            SML_NO_DISCARD f32 subtreecost(u32 node) const noexcept
+            {
+                const bvhnode8& n = nodes[node];
+
+                alignas(32) f32 areas[8];
+                _mm256_store_ps(areas, n.bounds.surfaceareas());
+
+                f32 res = 0.0f;
+
+                for (u32 i = 0; i < 8; i++)
+                {
+                    if (n.child[i] == ~0u)
+                        continue;
+
+                    if (n.count[i] > 0)
+                        res += areas[i] * static_cast<f32>(n.count[i]);
+                    else
+                        res += areas[i] + subtreecost(n.child[i]);
+                }
+
+                return res;
+            }
+
+            // Costs of every subtree relative to its own area and of the whole tree, the subtrees are
+            // measured in parallel and the levels above them reuse their costs
+            void measure(u32 threads, std::vector<f32>& relative, f32& total) const
+            {
+                std::vector<f32> absolute(subtrees.size());
+                relative.resize(subtrees.size());
+
+                parallelfor(0, subtrees.size(), 1, [&](size_t begin, size_t end, u32)
+                {
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        f32 area = nodes[subtrees[i]].bounds.bounds().surfacearea();
+
+                        absolute[i] = subtreecost(subtrees[i]);
+                        relative[i] = area > 0.0f ? absolute[i] / area : 0.0f;
+                    }
+                }, threads);
+
+                f32 area = nodes[0].bounds.bounds().surfacearea();
+
+                total = area > 0.0f ? uppercost(0, absolute) / area : 0.0f;
+            }
+
+            SML_NO_DISCARD f32 uppercost(u32 node, const std::vector<f32>& absolute) const noexcept
+            {
+                auto subtree = std::lower_bound(subtrees.begin(), subtrees.end(), node);
+
+                if (subtree != subtrees.end() && *subtree == node)
+                    return absolute[static_cast<size_t>(subtree - subtrees.begin())];
+
+                const bvhnode8& n = nodes[node];
+
+                alignas(32) f32 areas[8];
+                _mm256_store_ps(areas, n.bounds.surfaceareas());
+
+                f32 res = 0.0f;
+
+                for (u32 i = 0; i < 8; i++)
+                {
+                    if (n.child[i] == ~0u)
+                        continue;
+
+                    if (n.count[i] > 0)
+                        res += areas[i] * static_cast<f32>(n.count[i]);
+                    else
+                        res += areas[i] + uppercost(n.child[i], absolute);
+                }
+
+                return res;
+            }
+
+            // One past the last node of the subtree below node, the last inner child is laid out last
+            SML_NO_DISCARD u32 subtreeend(u32 node) const noexcept
+            {
+                while (true)
+                {
+                    u32 last = 0;
+
+                    for (u32 i = 0; i < 8; i++)
+                    {
+                        if (nodes[node].child[i] != ~0u && nodes[node].count[i] == 0)
+                            last = std::max(last, nodes[node].child[i]);
+                    }
+
+                    if (last == 0)
+                        return node + 1;
+
+                    node = last;
+                }
+            }
+
+            // Builds a fresh SAH subtree over the primitives below node and splices it over the old nodes.
+            // Every subtree covers a contiguous range of indices, so only that range is reordered.
+            void rebuild(const aabb<f32>* boxes, u32 node, const bvhsettings& settings)
+            {
+                u32 end = subtreeend(node);
+                u32 first = ~0u, last = 0;
+
+                for (u32 n = node; n < end; n++)
+                {
+                    for (u32 i = 0; i < 8; i++)
+                    {
+                        if (nodes[n].child[i] != ~0u && nodes[n].count[i] > 0)
+                        {
+                            first = std::min(first, nodes[n].child[i]);
+                            last = std::max(last, nodes[n].child[i] + nodes[n].count[i]);
+                        }
+                    }
+                }
+
+                std::vector<aabb<f32>> gathered(last - first);
+                std::vector<u32> previous(indices.begin() + first, indices.begin() + last);
+
+                for (u32 k = first; k < last; k++)
+                {
+                    gathered[k - first] = boxes[indices[k]];
+                }
+
+                builder b(gathered.data(), gathered.size(), settings);
+
+                bvh part;
+                part.assemble(b.nodes, settings.threads);
+
+                for (u32 k = first; k < last; k++)
+                {
+                    indices[k] = previous[b.indices[k - first]];
+                }
+
+                for (bvhnode8& n : part.nodes)
+                {
+                    for (u32 i = 0; i < 8; i++)
+                    {
+                        if (n.child[i] != ~0u)
+                            n.child[i] += n.count[i] > 0 ? first : node;
+                    }
+                }
+
+                // Nodes outside the subtree that point past it move by the change in size
+                s64 delta = static_cast<s64>(part.nodes.size()) - static_cast<s64>(end - node);
+
+                auto shift = [&](bvhnode8& n)
+                {
+                    for (u32 i = 0; i < 8; i++)
+                    {
+                        if (n.child[i] != ~0u && n.count[i] == 0 && n.child[i] >= end)
+                            n.child[i] = static_cast<u32>(static_cast<s64>(n.child[i]) + delta);
+                    }
+                };
+
+                for (u32 n = 0; n < node; n++)
+                {
+                    shift(nodes[n]);
+                }
+
+                for (size_t n = end; n < nodes.size(); n++)
+                {
+                    shift(nodes[n]);
+                }
+
+                nodes.erase(nodes.begin() + node, nodes.begin() + end);
+                nodes.insert(nodes.begin() + node, part.nodes.begin(), part.nodes.end());
+            }
+    };
+} // namespace sml
+
+#endif // sml_bvh_h__
@@ -0,0 +1,330 @@
+#ifndef sml_closest_h__
+#define sml_closest_h__
+
+/* closest.h -- closest point queries of the 'Simple Math Library'
+  Copyright (C) 2020 Roderick Griffioen
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+
+#include <limits>
+#include <immintrin.h>
+
+#include "smltypes.h"
+#include "common.h"
+#include "simd.h"
+#include "vec3.h"
+#include "vec3x8.h"
+
+namespace sml
+{
+    // Closest points on segments and triangles after Ericson, Real-Time Collision Detection 5.1. Segments
+    // of zero length act as points, parallel segments pick the pair at s = 0 and triangles of zero area
+    // fall back to their closest edge. The 8-wide versions answer eight independent queries in SoA
+    // layout without branching on the region each query falls in.
+
+    // Closest point of segment ab to p, t receives its weight of b
+    template<typename T>
+    SML_NO_DISCARD inline vec3<T> closestpointsegment(const vec3<T>& p, const vec3<T>& a, const vec3<T>& b, T& t) noexcept
+    {
+        vec3<T> ab = b - a;
+        T length = vec3<T>::dot(ab, ab);
+
+        t = length > static_cast<T>(0) ? clamp(vec3<T>::dot(p - a, ab) / length, static_cast<T>(0), static_cast<T>(1)) : static_cast<T>(0);
+
+        return a + ab * t;
+    }
+
+    // Closest points c1 = p1 + s (q1 - p1) and c2 = p2 + t (q2 - p2) of two segments, returns their
+    // squared distance
+    template<typename T>
+    inline T closestsegmentsegment(const vec3<T>& p1, const vec3<T>& q1, const vec3<T>& p2, const vec3<T>& q2, T& s, T& t, vec3<T>& c1, vec3<T>& c2) noexcept
+    {
+        const T zero = static_cast<T>(0), one = static_cast<T>(1);
+        const T epsilon = std::numeric_limits<T>::epsilon() * std::numeric_limits<T>::epsilon();
+
+        vec3<T> d1 = q1 - p1, d2 = q2 - p2, r = p1 - p2;
+        T a = vec3<T>::dot(d1, d1), e = vec3<T>::dot(d2, d2), f = vec3<T>::dot(d2, r);
+
+        if (a <= epsilon && e <= epsilon)
+        {
+            s = t = zero;
+        }
+        else if (a <= epsilon)
+        {
+            s = zero;
+            t = clamp(f / e, zero, one);
+        }
+        else
+        {
+            T c = vec3<T>::dot(d1, r);
+
+            if (e <= epsilon)
+            {
+                t = zero;
+                s = clamp(-c / a, zero, one);
+            }
+            else
+            {
+                T b = vec3<T>::dot(d1, d2);
+                T denominator = a * e - b * b;
+
+                s = denominator > std::numeric_limits<T>::epsilon() * a * e ? clamp((b * f - c * e) / denominator, zero, one) : zero;
+                t = (b * s + f) / e;
+
+                if (t < zero)
+                {
+                    t = zero;
+                    s = clamp(-c / a, zero, one);
+                }
+                else if (t > one)
+                {
+                    t = one;
+                    s = clamp((b - c) / a, zero, one);
+                }
+            }
+        }
+
+        c1 = p1 + d1 * s;
+        c2 = p2 + d2 * t;
+
+        return (c2 - c1).lengthsquared();
+    }
+
+    // Closest point of triangle abc to p, barycentric receives its weights of a, b and c
+    template<typename T>
+    SML_NO_DISCARD inline vec3<T> closestpointtriangle(const vec3<T>& p, const vec3<T>& a, const vec3<T>& b, const vec3<T>& c, vec3<T>& barycentric) noexcept
+    {
+        const T zero = static_cast<T>(0), one = static_cast<T>(1);
+
+        vec3<T> ab = b - a, ac = c - a, ap = p - a;
+        T d1 = vec3<T>::dot(ab, ap), d2 = vec3<T>::dot(ac, ap);
+
+        if (d1 <= zero && d2 <= zero)
+        {
+            barycentric = vec3<T>(one, zero, zero);
+            return a;
+        }
+
+        vec3<T> bp = p - b;
+        T d3 = vec3<T>::dot(ab, bp), d4 = vec3<T>::dot(ac, bp);
+
+        if (d3 >= zero && d4 <= d3)
+        {
+            barycentric = vec3<T>(zero, one, zero);
+            return b;
+        }
+
+        T vc = d1 * d4 - d3 * d2;
+
+        if (vc <= zero && d1 >= zero && d3 <= zero && d1 > d3)
+        {
+            T v = d1 / (d1 - d3);
+
+            barycentric = vec3<T>(one - v, v, zero);
+            return a + ab * v;
+        }
+
+        vec3<T> cp = p - c;
+        T d5 = vec3<T>::dot(ab, cp), d6 = vec3<T>::dot(ac, cp);
+
+        if (d6 >= zero && d5 <= d6)
+        {
+            barycentric = vec3<T>(zero, zero, one);
+            return c;
+        }
+
+        T vb = d5 * d2 - d1 * d6;
+
+        if (vb <= zero && d2 >= zero && d6 <= zero && d2 > d6)
+        {
+            T w = d2 / (d2 - d6);
+
+            barycentric = vec3<T>(one - w, zero, w);
+            return a + ac * w;
+        }
+
+        T va = d3 * d6 - d5 * d4;
+        T bc = d4 - d3, cb = d5 - d6;
+
+        if (va <= zero && bc >= zero && cb >= zero && bc + cb > zero)
+        {
+            T w = bc / (bc + cb);
+
+            barycentric = vec3<T>(zero, one - w, w);
+            return b + (c - b) * w;
+        }
+
+        // va + vb + vc is the squared area scaled by four, compared against the squared edge lengths
+        T sum = va + vb + vc;
+
+        if (!(sum > std::numeric_limits<T>::epsilon() * vec3<T>::dot(ab, ab) * vec3<T>::dot(ac, ac)))
+        {
+            T tab, tac, tbc;
+            vec3<T> pab = closestpointsegment(p, a, b, tab);
+            vec3<T> pac = closestpointsegment(p, a, c, tac);
+            vec3<T> pbc = closestpointsegment(p, b, c, tbc);
+
+            T dab = (pab - p).lengthsquared(), dac = (pac - p).lengthsquared(), dbc = (pbc - p).lengthsquared();
+
+            if (dab <= dac && dab <= dbc)
+            {
+                barycentric = vec3<T>(one - tab, tab, zero);
+                return pab;
+            }
+
+            if (dac <= dbc)
+            {
+                barycentric = vec3<T>(one - tac, zero, tac);
+                return pac;
+            }
+
+            barycentric = vec3<T>(zero, one - tbc, tbc);
+            return pbc;
+        }
+
+        T v = vb / sum, w = vc / sum;
+
+        barycentric = vec3<T>(one - v - w, v, w);
+        return a + ab * v + ac * w;
+    }
+
+    // 8-wide versions
+
+    inline vec3x8 closestpointsegment(const vec3x8& p, const vec3x8& a, const vec3x8& b, __m256& t) noexcept
+    {
+        vec3x8 ab = b - a;
+
+        // Zero length segments divide 0 by 0, the clamp turns the NaN into 0
+        t = simd::clamp(_mm256_div_ps(vec3x8::dot(p - a, ab), ab.lengthsquared()), _mm256_setzero_ps(), _mm256_set1_ps(1.0f));
+
+        return a + ab * t;
+    }
+
+    inline __m256 closestsegmentsegment(const vec3x8& p1, const vec3x8& q1, const vec3x8& p2, const vec3x8& q2, __m256& s, __m256& t, vec3x8& c1, vec3x8& c2) noexcept
+    {
+        const f32 epsilon = std::numeric_limits<f32>::epsilon();
+        __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+
+        vec3x8 d1 = q1 - p1, d2 = q2 - p2, r = p1 - p2;
+        __m256 a = d1.lengthsquared(), e = d2.lengthsquared();
+        __m256 f = vec3x8::dot(d2, r), c = vec3x8::dot(d1, r), b = vec3x8::dot(d1, d2);
+        __m256 ae = _mm256_mul_ps(a, e);
+        __m256 denominator = _mm256_sub_ps(ae, _mm256_mul_ps(b, b));
+
+        __m256 inversea = _mm256_div_ps(one, a), inversee = _mm256_div_ps(one, e);
+        __m256 nearesta = simd::clamp(_mm256_mul_ps(_mm256_sub_ps(zero, c), inversea), zero, one);
+
+        // The clamps turn the NaNs of divisions by zero into 0
+        __m256 parallel = _mm256_cmp_ps(denominator, _mm256_mul_ps(_mm256_set1_ps(epsilon), ae), _CMP_LE_OQ);
+
+        s = simd::clamp(_mm256_div_ps(_mm256_sub_ps(_mm256_mul_ps(b, f), _mm256_mul_ps(c, e)), denominator), zero, one);
+        s = _mm256_andnot_ps(parallel, s);
+        t = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(b, s), f), inversee);
+
+        s = simd::select(_mm256_cmp_ps(t, zero, _CMP_LT_OQ), s, nearesta);
+        s = simd::select(_mm256_cmp_ps(t, one, _CMP_GT_OQ), s, simd::clamp(_mm256_mul_ps(_mm256_sub_ps(b, c), inversea), zero, one));
+        t = simd::clamp(t, zero, one);
+
+        __m256 tiny = _mm256_set1_ps(epsilon * epsilon);
+        __m256 pointa = _mm256_cmp_ps(a, tiny, _CMP_LE_OQ), pointb = _mm256_cmp_ps(e, tiny, _CMP_LE_OQ);
+
+        s = _mm256_andnot_ps(pointa, s);
+        t = simd::select(pointa, t, simd::clamp(_mm256_mul_ps(f, inversee), zero, one));
+        s = simd::select(pointb, s, _mm256_andnot_ps(pointa, nearesta));
+        t = _mm256_andnot_ps(pointb, t);
+
+        c1 = p1 + d1 * s;
+        c2 = p2 + d2 * t;
+
+        return (c2 - c1).lengthsquared();
+    }
+
+    inline vec3x8 closestpointtriangle(const vec3x8& p, const vec3x8& a, const vec3x8& b, const vec3x8& c, vec3x8& barycentric) noexcept
+    {
+        __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+
+        vec3x8 ab = b - a, ac = c - a, ap = p - a, bp = p - b, cp = p - c;
+        __m256 d1 = vec3x8::dot(ab, ap), d2 = vec3x8::dot(ac, ap);
+        __m256 d3 = vec3x8::dot(ab, bp), d4 = vec3x8::dot(ac, bp);
+        __m256 d5 = vec3x8::dot(ab, cp), d6 = vec3x8::dot(ac, cp);
+
+        __m256 va = _mm256_sub_ps(_mm256_mul_ps(d3, d6), _mm256_mul_ps(d5, d4));
+        __m256 vb = _mm256_sub_ps(_mm256_mul_ps(d5, d2), _mm256_mul_ps(d1, d6));
+        __m256 vc = _mm256_sub_ps(_mm256_mul_ps(d1, d4), _mm256_mul_ps(d3, d2));
+        __m256 bc = _mm256_sub_ps(d4, d3), cb = _mm256_sub_ps(d5, d6);
+
+        auto le = [](__m256 x, __m256 y) { return _mm256_cmp_ps(x, y, _CMP_LE_OQ); };
+        auto ge = [](__m256 x, __m256 y) { return _mm256_cmp_ps(x, y, _CMP_GE_OQ); };
+
+        // Voronoi regions in the order the scalar version tests them, earlier regions win
+        __m256 ina = _mm256_and_ps(le(d1, zero), le(d2, zero));
+        __m256 inb = _mm256_and_ps(ge(d3, zero), le(d4, d3));
+        __m256 inab = _mm256_and_ps(_mm256_and_ps(le(vc, zero), ge(d1, zero)), _mm256_and_ps(le(d3, zero), _mm256_cmp_ps(d1, d3, _CMP_GT_OQ)));
+        __m256 inc = _mm256_and_ps(ge(d6, zero), le(d5, d6));
+        __m256 inac = _mm256_and_ps(_mm256_and_ps(le(vb, zero), ge(d2, zero)), _mm256_and_ps(le(d6, zero), _mm256_cmp_ps(d2, d6, _CMP_GT_OQ)));
+        __m256 inbc = _mm256_and_ps(_mm256_and_ps(le(va, zero), ge(bc, zero)), _mm256_and_ps(ge(cb, zero), _mm256_cmp_ps(_mm256_add_ps(bc, cb), zero, _CMP_GT_OQ)));
+
+        // Interior, weights of degenerate lanes are replaced below
+        __m256 sum = _mm256_add_ps(_mm256_add_ps(va, vb), vc);
+        __m256 inverse = _mm256_div_ps(one, sum);
+        __m256 v = _mm256_mul_ps(vb, inverse), w = _mm256_mul_ps(vc, inverse);
+
+        __m256 tab = simd::clamp(_mm256_div_ps(d1, _mm256_sub_ps(d1, d3)), zero, one);
+        __m256 tac = simd::clamp(_mm256_div_ps(d2, _mm256_sub_ps(d2, d6)), zero, one);
+        __m256 tbc = simd::clamp(_mm256_div_ps(bc, _mm256_add_ps(bc, cb)), zero, one);
+
+        v = simd::select(inbc, v, _mm256_sub_ps(one, tbc));
+        w = simd::select(inbc, w, tbc);
+        v = simd::select(inac, v, zero);
+        w = simd::select(inac, w, tac);
+        v = simd::select(inc, v, zero);
+        w = simd::select(inc, w, one);
+        v = simd::select(inab, v, tab);
+        w = simd::select(inab, w, zero);
+        v = simd::select(inb, v, one);
+        w = simd::select(inb, w, zero);
+        v = _mm256_andnot_ps(ina, v);
+        w = _mm256_andnot_ps(ina, w);
+
+        __m256 anyregion = _mm256_or_ps(_mm256_or_ps(_mm256_or_ps(ina, inb), _mm256_or_ps(inab, inc)), _mm256_or_ps(inac, inbc));
+        __m256 flat = _mm256_cmp_ps(sum, _mm256_mul_ps(_mm256_set1_ps(std::numeric_limits<f32>::epsilon()), _mm256_mul_ps(ab.lengthsquared(), ac.lengthsquared())), _CMP_NGT_UQ);
+        __m256 degenerate = _mm256_andnot_ps(anyregion, flat);
+
+        if (_mm256_movemask_ps(degenerate) != 0)
+        {
+            __m256 sab, sac, sbc;
+            __m256 dab = (closestpointsegment(p, a, b, sab) - p).lengthsquared();
+            __m256 dac = (closestpointsegment(p, a, c, sac) - p).lengthsquared();
+            __m256 dbc = (closestpointsegment(p, b, c, sbc) - p).lengthsquared();
+
+            __m256 useab = _mm256_and_ps(le(dab, dac), le(dab, dbc));
+            __m256 useac = _mm256_andnot_ps(useab, le(dac, dbc));
+
+            __m256 ev = simd::select(useab, simd::select(useac, _mm256_sub_ps(one, sbc), zero), sab);
+            __m256 ew = simd::select(useab, simd::select(useac, sbc, sac), zero);
+
+            v = simd::select(degenerate, v, ev);
+            w = simd::select(degenerate, w, ew);
+        }
+
+        barycentric = vec3x8(_mm256_sub_ps(_mm256_sub_ps(one, v), w), v, w);
+
+        return a + ab * v + ac * w;
+    }
+} // namespace sml
+
+#endif // sml_closest_h__
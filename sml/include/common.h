@@ -22,6 +22,10 @@
 #include <stdint.h>
 #include <float.h>
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 #include "smltypes.h"
 
 namespace constants
@@ -227,6 +231,54 @@ namespace sml
 
 		return angle;
 	}
+
+	// Number of set bits
+	static inline u32 popcount(u32 v)
+	{
+#ifdef _MSC_VER
+		return __popcnt(v);
+#else
+		return static_cast<u32>(__builtin_popcount(v));
+#endif
+	}
+
+	// Index of the lowest set bit, v must not be zero
+	static inline u32 lowestbit(u32 v)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward(&index, v);
+
+		return index;
+#else
+		return static_cast<u32>(__builtin_ctz(v));
+#endif
+	}
+
+	// Index of the highest set bit, v must not be zero
+	static inline u32 highestbit(u32 v)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanReverse(&index, v);
+
+		return index;
+#else
+		return static_cast<u32>(31 - __builtin_clz(v));
+#endif
+	}
+
+	static inline u32 highestbit(u64 v)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanReverse64(&index, v);
+
+		return index;
+#else
+		return static_cast<u32>(63 - __builtin_clzll(v));
+#endif
+	}
 } // namespace sml
 
 #endif // sml_common_h__
\ No newline at end of file
@@ -0,0 +1,567 @@
+#ifndef sml_contacts_h__
+#define sml_contacts_h__
+
+/* contacts.h -- batched sphere, capsule and box contacts of the 'Simple Math Library'
+  Copyright (C) 2020 Roderick Griffioen
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+
+#include <algorithm>
+#include <cstddef>
+#include <immintrin.h>
+
+#include "smltypes.h"
+#include "common.h"
+#include "simd.h"
+#include "vec3.h"
+#include "vec3x8.h"
+#include "closest.h"
+#include "quat.h"
+#include "sweepandprune.h"
+
+namespace sml
+{
+    // One contact per pair, normal points from a to b and depth is positive when the shapes overlap.
+    // The point lies halfway between the two surfaces.
+    struct contact
+    {
+        fvec3 point;
+        fvec3 normal;
+        f32 depth;
+        u32 pair;
+    };
+
+    // Shapes in SoA arrays indexed by the pairs given to the contact kernels, arrays a kernel does not
+    // read may stay null. Capsule segments run along the local y axis.
+    struct contactbodies
+    {
+        const fvec3* positions = nullptr;
+        const fquat* orientations = nullptr;
+        const f32* radii = nullptr;
+        const f32* halfheights = nullptr;
+        const fvec3* halfextents = nullptr;
+    };
+
+    namespace detail
+    {
+        struct quatx8
+        {
+            vec3x8 v;
+            __m256 w;
+        };
+
+        inline quatx8 gatherquat(const fquat* q, const u32* indices) noexcept
+        {
+            __m256 r0 = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(&q[indices[0]].x)), simd::load(&q[indices[4]].x), 1);
+            __m256 r1 = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(&q[indices[1]].x)), simd::load(&q[indices[5]].x), 1);
+            __m256 r2 = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(&q[indices[2]].x)), simd::load(&q[indices[6]].x), 1);
+            __m256 r3 = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(&q[indices[3]].x)), simd::load(&q[indices[7]].x), 1);
+
+            simd::transpose(r0, r1, r2, r3);
+
+            return { vec3x8(r0, r1, r2), r3 };
+        }
+
+        inline __m256 gatherscalar(const f32* p, const u32* indices) noexcept
+        {
+            return _mm256_setr_ps(p[indices[0]], p[indices[1]], p[indices[2]], p[indices[3]], p[indices[4]], p[indices[5]], p[indices[6]], p[indices[7]]);
+        }
+
+        // Rotated unit axes of eight quaternions, the columns of their rotation matrices
+        inline void axes(const quatx8& q, vec3x8 (&a)[3]) noexcept
+        {
+            __m256 one = _mm256_set1_ps(1.0f), two = _mm256_set1_ps(2.0f);
+            __m256 x2 = _mm256_mul_ps(q.v.x, two), y2 = _mm256_mul_ps(q.v.y, two), z2 = _mm256_mul_ps(q.v.z, two);
+            __m256 xx = _mm256_mul_ps(q.v.x, x2), yy = _mm256_mul_ps(q.v.y, y2), zz = _mm256_mul_ps(q.v.z, z2);
+            __m256 xy = _mm256_mul_ps(q.v.x, y2), xz = _mm256_mul_ps(q.v.x, z2), yz = _mm256_mul_ps(q.v.y, z2);
+            __m256 wx = _mm256_mul_ps(q.w, x2), wy = _mm256_mul_ps(q.w, y2), wz = _mm256_mul_ps(q.w, z2);
+
+            a[0] = vec3x8(_mm256_sub_ps(one, _mm256_add_ps(yy, zz)), _mm256_add_ps(xy, wz), _mm256_sub_ps(xz, wy));
+            a[1] = vec3x8(_mm256_sub_ps(xy, wz), _mm256_sub_ps(one, _mm256_add_ps(xx, zz)), _mm256_add_ps(yz, wx));
+            a[2] = vec3x8(_mm256_add_ps(xz, wy), _mm256_sub_ps(yz, wx), _mm256_sub_ps(one, _mm256_add_ps(xx, yy)));
+        }
+
+        // Segment of a capsule, center -/+ its y axis times the half height
+        inline void capsulesegment(const contactbodies& bodies, const u32* indices, vec3x8& p0, vec3x8& p1) noexcept
+        {
+            vec3x8 a[3];
+            axes(gatherquat(bodies.orientations, indices), a);
+
+            vec3x8 center(bodies.positions, indices);
+            vec3x8 half = a[1] * gatherscalar(bodies.halfheights, indices);
+
+            p0 = center - half;
+            p1 = center + half;
+        }
+
+        inline void spheresphere(const vec3x8& ca, __m256 ra, const vec3x8& cb, __m256 rb, vec3x8& point, vec3x8& normal, __m256& depth) noexcept
+        {
+            vec3x8 d = cb - ca;
+            __m256 distance = d.length();
+            __m256 apart = _mm256_cmp_ps(distance, _mm256_set1_ps(1e-6f), _CMP_GT_OQ);
+
+            // Concentric spheres push along y
+            normal = vec3x8::select(apart, vec3x8(fvec3(0.0f, 1.0f, 0.0f)), d * _mm256_div_ps(_mm256_set1_ps(1.0f), distance));
+            depth = _mm256_sub_ps(_mm256_add_ps(ra, rb), distance);
+            point = ca + normal * _mm256_sub_ps(ra, _mm256_mul_ps(depth, _mm256_set1_ps(0.5f)));
+        }
+
+        // Sphere at s against a box, the normal points from the sphere to the box
+        inline void spherebox(const vec3x8& s, __m256 r, const vec3x8& center, const vec3x8 (&a)[3], const __m256 (&h)[3],
+                              vec3x8& point, vec3x8& normal, __m256& depth) noexcept
+        {
+            __m256 zero = _mm256_setzero_ps(), sign = _mm256_set1_ps(-0.0f);
+            vec3x8 d = s - center;
+
+            __m256 local[3], clamped[3];
+            __m256 outside = zero, distancesq = zero;
+            __m256 best = _mm256_set1_ps(3.0e38f), bestaxis = zero;
+
+            for (s32 k = 0; k < 3; k++)
+            {
+                local[k] = vec3x8::dot(d, a[k]);
+                clamped[k] = simd::clamp(local[k], _mm256_xor_ps(h[k], sign), h[k]);
+
+                __m256 excess = _mm256_sub_ps(local[k], clamped[k]);
+                outside = _mm256_or_ps(outside, _mm256_cmp_ps(excess, zero, _CMP_NEQ_OQ));
+                distancesq = _mm256_add_ps(distancesq, _mm256_mul_ps(excess, excess));
+
+                // Face of least penetration for centers inside the box
+                __m256 penetration = _mm256_sub_ps(h[k], _mm256_andnot_ps(sign, local[k]));
+                __m256 better = _mm256_cmp_ps(penetration, best, _CMP_LT_OQ);
+
+                best = simd::select(better, best, penetration);
+                bestaxis = simd::select(better, bestaxis, _mm256_set1_ps(static_cast<f32>(k)));
+            }
+
+            __m256 distance = _mm256_sqrt_ps(distancesq);
+            __m256 inverse = _mm256_div_ps(_mm256_set1_ps(1.0f), distance);
+
+            vec3x8 surface = center + a[0] * clamped[0] + a[1] * clamped[1] + a[2] * clamped[2];
+            vec3x8 out = (s - surface) * inverse;
+
+            // Inside, the box point moves out to the face of least penetration
+            vec3x8 in, face = surface;
+
+            for (s32 k = 0; k < 3; k++)
+            {
+                __m256 chosen = _mm256_cmp_ps(bestaxis, _mm256_set1_ps(static_cast<f32>(k)), _CMP_EQ_OQ);
+                __m256 facesign = _mm256_or_ps(_mm256_and_ps(local[k], sign), _mm256_set1_ps(1.0f));
+
+                in = vec3x8::select(chosen, in, a[k] * facesign);
+                face = vec3x8::select(chosen, face, face + a[k] * _mm256_sub_ps(_mm256_mul_ps(h[k], facesign), local[k]));
+            }
+
+            // The normal points from the sphere into the box
+            normal = -vec3x8::select(outside, in, out);
+            depth = simd::select(outside, _mm256_add_ps(r, best), _mm256_sub_ps(r, distance));
+
+            vec3x8 boxpoint = vec3x8::select(outside, face, surface);
+            vec3x8 spherepoint = s + normal * r;
+
+            point = (boxpoint + spherepoint) * _mm256_set1_ps(0.5f);
+        }
+
+        // Runs kernel(a, b, point, normal, depth) on the pairs eight at a time and writes the contacts
+        // deeper than -margin. Lanes past the end repeat the first pair and are dropped.
+        template<typename K>
+        inline size_t contactbatches(const overlappair* pairs, size_t count, f32 margin, contact* out, K&& kernel) noexcept
+        {
+            size_t written = 0;
+            __m256 limit = _mm256_set1_ps(-margin);
+
+            for (size_t base = 0; base < count; base += 8)
+            {
+                alignas(32) u32 a[8], b[8];
+                size_t n = std::min(count - base, size_t(8));
+
+                for (size_t i = 0; i < 8; i++)
+                {
+                    const overlappair& p = pairs[base + (i < n ? i : 0)];
+
+                    a[i] = p.a;
+                    b[i] = p.b;
+                }
+
+                vec3x8 point, normal;
+                __m256 depth;
+
+                kernel(a, b, point, normal, depth);
+
+                u32 mask = static_cast<u32>(_mm256_movemask_ps(_mm256_cmp_ps(depth, limit, _CMP_GT_OQ))) & ((1u << n) - 1);
+
+                if (mask == 0)
+                    continue;
+
+                fvec3 points[8], normals[8];
+                alignas(32) f32 depths[8];
+
+                point.store(points);
+                normal.store(normals);
+                _mm256_store_ps(depths, depth);
+
+                for (; mask != 0; mask &= mask - 1)
+                {
+                    u32 k = lowestbit(mask);
+                    contact& c = out[written++];
+
+                    c.point = points[k];
+                    c.normal = normals[k];
+                    c.depth = depths[k];
+                    c.pair = static_cast<u32>(base + k);
+                }
+            }
+
+            return written;
+        }
+    } // namespace detail
+
+    // Contact kernels, pair.a indexes a and pair.b indexes b. They write one contact for each pair deeper
+    // than -margin to out, which holds up to count contacts, and return the number written.
+    inline size_t spherespherecontacts(const contactbodies& a, const contactbodies& b, const overlappair* pairs, size_t count, contact* out, f32 margin = 0.0f) noexcept
+    {
+        return detail::contactbatches(pairs, count, margin, out, [&](const u32* ia, const u32* ib, vec3x8& point, vec3x8& normal, __m256& depth)
+        {
+            detail::spheresphere(vec3x8(a.positions, ia), detail::gatherscalar(a.radii, ia), vec3x8(b.positions, ib), detail::gatherscalar(b.radii, ib), point, normal, depth);
+        });
+    }
+
+    inline size_t spherecapsulecontacts(const contactbodies& a, const contactbodies& b, const overlappair* pairs, size_t count, contact* out, f32 margin = 0.0f) noexcept
+    {
+        return detail::contactbatches(pairs, count, margin, out, [&](const u32* ia, const u32* ib, vec3x8& point, vec3x8& normal, __m256& depth)
+        {
+            vec3x8 center(a.positions, ia), p0, p1;
+            detail::capsulesegment(b, ib, p0, p1);
+
+            __m256 t;
+            vec3x8 closest = closestpointsegment(center, p0, p1, t);
+
+            detail::spheresphere(center, detail::gatherscalar(a.radii, ia), closest, detail::gatherscalar(b.radii, ib), point, normal, depth);
+        });
+    }
+
+    inline size_t capsulecapsulecontacts(const contactbodies& a, const contactbodies& b, const overlappair* pairs, size_t count, contact* out, f32 margin = 0.0f) noexcept
+    {
+        return detail::contactbatches(pairs, count, margin, out, [&](const u32* ia, const u32* ib, vec3x8& point, vec3x8& normal, __m256& depth)
+        {
+            vec3x8 p1, q1, p2, q2;
+            detail::capsulesegment(a, ia, p1, q1);
+            detail::capsulesegment(b, ib, p2, q2);
+
+            __m256 s, t;
+            vec3x8 c1, c2;
+            closestsegmentsegment(p1, q1, p2, q2, s, t, c1, c2);
+
+            detail::spheresphere(c1, detail::gatherscalar(a.radii, ia), c2, detail::gatherscalar(b.radii, ib), point, normal, depth);
+        });
+    }
+
+    inline size_t sphereboxcontacts(const contactbodies& a, const contactbodies& b, const overlappair* pairs, size_t count, contact* out, f32 margin = 0.0f) noexcept
+    {
+        return detail::contactbatches(pairs, count, margin, out, [&](const u32* ia, const u32* ib, vec3x8& point, vec3x8& normal, __m256& depth)
+        {
+            vec3x8 axes[3];
+            detail::axes(detail::gatherquat(b.orientations, ib), axes);
+
+            vec3x8 extents(b.halfextents, ib);
+            __m256 h[3] = { extents.x, extents.y, extents.z };
+
+            detail::spherebox(vec3x8(a.positions, ia), detail::gatherscalar(a.radii, ia), vec3x8(b.positions, ib), axes, h, point, normal, depth);
+        });
+    }
+
+    // Segments crossing the box take the separating axis of least overlap among the box faces and the
+    // crosses of the segment with the box axes, separated segments the exact closest points.
+    inline size_t capsuleboxcontacts(const contactbodies& a, const contactbodies& b, const overlappair* pairs, size_t count, contact* out, f32 margin = 0.0f) noexcept
+    {
+        return detail::contactbatches(pairs, count, margin, out, [&](const u32* ia, const u32* ib, vec3x8& point, vec3x8& normal, __m256& depth)
+        {
+            __m256 zero = _mm256_setzero_ps(), half = _mm256_set1_ps(0.5f), sign = _mm256_set1_ps(-0.0f);
+
+            vec3x8 axes[3];
+            detail::axes(detail::gatherquat(b.orientations, ib), axes);
+
+            vec3x8 center(b.positions, ib), extents(b.halfextents, ib);
+            __m256 h[3] = { extents.x, extents.y, extents.z };
+            __m256 radius = detail::gatherscalar(a.radii, ia);
+
+            vec3x8 p0, p1;
+            detail::capsulesegment(a, ia, p0, p1);
+
+            // Segment in box space
+            vec3x8 l0(vec3x8::dot(p0 - center, axes[0]), vec3x8::dot(p0 - center, axes[1]), vec3x8::dot(p0 - center, axes[2]));
+            vec3x8 l1(vec3x8::dot(p1 - center, axes[0]), vec3x8::dot(p1 - center, axes[1]), vec3x8::dot(p1 - center, axes[2]));
+            vec3x8 ld = l1 - l0;
+            vec3x8 hi(h[0], h[1], h[2]), lo = -hi;
+
+            // Separated, the closest points pair a segment end with the box or the segment with a box edge
+            vec3x8 outside0 = l0 - vec3x8::min(vec3x8::max(l0, lo), hi);
+            vec3x8 outside1 = l1 - vec3x8::min(vec3x8::max(l1, lo), hi);
+            __m256 nearestsq = outside0.lengthsquared(), d1 = outside1.lengthsquared();
+            __m256 t = _mm256_and_ps(_mm256_cmp_ps(d1, nearestsq, _CMP_LT_OQ), _mm256_set1_ps(1.0f));
+
+            nearestsq = _mm256_min_ps(nearestsq, d1);
+
+            for (s32 k = 0; k < 3; k++)
+            {
+                for (s32 corner = 0; corner < 4; corner++)
+                {
+                    __m256 c[3];
+                    c[k] = h[k];
+                    c[(k + 1) % 3] = corner & 1 ? h[(k + 1) % 3] : _mm256_xor_ps(h[(k + 1) % 3], sign);
+                    c[(k + 2) % 3] = corner & 2 ? h[(k + 2) % 3] : _mm256_xor_ps(h[(k + 2) % 3], sign);
+
+                    vec3x8 e1(c[0], c[1], c[2]), e0 = e1;
+                    (k == 0 ? e0.x : k == 1 ? e0.y : e0.z) = _mm256_xor_ps(h[k], sign);
+
+                    __m256 s, u;
+                    vec3x8 onsegment, onedge;
+                    __m256 distancesq = closestsegmentsegment(l0, l1, e0, e1, s, u, onsegment, onedge);
+                    __m256 better = _mm256_cmp_ps(distancesq, nearestsq, _CMP_LT_OQ);
+
+                    nearestsq = _mm256_min_ps(nearestsq, distancesq);
+                    t = simd::select(better, t, s);
+                }
+            }
+
+            vec3x8 nearest = p0 + (p1 - p0) * t;
+            detail::spherebox(nearest, radius, center, axes, h, point, normal, depth);
+
+            // Separating axes in box space, overlaps of the bare segment
+            vec3x8 mid = (l0 + l1) * half, e = ld * half;
+            __m256 m[3] = { mid.x, mid.y, mid.z }, ed[3] = { e.x, e.y, e.z };
+            __m256 best = _mm256_set1_ps(3.0e38f);
+            vec3x8 bestaxis;
+
+            for (s32 k = 0; k < 3; k++)
+            {
+                __m256 overlap = _mm256_sub_ps(_mm256_add_ps(h[k], _mm256_andnot_ps(sign, ed[k])), _mm256_andnot_ps(sign, m[k]));
+                __m256 better = _mm256_cmp_ps(overlap, best, _CMP_LT_OQ);
+
+                best = simd::select(better, best, overlap);
+                bestaxis = vec3x8::select(better, bestaxis, vec3x8(fvec3(k == 0 ? 1.0f : 0.0f, k == 1 ? 1.0f : 0.0f, k == 2 ? 1.0f : 0.0f)));
+            }
+
+            for (s32 k = 0; k < 3; k++)
+            {
+                // e x unit axis k, the segment projects to a point on it
+                s32 k1 = (k + 1) % 3, k2 = (k + 2) % 3;
+                __m256 n[3];
+
+                n[k] = zero;
+                n[k1] = ed[k2];
+                n[k2] = _mm256_xor_ps(ed[k1], sign);
+
+                __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(n[k1], n[k1]), _mm256_mul_ps(n[k2], n[k2])));
+                __m256 extent = _mm256_add_ps(_mm256_mul_ps(h[k1], _mm256_andnot_ps(sign, n[k1])), _mm256_mul_ps(h[k2], _mm256_andnot_ps(sign, n[k2])));
+                __m256 distance = _mm256_andnot_ps(sign, _mm256_add_ps(_mm256_mul_ps(m[k1], n[k1]), _mm256_mul_ps(m[k2], n[k2])));
+                __m256 overlap = _mm256_div_ps(_mm256_sub_ps(extent, distance), length);
+
+                __m256 better = _mm256_and_ps(_mm256_cmp_ps(length, _mm256_set1_ps(1e-4f), _CMP_GT_OQ), _mm256_cmp_ps(overlap, best, _CMP_LT_OQ));
+                __m256 inverse = _mm256_div_ps(_mm256_set1_ps(1.0f), length);
+
+                best = simd::select(better, best, overlap);
+                bestaxis = vec3x8::select(better, bestaxis, vec3x8(_mm256_mul_ps(n[0], inverse), _mm256_mul_ps(n[1], inverse), _mm256_mul_ps(n[2], inverse)));
+            }
+
+            // Local normal from the capsule to the box, pointing against the segment midpoint
+            __m256 flip = _mm256_cmp_ps(vec3x8::dot(bestaxis, mid), zero, _CMP_GT_OQ);
+            vec3x8 local = vec3x8::select(flip, bestaxis, -bestaxis);
+
+            // Deepest end of the part of the segment inside the box, its middle when the segment lies flat
+            __m256 enter = zero, exit = _mm256_set1_ps(1.0f);
+            __m256 l0s[3] = { l0.x, l0.y, l0.z }, lds[3] = { ld.x, ld.y, ld.z };
+
+            for (s32 k = 0; k < 3; k++)
+            {
+                __m256 inverse = _mm256_div_ps(_mm256_set1_ps(1.0f), lds[k]);
+                __m256 ta = _mm256_mul_ps(_mm256_sub_ps(_mm256_xor_ps(h[k], sign), l0s[k]), inverse);
+                __m256 tb = _mm256_mul_ps(_mm256_sub_ps(h[k], l0s[k]), inverse);
+
+                enter = _mm256_max_ps(_mm256_min_ps(ta, tb), enter);
+                exit = _mm256_min_ps(_mm256_max_ps(ta, tb), exit);
+            }
+
+            exit = _mm256_max_ps(exit, enter);
+
+            __m256 slope = vec3x8::dot(ld, local);
+            __m256 flat = _mm256_cmp_ps(_mm256_andnot_ps(sign, slope), _mm256_mul_ps(_mm256_set1_ps(1e-3f), ld.length()), _CMP_LE_OQ);
+            __m256 deepest = simd::select(_mm256_cmp_ps(slope, zero, _CMP_GT_OQ), enter, exit);
+            deepest = simd::select(flat, deepest, _mm256_mul_ps(_mm256_add_ps(enter, exit), half));
+
+            vec3x8 crossingnormal = axes[0] * local.x + axes[1] * local.y + axes[2] * local.z;
+            __m256 crossingdepth = _mm256_add_ps(best, radius);
+            vec3x8 surface = p0 + (p1 - p0) * deepest + crossingnormal * radius;
+            vec3x8 crossingpoint = surface - crossingnormal * _mm256_mul_ps(crossingdepth, half);
+
+            __m256 crossing = _mm256_cmp_ps(best, zero, _CMP_GT_OQ);
+
+            normal = vec3x8::select(crossing, normal, crossingnormal);
+            depth = simd::select(crossing, depth, crossingdepth);
+            point = vec3x8::select(crossing, point, crossingpoint);
+        });
+    }
+
+    // Separating axis test over the 15 axes of two boxes. The contact is the deepest vertex of the incident
+    // box clamped to the reference face for face axes and the midpoint of the closest points of the two
+    // edges for edge axes. Face axes are preferred unless an edge axis is clearly shallower, which keeps
+    // resting contacts stable.
+    inline size_t boxboxcontacts(const contactbodies& a, const contactbodies& b, const overlappair* pairs, size_t count, contact* out, f32 margin = 0.0f) noexcept
+    {
+        return detail::contactbatches(pairs, count, margin, out, [&](const u32* ia, const u32* ib, vec3x8& point, vec3x8& normal, __m256& depth)
+        {
+            __m256 zero = _mm256_setzero_ps(), half = _mm256_set1_ps(0.5f), sign = _mm256_set1_ps(-0.0f);
+
+            vec3x8 aa[3], ba[3];
+            detail::axes(detail::gatherquat(a.orientations, ia), aa);
+            detail::axes(detail::gatherquat(b.orientations, ib), ba);
+
+            vec3x8 ca(a.positions, ia), cb(b.positions, ib);
+            vec3x8 ea(a.halfextents, ia), eb(b.halfextents, ib);
+            __m256 ha[3] = { ea.x, ea.y, ea.z }, hb[3] = { eb.x, eb.y, eb.z };
+
+            vec3x8 between = cb - ca;
+            __m256 r[3][3], absr[3][3], t[3];
+
+            for (s32 i = 0; i < 3; i++)
+            {
+                t[i] = vec3x8::dot(between, aa[i]);
+
+                for (s32 j = 0; j < 3; j++)
+                {
+                    r[i][j] = vec3x8::dot(aa[i], ba[j]);
+                    absr[i][j] = _mm256_add_ps(_mm256_andnot_ps(sign, r[i][j]), _mm256_set1_ps(1e-6f));
+                }
+            }
+
+            __m256 best = _mm256_set1_ps(3.0e38f), kind = zero, besti = zero, bestj = zero;
+            vec3x8 bestnormal;
+
+            auto consider = [&](__m256 overlap, const vec3x8& n, f32 k, f32 i, f32 j, __m256 better)
+            {
+                better = _mm256_and_ps(better, _mm256_cmp_ps(overlap, best, _CMP_LT_OQ));
+
+                best = simd::select(better, best, overlap);
+                kind = simd::select(better, kind, _mm256_set1_ps(k));
+                besti = simd::select(better, besti, _mm256_set1_ps(i));
+                bestj = simd::select(better, bestj, _mm256_set1_ps(j));
+                bestnormal = vec3x8::select(better, bestnormal, n);
+            };
+
+            __m256 all = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+            for (s32 i = 0; i < 3; i++)
+            {
+                __m256 rb = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(hb[0], absr[i][0]), _mm256_mul_ps(hb[1], absr[i][1])), _mm256_mul_ps(hb[2], absr[i][2]));
+
+                consider(_mm256_sub_ps(_mm256_add_ps(ha[i], rb), _mm256_andnot_ps(sign, t[i])), aa[i], 0.0f, static_cast<f32>(i), 0.0f, all);
+            }
+
+            for (s32 j = 0; j < 3; j++)
+            {
+                __m256 ra = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ha[0], absr[0][j]), _mm256_mul_ps(ha[1], absr[1][j])), _mm256_mul_ps(ha[2], absr[2][j]));
+                __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(t[0], r[0][j]), _mm256_mul_ps(t[1], r[1][j])), _mm256_mul_ps(t[2], r[2][j]));
+
+                consider(_mm256_sub_ps(_mm256_add_ps(ra, hb[j]), _mm256_andnot_ps(sign, distance)), ba[j], 1.0f, 0.0f, static_cast<f32>(j), all);
+            }
+
+            for (s32 i = 0; i < 3; i++)
+            {
+                s32 i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+
+                for (s32 j = 0; j < 3; j++)
+                {
+                    s32 j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+
+                    vec3x8 axis = vec3x8::cross(aa[i], ba[j]);
+                    __m256 length = axis.length();
+
+                    __m256 ra = _mm256_add_ps(_mm256_mul_ps(ha[i1], absr[i2][j]), _mm256_mul_ps(ha[i2], absr[i1][j]));
+                    __m256 rb = _mm256_add_ps(_mm256_mul_ps(hb[j1], absr[i][j2]), _mm256_mul_ps(hb[j2], absr[i][j1]));
+                    __m256 distance = _mm256_andnot_ps(sign, _mm256_sub_ps(_mm256_mul_ps(t[i2], r[i1][j]), _mm256_mul_ps(t[i1], r[i2][j])));
+                    __m256 overlap = _mm256_div_ps(_mm256_sub_ps(_mm256_add_ps(ra, rb), distance), length);
+
+                    // Parallel edges have no axis, edges must beat the faces by a margin
+                    __m256 valid = _mm256_cmp_ps(length, _mm256_set1_ps(1e-4f), _CMP_GT_OQ);
+                    __m256 clearly = _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(overlap, _mm256_set1_ps(1.05f)), _mm256_set1_ps(1e-3f)), best, _CMP_LT_OQ);
+
+                    consider(overlap, axis * _mm256_div_ps(_mm256_set1_ps(1.0f), length), 2.0f, static_cast<f32>(i), static_cast<f32>(j), _mm256_and_ps(valid, clearly));
+                }
+            }
+
+            // Normal from a to b
+            __m256 flip = _mm256_cmp_ps(vec3x8::dot(bestnormal, between), zero, _CMP_LT_OQ);
+            normal = vec3x8::select(flip, bestnormal, -bestnormal);
+            depth = best;
+
+            // Support points of a along the normal and of b against it, with the chosen edge axes
+            vec3x8 supporta = ca, supportb = cb, edgea, edgeb, offseta, offsetb;
+            __m256 halfa = zero, halfb = zero;
+
+            for (s32 k = 0; k < 3; k++)
+            {
+                vec3x8 sa = aa[k] * _mm256_or_ps(_mm256_andnot_ps(sign, ha[k]), _mm256_and_ps(vec3x8::dot(normal, aa[k]), sign));
+                vec3x8 sb = ba[k] * _mm256_xor_ps(_mm256_or_ps(_mm256_andnot_ps(sign, hb[k]), _mm256_and_ps(vec3x8::dot(normal, ba[k]), sign)), sign);
+
+                supporta += sa;
+                supportb += sb;
+
+                __m256 ci = _mm256_cmp_ps(besti, _mm256_set1_ps(static_cast<f32>(k)), _CMP_EQ_OQ);
+                __m256 cj = _mm256_cmp_ps(bestj, _mm256_set1_ps(static_cast<f32>(k)), _CMP_EQ_OQ);
+
+                edgea = vec3x8::select(ci, edgea, aa[k]);
+                edgeb = vec3x8::select(cj, edgeb, ba[k]);
+                offseta = vec3x8::select(ci, offseta, sa);
+                offsetb = vec3x8::select(cj, offsetb, sb);
+                halfa = simd::select(ci, halfa, ha[k]);
+                halfb = simd::select(cj, halfb, hb[k]);
+            }
+
+            // Face contacts clamp the deepest vertex of the incident box to the extent of the reference face
+            vec3x8 facea = supportb, faceb = supporta;
+
+            for (s32 k = 0; k < 3; k++)
+            {
+                __m256 ca_k = vec3x8::dot(facea - ca, aa[k]), cb_k = vec3x8::dot(faceb - cb, ba[k]);
+                __m256 tangenta = _mm256_cmp_ps(besti, _mm256_set1_ps(static_cast<f32>(k)), _CMP_NEQ_OQ);
+                __m256 tangentb = _mm256_cmp_ps(bestj, _mm256_set1_ps(static_cast<f32>(k)), _CMP_NEQ_OQ);
+
+                facea += aa[k] * _mm256_and_ps(_mm256_sub_ps(simd::clamp(ca_k, _mm256_xor_ps(ha[k], sign), ha[k]), ca_k), tangenta);
+                faceb += ba[k] * _mm256_and_ps(_mm256_sub_ps(simd::clamp(cb_k, _mm256_xor_ps(hb[k], sign), hb[k]), cb_k), tangentb);
+            }
+
+            facea += normal * _mm256_mul_ps(depth, half);
+            faceb -= normal * _mm256_mul_ps(depth, half);
+
+            // Edges through the support points along the separating edge axes
+            vec3x8 centera = supporta - offseta, centerb = supportb - offsetb;
+            vec3x8 p1 = centera - edgea * halfa, q1 = centera + edgea * halfa;
+            vec3x8 p2 = centerb - edgeb * halfb, q2 = centerb + edgeb * halfb;
+
+            __m256 s, u;
+            vec3x8 c1, c2;
+            closestsegmentsegment(p1, q1, p2, q2, s, u, c1, c2);
+
+            vec3x8 edge = (c1 + c2) * half;
+
+            point = vec3x8::select(_mm256_cmp_ps(kind, zero, _CMP_EQ_OQ), faceb, facea);
+            point = vec3x8::select(_mm256_cmp_ps(kind, _mm256_set1_ps(2.0f), _CMP_EQ_OQ), point, edge);
+        });
+    }
+} // namespace sml
+
+#endif // sml_contacts_h__
@@ -0,0 +1,303 @@
+#ifndef sml_frustum_h__
+#define sml_frustum_h__
+
+/* frustum.h -- view frustum culling of the 'Simple Math Library'
+  Copyright (C) 2020 Roderick Griffioen
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <cstddef>
+#include <immintrin.h>
+
+#include "smltypes.h"
+#include "common.h"
+#include "simd.h"
+#include "vec3.h"
+#include "vec4.h"
+#include "mat4.h"
+#include "aabb.h"
+#include "sphere.h"
+
+namespace sml
+{
+    // Six planes with inward facing unit normals in xyz and the distance in w, a point p is on
+    // the inner side of a plane when dot(plane.xyz, p) + plane.w >= 0
+    template<typename T>
+    class alignas(simdalign<T>::value) frustum
+    {
+        public:
+            enum
+            {
+                leftplane,
+                rightplane,
+                bottomplane,
+                topplane,
+                nearplane,
+                farplane
+            };
+
+            constexpr frustum() noexcept
+            {
+            }
+
+            // Gribb-Hartmann extraction from a view projection matrix. Clip space depth is [0, 1] for
+            // mat4::perspective and mat4::ortho, pass zerotoone = false for [-1, 1] projections.
+            explicit frustum(const mat4<T>& viewprojection, bool zerotoone = true) noexcept
+            {
+                const mat4<T>& m = viewprojection;
+
+                vec4<T> r0(m.m00, m.m10, m.m20, m.m30);
+                vec4<T> r1(m.m01, m.m11, m.m21, m.m31);
+                vec4<T> r2(m.m02, m.m12, m.m22, m.m32);
+                vec4<T> r3(m.m03, m.m13, m.m23, m.m33);
+
+                planes[leftplane] = r3 + r0;
+                planes[rightplane] = r3 - r0;
+                planes[bottomplane] = r3 + r1;
+                planes[topplane] = r3 - r1;
+                planes[nearplane] = zerotoone ? r2 : r3 + r2;
+                planes[farplane] = r3 - r2;
+
+                for (vec4<T>& plane : planes)
+                {
+                    T length = sml::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+
+                    plane /= length;
+                }
+            }
+
+            // Operations
+            SML_NO_DISCARD inline constexpr T distance(s32 plane, const vec3<T>& point) const noexcept
+            {
+                const vec4<T>& p = planes[plane];
+
+                return p.x * point.x + p.y * point.y + p.z * point.z + p.w;
+            }
+
+            SML_NO_DISCARD inline constexpr bool contains(const vec3<T>& point) const noexcept
+            {
+                for (s32 i = 0; i < 6; i++)
+                {
+                    if (distance(i, point) < static_cast<T>(0))
+                        return false;
+                }
+
+                return true;
+            }
+
+            // Conservative tests, objects outside the frustum but close to one of its edges or corners
+            // may be reported as intersecting. Empty spheres and boxes never intersect.
+            SML_NO_DISCARD inline constexpr bool intersects(const sphere<T>& s) const noexcept
+            {
+                if (s.empty())
+                    return false;
+
+                for (s32 i = 0; i < 6; i++)
+                {
+                    if (distance(i, s.center()) < -s.radius)
+                        return false;
+                }
+
+                return true;
+            }
+
+            SML_NO_DISCARD inline constexpr bool intersects(const aabb<T>& box) const noexcept
+            {
+                if (box.empty())
+                    return false;
+
+                vec3<T> c = box.center();
+                vec3<T> e = box.extents();
+
+                for (s32 i = 0; i < 6; i++)
+                {
+                    const vec4<T>& p = planes[i];
+                    T r = sml::abs(p.x) * e.x + sml::abs(p.y) * e.y + sml::abs(p.z) * e.z;
+
+                    if (distance(i, c) < -r)
+                        return false;
+                }
+
+                return true;
+            }
+
+            // Data
+            vec4<T> planes[6];
+    };
+
+    // Visibility of eight spheres given as x, y, z and radius registers, bit i is set when sphere i
+    // intersects the frustum
+    inline u32 spherevisibility(const frustum<f32>& f, __m256 x, __m256 y, __m256 z, __m256 radius) noexcept
+    {
+        __m256 outside = _mm256_cmp_ps(radius, _mm256_setzero_ps(), _CMP_LT_OQ);
+        __m256 negradius = _mm256_xor_ps(radius, _mm256_set1_ps(-0.0f));
+
+        for (s32 i = 0; i < 6; i++)
+        {
+            const vec4<f32>& p = f.planes[i];
+
+            __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_broadcast_ss(&p.x), x), _mm256_mul_ps(_mm256_broadcast_ss(&p.y), y)),
+                                     _mm256_add_ps(_mm256_mul_ps(_mm256_broadcast_ss(&p.z), z), _mm256_broadcast_ss(&p.w)));
+
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(d, negradius, _CMP_LT_OQ));
+        }
+
+        return static_cast<u32>(_mm256_movemask_ps(outside)) ^ 0xFF;
+    }
+
+    // Visibility of eight boxes given as min and max registers
+    inline u32 boxvisibility(const frustum<f32>& f, __m256 minx, __m256 miny, __m256 minz, __m256 maxx, __m256 maxy, __m256 maxz) noexcept
+    {
+        __m256 onehalf = _mm256_set1_ps(0.5f);
+        __m256 signmask = _mm256_set1_ps(-0.0f);
+
+        __m256 cx = _mm256_mul_ps(_mm256_add_ps(minx, maxx), onehalf);
+        __m256 cy = _mm256_mul_ps(_mm256_add_ps(miny, maxy), onehalf);
+        __m256 cz = _mm256_mul_ps(_mm256_add_ps(minz, maxz), onehalf);
+        __m256 ex = _mm256_mul_ps(_mm256_sub_ps(maxx, minx), onehalf);
+        __m256 ey = _mm256_mul_ps(_mm256_sub_ps(maxy, miny), onehalf);
+        __m256 ez = _mm256_mul_ps(_mm256_sub_ps(maxz, minz), onehalf);
+
+        __m256 outside = _mm256_or_ps(_mm256_or_ps(_mm256_cmp_ps(minx, maxx, _CMP_GT_OQ), _mm256_cmp_ps(miny, maxy, _CMP_GT_OQ)), _mm256_cmp_ps(minz, maxz, _CMP_GT_OQ));
+
+        for (s32 i = 0; i < 6; i++)
+        {
+            const vec4<f32>& p = f.planes[i];
+
+            __m256 px = _mm256_broadcast_ss(&p.x), py = _mm256_broadcast_ss(&p.y), pz = _mm256_broadcast_ss(&p.z);
+
+            __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px, cx), _mm256_mul_ps(py, cy)), _mm256_add_ps(_mm256_mul_ps(pz, cz), _mm256_broadcast_ss(&p.w)));
+            __m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_andnot_ps(signmask, px), ex), _mm256_mul_ps(_mm256_andnot_ps(signmask, py), ey)),
+                                     _mm256_mul_ps(_mm256_andnot_ps(signmask, pz), ez));
+
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(d, r), _mm256_setzero_ps(), _CMP_LT_OQ));
+        }
+
+        return static_cast<u32>(_mm256_movemask_ps(outside)) ^ 0xFF;
+    }
+
+    // Visibility of spheres i..i+7
+    inline u32 visibility(const frustum<f32>& f, const sphere<f32>* spheres) noexcept
+    {
+        __m256 r0 = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(&spheres[0].x)), simd::load(&spheres[4].x), 1);
+        __m256 r1 = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(&spheres[1].x)), simd::load(&spheres[5].x), 1);
+        __m256 r2 = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(&spheres[2].x)), simd::load(&spheres[6].x), 1);
+        __m256 r3 = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(&spheres[3].x)), simd::load(&spheres[7].x), 1);
+
+        simd::transpose(r0, r1, r2, r3);
+
+        return spherevisibility(f, r0, r1, r2, r3);
+    }
+
+    // Visibility of boxes i..i+7
+    inline u32 visibility(const frustum<f32>& f, const aabb<f32>* boxes) noexcept
+    {
+        __m256 r0 = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(boxes[0].min.v)), simd::load(boxes[4].min.v), 1);
+        __m256 r1 = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(boxes[1].min.v)), simd::load(boxes[5].min.v), 1);
+        __m256 r2 = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(boxes[2].min.v)), simd::load(boxes[6].min.v), 1);
+        __m256 r3 = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(boxes[3].min.v)), simd::load(boxes[7].min.v), 1);
+        __m256 r4 = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(boxes[0].max.v)), simd::load(boxes[4].max.v), 1);
+        __m256 r5 = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(boxes[1].max.v)), simd::load(boxes[5].max.v), 1);
+        __m256 r6 = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(boxes[2].max.v)), simd::load(boxes[6].max.v), 1);
+        __m256 r7 = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(boxes[3].max.v)), simd::load(boxes[7].max.v), 1);
+
+        simd::transpose(r0, r1, r2, r3);
+        simd::transpose(r4, r5, r6, r7);
+
+        return boxvisibility(f, r0, r1, r2, r4, r5, r6);
+    }
+
+    // Culls count spheres or boxes eight at a time. Visible objects set bit (i & 31) of mask[i >> 5], the mask
+    // holds (count + 31) / 32 words. Returns the number of visible objects.
+    template<typename T, typename O>
+    inline size_t visibilitymask(const frustum<T>& f, const O* objects, size_t count, u32* mask) noexcept
+    {
+        size_t i = 0;
+        size_t visible = 0;
+        u32 word = 0;
+
+        if constexpr (std::is_same<T, f32>::value)
+        {
+            for (; i + 8 <= count; i += 8)
+            {
+                u32 bits = visibility(f, objects + i);
+
+                visible += popcount(bits);
+                word |= bits << (i & 31);
+
+                if ((i & 31) == 24)
+                {
+                    mask[i >> 5] = word;
+                    word = 0;
+                }
+            }
+        }
+
+        for (; i < count; i++)
+        {
+            u32 bit = f.intersects(objects[i]) ? 1 : 0;
+
+            visible += bit;
+            word |= bit << (i & 31);
+
+            if ((i & 31) == 31)
+            {
+                mask[i >> 5] = word;
+                word = 0;
+            }
+        }
+
+        if ((count & 31) != 0)
+            mask[count >> 5] = word;
+
+        return visible;
+    }
+
+    // Writes the indices of the visible objects to indices, which holds up to count entries. Returns the
+    // number of visible objects.
+    template<typename T, typename O>
+    inline size_t visibleindices(const frustum<T>& f, const O* objects, size_t count, u32* indices) noexcept
+    {
+        size_t i = 0;
+        size_t visible = 0;
+
+        if constexpr (std::is_same<T, f32>::value)
+        {
+            for (; i + 8 <= count; i += 8)
+            {
+                u32 bits = visibility(f, objects + i);
+
+                for (; bits != 0; bits &= bits - 1)
+                {
+                    indices[visible++] = static_cast<u32>(i + lowestbit(bits));
+                }
+            }
+        }
+
+        for (; i < count; i++)
+        {
+            if (f.intersects(objects[i]))
+                indices[visible++] = static_cast<u32>(i);
+        }
+
+        return visible;
+    }
+
+    typedef frustum<f32> ffrustum;
+    typedef frustum<f64> dfrustum;
+} // namespace sml
+
+#endif // sml_frustum_h__
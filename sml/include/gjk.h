@@ -0,0 +1,890 @@
+#ifndef sml_gjk_h__
+#define sml_gjk_h__
+
+/* gjk.h -- GJK and EPA convex collision queries of the 'Simple Math Library'
+  Copyright (C) 2020 Roderick Griffioen
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <initializer_list>
+#include <limits>
+#include <vector>
+#include <immintrin.h>
+
+#include "smltypes.h"
+#include "common.h"
+#include "simd.h"
+#include "vec3.h"
+#include "quat.h"
+#include "mat4.h"
+
+namespace sml
+{
+    // Support mapped shapes for gjk and epa. support(direction) returns the point of the core shape
+    // furthest along direction and margin() is a radius around the core, so spheres and capsules are
+    // a point and a segment with a margin and stay exactly round. center() is any interior point.
+    class convexsphere
+    {
+        public:
+            convexsphere(const fvec3& center, f32 radius) noexcept : position(center), radius(radius)
+            {
+            }
+
+            // Operations
+            SML_NO_DISCARD inline fvec3 support(const fvec3&) const noexcept
+            {
+                return position;
+            }
+
+            SML_NO_DISCARD inline fvec3 center() const noexcept
+            {
+                return position;
+            }
+
+            SML_NO_DISCARD inline f32 margin() const noexcept
+            {
+                return radius;
+            }
+
+            // Data
+            fvec3 position;
+            f32 radius;
+    };
+
+    class convexcapsule
+    {
+        public:
+            convexcapsule(const fvec3& a, const fvec3& b, f32 radius) noexcept : a(a), b(b), radius(radius)
+            {
+            }
+
+            // Operations
+            SML_NO_DISCARD inline fvec3 support(const fvec3& direction) const noexcept
+            {
+                return fvec3::dot(a, direction) >= fvec3::dot(b, direction) ? a : b;
+            }
+
+            SML_NO_DISCARD inline fvec3 center() const noexcept
+            {
+                return (a + b) * 0.5f;
+            }
+
+            SML_NO_DISCARD inline f32 margin() const noexcept
+            {
+                return radius;
+            }
+
+            // Data
+            fvec3 a, b;
+            f32 radius;
+    };
+
+    class convexbox
+    {
+        public:
+            convexbox(const fvec3& center, const fvec3& halfextents, const fquat& rotation = fquat::identity()) noexcept
+                : position(center), halfextents(halfextents), rotation(rotation)
+            {
+            }
+
+            // Operations
+            SML_NO_DISCARD inline fvec3 support(const fvec3& direction) const noexcept
+            {
+                fvec3 local = rotation.conjugate() * direction;
+                fvec3 corner(local.x >= 0.0f ? halfextents.x : -halfextents.x,
+                             local.y >= 0.0f ? halfextents.y : -halfextents.y,
+                             local.z >= 0.0f ? halfextents.z : -halfextents.z);
+
+                return rotation * corner + position;
+            }
+
+            SML_NO_DISCARD inline fvec3 center() const noexcept
+            {
+                return position;
+            }
+
+            SML_NO_DISCARD inline f32 margin() const noexcept
+            {
+                return 0.0f;
+            }
+
+            // Data
+            fvec3 position;
+            fvec3 halfextents;
+            fquat rotation;
+    };
+
+    // Vertices of a convex hull in local space, stored SoA and padded to a multiple of eight so the
+    // support function dots eight vertices per instruction. The transform is any affine matrix or a
+    // rotation and position. A hull needs at least one vertex, the support function reads the first.
+    class convexhull
+    {
+        public:
+            convexhull(const fvec3* vertices, size_t count)
+            {
+                SML_ASSERT(count > 0);
+
+                size_t padded = (count + 7) & ~size_t(7);
+
+                x.resize(padded);
+                y.resize(padded);
+                z.resize(padded);
+
+                fvec3 sum(0.0f);
+
+                for (size_t i = 0; i < padded; i++)
+                {
+                    // Padding repeats the first vertex, which can never beat it
+                    const fvec3& v = vertices[i < count ? i : 0];
+
+                    x[i] = v.x;
+                    y[i] = v.y;
+                    z[i] = v.z;
+
+                    if (i < count)
+                        sum += v;
+                }
+
+                localcenter = count > 0 ? sum / static_cast<f32>(count) : sum;
+            }
+
+            // Operations
+            void settransform(const fmat4& transform) noexcept
+            {
+                columns[0] = fvec3(transform.m00, transform.m01, transform.m02);
+                columns[1] = fvec3(transform.m10, transform.m11, transform.m12);
+                columns[2] = fvec3(transform.m20, transform.m21, transform.m22);
+                translation = fvec3(transform.m30, transform.m31, transform.m32);
+            }
+
+            void settransform(const fquat& rotation, const fvec3& position) noexcept
+            {
+                columns[0] = rotation * fvec3(1.0f, 0.0f, 0.0f);
+                columns[1] = rotation * fvec3(0.0f, 1.0f, 0.0f);
+                columns[2] = rotation * fvec3(0.0f, 0.0f, 1.0f);
+                translation = position;
+            }
+
+            SML_NO_DISCARD inline fvec3 support(const fvec3& direction) const noexcept
+            {
+                // The direction goes to local space through the transpose of the linear part
+                __m256 dx = _mm256_set1_ps(fvec3::dot(columns[0], direction));
+                __m256 dy = _mm256_set1_ps(fvec3::dot(columns[1], direction));
+                __m256 dz = _mm256_set1_ps(fvec3::dot(columns[2], direction));
+
+                __m256 best = _mm256_set1_ps(-std::numeric_limits<f32>::infinity());
+                __m256 bestindex = _mm256_setzero_ps();
+                __m256 index = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+                __m256 step = _mm256_set1_ps(8.0f);
+
+                for (size_t i = 0; i < x.size(); i += 8)
+                {
+                    __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(&x[i]), dx), _mm256_mul_ps(_mm256_loadu_ps(&y[i]), dy)),
+                                             _mm256_mul_ps(_mm256_loadu_ps(&z[i]), dz));
+                    __m256 greater = _mm256_cmp_ps(d, best, _CMP_GT_OQ);
+
+                    best = simd::select(greater, best, d);
+                    bestindex = simd::select(greater, bestindex, index);
+                    index = _mm256_add_ps(index, step);
+                }
+
+                alignas(32) f32 values[8], indices[8];
+                _mm256_store_ps(values, best);
+                _mm256_store_ps(indices, bestindex);
+
+                u32 lane = 0;
+
+                for (u32 l = 1; l < 8; l++)
+                {
+                    if (values[l] > values[lane] || (values[l] == values[lane] && indices[l] < indices[lane]))
+                        lane = l;
+                }
+
+                size_t v = static_cast<size_t>(indices[lane]);
+
+                return transform(fvec3(x[v], y[v], z[v]));
+            }
+
+            SML_NO_DISCARD inline fvec3 center() const noexcept
+            {
+                return transform(localcenter);
+            }
+
+            SML_NO_DISCARD inline f32 margin() const noexcept
+            {
+                return 0.0f;
+            }
+
+        private:
+            inline fvec3 transform(const fvec3& p) const noexcept
+            {
+                return columns[0] * p.x + columns[1] * p.y + columns[2] * p.z + translation;
+            }
+
+            // Data
+            std::vector<f32> x, y, z;
+            fvec3 localcenter;
+            fvec3 columns[3] = { fvec3(1.0f, 0.0f, 0.0f), fvec3(0.0f, 1.0f, 0.0f), fvec3(0.0f, 0.0f, 1.0f) };
+            fvec3 translation = fvec3(0.0f);
+    };
+
+    // Directions that produced the final simplex of a query. Passing the same cache to the query of the
+    // next frame starts from the supports along them, which usually leaves one or two iterations.
+    struct gjkcache
+    {
+        fvec3 directions[4];
+        u32 count = 0;
+    };
+
+    // Distance is the signed distance between the shapes, it is negative when they overlap by less
+    // than their margins or when epa measured the penetration. Normal points from a to b and the
+    // points are the closest (or deepest) points of a and b.
+    struct gjkresult
+    {
+        f32 distance = 0.0f;
+        fvec3 normal = fvec3(0.0f);
+        fvec3 pointa = fvec3(0.0f);
+        fvec3 pointb = fvec3(0.0f);
+        bool intersecting = false;
+        u32 iterations = 0;
+    };
+
+    namespace detail
+    {
+        // Vertex of the Minkowski difference a - b with the points that made it
+        struct gjkvertex
+        {
+            fvec3 w, a, b, direction;
+        };
+
+        struct gjksimplex
+        {
+            gjkvertex v[4];
+            f32 lambda[4];
+            u32 count = 0;
+
+            inline void keep(std::initializer_list<u32> which, std::initializer_list<f32> weights) noexcept
+            {
+                gjkvertex kept[4];
+                u32 n = 0;
+
+                for (u32 i : which)
+                {
+                    kept[n++] = v[i];
+                }
+
+                n = 0;
+
+                for (f32 l : weights)
+                {
+                    v[n] = kept[n];
+                    lambda[n++] = l;
+                }
+
+                count = n;
+            }
+
+            inline fvec3 closest() const noexcept
+            {
+                fvec3 p(0.0f);
+
+                for (u32 i = 0; i < count; i++)
+                {
+                    p += v[i].w * lambda[i];
+                }
+
+                return p;
+            }
+        };
+
+        // Closest point of the segment ab to the origin as a weight of b
+        inline f32 segmentweight(const fvec3& a, const fvec3& b) noexcept
+        {
+            fvec3 ab = b - a;
+            f32 length = fvec3::dot(ab, ab);
+
+            return length > 0.0f ? std::min(std::max(-fvec3::dot(a, ab) / length, 0.0f), 1.0f) : 0.0f;
+        }
+
+        // Reduces the triangle 0, 1, 2 of s to the feature closest to the origin (Ericson 5.1.5)
+        inline void closesttriangle(gjksimplex& s) noexcept
+        {
+            const fvec3 &a = s.v[0].w, &b = s.v[1].w, &c = s.v[2].w;
+            fvec3 ab = b - a, ac = c - a;
+
+            f32 d1 = -fvec3::dot(ab, a), d2 = -fvec3::dot(ac, a);
+
+            if (d1 <= 0.0f && d2 <= 0.0f)
+                return s.keep({ 0 }, { 1.0f });
+
+            f32 d3 = -fvec3::dot(ab, b), d4 = -fvec3::dot(ac, b);
+
+            if (d3 >= 0.0f && d4 <= d3)
+                return s.keep({ 1 }, { 1.0f });
+
+            f32 vc = d1 * d4 - d3 * d2;
+
+            if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+            {
+                f32 t = d1 / (d1 - d3);
+                return s.keep({ 0, 1 }, { 1.0f - t, t });
+            }
+
+            f32 d5 = -fvec3::dot(ab, c), d6 = -fvec3::dot(ac, c);
+
+            if (d6 >= 0.0f && d5 <= d6)
+                return s.keep({ 2 }, { 1.0f });
+
+            f32 vb = d5 * d2 - d1 * d6;
+
+            if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+            {
+                f32 t = d2 / (d2 - d6);
+                return s.keep({ 0, 2 }, { 1.0f - t, t });
+            }
+
+            f32 va = d3 * d6 - d5 * d4;
+
+            if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+            {
+                f32 t = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+                return s.keep({ 1, 2 }, { 1.0f - t, t });
+            }
+
+            f32 sum = va + vb + vc;
+
+            // Degenerate triangles fall back to their closest edge
+            if (!(sum > 0.0f))
+            {
+                f32 best = std::numeric_limits<f32>::infinity();
+                u32 edges[3][2] = { { 0, 1 }, { 0, 2 }, { 1, 2 } };
+                u32 e = 0;
+                f32 weight = 0.0f;
+
+                for (u32 i = 0; i < 3; i++)
+                {
+                    const fvec3 &p = s.v[edges[i][0]].w, &q = s.v[edges[i][1]].w;
+                    f32 t = segmentweight(p, q);
+                    f32 d = (p + (q - p) * t).lengthsquared();
+
+                    if (d < best)
+                    {
+                        best = d;
+                        e = i;
+                        weight = t;
+                    }
+                }
+
+                return s.keep({ edges[e][0], edges[e][1] }, { 1.0f - weight, weight });
+            }
+
+            f32 v = vb / sum, w = vc / sum;
+
+            s.lambda[0] = 1.0f - v - w;
+            s.lambda[1] = v;
+            s.lambda[2] = w;
+        }
+
+        // Reduces s to the feature closest to the origin, returns false when a tetrahedron contains it
+        inline bool closestfeature(gjksimplex& s) noexcept
+        {
+            switch (s.count)
+            {
+                case 1:
+                    s.lambda[0] = 1.0f;
+                    return true;
+
+                case 2:
+                {
+                    f32 t = segmentweight(s.v[0].w, s.v[1].w);
+
+                    if (t <= 0.0f)
+                        s.keep({ 0 }, { 1.0f });
+                    else if (t >= 1.0f)
+                        s.keep({ 1 }, { 1.0f });
+                    else
+                    {
+                        s.lambda[0] = 1.0f - t;
+                        s.lambda[1] = t;
+                    }
+
+                    return true;
+                }
+
+                case 3:
+                    closesttriangle(s);
+                    return true;
+
+                default:
+                {
+                    // Faces with the origin on their outer side, degenerate tetrahedra have all faces outside
+                    u32 faces[4][4] = { { 0, 1, 2, 3 }, { 0, 3, 1, 2 }, { 0, 2, 3, 1 }, { 1, 3, 2, 0 } };
+                    gjksimplex best;
+                    f32 bestdistance = std::numeric_limits<f32>::infinity();
+                    bool outside = false;
+
+                    for (const u32 (&f)[4] : faces)
+                    {
+                        const fvec3 &a = s.v[f[0]].w, &b = s.v[f[1]].w, &c = s.v[f[2]].w, &d = s.v[f[3]].w;
+                        fvec3 n = fvec3::cross(b - a, c - a);
+                        f32 origin = -fvec3::dot(n, a), opposite = fvec3::dot(n, d - a);
+
+                        if (opposite != 0.0f && origin * opposite >= 0.0f)
+                            continue;
+
+                        outside = true;
+
+                        gjksimplex t;
+                        t.v[0] = s.v[f[0]];
+                        t.v[1] = s.v[f[1]];
+                        t.v[2] = s.v[f[2]];
+                        t.count = 3;
+                        closesttriangle(t);
+
+                        f32 distance = t.closest().lengthsquared();
+
+                        if (distance < bestdistance)
+                        {
+                            bestdistance = distance;
+                            best = t;
+                        }
+                    }
+
+                    if (!outside)
+                        return false;
+
+                    s = best;
+                    return true;
+                }
+            }
+        }
+
+        // Runs GJK on the Minkowski difference given by support(direction) -> gjkvertex until the
+        // distance converges or the origin is enclosed. Returns false when the shapes intersect, s
+        // then holds a simplex that contains or touches the origin.
+        template<typename S>
+        inline bool gjkloop(S&& support, gjksimplex& s, fvec3 direction, u32 maxiterations, u32& iterations) noexcept
+        {
+            if (s.count == 0)
+            {
+                if (direction.lengthsquared() == 0.0f)
+                    direction = fvec3(1.0f, 0.0f, 0.0f);
+
+                s.v[0] = support(-direction);
+                s.count = 1;
+            }
+
+            f32 previous = std::numeric_limits<f32>::infinity();
+
+            for (iterations = 0; iterations < maxiterations; iterations++)
+            {
+                if (!closestfeature(s))
+                    return false;
+
+                fvec3 v = s.closest();
+                f32 vv = v.lengthsquared();
+                f32 scale = 0.0f;
+
+                for (u32 i = 0; i < s.count; i++)
+                {
+                    scale = std::max(scale, s.v[i].w.lengthsquared());
+                }
+
+                if (vv <= 1e-10f * scale || vv == 0.0f)
+                    return false;
+
+                // No progress is as close as single precision gets
+                if (vv >= previous)
+                    return true;
+
+                previous = vv;
+
+                gjkvertex w = support(-v);
+
+                if (vv - fvec3::dot(v, w.w) <= 1e-6f * vv)
+                    return true;
+
+                for (u32 i = 0; i < s.count; i++)
+                {
+                    if (s.v[i].w == w.w)
+                        return true;
+                }
+
+                s.v[s.count++] = w;
+            }
+
+            return true;
+        }
+
+        template<typename A, typename B>
+        inline gjkvertex coresupport(const A& a, const B& b, const fvec3& direction) noexcept
+        {
+            gjkvertex v;
+
+            v.a = a.support(direction);
+            v.b = b.support(-direction);
+            v.w = v.a - v.b;
+            v.direction = direction;
+
+            return v;
+        }
+
+        // Distance between the cores, fills s with the final simplex
+        template<typename A, typename B>
+        inline bool gjkcores(const A& a, const B& b, gjkcache* cache, u32 maxiterations, gjksimplex& s, u32& iterations) noexcept
+        {
+            auto support = [&](const fvec3& d) { return coresupport(a, b, d); };
+
+            s.count = 0;
+
+            if (cache != nullptr)
+            {
+                for (u32 i = 0; i < cache->count; i++)
+                {
+                    gjkvertex w = support(cache->directions[i]);
+                    bool duplicate = false;
+
+                    for (u32 j = 0; j < s.count; j++)
+                    {
+                        duplicate = duplicate || s.v[j].w == w.w;
+                    }
+
+                    if (!duplicate)
+                        s.v[s.count++] = w;
+                }
+            }
+
+            bool separated = gjkloop(support, s, b.center() - a.center(), maxiterations, iterations);
+
+            if (cache != nullptr)
+            {
+                cache->count = s.count;
+
+                for (u32 i = 0; i < s.count; i++)
+                {
+                    cache->directions[i] = s.v[i].direction;
+                }
+            }
+
+            return separated;
+        }
+    } // namespace detail
+
+    // Distance query between two convex shapes. Separated shapes get their distance and closest points.
+    // When the cores lie within the margins the result is a shallow penetration with a negative
+    // distance, when the cores themselves overlap intersecting is set with a distance of zero and epa
+    // measures the depth.
+    template<typename A, typename B>
+    inline gjkresult gjk(const A& a, const B& b, gjkcache* cache = nullptr, u32 maxiterations = 64) noexcept
+    {
+        detail::gjksimplex s;
+        gjkresult result;
+
+        if (!detail::gjkcores(a, b, cache, maxiterations, s, result.iterations))
+        {
+            result.intersecting = true;
+
+            for (u32 i = 0; i < s.count; i++)
+            {
+                result.pointa += s.v[i].a * (1.0f / static_cast<f32>(s.count));
+            }
+
+            result.pointb = result.pointa;
+
+            return result;
+        }
+
+        fvec3 pa(0.0f), pb(0.0f);
+
+        for (u32 i = 0; i < s.count; i++)
+        {
+            pa += s.v[i].a * s.lambda[i];
+            pb += s.v[i].b * s.lambda[i];
+        }
+
+        f32 core = (pb - pa).length();
+        f32 margins = a.margin() + b.margin();
+
+        result.normal = core > 0.0f ? (pb - pa) / core : fvec3(1.0f, 0.0f, 0.0f);
+        result.pointa = pa + result.normal * a.margin();
+        result.pointb = pb - result.normal * b.margin();
+        result.distance = core - margins;
+        result.intersecting = result.distance < 0.0f;
+
+        return result;
+    }
+
+    // Penetration query, gjk followed by the expanding polytope algorithm on the full shapes when the
+    // cores overlap. Distance is minus the depth, moving b by -distance along normal separates them.
+    template<typename A, typename B>
+    inline gjkresult epa(const A& a, const B& b, gjkcache* cache = nullptr, u32 maxiterations = 64) noexcept
+    {
+        using detail::gjkvertex;
+
+        gjkresult result = gjk(a, b, cache, maxiterations);
+
+        if (!result.intersecting || result.distance < 0.0f)
+            return result;
+
+        auto support = [&](const fvec3& d)
+        {
+            gjkvertex v = detail::coresupport(a, b, d);
+            fvec3 n = d / d.length();
+
+            v.a += n * a.margin();
+            v.b -= n * b.margin();
+            v.w = v.a - v.b;
+
+            return v;
+        };
+
+        // A simplex of the full shapes enclosing the origin, grown to a tetrahedron when it only touches it
+        detail::gjksimplex s;
+        u32 iterations = 0;
+
+        if (detail::gjkloop(support, s, b.center() - a.center(), maxiterations, iterations))
+            return result;
+
+        result.iterations += iterations;
+
+        const fvec3 axes[6] = { fvec3(1.0f, 0.0f, 0.0f), fvec3(-1.0f, 0.0f, 0.0f), fvec3(0.0f, 1.0f, 0.0f),
+                                fvec3(0.0f, -1.0f, 0.0f), fvec3(0.0f, 0.0f, 1.0f), fvec3(0.0f, 0.0f, -1.0f) };
+        const f32 tiny = 1e-12f;
+
+        if (s.count == 1)
+        {
+            for (const fvec3& axis : axes)
+            {
+                gjkvertex w = support(axis);
+
+                if ((w.w - s.v[0].w).lengthsquared() > tiny)
+                {
+                    s.v[s.count++] = w;
+                    break;
+                }
+            }
+        }
+
+        if (s.count == 2)
+        {
+            fvec3 d = s.v[1].w - s.v[0].w;
+
+            for (const fvec3& axis : axes)
+            {
+                fvec3 p = fvec3::cross(d, axis);
+
+                if (p.lengthsquared() <= tiny)
+                    continue;
+
+                gjkvertex w = support(p);
+
+                if (fvec3::cross(w.w - s.v[0].w, d).lengthsquared() > tiny)
+                {
+                    s.v[s.count++] = w;
+                    break;
+                }
+            }
+        }
+
+        if (s.count == 3 && fvec3::cross(s.v[1].w - s.v[0].w, s.v[2].w - s.v[0].w).lengthsquared() > tiny)
+        {
+            fvec3 n = fvec3::cross(s.v[1].w - s.v[0].w, s.v[2].w - s.v[0].w);
+            gjkvertex w = support(n);
+
+            if (std::abs(fvec3::dot(w.w - s.v[0].w, n)) <= tiny)
+                w = support(-n);
+
+            if (std::abs(fvec3::dot(w.w - s.v[0].w, n)) > tiny)
+                s.v[s.count++] = w;
+        }
+
+        if (s.count < 4)
+        {
+            // Flat shapes touching, no direction to push along. Coincident centers fall back to a fixed axis.
+            fvec3 between = b.center() - a.center();
+            f32 length = between.length();
+
+            result.distance = 0.0f;
+            result.normal = length > 0.0f ? between / length : fvec3(1.0f, 0.0f, 0.0f);
+
+            return result;
+        }
+
+        // Orient the tetrahedron so face 0 1 2 faces away from vertex 3
+        if (fvec3::dot(fvec3::cross(s.v[1].w - s.v[0].w, s.v[2].w - s.v[0].w), s.v[3].w - s.v[0].w) > 0.0f)
+            std::swap(s.v[1], s.v[2]);
+
+        const u32 maxvertices = 128, maxfaces = 512;
+
+        struct face
+        {
+            fvec3 normal;
+            f32 distance;
+            u32 i[3];
+            bool live;
+        };
+
+        gjkvertex vertices[maxvertices];
+        face faces[maxfaces];
+        u32 vertexcount = 4, facecount = 0;
+
+        for (u32 i = 0; i < 4; i++)
+        {
+            vertices[i] = s.v[i];
+        }
+
+        auto addface = [&](u32 p, u32 q, u32 r)
+        {
+            fvec3 n = fvec3::cross(vertices[q].w - vertices[p].w, vertices[r].w - vertices[p].w);
+            f32 length = n.length();
+
+            if (facecount == maxfaces)
+                return false;
+
+            face& f = faces[facecount++];
+
+            f.normal = length > 0.0f ? n / length : n;
+            f.distance = length > 0.0f ? fvec3::dot(f.normal, vertices[p].w) : std::numeric_limits<f32>::infinity();
+            f.i[0] = p;
+            f.i[1] = q;
+            f.i[2] = r;
+            f.live = length > 0.0f;
+
+            return true;
+        };
+
+        addface(0, 1, 2);
+        addface(0, 3, 1);
+        addface(0, 2, 3);
+        addface(1, 3, 2);
+
+        face closest;
+        closest.live = false;
+
+        for (u32 iteration = 0; iteration < maxiterations; iteration++)
+        {
+            closest.live = false;
+
+            for (u32 f = 0; f < facecount; f++)
+            {
+                if (faces[f].live && (!closest.live || faces[f].distance < closest.distance))
+                    closest = faces[f];
+            }
+
+            if (!closest.live)
+                break;
+
+            gjkvertex w = support(closest.normal);
+            f32 gain = fvec3::dot(w.w, closest.normal) - closest.distance;
+
+            if (gain <= 1e-4f * std::max(closest.distance, 1e-3f) || vertexcount == maxvertices)
+                break;
+
+            u32 added = vertexcount++;
+            vertices[added] = w;
+
+            // Faces seen from the new vertex go, their boundary edges form the horizon
+            u32 edges[maxfaces][2];
+            u32 edgecount = 0;
+
+            for (u32 f = 0; f < facecount; f++)
+            {
+                if (!faces[f].live || fvec3::dot(faces[f].normal, w.w - vertices[faces[f].i[0]].w) <= 0.0f)
+                    continue;
+
+                faces[f].live = false;
+
+                for (u32 e = 0; e < 3; e++)
+                {
+                    u32 p = faces[f].i[e], q = faces[f].i[(e + 1) % 3];
+                    bool shared = false;
+
+                    for (u32 k = 0; k < edgecount; k++)
+                    {
+                        if (edges[k][0] == q && edges[k][1] == p)
+                        {
+                            edges[k][0] = edges[--edgecount][0];
+                            edges[k][1] = edges[edgecount][1];
+                            shared = true;
+                            break;
+                        }
+                    }
+
+                    if (!shared && edgecount < maxfaces)
+                    {
+                        edges[edgecount][0] = p;
+                        edges[edgecount++][1] = q;
+                    }
+                }
+            }
+
+            // Dead faces are compacted when the table fills up
+            if (facecount + edgecount > maxfaces)
+            {
+                u32 n = 0;
+
+                for (u32 f = 0; f < facecount; f++)
+                {
+                    if (faces[f].live)
+                        faces[n++] = faces[f];
+                }
+
+                facecount = n;
+            }
+
+            bool full = false;
+
+            for (u32 k = 0; k < edgecount; k++)
+            {
+                full = !addface(edges[k][0], edges[k][1], added) || full;
+            }
+
+            if (full)
+                break;
+
+            result.iterations++;
+        }
+
+        if (!closest.live)
+            return result;
+
+        // Barycentric weights of the projection of the origin onto the closest face
+        const gjkvertex &va = vertices[closest.i[0]], &vb = vertices[closest.i[1]], &vc = vertices[closest.i[2]];
+        fvec3 p = closest.normal * closest.distance;
+        fvec3 v0 = vb.w - va.w, v1 = vc.w - va.w, v2 = p - va.w;
+
+        f32 d00 = fvec3::dot(v0, v0), d01 = fvec3::dot(v0, v1), d11 = fvec3::dot(v1, v1);
+        f32 d20 = fvec3::dot(v2, v0), d21 = fvec3::dot(v2, v1);
+        f32 denominator = d00 * d11 - d01 * d01;
+        f32 v = denominator != 0.0f ? (d11 * d20 - d01 * d21) / denominator : 0.0f;
+        f32 w = denominator != 0.0f ? (d00 * d21 - d01 * d20) / denominator : 0.0f;
+        f32 u = 1.0f - v - w;
+
+        result.distance = -closest.distance;
+        result.normal = closest.normal;
+        result.pointa = va.a * u + vb.a * v + vc.a * w;
+        result.pointb = va.b * u + vb.b * v + vc.b * w;
+        result.intersecting = true;
+
+        return result;
+    }
+} // namespace sml
+
+#endif // sml_gjk_h__
@@ -0,0 +1,362 @@
+#ifndef sml_half_h__
+#define sml_half_h__
+
+/* half.h -- half precision storage types of the 'Simple Math Library'
+  Copyright (C) 2020 Roderick Griffioen
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <cstddef>
+#include <cstring>
+#include <immintrin.h>
+
+#include "smltypes.h"
+#include "vec2.h"
+#include "vec3.h"
+#include "vec4.h"
+
+namespace sml
+{
+    // IEEE 754 binary16 storage, converts to and from f32 with round to nearest even.
+    // The conversions use F16C when the compiler targets it (-mf16c) and exact bit manipulation otherwise.
+    class half
+    {
+        public:
+            constexpr half() noexcept : bits(0)
+            {
+            }
+
+            half(f32 value) noexcept : bits(fromfloat(value))
+            {
+            }
+
+            operator f32() const noexcept
+            {
+                return tofloat(bits);
+            }
+
+            inline constexpr bool operator == (const half& other) const noexcept
+            {
+                return bits == other.bits;
+            }
+
+            inline constexpr bool operator != (const half& other) const noexcept
+            {
+                return bits != other.bits;
+            }
+
+            // Statics
+            SML_NO_DISCARD static inline constexpr half frombits(u16 bits) noexcept
+            {
+                half h;
+                h.bits = bits;
+
+                return h;
+            }
+
+            SML_NO_DISCARD static inline u16 fromfloat(f32 value) noexcept
+            {
+#ifdef __F16C__
+                return static_cast<u16>(_mm_extract_epi16(_mm_cvtps_ph(_mm_set_ss(value), _MM_FROUND_TO_NEAREST_INT), 0));
+#else
+                u32 f;
+                std::memcpy(&f, &value, sizeof(f));
+
+                u32 sign = (f >> 16) & 0x8000;
+                u32 absf = f & 0x7FFFFFFF;
+
+                // Infinity and NaN, NaN keeps its top payload bits and stays quiet
+                if (absf >= 0x7F800000)
+                    return static_cast<u16>(sign | 0x7C00 | (absf > 0x7F800000 ? 0x200 | ((absf >> 13) & 0x3FF) : 0));
+
+                // Anything from 65520 upwards rounds past the largest half
+                if (absf >= 0x477FF000)
+                    return static_cast<u16>(sign | 0x7C00);
+
+                // Subnormal halves, 2^-25 and below round to zero
+                if (absf < 0x38800000)
+                {
+                    if (absf <= 0x33000000)
+                        return static_cast<u16>(sign);
+
+                    u32 mantissa = (absf & 0x7FFFFF) | 0x800000;
+                    u32 shift = 126 - (absf >> 23);
+                    u32 h = mantissa >> shift;
+                    u32 remainder = mantissa & ((1u << shift) - 1);
+                    u32 halfway = 1u << (shift - 1);
+
+                    if (remainder > halfway || (remainder == halfway && (h & 1)))
+                        h++;
+
+                    return static_cast<u16>(sign | h);
+                }
+
+                u32 h = (absf - 0x38000000) >> 13;
+                u32 remainder = absf & 0x1FFF;
+
+                if (remainder > 0x1000 || (remainder == 0x1000 && (h & 1)))
+                    h++;
+
+                return static_cast<u16>(sign | h);
+#endif
+            }
+
+            SML_NO_DISCARD static inline f32 tofloat(u16 bits) noexcept
+            {
+#ifdef __F16C__
+                return _mm_cvtss_f32(_mm_cvtph_ps(_mm_cvtsi32_si128(bits)));
+#else
+                u32 sign = static_cast<u32>(bits & 0x8000) << 16;
+                u32 exponent = (bits >> 10) & 0x1F;
+                u32 mantissa = bits & 0x3FF;
+                u32 f;
+
+                if (exponent == 0)
+                {
+                    // Zero and subnormals, mantissa * 2^-24 is exact in f32
+                    f32 value = static_cast<f32>(mantissa) * 5.9604644775390625e-8f;
+
+                    return sign ? -value : value;
+                }
+
+                if (exponent == 31)
+                    f = sign | 0x7F800000 | (mantissa << 13);
+                else
+                    f = sign | ((exponent + 112) << 23) | (mantissa << 13);
+
+                f32 value;
+                std::memcpy(&value, &f, sizeof(value));
+
+                return value;
+#endif
+            }
+
+            // Data
+            u16 bits;
+    };
+
+    static_assert(sizeof(half) == 2, "half must be two bytes");
+
+    struct hvec2
+    {
+        constexpr hvec2() noexcept = default;
+
+        hvec2(f32 x, f32 y) noexcept : x(x), y(y)
+        {
+        }
+
+        hvec2(const vec2<f32>& other) noexcept : x(other.x), y(other.y)
+        {
+        }
+
+        operator vec2<f32>() const noexcept
+        {
+            return vec2<f32>(x, y);
+        }
+
+        half x, y;
+    };
+
+    struct hvec3
+    {
+        constexpr hvec3() noexcept = default;
+
+        hvec3(f32 x, f32 y, f32 z) noexcept : x(x), y(y), z(z)
+        {
+        }
+
+        hvec3(const vec3<f32>& other) noexcept : x(other.x), y(other.y), z(other.z)
+        {
+        }
+
+        operator vec3<f32>() const noexcept
+        {
+            return vec3<f32>(x, y, z);
+        }
+
+        half x, y, z;
+    };
+
+    struct hvec4
+    {
+        constexpr hvec4() noexcept = default;
+
+        hvec4(f32 x, f32 y, f32 z, f32 w) noexcept : x(x), y(y), z(z), w(w)
+        {
+        }
+
+        hvec4(const vec4<f32>& other) noexcept : x(other.x), y(other.y), z(other.z), w(other.w)
+        {
+        }
+
+        operator vec4<f32>() const noexcept
+        {
+            return vec4<f32>(x, y, z, w);
+        }
+
+        half x, y, z, w;
+    };
+
+    static_assert(sizeof(hvec3) == 6, "hvec3 must not be padded");
+
+    // Bulk f32 -> f16, eight values per instruction with F16C
+    inline void pack(const f32* src, half* dst, size_t count) noexcept
+    {
+        size_t i = 0;
+
+#ifdef __F16C__
+        for (; i + 8 <= count; i += 8)
+        {
+            __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), h);
+        }
+#endif
+
+        for (; i < count; i++)
+        {
+            dst[i] = half(src[i]);
+        }
+    }
+
+    // Bulk f16 -> f32
+    inline void unpack(const half* src, f32* dst, size_t count) noexcept
+    {
+        size_t i = 0;
+
+#ifdef __F16C__
+        for (; i + 8 <= count; i += 8)
+        {
+            __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+
+            _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+        }
+#endif
+
+        for (; i < count; i++)
+        {
+            dst[i] = src[i];
+        }
+    }
+
+    inline void pack(const vec2<f32>* src, hvec2* dst, size_t count) noexcept
+    {
+        size_t i = 0;
+
+#ifdef __F16C__
+        for (; i + 4 <= count; i += 4)
+        {
+            // x y 0 0 x y 0 0 in 16 bit lanes, keep the even 32 bit lanes
+            __m128i h01 = _mm256_cvtps_ph(_mm256_loadu_ps(src[i + 0].v), _MM_FROUND_TO_NEAREST_INT);
+            __m128i h23 = _mm256_cvtps_ph(_mm256_loadu_ps(src[i + 2].v), _MM_FROUND_TO_NEAREST_INT);
+
+            h01 = _mm_shuffle_epi32(h01, _MM_SHUFFLE(3, 1, 2, 0));
+            h23 = _mm_shuffle_epi32(h23, _MM_SHUFFLE(3, 1, 2, 0));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_unpacklo_epi64(h01, h23));
+        }
+#endif
+
+        for (; i < count; i++)
+        {
+            dst[i] = src[i];
+        }
+    }
+
+    inline void unpack(const hvec2* src, vec2<f32>* dst, size_t count) noexcept
+    {
+        size_t i = 0;
+
+#ifdef __F16C__
+        __m128i zero = _mm_setzero_si128();
+
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+
+            _mm256_storeu_ps(dst[i + 0].v, _mm256_cvtph_ps(_mm_unpacklo_epi32(h, zero)));
+            _mm256_storeu_ps(dst[i + 2].v, _mm256_cvtph_ps(_mm_unpackhi_epi32(h, zero)));
+        }
+#endif
+
+        for (; i < count; i++)
+        {
+            dst[i] = src[i];
+        }
+    }
+
+    inline void pack(const vec3<f32>* src, hvec3* dst, size_t count) noexcept
+    {
+        size_t i = 0;
+
+#ifdef __F16C__
+        // Each store writes 16 bytes for 12 bytes of output, the 4 extra bytes land in
+        // element i + 8 which exists and is rewritten by the next iteration or the tail
+        __m128i compact = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 8, 9, 10, 11, 12, 13, -128, -128, -128, -128);
+
+        for (; i + 8 < count; i += 8)
+        {
+            for (size_t k = 0; k < 8; k += 2)
+            {
+                __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src[i + k].v), _MM_FROUND_TO_NEAREST_INT);
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + k), _mm_shuffle_epi8(h, compact));
+            }
+        }
+#endif
+
+        for (; i < count; i++)
+        {
+            dst[i] = src[i];
+        }
+    }
+
+    inline void unpack(const hvec3* src, vec3<f32>* dst, size_t count) noexcept
+    {
+        size_t i = 0;
+
+#ifdef __F16C__
+        // 16 byte loads read 4 bytes of element i + 8, which exists
+        __m128i expand = _mm_setr_epi8(0, 1, 2, 3, 4, 5, -128, -128, 6, 7, 8, 9, 10, 11, -128, -128);
+
+        for (; i + 8 < count; i += 8)
+        {
+            for (size_t k = 0; k < 8; k += 2)
+            {
+                __m128i h = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + k)), expand);
+
+                _mm256_storeu_ps(dst[i + k].v, _mm256_cvtph_ps(h));
+            }
+        }
+#endif
+
+        for (; i < count; i++)
+        {
+            dst[i] = src[i];
+        }
+    }
+
+    inline void pack(const vec4<f32>* src, hvec4* dst, size_t count) noexcept
+    {
+        pack(src[0].v, &dst[0].x, count * 4);
+    }
+
+    inline void unpack(const hvec4* src, vec4<f32>* dst, size_t count) noexcept
+    {
+        unpack(&src[0].x, dst[0].v, count * 4);
+    }
+} // namespace sml
+
+#endif // sml_half_h__
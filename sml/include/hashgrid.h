@@ -0,0 +1,412 @@
+#ifndef sml_hashgrid_h__
+#define sml_hashgrid_h__
+
+/* hashgrid.h -- uniform spatial hash grid of the 'Simple Math Library'
+  Copyright (C) 2020 Roderick Griffioen
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+#include <immintrin.h>
+
+#include "smltypes.h"
+#include "common.h"
+#include "simd.h"
+#include "vec3.h"
+#include "parallel.h"
+#include "morton.h"
+
+namespace sml
+{
+    // Uniform grid of cubic cells hashed into a power of two table of buckets. Points are radix
+    // sorted by bucket and copied into SoA arrays, queries scan the buckets of the cells they touch
+    // eight points at a time and skip points of other cells that share a bucket. Rebuilding with
+    // the same or a smaller number of points reuses every buffer, and the layout does not depend
+    // on the number of threads.
+    class hashgrid
+    {
+        public:
+            explicit hashgrid(f32 cellsize = 1.0f) noexcept : cellsize(cellsize), inverse(1.0f / cellsize)
+            {
+            }
+
+            // Operations
+            void build(const vec3<f32>* positions, size_t count, u32 threads = 0)
+            {
+                u32 chunks = threadcount(threads);
+                size_t wanted = 16;
+
+                while (wanted < count)
+                {
+                    wanted <<= 1;
+                }
+
+                if (wanted > tablesize)
+                {
+                    tablesize = wanted;
+                    starts.resize(tablesize + 1);
+                }
+
+                buckets.resize(count);
+                indices.resize(count);
+                tempbuckets.resize(count);
+                tempindices.resize(count);
+                x.resize(count + 8);
+                y.resize(count + 8);
+                z.resize(count + 8);
+                partial.resize(chunks * 8);
+                points = count;
+
+                __m128 scale = _mm_set1_ps(inverse);
+
+                // Buckets and the range of occupied cells, which bounds the cell loops of large queries
+                parallelfor(0, count, 16384, [&](size_t begin, size_t end, u32 chunk)
+                {
+                    __m128i lo = _mm_set1_epi32(std::numeric_limits<s32>::max());
+                    __m128i hi = _mm_set1_epi32(std::numeric_limits<s32>::min());
+
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        __m128i cell = _mm_cvtps_epi32(_mm_floor_ps(_mm_mul_ps(simd::load(positions[i].v), scale)));
+
+                        lo = _mm_min_epi32(lo, cell);
+                        hi = _mm_max_epi32(hi, cell);
+                        buckets[i] = bucket(_mm_cvtsi128_si32(cell), _mm_extract_epi32(cell, 1), _mm_extract_epi32(cell, 2));
+                        indices[i] = static_cast<u32>(i);
+                    }
+
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(&partial[chunk * 8]), lo);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(&partial[chunk * 8 + 4]), hi);
+                }, chunks);
+
+                __m128i lo = _mm_set1_epi32(std::numeric_limits<s32>::max());
+                __m128i hi = _mm_set1_epi32(std::numeric_limits<s32>::min());
+
+                for (size_t c = 0; c < chunks && c * 16384 < count; c++)
+                {
+                    lo = _mm_min_epi32(lo, _mm_loadu_si128(reinterpret_cast<const __m128i*>(&partial[c * 8])));
+                    hi = _mm_max_epi32(hi, _mm_loadu_si128(reinterpret_cast<const __m128i*>(&partial[c * 8 + 4])));
+                }
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(cellmin), lo);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(cellmax), hi);
+
+                // A stable sort keeps the points of a bucket in input order whatever the thread count
+                radixsort(buckets.data(), indices.data(), count, tempbuckets.data(), tempindices.data(), chunks);
+
+                // Every bucket starts at the first sorted point whose bucket is not smaller, the point at
+                // which the bucket changes writes the starts of the empty buckets before it
+                parallelfor(0, count + 1, 16384, [&](size_t begin, size_t end, u32)
+                {
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        size_t first = i == 0 ? 0 : buckets[i - 1] + 1;
+                        size_t last = i == count ? tablesize : buckets[i];
+
+                        for (size_t h = first; h <= last; h++)
+                        {
+                            starts[h] = static_cast<u32>(i);
+                        }
+
+                        if (i < count)
+                        {
+                            const vec3<f32>& p = positions[indices[i]];
+
+                            x[i] = p.x;
+                            y[i] = p.y;
+                            z[i] = p.z;
+                        }
+                    }
+                }, chunks);
+
+                // Padding lies in no cell, so eight wide scans past the last bucket never match
+                for (size_t i = count; i < count + 8; i++)
+                {
+                    x[i] = y[i] = z[i] = std::numeric_limits<f32>::infinity();
+                }
+            }
+
+            SML_NO_DISCARD inline bool empty() const noexcept
+            {
+                return points == 0;
+            }
+
+            SML_NO_DISCARD inline size_t size() const noexcept
+            {
+                return points;
+            }
+
+            // Calls visit(index, distancesq) for every point within radius of p
+            template<typename F>
+            void withinradius(const vec3<f32>& p, f32 radius, F&& visit) const
+            {
+                if (empty())
+                    return;
+
+                s32 lo[3], hi[3];
+                cellrange(p, radius, lo, hi);
+
+                for (s32 cz = lo[2]; cz <= hi[2]; cz++)
+                {
+                    for (s32 cy = lo[1]; cy <= hi[1]; cy++)
+                    {
+                        for (s32 cx = lo[0]; cx <= hi[0]; cx++)
+                        {
+                            scan(p, radius * radius, cx, cy, cz, 0, [&](u32 slot, f32 d) { visit(indices[slot], d); });
+                        }
+                    }
+                }
+            }
+
+            // The k points closest to p within maxdistance, nearest first. Rings of cells around the cell
+            // of p, clipped to the occupied cells, are searched until the kth distance lies inside the rings
+            // searched so far. Returns the number of points found.
+            u32 nearest(const vec3<f32>& p, u32 k, u32* result, f32* distancesq, f32 maxdistance = std::numeric_limits<f32>::infinity()) const
+            {
+                if (empty() || k == 0)
+                    return 0;
+
+                s64 c[3];
+                cellof(p, c);
+
+                // Rings closer than the occupied cells are empty, the first one that reaches them starts
+                s64 first = 0;
+
+                for (s32 a = 0; a < 3; a++)
+                {
+                    first = std::max(first, std::max(cellmin[a] - c[a], c[a] - cellmax[a]));
+                }
+
+                f32 limit = maxdistance * maxdistance;
+                u32 found = 0;
+
+                auto add = [&](u32 slot, f32 d)
+                {
+                    if (found == k && d >= distancesq[k - 1])
+                        return;
+
+                    u32 at = found < k ? found++ : k - 1;
+
+                    for (; at > 0 && distancesq[at - 1] > d; at--)
+                    {
+                        result[at] = result[at - 1];
+                        distancesq[at] = distancesq[at - 1];
+                    }
+
+                    result[at] = indices[slot];
+                    distancesq[at] = d;
+                };
+
+                for (s64 r = first;; r++)
+                {
+                    s64 lo[3], hi[3];
+
+                    for (s32 a = 0; a < 3; a++)
+                    {
+                        lo[a] = std::max<s64>(c[a] - r, cellmin[a]);
+                        hi[a] = std::min<s64>(c[a] + r, cellmax[a]);
+                    }
+
+                    auto visit = [&](s64 cx, s64 cy, s64 cz)
+                    {
+                        scan(p, found == k ? std::min(limit, distancesq[k - 1]) : limit, static_cast<s32>(cx), static_cast<s32>(cy), static_cast<s32>(cz), 0, add);
+                    };
+
+                    for (s64 cz = lo[2]; cz <= hi[2]; cz++)
+                    {
+                        for (s64 cy = lo[1]; cy <= hi[1]; cy++)
+                        {
+                            // Inner rows of the shell only have their two end cells on the ring
+                            if (cz == c[2] - r || cz == c[2] + r || cy == c[1] - r || cy == c[1] + r)
+                            {
+                                for (s64 cx = lo[0]; cx <= hi[0]; cx++)
+                                {
+                                    visit(cx, cy, cz);
+                                }
+                            }
+                            else
+                            {
+                                if (c[0] - r >= lo[0])
+                                {
+                                    visit(c[0] - r, cy, cz);
+                                }
+
+                                if (c[0] + r <= hi[0])
+                                {
+                                    visit(c[0] + r, cy, cz);
+                                }
+                            }
+                        }
+                    }
+
+                    // Distance from p to the outside of the searched cube of cells, none when the cell of p
+                    // was clamped and p lies outside the cube
+                    f64 inside = std::numeric_limits<f64>::infinity();
+
+                    for (s32 a = 0; a < 3; a++)
+                    {
+                        f64 lower = static_cast<f64>(p.v[a]) - static_cast<f64>(c[a] - r) * cellsize;
+                        f64 upper = static_cast<f64>(c[a] + r + 1) * cellsize - static_cast<f64>(p.v[a]);
+
+                        inside = std::min(inside, std::max(std::min(lower, upper), 0.0));
+                    }
+
+                    bool covered = c[0] - r <= cellmin[0] && c[0] + r >= cellmax[0] && c[1] - r <= cellmin[1] && c[1] + r >= cellmax[1] &&
+                                   c[2] - r <= cellmin[2] && c[2] + r >= cellmax[2];
+
+                    if (covered || inside * inside >= limit || (found == k && distancesq[k - 1] <= inside * inside))
+                        break;
+                }
+
+                return found;
+            }
+
+            // Calls visit(a, b, distancesq, thread) once for every pair of points within radius of each
+            // other. Threads split the points, so visit runs concurrently when threads is not 1.
+            template<typename F>
+            void pairswithin(f32 radius, F&& visit, u32 threads = 0) const
+            {
+                if (empty())
+                    return;
+
+                f32 r2 = radius * radius;
+
+                parallelfor(0, points, 1024, [&](size_t begin, size_t end, u32 thread)
+                {
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        vec3<f32> p(x[i], y[i], z[i]);
+                        s32 lo[3], hi[3];
+                        cellrange(p, radius, lo, hi);
+
+                        for (s32 cz = lo[2]; cz <= hi[2]; cz++)
+                        {
+                            for (s32 cy = lo[1]; cy <= hi[1]; cy++)
+                            {
+                                for (s32 cx = lo[0]; cx <= hi[0]; cx++)
+                                {
+                                    // Each pair is reported from the point that comes first in bucket order
+                                    scan(p, r2, cx, cy, cz, static_cast<u32>(i) + 1, [&](u32 slot, f32 d)
+                                    {
+                                        visit(indices[i], indices[slot], d, thread);
+                                    });
+                                }
+                            }
+                        }
+                    }
+                }, threads);
+            }
+
+        private:
+            static inline u32 hash(s32 cx, s32 cy, s32 cz) noexcept
+            {
+                return (static_cast<u32>(cx) * 73856093u) ^ (static_cast<u32>(cy) * 19349663u) ^ (static_cast<u32>(cz) * 83492791u);
+            }
+
+            inline u32 bucket(s32 cx, s32 cy, s32 cz) const noexcept
+            {
+                return hash(cx, cy, cz) & static_cast<u32>(tablesize - 1);
+            }
+
+            // Cell of p, clamped to 2^40 cells so far queries cannot overflow the ring arithmetic
+            inline void cellof(const vec3<f32>& p, s64 (&c)[3]) const noexcept
+            {
+                const f32 bound = 1099511627776.0f;
+
+                for (s32 a = 0; a < 3; a++)
+                {
+                    c[a] = static_cast<s64>(std::max(-bound, std::min(bound, std::floor(p.v[a] * inverse))));
+                }
+            }
+
+            // Cells touched by the sphere around p, clamped to the occupied cells
+            inline void cellrange(const vec3<f32>& p, f32 radius, s32 (&lo)[3], s32 (&hi)[3]) const noexcept
+            {
+                for (s32 a = 0; a < 3; a++)
+                {
+                    f32 l = std::floor((p.v[a] - radius) * inverse);
+                    f32 h = std::floor((p.v[a] + radius) * inverse);
+
+                    lo[a] = l > static_cast<f32>(cellmin[a]) ? static_cast<s32>(l) : cellmin[a];
+                    hi[a] = h < static_cast<f32>(cellmax[a]) ? static_cast<s32>(h) : cellmax[a];
+                }
+            }
+
+            // Calls f(slot, distancesq) for the points of one cell at slot first or later that lie within
+            // r2 of p. Other cells of the same bucket fail the cell test, so do the padding lanes.
+            template<typename F>
+            inline void scan(const vec3<f32>& p, f32 r2, s32 cx, s32 cy, s32 cz, u32 first, F&& f) const
+            {
+                u32 h = bucket(cx, cy, cz);
+                u32 begin = std::max(starts[h], first), end = starts[h + 1];
+
+                if (begin >= end)
+                    return;
+
+                __m256 px = _mm256_set1_ps(p.x), py = _mm256_set1_ps(p.y), pz = _mm256_set1_ps(p.z);
+                __m256 fx = _mm256_set1_ps(static_cast<f32>(cx)), fy = _mm256_set1_ps(static_cast<f32>(cy)), fz = _mm256_set1_ps(static_cast<f32>(cz));
+                __m256 scale = _mm256_set1_ps(inverse);
+                __m256 limit = _mm256_set1_ps(r2);
+
+                for (u32 i = begin; i < end; i += 8)
+                {
+                    __m256 qx = _mm256_loadu_ps(&x[i]), qy = _mm256_loadu_ps(&y[i]), qz = _mm256_loadu_ps(&z[i]);
+                    __m256 dx = _mm256_sub_ps(qx, px), dy = _mm256_sub_ps(qy, py), dz = _mm256_sub_ps(qz, pz);
+                    __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+
+                    __m256 m = _mm256_cmp_ps(d, limit, _CMP_LE_OQ);
+                    m = _mm256_and_ps(m, _mm256_cmp_ps(_mm256_floor_ps(_mm256_mul_ps(qx, scale)), fx, _CMP_EQ_OQ));
+                    m = _mm256_and_ps(m, _mm256_cmp_ps(_mm256_floor_ps(_mm256_mul_ps(qy, scale)), fy, _CMP_EQ_OQ));
+                    m = _mm256_and_ps(m, _mm256_cmp_ps(_mm256_floor_ps(_mm256_mul_ps(qz, scale)), fz, _CMP_EQ_OQ));
+
+                    u32 mask = static_cast<u32>(_mm256_movemask_ps(m));
+
+                    if (mask == 0)
+                        continue;
+
+                    alignas(32) f32 distances[8];
+                    _mm256_store_ps(distances, d);
+
+                    for (; mask != 0; mask &= mask - 1)
+                    {
+                        u32 k = lowestbit(mask);
+
+                        f(i + k, distances[k]);
+                    }
+                }
+            }
+
+            // Data
+            f32 cellsize;
+            f32 inverse;
+            size_t tablesize = 0;
+            size_t points = 0;
+            s32 cellmin[4] = {};
+            s32 cellmax[4] = {};
+
+            std::vector<u32> starts;
+            std::vector<u32> buckets, tempbuckets;
+            std::vector<u32> indices, tempindices;
+            std::vector<f32> x, y, z;
+            std::vector<s32> partial;
+    };
+} // namespace sml
+
+#endif // sml_hashgrid_h__
@@ -0,0 +1,391 @@
+#ifndef sml_kdtree_h__
+#define sml_kdtree_h__
+
+/* kdtree.h -- implicit k-d tree of the 'Simple Math Library'
+  Copyright (C) 2020 Roderick Griffioen
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include <immintrin.h>
+
+#include "smltypes.h"
+#include "common.h"
+#include "vec3.h"
+#include "parallel.h"
+
+namespace sml
+{
+    // Implicit k-d tree over a point cloud. Every level splits the index range of a node in half at
+    // the median along the widest axis of the node, so the tree is balanced and node ranges follow
+    // from the level alone. Only the split planes are stored, in breadth first order, next to the
+    // points in SoA arrays. Leaves hold at most leafsize points and are scanned eight (f32) or four
+    // (f64) points at a time.
+    template<typename T>
+    class kdtree
+    {
+        static_assert(std::is_same<T, f32>::value || std::is_same<T, f64>::value, "kdtree stores f32 or f64 points");
+
+        public:
+            explicit kdtree(u32 leafsize = 16) noexcept : leafsize(leafsize > 0 ? leafsize : 1)
+            {
+            }
+
+            // Operations
+            void build(const vec3<T>* positions, size_t count, u32 threads = 0)
+            {
+                u32 chunks = threadcount(threads);
+
+                points = count;
+                levels = 0;
+
+                while (((count + (size_t(1) << levels) - 1) >> levels) > leafsize)
+                {
+                    levels++;
+                }
+
+                size_t inner = (size_t(1) << levels) - 1;
+                splits.resize(inner);
+                axes.resize(inner);
+
+                std::vector<entry> work(count);
+                std::vector<T> partial(static_cast<size_t>(chunks) * 6);
+
+                parallelfor(0, count, 65536, [&](size_t begin, size_t end, u32 chunk)
+                {
+                    T lo[3] = { std::numeric_limits<T>::max(), std::numeric_limits<T>::max(), std::numeric_limits<T>::max() };
+                    T hi[3] = { std::numeric_limits<T>::lowest(), std::numeric_limits<T>::lowest(), std::numeric_limits<T>::lowest() };
+
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        for (u32 a = 0; a < 3; a++)
+                        {
+                            T c = positions[i].v[a];
+
+                            work[i].p[a] = c;
+                            lo[a] = std::min(lo[a], c);
+                            hi[a] = std::max(hi[a], c);
+                        }
+
+                        work[i].index = static_cast<u32>(i);
+                    }
+
+                    std::copy(lo, lo + 3, &partial[chunk * 6]);
+                    std::copy(hi, hi + 3, &partial[chunk * 6 + 3]);
+                }, chunks);
+
+                T lo[3] = { std::numeric_limits<T>::max(), std::numeric_limits<T>::max(), std::numeric_limits<T>::max() };
+                T hi[3] = { std::numeric_limits<T>::lowest(), std::numeric_limits<T>::lowest(), std::numeric_limits<T>::lowest() };
+
+                for (size_t c = 0; c < chunks && c * 65536 < count; c++)
+                {
+                    for (u32 a = 0; a < 3; a++)
+                    {
+                        lo[a] = std::min(lo[a], partial[c * 6 + a]);
+                        hi[a] = std::max(hi[a], partial[c * 6 + 3 + a]);
+                    }
+                }
+
+                split(work.data(), 0, 0, count, 0, lo, hi, chunks);
+
+                x.resize(count + 8);
+                y.resize(count + 8);
+                z.resize(count + 8);
+                indices.resize(count);
+
+                parallelfor(0, count, 65536, [&](size_t begin, size_t end, u32)
+                {
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        x[i] = work[i].p[0];
+                        y[i] = work[i].p[1];
+                        z[i] = work[i].p[2];
+                        indices[i] = work[i].index;
+                    }
+                }, chunks);
+
+                // Padding keeps the wide loads of the last leaf inside the arrays, its lanes are masked off
+                for (size_t i = count; i < count + 8; i++)
+                {
+                    x[i] = y[i] = z[i] = std::numeric_limits<T>::infinity();
+                }
+            }
+
+            SML_NO_DISCARD inline bool empty() const noexcept
+            {
+                return points == 0;
+            }
+
+            SML_NO_DISCARD inline size_t size() const noexcept
+            {
+                return points;
+            }
+
+            // Bytes held by the points and split planes
+            SML_NO_DISCARD inline size_t memory() const noexcept
+            {
+                return (x.capacity() + y.capacity() + z.capacity() + splits.capacity()) * sizeof(T) + indices.capacity() * sizeof(u32) + axes.capacity();
+            }
+
+            // Calls visit(index, distancesq) for every point within radius of p
+            template<typename F>
+            void withinradius(const vec3<T>& p, T radius, F&& visit) const
+            {
+                if (empty())
+                    return;
+
+                T q[3] = { p.x, p.y, p.z };
+                T offsets[3] = {};
+                T r2 = radius * radius;
+
+                search(q, 0, 0, points, 0, offsets, 0, r2, [&](size_t begin, size_t end)
+                {
+                    scan(q, begin, end, r2, [&](size_t slot, T d) { visit(indices[slot], d); });
+                });
+            }
+
+            // The k points closest to p within maxdistance, nearest first. Returns the number of points found.
+            u32 nearest(const vec3<T>& p, u32 k, u32* result, T* distancesq, T maxdistance = std::numeric_limits<T>::infinity()) const
+            {
+                if (empty() || k == 0)
+                    return 0;
+
+                T q[3] = { p.x, p.y, p.z };
+                T offsets[3] = {};
+                T bound = maxdistance * maxdistance;
+                u32 found = 0;
+
+                auto add = [&](size_t slot, T d)
+                {
+                    if (d > bound)
+                        return;
+
+                    u32 at = found < k ? found++ : k - 1;
+
+                    for (; at > 0 && distancesq[at - 1] > d; at--)
+                    {
+                        result[at] = result[at - 1];
+                        distancesq[at] = distancesq[at - 1];
+                    }
+
+                    result[at] = indices[slot];
+                    distancesq[at] = d;
+
+                    if (found == k)
+                        bound = std::min(bound, distancesq[k - 1]);
+                };
+
+                search(q, 0, 0, points, 0, offsets, 0, bound, [&](size_t begin, size_t end) { scan(q, begin, end, bound, add); });
+
+                return found;
+            }
+
+            // Batched k nearest, the results of query i start at result[i * k] and distancesq[i * k] and
+            // found[i] receives their count. Queries are split across threads.
+            void nearest(const vec3<T>* queries, size_t count, u32 k, u32* result, T* distancesq, u32* found,
+                         T maxdistance = std::numeric_limits<T>::infinity(), u32 threads = 0) const
+            {
+                parallelfor(0, count, 256, [&](size_t begin, size_t end, u32)
+                {
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        found[i] = nearest(queries[i], k, result + i * k, distancesq + i * k, maxdistance);
+                    }
+                }, threads);
+            }
+
+            // Batched radius search, calls visit(query, index, distancesq, thread) and runs visit
+            // concurrently when threads is not 1
+            template<typename F>
+            void withinradius(const vec3<T>* queries, size_t count, T radius, F&& visit, u32 threads = 0) const
+            {
+                parallelfor(0, count, 256, [&](size_t begin, size_t end, u32 thread)
+                {
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        withinradius(queries[i], radius, [&](u32 index, T d) { visit(static_cast<u32>(i), index, d, thread); });
+                    }
+                }, threads);
+            }
+
+        private:
+            struct entry
+            {
+                T p[3];
+                u32 index;
+            };
+
+            // Partitions [begin, end) around its median along the widest axis of the node bounds and
+            // recurses, handing half of the threads to each side
+            void split(entry* work, size_t node, size_t begin, size_t end, u32 level, const T (&lo)[3], const T (&hi)[3], u32 threads)
+            {
+                if (level == levels)
+                    return;
+
+                u32 axis = 0;
+
+                for (u32 a = 1; a < 3; a++)
+                {
+                    if (hi[a] - lo[a] > hi[axis] - lo[axis])
+                        axis = a;
+                }
+
+                size_t mid = begin + (end - begin) / 2;
+
+                std::nth_element(work + begin, work + mid, work + end, [axis](const entry& a, const entry& b) { return a.p[axis] < b.p[axis]; });
+
+                T plane = work[mid].p[axis];
+                splits[node] = plane;
+                axes[node] = static_cast<u8>(axis);
+
+                T lefthi[3] = { hi[0], hi[1], hi[2] };
+                T rightlo[3] = { lo[0], lo[1], lo[2] };
+                lefthi[axis] = plane;
+                rightlo[axis] = plane;
+
+                u32 half = threads / 2;
+
+                parallelinvoke(threads > 1 && end - begin > 65536,
+                    [&]() { split(work, node * 2 + 1, begin, mid, level + 1, lo, lefthi, half); },
+                    [&]() { split(work, node * 2 + 2, mid, end, level + 1, rightlo, hi, threads - half); });
+            }
+
+            // Visits the leaves whose cells lie within bound of q, near side first. Offsets hold the
+            // distance from q to the cell of the node along each axis, so distance is the squared
+            // distance to the cell (Arya and Mount). Bound may shrink while leaves are visited.
+            template<typename F>
+            void search(const T* q, size_t node, size_t begin, size_t end, u32 level, T (&offsets)[3], T distance, const T& bound, F&& leaf) const
+            {
+                if (level == levels)
+                {
+                    leaf(begin, end);
+                    return;
+                }
+
+                size_t mid = begin + (end - begin) / 2;
+                u32 axis = axes[node];
+                T d = q[axis] - splits[node];
+
+                if (d < 0)
+                    search(q, node * 2 + 1, begin, mid, level + 1, offsets, distance, bound, leaf);
+                else
+                    search(q, node * 2 + 2, mid, end, level + 1, offsets, distance, bound, leaf);
+
+                T old = offsets[axis];
+                T far = distance - old * old + d * d;
+
+                if (far > bound)
+                    return;
+
+                offsets[axis] = d;
+
+                if (d < 0)
+                    search(q, node * 2 + 2, mid, end, level + 1, offsets, far, bound, leaf);
+                else
+                    search(q, node * 2 + 1, begin, mid, level + 1, offsets, far, bound, leaf);
+
+                offsets[axis] = old;
+            }
+
+            // Calls f(slot, distancesq) for the points of the leaf [begin, end) within bound of q
+            template<typename F>
+            inline void scan(const T* q, size_t begin, size_t end, T bound, F&& f) const
+            {
+                if constexpr (std::is_same<T, f32>::value)
+                {
+                    __m256 px = _mm256_set1_ps(q[0]), py = _mm256_set1_ps(q[1]), pz = _mm256_set1_ps(q[2]);
+                    __m256 limit = _mm256_set1_ps(bound);
+
+                    for (size_t i = begin; i < end; i += 8)
+                    {
+                        __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(&x[i]), px);
+                        __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(&y[i]), py);
+                        __m256 dz = _mm256_sub_ps(_mm256_loadu_ps(&z[i]), pz);
+                        __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+
+                        u32 mask = static_cast<u32>(_mm256_movemask_ps(_mm256_cmp_ps(d, limit, _CMP_LE_OQ)));
+
+                        if (end - i < 8)
+                            mask &= (1u << (end - i)) - 1;
+
+                        if (mask == 0)
+                            continue;
+
+                        alignas(32) f32 distances[8];
+                        _mm256_store_ps(distances, d);
+
+                        for (; mask != 0; mask &= mask - 1)
+                        {
+                            u32 k = lowestbit(mask);
+
+                            f(i + k, distances[k]);
+                        }
+                    }
+                }
+                else
+                {
+                    __m256d px = _mm256_set1_pd(q[0]), py = _mm256_set1_pd(q[1]), pz = _mm256_set1_pd(q[2]);
+                    __m256d limit = _mm256_set1_pd(bound);
+
+                    for (size_t i = begin; i < end; i += 4)
+                    {
+                        __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(&x[i]), px);
+                        __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(&y[i]), py);
+                        __m256d dz = _mm256_sub_pd(_mm256_loadu_pd(&z[i]), pz);
+                        __m256d d = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)), _mm256_mul_pd(dz, dz));
+
+                        u32 mask = static_cast<u32>(_mm256_movemask_pd(_mm256_cmp_pd(d, limit, _CMP_LE_OQ)));
+
+                        if (end - i < 4)
+                            mask &= (1u << (end - i)) - 1;
+
+                        if (mask == 0)
+                            continue;
+
+                        alignas(32) f64 distances[4];
+                        _mm256_store_pd(distances, d);
+
+                        for (; mask != 0; mask &= mask - 1)
+                        {
+                            u32 k = lowestbit(mask);
+
+                            f(i + k, distances[k]);
+                        }
+                    }
+                }
+            }
+
+            // Data
+            u32 leafsize;
+            u32 levels = 0;
+            size_t points = 0;
+
+            std::vector<T> splits;
+            std::vector<u8> axes;
+            std::vector<T> x, y, z;
+            std::vector<u32> indices;
+    };
+
+    typedef kdtree<f32> fkdtree;
+    typedef kdtree<f64> dkdtree;
+} // namespace sml
+
+#endif // sml_kdtree_h__
@@ -0,0 +1,706 @@
+#ifndef sml_mat_h__
+#define sml_mat_h__
+
+/* mat.h -- generic column major matrix implementation of the 'Simple Math Library'
+  Copyright (C) 2020 Roderick Griffioen
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <immintrin.h>
+
+#include "smltypes.h"
+#include "common.h"
+#include "simd.h"
+#include "vec3.h"
+#include "vec4.h"
+#include "mat2.h"
+#include "mat3.h"
+#include "mat4.h"
+
+namespace sml
+{
+    namespace detail
+    {
+        // Calls f(std::integral_constant<size_t, I>()) for every I in [0, N), expanded at compile time
+        template<typename F, size_t... I>
+        inline constexpr void unroll(F&& f, std::index_sequence<I...>) noexcept
+        {
+            (f(std::integral_constant<size_t, I>()), ...);
+        }
+
+        template<size_t N, typename F>
+        inline constexpr void unroll(F&& f) noexcept
+        {
+            unroll(std::forward<F>(f), std::make_index_sequence<N>());
+        }
+
+        // Columns of three or more rows are padded to whole registers of four lanes
+        template<size_t R>
+        struct matstride : std::integral_constant<size_t, R < 3 ? R : (R + 3) & ~static_cast<size_t>(3)>
+        {
+        };
+
+        // Columns that fill whole 256 bit registers are aligned for them
+        template<size_t R, typename T>
+        struct matalign : std::integral_constant<size_t, (matstride<R>::value * sizeof(T)) % 32 == 0 ? 32 : simdalign<T>::value>
+        {
+        };
+    } // namespace detail
+
+    // Column major R x C matrix for the sizes mat2, mat3 and mat4 do not cover, such as 3x4 affine
+    // transforms or the 6x6 and 8x8 systems of constraint solvers and filters. Columns of three or more
+    // rows are padded to a multiple of four elements that are kept at zero, so every column is a run of
+    // whole f32 or f64 registers. mat<3, 3, T> and mat<4, 4, T> share their layout with mat3 and mat4.
+    template<size_t R, size_t C, typename T>
+    class alignas(detail::matalign<R, T>::value) mat
+    {
+        static_assert(R > 0 && C > 0, "Matrices need at least one row and one column");
+
+        public:
+            static constexpr size_t rows = R;
+            static constexpr size_t columns = C;
+            static constexpr size_t stride = detail::matstride<R>::value;
+
+            // Ones on the main diagonal like the fixed size matrices, for non square matrices as well
+            constexpr mat() noexcept : mat(static_cast<T>(1))
+            {
+            }
+
+            constexpr explicit mat(T diagonal) noexcept : v()
+            {
+                for (size_t i = 0; i < (R < C ? R : C); i++)
+                {
+                    v[i * stride + i] = diagonal;
+                }
+            }
+
+            // R * C values, column after column
+            constexpr explicit mat(const T* values) noexcept : v()
+            {
+                for (size_t c = 0; c < C; c++)
+                {
+                    for (size_t r = 0; r < R; r++)
+                    {
+                        v[c * stride + r] = values[c * R + r];
+                    }
+                }
+            }
+
+            explicit mat(const mat2<T>& other) noexcept : v()
+            {
+                static_assert(R == 2 && C == 2, "Only a 2x2 matrix converts from mat2");
+
+                std::memcpy(v, other.v, sizeof(v));
+            }
+
+            explicit mat(const mat3<T>& other) noexcept : v()
+            {
+                static_assert(R == 3 && C == 3, "Only a 3x3 matrix converts from mat3");
+
+                for (size_t c = 0; c < 3; c++)
+                {
+                    v[c * 4 + 0] = other.v[c * 4 + 0];
+                    v[c * 4 + 1] = other.v[c * 4 + 1];
+                    v[c * 4 + 2] = other.v[c * 4 + 2];
+                }
+            }
+
+            explicit mat(const mat4<T>& other) noexcept : v()
+            {
+                static_assert(R == 4 && C == 4, "Only a 4x4 matrix converts from mat4");
+
+                std::memcpy(v, other.v, sizeof(v));
+            }
+
+            explicit mat(const vec3<T>& other) noexcept : v()
+            {
+                static_assert(R == 3 && C == 1, "Only a 3x1 matrix converts from vec3");
+
+                v[0] = other.x;
+                v[1] = other.y;
+                v[2] = other.z;
+            }
+
+            explicit mat(const vec4<T>& other) noexcept : v()
+            {
+                static_assert(R == 4 && C == 1, "Only a 4x1 matrix converts from vec4");
+
+                v[0] = other.x;
+                v[1] = other.y;
+                v[2] = other.z;
+                v[3] = other.w;
+            }
+
+            // Operators
+            inline constexpr T& operator () (size_t row, size_t column) noexcept
+            {
+                return v[column * stride + row];
+            }
+
+            inline constexpr const T& operator () (size_t row, size_t column) const noexcept
+            {
+                return v[column * stride + row];
+            }
+
+            inline constexpr bool operator == (const mat& other) const noexcept
+            {
+                for (size_t i = 0; i < C * stride; i++)
+                {
+                    if (v[i] != other.v[i])
+                        return false;
+                }
+
+                return true;
+            }
+
+            inline constexpr bool operator != (const mat& other) const noexcept
+            {
+                return !(*this == other);
+            }
+
+            // The padding is zero on both sides so whole columns can be combined
+            inline constexpr mat& operator += (const mat& other) noexcept
+            {
+                for (size_t i = 0; i < C * stride; i++)
+                {
+                    v[i] += other.v[i];
+                }
+
+                return *this;
+            }
+
+            inline constexpr mat& operator -= (const mat& other) noexcept
+            {
+                for (size_t i = 0; i < C * stride; i++)
+                {
+                    v[i] -= other.v[i];
+                }
+
+                return *this;
+            }
+
+            inline constexpr mat& operator *= (T scalar) noexcept
+            {
+                for (size_t i = 0; i < C * stride; i++)
+                {
+                    v[i] *= scalar;
+                }
+
+                return *this;
+            }
+
+            inline mat& operator *= (const mat<C, C, T>& other) noexcept;
+
+            // Operations
+            SML_NO_DISCARD inline constexpr T* column(size_t c) noexcept
+            {
+                return v + c * stride;
+            }
+
+            SML_NO_DISCARD inline constexpr const T* column(size_t c) const noexcept
+            {
+                return v + c * stride;
+            }
+
+            SML_NO_DISCARD inline mat2<T> tomat2() const noexcept
+            {
+                static_assert(R == 2 && C == 2, "Only a 2x2 matrix converts to mat2");
+
+                return mat2<T>(v[0], v[1], v[2], v[3]);
+            }
+
+            SML_NO_DISCARD inline mat3<T> tomat3() const noexcept
+            {
+                static_assert(R == 3 && C == 3, "Only a 3x3 matrix converts to mat3");
+
+                return mat3<T>(v[0], v[1], v[2], v[4], v[5], v[6], v[8], v[9], v[10]);
+            }
+
+            SML_NO_DISCARD inline mat4<T> tomat4() const noexcept
+            {
+                static_assert(R == 4 && C == 4, "Only a 4x4 matrix converts to mat4");
+
+                mat4<T> res;
+                std::memcpy(res.v, v, sizeof(v));
+
+                return res;
+            }
+
+            SML_NO_DISCARD inline vec3<T> tovec3() const noexcept
+            {
+                static_assert(R == 3 && C == 1, "Only a 3x1 matrix converts to vec3");
+
+                return vec3<T>(v[0], v[1], v[2]);
+            }
+
+            SML_NO_DISCARD inline vec4<T> tovec4() const noexcept
+            {
+                static_assert(R == 4 && C == 1, "Only a 4x1 matrix converts to vec4");
+
+                return vec4<T>(v[0], v[1], v[2], v[3]);
+            }
+
+            inline constexpr void identity() noexcept
+            {
+                *this = mat(static_cast<T>(1));
+            }
+
+            inline constexpr void transpose() noexcept
+            {
+                static_assert(R == C, "Only square matrices transpose in place");
+
+                for (size_t c = 0; c < C; c++)
+                {
+                    for (size_t r = c + 1; r < R; r++)
+                    {
+                        std::swap(v[c * stride + r], v[r * stride + c]);
+                    }
+                }
+            }
+
+            SML_NO_DISCARD inline constexpr mat<C, R, T> transposed() const noexcept
+            {
+                mat<C, R, T> res(static_cast<T>(0));
+
+                detail::unroll<C>([&](auto c)
+                {
+                    detail::unroll<R>([&](auto r)
+                    {
+                        res(c, r) = v[c * stride + r];
+                    });
+                });
+
+                return res;
+            }
+
+            inline constexpr void negate() noexcept
+            {
+                for (size_t i = 0; i < C * stride; i++)
+                {
+                    v[i] = -v[i];
+                }
+            }
+
+            SML_NO_DISCARD inline constexpr mat negated() const noexcept
+            {
+                mat copy(*this);
+                copy.negate();
+
+                return copy;
+            }
+
+            // Through the LU decomposition, zero for singular matrices
+            SML_NO_DISCARD inline T determinant() const noexcept;
+
+            // Singular matrices are left as they are, like mat3 and mat4
+            inline void invert() noexcept;
+
+            SML_NO_DISCARD inline mat inverted() const noexcept
+            {
+                mat copy(*this);
+                copy.invert();
+
+                return copy;
+            }
+
+            SML_NO_DISCARD inline std::string toString() const noexcept
+            {
+                std::string res;
+
+                for (size_t r = 0; r < R; r++)
+                {
+                    for (size_t c = 0; c < C; c++)
+                    {
+                        res += std::to_string(v[c * stride + r]) + (c + 1 < C ? ", " : "");
+                    }
+
+                    res += r + 1 < R ? "\n" : "";
+                }
+
+                return res;
+            }
+
+            // Statics
+            SML_NO_DISCARD static inline constexpr mat zero() noexcept
+            {
+                return mat(static_cast<T>(0));
+            }
+
+            // Data
+            T v[C * stride];
+    };
+
+    namespace detail
+    {
+        // res = a * b one result column at a time, every column is a sum of the columns of a scaled by
+        // the entries of b. Columns that fill registers are computed a register at a time.
+        template<size_t R, size_t K, size_t C, typename T>
+        inline void multiply(const mat<R, K, T>& a, const mat<K, C, T>& b, mat<R, C, T>& res) noexcept
+        {
+            constexpr size_t stride = mat<R, K, T>::stride;
+
+            if constexpr (std::is_same<T, f32>::value && stride % 8 == 0)
+            {
+                unroll<C>([&](auto c)
+                {
+                    unroll<stride / 8>([&](auto chunk)
+                    {
+                        __m256 sum = _mm256_setzero_ps();
+
+                        unroll<K>([&](auto k)
+                        {
+                            sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_load_ps(a.v + k * stride + chunk * 8), _mm256_set1_ps(b(k, c))));
+                        });
+
+                        _mm256_store_ps(res.v + c * stride + chunk * 8, sum);
+                    });
+                });
+            }
+            else if constexpr (std::is_same<T, f32>::value && stride % 4 == 0)
+            {
+                unroll<C>([&](auto c)
+                {
+                    unroll<stride / 4>([&](auto chunk)
+                    {
+                        __m128 sum = _mm_setzero_ps();
+
+                        unroll<K>([&](auto k)
+                        {
+                            sum = _mm_add_ps(sum, _mm_mul_ps(simd::load(a.v + k * stride + chunk * 4), _mm_set1_ps(b(k, c))));
+                        });
+
+                        simd::store(res.v + c * stride + chunk * 4, sum);
+                    });
+                });
+            }
+            else if constexpr (std::is_same<T, f64>::value && stride % 4 == 0)
+            {
+                unroll<C>([&](auto c)
+                {
+                    unroll<stride / 4>([&](auto chunk)
+                    {
+                        __m256d sum = _mm256_setzero_pd();
+
+                        unroll<K>([&](auto k)
+                        {
+                            sum = _mm256_add_pd(sum, _mm256_mul_pd(simd::load(a.v + k * stride + chunk * 4), _mm256_set1_pd(b(k, c))));
+                        });
+
+                        simd::store(res.v + c * stride + chunk * 4, sum);
+                    });
+                });
+            }
+            else
+            {
+                unroll<C>([&](auto c)
+                {
+                    unroll<R>([&](auto r)
+                    {
+                        T sum = static_cast<T>(0);
+
+                        unroll<K>([&](auto k)
+                        {
+                            sum += a(r, k) * b(k, c);
+                        });
+
+                        res(r, c) = sum;
+                    });
+                });
+            }
+        }
+    } // namespace detail
+
+    // Operators
+    template<size_t R, size_t K, size_t C, typename T>
+    inline mat<R, C, T> operator * (const mat<R, K, T>& left, const mat<K, C, T>& right) noexcept
+    {
+        mat<R, C, T> res(static_cast<T>(0));
+        detail::multiply(left, right, res);
+
+        return res;
+    }
+
+    template<size_t R, size_t C, typename T>
+    inline mat<R, C, T>& mat<R, C, T>::operator *= (const mat<C, C, T>& other) noexcept
+    {
+        mat<R, C, T> res(static_cast<T>(0));
+        detail::multiply(*this, other, res);
+
+        return *this = res;
+    }
+
+    template<size_t R, size_t C, typename T>
+    inline constexpr mat<R, C, T> operator + (mat<R, C, T> left, const mat<R, C, T>& right) noexcept
+    {
+        return left += right;
+    }
+
+    template<size_t R, size_t C, typename T>
+    inline constexpr mat<R, C, T> operator - (mat<R, C, T> left, const mat<R, C, T>& right) noexcept
+    {
+        return left -= right;
+    }
+
+    template<size_t R, size_t C, typename T>
+    inline constexpr mat<R, C, T> operator - (const mat<R, C, T>& value) noexcept
+    {
+        return value.negated();
+    }
+
+    template<size_t R, size_t C, typename T>
+    inline constexpr mat<R, C, T> operator * (mat<R, C, T> left, T right) noexcept
+    {
+        return left *= right;
+    }
+
+    template<size_t R, size_t C, typename T>
+    inline constexpr mat<R, C, T> operator * (T left, mat<R, C, T> right) noexcept
+    {
+        return right *= left;
+    }
+
+    // LU decomposition with partial pivoting in place, the strict lower triangle holds L (with a unit
+    // diagonal) and the rest U. Row k was swapped with row pivots[k] at step k. Returns false for a
+    // singular matrix.
+    template<size_t N, typename T>
+    inline bool ludecompose(mat<N, N, T>& a, u32 (&pivots)[N]) noexcept
+    {
+        for (size_t k = 0; k < N; k++)
+        {
+            size_t p = k;
+            for (size_t i = k + 1; i < N; i++)
+            {
+                if (sml::abs(a(i, k)) > sml::abs(a(p, k)))
+                    p = i;
+            }
+
+            pivots[k] = static_cast<u32>(p);
+
+            if (a(p, k) == static_cast<T>(0))
+                return false;
+
+            if (p != k)
+            {
+                for (size_t c = 0; c < N; c++)
+                {
+                    std::swap(a(k, c), a(p, c));
+                }
+            }
+
+            T inverse = static_cast<T>(1) / a(k, k);
+            for (size_t i = k + 1; i < N; i++)
+            {
+                a(i, k) *= inverse;
+            }
+
+            // Column major, so the trailing update runs down contiguous columns
+            for (size_t c = k + 1; c < N; c++)
+            {
+                T f = a(k, c);
+                T* column = a.column(c);
+                const T* l = a.column(k);
+
+                for (size_t i = k + 1; i < N; i++)
+                {
+                    column[i] -= l[i] * f;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // Solves a x = b for every column of b from the output of ludecompose
+    template<size_t N, size_t C, typename T>
+    SML_NO_DISCARD inline mat<N, C, T> lusolve(const mat<N, N, T>& lu, const u32 (&pivots)[N], mat<N, C, T> b) noexcept
+    {
+        for (size_t k = 0; k < N; k++)
+        {
+            if (pivots[k] != k)
+            {
+                for (size_t c = 0; c < C; c++)
+                {
+                    std::swap(b(k, c), b(pivots[k], c));
+                }
+            }
+        }
+
+        for (size_t c = 0; c < C; c++)
+        {
+            T* x = b.column(c);
+
+            for (size_t k = 0; k < N; k++)
+            {
+                const T* l = lu.column(k);
+
+                for (size_t i = k + 1; i < N; i++)
+                {
+                    x[i] -= l[i] * x[k];
+                }
+            }
+
+            for (size_t k = N; k-- > 0;)
+            {
+                const T* u = lu.column(k);
+
+                x[k] /= u[k];
+
+                for (size_t i = 0; i < k; i++)
+                {
+                    x[i] -= u[i] * x[k];
+                }
+            }
+        }
+
+        return b;
+    }
+
+    // Cholesky decomposition a = L L^T of a symmetric positive definite matrix in place, only the lower
+    // triangle is read and the upper one is cleared. Returns false when a is not positive definite.
+    template<size_t N, typename T>
+    inline bool choleskydecompose(mat<N, N, T>& a) noexcept
+    {
+        for (size_t j = 0; j < N; j++)
+        {
+            T d = a(j, j);
+            for (size_t k = 0; k < j; k++)
+            {
+                d -= a(j, k) * a(j, k);
+            }
+
+            if (!(d > static_cast<T>(0)))
+                return false;
+
+            T l = sml::sqrt(d);
+            T inverse = static_cast<T>(1) / l;
+            a(j, j) = l;
+
+            for (size_t i = j + 1; i < N; i++)
+            {
+                T s = a(i, j);
+                for (size_t k = 0; k < j; k++)
+                {
+                    s -= a(i, k) * a(j, k);
+                }
+
+                a(i, j) = s * inverse;
+                a(j, i) = static_cast<T>(0);
+            }
+        }
+
+        return true;
+    }
+
+    // Solves L L^T x = b for every column of b from the output of choleskydecompose
+    template<size_t N, size_t C, typename T>
+    SML_NO_DISCARD inline mat<N, C, T> choleskysolve(const mat<N, N, T>& l, mat<N, C, T> b) noexcept
+    {
+        for (size_t c = 0; c < C; c++)
+        {
+            T* x = b.column(c);
+
+            for (size_t k = 0; k < N; k++)
+            {
+                const T* column = l.column(k);
+
+                x[k] /= column[k];
+
+                for (size_t i = k + 1; i < N; i++)
+                {
+                    x[i] -= column[i] * x[k];
+                }
+            }
+
+            for (size_t k = N; k-- > 0;)
+            {
+                const T* column = l.column(k);
+
+                for (size_t i = k + 1; i < N; i++)
+                {
+                    x[k] -= column[i] * x[i];
+                }
+
+                x[k] /= column[k];
+            }
+        }
+
+        return b;
+    }
+
+    // Solves a x = b, returns false and leaves x alone when a is singular
+    template<size_t N, size_t C, typename T>
+    inline bool solve(const mat<N, N, T>& a, const mat<N, C, T>& b, mat<N, C, T>& x) noexcept
+    {
+        mat<N, N, T> lu = a;
+        u32 pivots[N];
+
+        if (!ludecompose(lu, pivots))
+            return false;
+
+        x = lusolve(lu, pivots, b);
+
+        return true;
+    }
+
+    template<size_t R, size_t C, typename T>
+    inline T mat<R, C, T>::determinant() const noexcept
+    {
+        static_assert(R == C, "Only square matrices have a determinant");
+
+        mat lu = *this;
+        u32 pivots[R];
+
+        if (!ludecompose(lu, pivots))
+            return static_cast<T>(0);
+
+        T res = static_cast<T>(1);
+        for (size_t k = 0; k < R; k++)
+        {
+            res *= pivots[k] != k ? -lu(k, k) : lu(k, k);
+        }
+
+        return res;
+    }
+
+    template<size_t R, size_t C, typename T>
+    inline void mat<R, C, T>::invert() noexcept
+    {
+        static_assert(R == C, "Only square matrices invert");
+
+        mat lu = *this;
+        u32 pivots[R];
+
+        if (ludecompose(lu, pivots))
+            *this = lusolve(lu, pivots, mat());
+    }
+
+    // Predefined types
+    typedef mat<3, 4, f32> fmat34;
+    typedef mat<4, 3, f32> fmat43;
+    typedef mat<6, 6, f32> fmat66;
+    typedef mat<8, 8, f32> fmat88;
+    typedef mat<3, 4, f64> dmat34;
+    typedef mat<4, 3, f64> dmat43;
+    typedef mat<6, 6, f64> dmat66;
+    typedef mat<8, 8, f64> dmat88;
+} // namespace sml
+
+#endif // sml_mat_h__
@@ -24,6 +24,7 @@
 
 #include "vec2.h"
 #include "smltypes.h"
+#include "simd.h"
 
 namespace sml
 {
@@ -109,8 +110,8 @@ namespace sml
                         __m128i i;
                     };
 
-                    __m128 me = _mm_load_ps(&m00);
-                    __m128 ot = _mm_load_ps(&other.m00);
+                    __m128 me = simd::load(&m00);
+                    __m128 ot = simd::load(&other.m00);
 
                     m128 cmp = { _mm_cmpeq_ps(me, ot) };
                     s32 result = _mm_movemask_epi8(cmp.i);
@@ -127,8 +128,8 @@ namespace sml
                     };
 
                     s32 result = 0xFFFF;
-                    __m256d me = _mm256_load_pd(&m00);
-                    __m256d ot = _mm256_load_pd(&other.m00);
+                    __m256d me = simd::load(&m00);
+                    __m256d ot = simd::load(&other.m00);
                     __m256d res = _mm256_cmp_pd(me, ot, _CMP_EQ_OQ);
 
                     __m128d high = _mm256_extractf128_pd(res, 1);
@@ -156,8 +157,8 @@ namespace sml
                         __m128i i;
                     };
 
-                    __m128 me = _mm_load_ps(&m00);
-                    __m128 ot = _mm_load_ps(&other.m00);
+                    __m128 me = simd::load(&m00);
+                    __m128 ot = simd::load(&other.m00);
 
                     m128 cmp = { _mm_cmpneq_ps(me, ot) };
                     s32 result = _mm_movemask_epi8(cmp.i);
@@ -174,8 +175,8 @@ namespace sml
                     };
 
                     s32 result = 0x0000;
-                    __m256d me = _mm256_load_pd(&m00);
-                    __m256d ot = _mm256_load_pd(&other.m00);
+                    __m256d me = simd::load(&m00);
+                    __m256d ot = simd::load(&other.m00);
                     __m256d res = _mm256_cmp_pd(me, ot, _CMP_NEQ_OQ);
 
                     __m128d high = _mm256_extractf128_pd(res, 1);
@@ -214,8 +215,8 @@ namespace sml
             {
                 if constexpr(std::is_same<T, f32>::value)
                 {
-                    __m128 lhs = _mm_load_ps(v);
-                    __m128 rhs = _mm_load_ps(other.v);
+                    __m128 lhs = simd::load(v);
+                    __m128 rhs = simd::load(other.v);
 
                     __m128 m0 = _mm_shuffle_ps(lhs, lhs, _MM_SHUFFLE(1, 0, 1, 0));
                     __m128 m1 = _mm_shuffle_ps(rhs, rhs, _MM_SHUFFLE(2, 2, 0, 0));
@@ -229,7 +230,7 @@ namespace sml
 
                     __m128 res = _mm_add_ps(res1, res2);
 
-                    _mm_store_ps(v, res);
+                    simd::store(v, res);
 
                     return *this;
                 }
@@ -238,8 +239,8 @@ namespace sml
                 {
                     alignas(simdalign<T>::value) f64 res[4];
 
-                    __m128d col0 = _mm_load_pd(&m00);
-                    __m128d col1 = _mm_load_pd(&m10);
+                    __m128d col0 = simd::load2(&m00);
+                    __m128d col1 = simd::load2(&m10);
 
                     for(s32 i = 0; i < 2; i++)
                     {
@@ -248,11 +249,11 @@ namespace sml
 
                         __m128d result = _mm_add_pd(_mm_mul_pd(elem0, col0), _mm_mul_pd(elem1, col1));
                         
-                        _mm_store_pd(res + (2 * i), result);
+                        simd::store2(res + (2 * i), result);
                     }
 
-                    _mm_store_pd(&m00 + 0, _mm_load_pd(res + 0));
-                    _mm_store_pd(&m00 + 2, _mm_load_pd(res + 2));
+                    simd::store2(&m00 + 0, simd::load2(res + 0));
+                    simd::store2(&m00 + 2, simd::load2(res + 2));
 
                     return *this;
                 }
@@ -307,7 +308,7 @@ namespace sml
 
                         __m128 res = _mm_mul_ps(me, det);
 
-                        _mm_store_ps(v, res);
+                        simd::store(v, res);
 
                         return;
                     }
@@ -322,8 +323,8 @@ namespace sml
                         __m128d res1 = _mm_mul_pd(me1, det);
                         __m128d res2 = _mm_mul_pd(me2, det);
 
-                        _mm_store_pd(&m00 + 2, res1);
-                        _mm_store_pd(&m00 + 0, res2);
+                        simd::store2(&m00 + 2, res1);
+                        simd::store2(&m00 + 0, res2);
 
                         return;
                     }
@@ -403,10 +404,10 @@ namespace sml
             __m128 x = _mm_broadcast_ss(&rhs.x);
             __m128 y = _mm_broadcast_ss(&rhs.y);
 
-            __m128 c0 = _mm_load_ps(&lhs.m00);
+            __m128 c0 = simd::load(&lhs.m00);
             __m128 c1 = _mm_shuffle_ps(c0, c0, _MM_SHUFFLE(0, 0, 3, 2));
 
-            _mm_store_ps(res.v, _mm_add_ps(_mm_mul_ps(x, c0), _mm_mul_ps(y, c1)));
+            simd::store(res.v, _mm_add_ps(_mm_mul_ps(x, c0), _mm_mul_ps(y, c1)));
 
             return res;
         }
@@ -416,10 +417,10 @@ namespace sml
             __m256d x = _mm256_set1_pd(rhs.x);
             __m256d y = _mm256_set1_pd(rhs.y);
 
-            __m256d c0 = _mm256_load_pd(&lhs.m00);
+            __m256d c0 = simd::load(&lhs.m00);
             __m256d c1 = _mm256_shuffle_pd(c0, c0, _MM_SHUFFLE(0, 0, 3, 2));
 
-            _mm256_store_pd(res.v, _mm256_add_pd(_mm256_mul_pd(x, c0), _mm256_mul_pd(y, c1)));
+            simd::store(res.v, _mm256_add_pd(_mm256_mul_pd(x, c0), _mm256_mul_pd(y, c1)));
 
             return res;
         }
@@ -18,12 +18,15 @@
   3. This notice may not be removed or altered from any source distribution.
 */
 
+#include <limits>
+#include <utility>
 #include <immintrin.h>
 #include <mmintrin.h>
 #include <smmintrin.h>
 
 #include "vec3.h"
 #include "smltypes.h"
+#include "simd.h"
 
 namespace sml
 {
@@ -201,8 +204,8 @@ namespace sml
                     s32 result = 0x0000;
                     for (s32 i = 0; i < 3; i++)
                     {
-                        __m128 me = _mm_load_ps(v + (4 * i));
-                        __m128 ot = _mm_load_ps(other.v + (4 * i));
+                        __m128 me = simd::load(v + (4 * i));
+                        __m128 ot = simd::load(other.v + (4 * i));
                         __m128 res = _mm_cmpneq_ps(me, ot);
 
                         m128 cmp = { res };
@@ -224,8 +227,8 @@ namespace sml
                     s32 result = 0x0000;
                     for (s32 i = 0; i < 3; i++)
                     {
-                        __m256d me = _mm256_load_pd(v + (4 * i));
-                        __m256d ot = _mm256_load_pd(other.v + (4 * i));
+                        __m256d me = simd::load(v + (4 * i));
+                        __m256d ot = simd::load(other.v + (4 * i));
                         __m256d res = _mm256_cmp_pd(me, ot, _CMP_NEQ_OQ);
 
                         __m128d high = _mm256_extractf128_pd(res, 0);
@@ -259,8 +262,8 @@ namespace sml
                     s32 result = 0xFFFF;
                     for (s32 i = 0; i < 3; i++)
                     {
-                        __m128 me = _mm_load_ps(v + (4 * i + 0));
-                        __m128 ot = _mm_load_ps(other.v + (4 * i + 0));
+                        __m128 me = simd::load(v + (4 * i + 0));
+                        __m128 ot = simd::load(other.v + (4 * i + 0));
 
                         m128 cmp = { _mm_cmpeq_ps(me, ot) };
 
@@ -281,8 +284,8 @@ namespace sml
                     s32 result = 0xFFFF;
                     for (s32 i = 0; i < 3; i++)
                     {
-                        __m256d me = _mm256_load_pd(v + (4 * i));
-                        __m256d ot = _mm256_load_pd(other.v + (4 * i));
+                        __m256d me = simd::load(v + (4 * i));
+                        __m256d ot = simd::load(other.v + (4 * i));
                         __m256d res = _mm256_cmp_pd(me, ot, _CMP_EQ_OQ);
 
                         __m128d high = _mm256_extractf128_pd(res, 1);
@@ -307,9 +310,9 @@ namespace sml
             {
                 if constexpr (std::is_same<T, f32>::value)
                 {
-                    __m128 col0 = _mm_load_ps(v + 0);
-                    __m128 col1 = _mm_load_ps(v + 4);
-                    __m128 col2 = _mm_load_ps(v + 8);
+                    __m128 col0 = simd::load(v + 0);
+                    __m128 col1 = simd::load(v + 4);
+                    __m128 col2 = simd::load(v + 8);
 
                     for (s32 i = 0; i < 3; i++)
                     {
@@ -318,7 +321,7 @@ namespace sml
                         __m128 elem2 = _mm_broadcast_ss(other.v + (4 * i + 2));
 
                         __m128 result = _mm_add_ps(_mm_add_ps(_mm_mul_ps(elem0, col0), _mm_mul_ps(elem1, col1)), _mm_mul_ps(elem2, col2));
-                        _mm_store_ps(v + 4 * i, result);
+                        simd::store(v + 4 * i, result);
                     }
 
                     return *this;
@@ -327,9 +330,9 @@ namespace sml
                 if constexpr (std::is_same<T, f64>::value)
                 {
                     alignas(simdalign<T>::value) f64 res[12];
-                    __m256d col0 = _mm256_load_pd(&m00);
-                    __m256d col1 = _mm256_load_pd(&m10);
-                    __m256d col2 = _mm256_load_pd(&m20);
+                    __m256d col0 = simd::load(&m00);
+                    __m256d col1 = simd::load(&m10);
+                    __m256d col2 = simd::load(&m20);
 
                     for (s32 i = 0; i < 3; i++)
                     {
@@ -339,12 +342,12 @@ namespace sml
 
                         __m256d result = _mm256_add_pd(_mm256_mul_pd(elem0, col0), _mm256_add_pd(_mm256_mul_pd(elem1, col1), _mm256_mul_pd(elem2, col2)));
 
-                        _mm256_store_pd(res + (4 * i), result);
+                        simd::store(res + (4 * i), result);
                     }
 
-                    _mm256_store_pd(&m00, _mm256_load_pd(res + 0));
-                    _mm256_store_pd(&m10, _mm256_load_pd(res + 4));
-                    _mm256_store_pd(&m20, _mm256_load_pd(res + 8));
+                    simd::store(&m00, simd::load(res + 0));
+                    simd::store(&m10, simd::load(res + 4));
+                    simd::store(&m20, simd::load(res + 8));
 
                     return *this;
                 }
@@ -449,9 +452,9 @@ namespace sml
                         res2 = _mm_mul_ps(res2, detinvregister);
                         res3 = _mm_mul_ps(res3, detinvregister);
 
-                        _mm_store_ps(v, res1);
-                        _mm_store_ps(v + 4, res2);
-                        _mm_store_ps(v + 8, res3);
+                        simd::store(v, res1);
+                        simd::store(v + 4, res2);
+                        simd::store(v + 8, res3);
 
                         return *this;
                     }*/
@@ -586,11 +589,11 @@ namespace sml
             __m128 y = _mm_broadcast_ss(&rhs.y);
             __m128 z = _mm_broadcast_ss(&rhs.z);
 
-            __m128 c0 = _mm_load_ps(&lhs.m00);
-            __m128 c1 = _mm_load_ps(&lhs.m10);
-            __m128 c2 = _mm_load_ps(&lhs.m20);
+            __m128 c0 = simd::load(&lhs.m00);
+            __m128 c1 = simd::load(&lhs.m10);
+            __m128 c2 = simd::load(&lhs.m20);
 
-            _mm_store_ps(res.v, _mm_add_ps(_mm_mul_ps(x, c0), _mm_add_ps(_mm_mul_ps(y, c1), _mm_mul_ps(z, c2))));
+            simd::store(res.v, _mm_add_ps(_mm_mul_ps(x, c0), _mm_add_ps(_mm_mul_ps(y, c1), _mm_mul_ps(z, c2))));
 
             return res;
         }
@@ -601,13 +604,13 @@ namespace sml
             __m256d y = _mm256_set1_pd(rhs.y);
             __m256d z = _mm256_set1_pd(rhs.z);
 
-            __m256d c0 = _mm256_load_pd(lhs.col0.v);
-            __m256d c1 = _mm256_load_pd(lhs.col1.v);
-            __m256d c2 = _mm256_load_pd(lhs.col2.v);
+            __m256d c0 = simd::load(lhs.col0.v);
+            __m256d c1 = simd::load(lhs.col1.v);
+            __m256d c2 = simd::load(lhs.col2.v);
 
             __m256d resu = _mm256_add_pd(_mm256_mul_pd(x, c0), _mm256_add_pd(_mm256_mul_pd(y, c1), _mm256_mul_pd(z, c2)));
 
-            _mm256_store_pd(res.v, resu);
+            simd::store(res.v, resu);
 
             return res;
         }
@@ -619,6 +622,78 @@ namespace sml
         return { x, y, z };
     }
 
+    // Eigen decomposition of a symmetric matrix by cyclic Jacobi rotations. The columns of vectors are
+    // the orthonormal eigenvectors, sorted by descending eigenvalue. Only the lower triangle is read.
+    template<typename T>
+    inline void eigensymmetric(const mat3<T>& m, mat3<T>& vectors, vec3<T>& values, s32 sweeps = 16) noexcept
+    {
+        T a[3][3] = { { m.m00, m.m01, m.m02 }, { m.m01, m.m11, m.m12 }, { m.m02, m.m12, m.m22 } };
+        T v[3][3] = { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+
+        const T epsilon = std::numeric_limits<T>::epsilon();
+
+        for (s32 sweep = 0; sweep < sweeps; sweep++)
+        {
+            T off = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+            T diagonal = a[0][0] * a[0][0] + a[1][1] * a[1][1] + a[2][2] * a[2][2];
+
+            if (off <= epsilon * epsilon * diagonal)
+                break;
+
+            for (s32 p = 0; p < 2; p++)
+            {
+                for (s32 q = p + 1; q < 3; q++)
+                {
+                    if (a[p][q] == static_cast<T>(0))
+                        continue;
+
+                    // Smaller of the two rotation angles that zero a[p][q]
+                    T theta = (a[q][q] - a[p][p]) / (static_cast<T>(2) * a[p][q]);
+                    T t = static_cast<T>(1) / (sml::abs(theta) + sml::sqrt(theta * theta + static_cast<T>(1)));
+                    t = theta < static_cast<T>(0) ? -t : t;
+
+                    T c = static_cast<T>(1) / sml::sqrt(t * t + static_cast<T>(1));
+                    T s = t * c;
+
+                    for (s32 k = 0; k < 3; k++)
+                    {
+                        T kp = a[k][p], kq = a[k][q];
+                        a[k][p] = c * kp - s * kq;
+                        a[k][q] = s * kp + c * kq;
+                    }
+
+                    for (s32 k = 0; k < 3; k++)
+                    {
+                        T pk = a[p][k], qk = a[q][k];
+                        a[p][k] = c * pk - s * qk;
+                        a[q][k] = s * pk + c * qk;
+                    }
+
+                    for (s32 k = 0; k < 3; k++)
+                    {
+                        T kp = v[k][p], kq = v[k][q];
+                        v[k][p] = c * kp - s * kq;
+                        v[k][q] = s * kp + c * kq;
+                    }
+                }
+            }
+        }
+
+        s32 order[3] = { 0, 1, 2 };
+
+        if (a[order[0]][order[0]] < a[order[1]][order[1]]) std::swap(order[0], order[1]);
+        if (a[order[1]][order[1]] < a[order[2]][order[2]]) std::swap(order[1], order[2]);
+        if (a[order[0]][order[0]] < a[order[1]][order[1]]) std::swap(order[0], order[1]);
+
+        for (s32 i = 0; i < 3; i++)
+        {
+            s32 j = order[i];
+
+            values.v[i] = a[j][j];
+            vectors.col[i] = vec3<T>(v[0][j], v[1][j], v[2][j]);
+        }
+    }
+
     // Predefined types
     typedef mat3<f32> fmat3;
     typedef mat3<f64> dmat3;
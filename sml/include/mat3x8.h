@@ -0,0 +1,214 @@
+#ifndef sml_mat3x8_h__
+#define sml_mat3x8_h__
+
+/* mat3x8.h -- eight 3x3 matrices in SoA layout of the 'Simple Math Library'
+  Copyright (C) 2020 Roderick Griffioen
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <immintrin.h>
+
+#include "smltypes.h"
+#include "simd.h"
+#include "vec3.h"
+#include "mat3.h"
+#include "vec3x8.h"
+
+namespace sml
+{
+    // Eight f32 3x3 matrices in SoA layout, column c of all eight matrices is col[c]
+    class alignas(32) mat3x8
+    {
+        public:
+            mat3x8() noexcept
+            {
+                col[0] = vec3x8(_mm256_set1_ps(1.0f), _mm256_setzero_ps(), _mm256_setzero_ps());
+                col[1] = vec3x8(_mm256_setzero_ps(), _mm256_set1_ps(1.0f), _mm256_setzero_ps());
+                col[2] = vec3x8(_mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_set1_ps(1.0f));
+            }
+
+            mat3x8(const vec3x8& col0, const vec3x8& col1, const vec3x8& col2) noexcept
+            {
+                col[0] = col0;
+                col[1] = col1;
+                col[2] = col2;
+            }
+
+            explicit mat3x8(const mat3<f32>& m) noexcept
+            {
+                col[0] = vec3x8(m.col0);
+                col[1] = vec3x8(m.col1);
+                col[2] = vec3x8(m.col2);
+            }
+
+            // Eight consecutive matrices
+            explicit mat3x8(const mat3<f32>* p) noexcept
+            {
+                for (s32 c = 0; c < 3; c++)
+                {
+                    col[c] = vec3x8(&p->col[c], strides);
+                }
+            }
+
+            // Gathers p[indices[0]] .. p[indices[7]]
+            mat3x8(const mat3<f32>* p, const u32* indices) noexcept
+            {
+                for (s32 c = 0; c < 3; c++)
+                {
+                    col[c] = vec3x8(&p->col[c], columns(indices).v);
+                }
+            }
+
+            // Operators
+            mat3x8& operator += (const mat3x8& other) noexcept
+            {
+                for (s32 c = 0; c < 3; c++)
+                {
+                    col[c] += other.col[c];
+                }
+
+                return *this;
+            }
+
+            mat3x8& operator -= (const mat3x8& other) noexcept
+            {
+                for (s32 c = 0; c < 3; c++)
+                {
+                    col[c] -= other.col[c];
+                }
+
+                return *this;
+            }
+
+            mat3x8& operator *= (__m256 s) noexcept
+            {
+                for (s32 c = 0; c < 3; c++)
+                {
+                    col[c] *= s;
+                }
+
+                return *this;
+            }
+
+            // Operations
+            SML_NO_DISCARD inline mat3<f32> lane(s32 i) const noexcept
+            {
+                mat3<f32> m;
+                m.col0 = col[0].lane(i);
+                m.col1 = col[1].lane(i);
+                m.col2 = col[2].lane(i);
+
+                return m;
+            }
+
+            // Writes the eight matrices to p[0] .. p[7]
+            inline void store(mat3<f32>* p) const noexcept
+            {
+                for (s32 c = 0; c < 3; c++)
+                {
+                    col[c].store(&p->col[c], strides);
+                }
+            }
+
+            // Scatters the eight matrices to p[indices[0]] .. p[indices[7]]
+            inline void store(mat3<f32>* p, const u32* indices) const noexcept
+            {
+                for (s32 c = 0; c < 3; c++)
+                {
+                    col[c].store(&p->col[c], columns(indices).v);
+                }
+            }
+
+            inline mat3x8& transpose() noexcept
+            {
+                *this = transposed();
+
+                return *this;
+            }
+
+            SML_NO_DISCARD inline mat3x8 transposed() const noexcept
+            {
+                return mat3x8(vec3x8(col[0].x, col[1].x, col[2].x),
+                              vec3x8(col[0].y, col[1].y, col[2].y),
+                              vec3x8(col[0].z, col[1].z, col[2].z));
+            }
+
+            SML_NO_DISCARD inline __m256 determinant() const noexcept
+            {
+                return vec3x8::dot(col[0], vec3x8::cross(col[1], col[2]));
+            }
+
+            // Statics
+            // Lanes of b where mask is set, of a elsewhere
+            SML_NO_DISCARD static inline mat3x8 select(__m256 mask, const mat3x8& a, const mat3x8& b) noexcept
+            {
+                return mat3x8(vec3x8::select(mask, a.col[0], b.col[0]), vec3x8::select(mask, a.col[1], b.col[1]), vec3x8::select(mask, a.col[2], b.col[2]));
+            }
+
+            // Data
+            vec3x8 col[3];
+
+        private:
+            struct indexset
+            {
+                u32 v[8];
+            };
+
+            // Matrix i starts at vector 3 i of the array
+            static inline indexset columns(const u32* indices) noexcept
+            {
+                indexset set;
+                for (s32 i = 0; i < 8; i++)
+                {
+                    set.v[i] = indices[i] * 3;
+                }
+
+                return set;
+            }
+
+            static constexpr u32 strides[8] = { 0, 3, 6, 9, 12, 15, 18, 21 };
+
+            static_assert(sizeof(mat3<f32>) == 3 * sizeof(vec3<f32>), "mat3x8 addresses matrices as runs of three vec3");
+    };
+
+    // Operators
+    inline mat3x8 operator + (mat3x8 left, const mat3x8& right) noexcept
+    {
+        return left += right;
+    }
+
+    inline mat3x8 operator - (mat3x8 left, const mat3x8& right) noexcept
+    {
+        return left -= right;
+    }
+
+    inline mat3x8 operator * (mat3x8 left, __m256 right) noexcept
+    {
+        return left *= right;
+    }
+
+    inline vec3x8 operator * (const mat3x8& m, const vec3x8& v) noexcept
+    {
+        return m.col[0] * v.x + m.col[1] * v.y + m.col[2] * v.z;
+    }
+
+    inline mat3x8 operator * (const mat3x8& left, const mat3x8& right) noexcept
+    {
+        return mat3x8(left * right.col[0], left * right.col[1], left * right.col[2]);
+    }
+} // namespace sml
+
+#endif // sml_mat3x8_h__
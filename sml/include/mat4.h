@@ -23,6 +23,7 @@
 #include "vec3.h"
 #include "vec4.h"
 #include "smltypes.h"
+#include "simd.h"
 #include "common.h"
 
 namespace sml
@@ -248,8 +249,8 @@ namespace sml
                     s32 result = 0x0000;
                     for (s32 i = 0; i < 4; i++)
                     {
-                        __m128 me = _mm_load_ps(v + (4 * i));
-                        __m128 ot = _mm_load_ps(other.v + (4 * i));
+                        __m128 me = simd::load(v + (4 * i));
+                        __m128 ot = simd::load(other.v + (4 * i));
                         __m128 res = _mm_cmp_ps(me, ot, _CMP_NEQ_OQ);
 
                         m128 cmp = { res };
@@ -270,8 +271,8 @@ namespace sml
                     s32 result = 0x0000;
                     for (s32 i = 0; i < 4; i++)
                     {
-                        __m256d me = _mm256_load_pd(v + (4 * i));
-                        __m256d ot = _mm256_load_pd(other.v + (4 * i));
+                        __m256d me = simd::load(v + (4 * i));
+                        __m256d ot = simd::load(other.v + (4 * i));
                         __m256d res = _mm256_cmp_pd(me, ot, _CMP_NEQ_OQ);
 
                         __m128d high = _mm256_extractf128_pd(res, 1);
@@ -306,8 +307,8 @@ namespace sml
                     s32 result = 0xFFFF;
                     for (s32 i = 0; i < 4; i++)
                     {
-                        __m128 me = _mm_load_ps(v + (4 * i + 0));
-                        __m128 ot = _mm_load_ps(other.v + (4 * i + 0));
+                        __m128 me = simd::load(v + (4 * i + 0));
+                        __m128 ot = simd::load(other.v + (4 * i + 0));
 
                         m128 cmp = { _mm_cmpeq_ps(me, ot) };
                         result &= _mm_movemask_epi8(cmp.i);
@@ -327,8 +328,8 @@ namespace sml
                     s32 result = 0xFFFF;
                     for (s32 i = 0; i < 4; i++)
                     {
-                        __m256d me = _mm256_load_pd(v + (4 * i));
-                        __m256d ot = _mm256_load_pd(other.v + (4 * i));
+                        __m256d me = simd::load(v + (4 * i));
+                        __m256d ot = simd::load(other.v + (4 * i));
                         __m256d res = _mm256_cmp_pd(me, ot, _CMP_EQ_OQ);
 
                         __m128d high = _mm256_extractf128_pd(res, 1);
@@ -354,10 +355,10 @@ namespace sml
             {
                 if constexpr (std::is_same<T, f32>::value)
                 {
-                    __m128 col0 = _mm_load_ps(v + 0);
-                    __m128 col1 = _mm_load_ps(v + 4);
-                    __m128 col2 = _mm_load_ps(v + 8);
-                    __m128 col3 = _mm_load_ps(v + 12);
+                    __m128 col0 = simd::load(v + 0);
+                    __m128 col1 = simd::load(v + 4);
+                    __m128 col2 = simd::load(v + 8);
+                    __m128 col3 = simd::load(v + 12);
                     
                     for (s32 i = 0; i < 4; i++)
                     {
@@ -370,7 +371,7 @@ namespace sml
                             _mm_mul_ps(elem1, col1)),
                             _mm_add_ps(_mm_mul_ps(elem2, col2),
                                 _mm_mul_ps(elem3, col3)));
-                        _mm_store_ps(v + 4 * i, result);
+                        simd::store(v + 4 * i, result);
                     }
 
                     return *this;
@@ -379,10 +380,10 @@ namespace sml
                 if constexpr (std::is_same<T, f64>::value)
                 {
                     alignas(simdalign<T>::value) f64 res[16];
-                    __m256d col0 = _mm256_load_pd(&m00);
-                    __m256d col1 = _mm256_load_pd(&m10);
-                    __m256d col2 = _mm256_load_pd(&m20);
-                    __m256d col3 = _mm256_load_pd(&m30);
+                    __m256d col0 = simd::load(&m00);
+                    __m256d col1 = simd::load(&m10);
+                    __m256d col2 = simd::load(&m20);
+                    __m256d col3 = simd::load(&m30);
 
                     for (s32 i = 0; i < 4; i++)
                     {
@@ -393,13 +394,13 @@ namespace sml
 
                         __m256d result = _mm256_add_pd(_mm256_mul_pd(elem0, col0), _mm256_add_pd(_mm256_mul_pd(elem1, col1), _mm256_add_pd(_mm256_mul_pd(elem2, col2), _mm256_mul_pd(elem3, col3))));
 
-                        _mm256_store_pd(res + (4 * i), result);
+                        simd::store(res + (4 * i), result);
                     }
 
-                    _mm256_store_pd(&m00, _mm256_load_pd(res + 0));
-                    _mm256_store_pd(&m10, _mm256_load_pd(res + 4));
-                    _mm256_store_pd(&m20, _mm256_load_pd(res + 8));
-                    _mm256_store_pd(&m30, _mm256_load_pd(res + 12));
+                    simd::store(&m00, simd::load(res + 0));
+                    simd::store(&m10, simd::load(res + 4));
+                    simd::store(&m20, simd::load(res + 8));
+                    simd::store(&m30, simd::load(res + 12));
 
                     return *this;
                 }
@@ -413,10 +414,10 @@ namespace sml
             {
                 if constexpr (std::is_same<T, f32>::value)
                 {
-                    __m128 col0 = _mm_load_ps(v + 0);
-                    __m128 col1 = _mm_load_ps(v + 4);
-                    __m128 col2 = _mm_load_ps(v + 8);
-                    __m128 col3 = _mm_load_ps(v + 12);
+                    __m128 col0 = simd::load(v + 0);
+                    __m128 col1 = simd::load(v + 4);
+                    __m128 col2 = simd::load(v + 8);
+                    __m128 col3 = simd::load(v + 12);
 
                     __m128 multi = _mm_broadcast_ss(&other);
 
@@ -425,20 +426,20 @@ namespace sml
                     col2 = _mm_mul_ps(col2, multi);
                     col3 = _mm_mul_ps(col3, multi);
 
-                    _mm_store_ps(v + 0, col0);
-                    _mm_store_ps(v + 4, col1);
-                    _mm_store_ps(v + 8, col2);
-                    _mm_store_ps(v + 12, col3);
+                    simd::store(v + 0, col0);
+                    simd::store(v + 4, col1);
+                    simd::store(v + 8, col2);
+                    simd::store(v + 12, col3);
 
                     return *this;
                 }
 
                 if constexpr (std::is_same<T, f64>::value)
                 {
-                    __m256d col0 = _mm256_load_pd(v + 0);
-                    __m256d col1 = _mm256_load_pd(v + 4);
-                    __m256d col2 = _mm256_load_pd(v + 8);
-                    __m256d col3 = _mm256_load_pd(v + 12);
+                    __m256d col0 = simd::load(v + 0);
+                    __m256d col1 = simd::load(v + 4);
+                    __m256d col2 = simd::load(v + 8);
+                    __m256d col3 = simd::load(v + 12);
 
                     __m256d multi = _mm256_set1_pd(other);
 
@@ -447,10 +448,10 @@ namespace sml
                     col2 = _mm256_mul_pd(col2, multi);
                     col3 = _mm256_mul_pd(col3, multi);
 
-                    _mm256_store_pd(v + 0, col0);
-                    _mm256_store_pd(v + 4, col1);
-                    _mm256_store_pd(v + 8, col2);
-                    _mm256_store_pd(v + 12, col3);
+                    simd::store(v + 0, col0);
+                    simd::store(v + 4, col1);
+                    simd::store(v + 8, col2);
+                    simd::store(v + 12, col3);
 
                     return *this;
                 }
@@ -674,13 +675,15 @@ namespace sml
             {
                 mat4 res(static_cast<T>(1));
                 
-                T width = static_cast<T>(1) - sml::tan(fov / static_cast<T>(2)), height = aspect / sml::tan(fov / static_cast<T>(2));
+                T height = static_cast<T>(1) / sml::tan(fov / static_cast<T>(2)), width = height / aspect;
 
+                // Right handed, depth maps to [0, 1]
                 res.m00 = width;
                 res.m11 = height;
-                res.m22 - zFar / (zNear - zFar);
+                res.m22 = zFar / (zNear - zFar);
                 res.m32 = zFar * zNear / (zNear - zFar);
                 res.m23 = static_cast<T>(-1);
+                res.m33 = static_cast<T>(0);
 
                 return res;
             }
@@ -691,7 +694,7 @@ namespace sml
 
                 res.m00 = static_cast<T>(2) / width;
                 res.m11 = static_cast<T>(2) / height;
-                res.m22 = static_cast<T>(2) / (zNear - zFar);
+                res.m22 = static_cast<T>(1) / (zNear - zFar);
                 res.m32 = zNear / (zNear - zFar);
 
                 return res;
@@ -873,12 +876,12 @@ namespace sml
             __m128 z = _mm_broadcast_ss(&rhs.z);
             __m128 w = _mm_broadcast_ss(&rhs.w);
 
-            __m128 c0 = _mm_load_ps(&lhs.m00);
-            __m128 c1 = _mm_load_ps(&lhs.m10);
-            __m128 c2 = _mm_load_ps(&lhs.m20);
-            __m128 c3 = _mm_load_ps(&lhs.m30);
+            __m128 c0 = simd::load(&lhs.m00);
+            __m128 c1 = simd::load(&lhs.m10);
+            __m128 c2 = simd::load(&lhs.m20);
+            __m128 c3 = simd::load(&lhs.m30);
 
-            _mm_store_ps(res.v, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, c0), _mm_mul_ps(y, c1)), _mm_add_ps(_mm_mul_ps(z, c2), _mm_mul_ps(w, c3))));
+            simd::store(res.v, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, c0), _mm_mul_ps(y, c1)), _mm_add_ps(_mm_mul_ps(z, c2), _mm_mul_ps(w, c3))));
 
             return res;
         }
@@ -890,12 +893,12 @@ namespace sml
             __m256d z = _mm256_set1_pd(rhs.z);
             __m256d w = _mm256_set1_pd(rhs.w);
 
-            __m256d c0 = _mm256_load_pd(&lhs.m00);
-            __m256d c1 = _mm256_load_pd(&lhs.m10);
-            __m256d c2 = _mm256_load_pd(&lhs.m20);
-            __m256d c3 = _mm256_load_pd(&lhs.m30);
+            __m256d c0 = simd::load(&lhs.m00);
+            __m256d c1 = simd::load(&lhs.m10);
+            __m256d c2 = simd::load(&lhs.m20);
+            __m256d c3 = simd::load(&lhs.m30);
 
-            _mm256_store_pd(res.v, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(x, c0), _mm256_mul_pd(y, c1)), _mm256_add_pd(_mm256_mul_pd(z, c2), _mm256_mul_pd(w, c3))));
+            simd::store(res.v, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(x, c0), _mm256_mul_pd(y, c1)), _mm256_add_pd(_mm256_mul_pd(z, c2), _mm256_mul_pd(w, c3))));
 
             return res;
         }
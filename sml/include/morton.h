@@ -0,0 +1,283 @@
+#ifndef sml_morton_h__
+#define sml_morton_h__
+
+/* morton.h -- morton codes and radix sort of the 'Simple Math Library'
+  Copyright (C) 2020 Roderick Griffioen
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include <immintrin.h>
+
+#include "smltypes.h"
+#include "common.h"
+#include "simd.h"
+#include "vec3.h"
+#include "aabb.h"
+#include "parallel.h"
+
+namespace sml
+{
+    // 30 bit codes interleave 10 bits per axis and 63 bit codes 21 bits per axis, x in the lowest bit.
+    // Interleaving uses BMI2 pdep/pext when the compiler targets it (-mbmi2) and shift and mask
+    // sequences otherwise. Note that pdep is microcoded and slow on AMD before Zen 3.
+    SML_NO_DISCARD inline u32 mortonspread10(u32 x) noexcept
+    {
+#ifdef __BMI2__
+        return _pdep_u32(x, 0x09249249u);
+#else
+        x &= 0x000003FFu;
+        x = (x | (x << 16)) & 0x030000FFu;
+        x = (x | (x << 8)) & 0x0300F00Fu;
+        x = (x | (x << 4)) & 0x030C30C3u;
+        x = (x | (x << 2)) & 0x09249249u;
+
+        return x;
+#endif
+    }
+
+    SML_NO_DISCARD inline u32 mortoncompact10(u32 x) noexcept
+    {
+#ifdef __BMI2__
+        return _pext_u32(x, 0x09249249u);
+#else
+        x &= 0x09249249u;
+        x = (x | (x >> 2)) & 0x030C30C3u;
+        x = (x | (x >> 4)) & 0x0300F00Fu;
+        x = (x | (x >> 8)) & 0x030000FFu;
+        x = (x | (x >> 16)) & 0x000003FFu;
+
+        return x;
+#endif
+    }
+
+    SML_NO_DISCARD inline u64 mortonspread21(u64 x) noexcept
+    {
+#ifdef __BMI2__
+        return _pdep_u64(x, 0x1249249249249249ull);
+#else
+        x &= 0x00000000001FFFFFull;
+        x = (x | (x << 32)) & 0x001F00000000FFFFull;
+        x = (x | (x << 16)) & 0x001F0000FF0000FFull;
+        x = (x | (x << 8)) & 0x100F00F00F00F00Full;
+        x = (x | (x << 4)) & 0x10C30C30C30C30C3ull;
+        x = (x | (x << 2)) & 0x1249249249249249ull;
+
+        return x;
+#endif
+    }
+
+    SML_NO_DISCARD inline u64 mortoncompact21(u64 x) noexcept
+    {
+#ifdef __BMI2__
+        return _pext_u64(x, 0x1249249249249249ull);
+#else
+        x &= 0x1249249249249249ull;
+        x = (x | (x >> 2)) & 0x10C30C30C30C30C3ull;
+        x = (x | (x >> 4)) & 0x100F00F00F00F00Full;
+        x = (x | (x >> 8)) & 0x001F0000FF0000FFull;
+        x = (x | (x >> 16)) & 0x001F00000000FFFFull;
+        x = (x | (x >> 32)) & 0x00000000001FFFFFull;
+
+        return x;
+#endif
+    }
+
+    SML_NO_DISCARD inline u32 morton30(u32 x, u32 y, u32 z) noexcept
+    {
+        return mortonspread10(x) | (mortonspread10(y) << 1) | (mortonspread10(z) << 2);
+    }
+
+    SML_NO_DISCARD inline u64 morton63(u64 x, u64 y, u64 z) noexcept
+    {
+        return mortonspread21(x) | (mortonspread21(y) << 1) | (mortonspread21(z) << 2);
+    }
+
+    inline void mortondecode30(u32 code, u32& x, u32& y, u32& z) noexcept
+    {
+        x = mortoncompact10(code);
+        y = mortoncompact10(code >> 1);
+        z = mortoncompact10(code >> 2);
+    }
+
+    inline void mortondecode63(u64 code, u64& x, u64& y, u64& z) noexcept
+    {
+        x = mortoncompact21(code);
+        y = mortoncompact21(code >> 1);
+        z = mortoncompact21(code >> 2);
+    }
+
+    // Quantises p to a grid of cells cells per axis spanning bounds, points outside bounds are clamped
+    template<typename T>
+    inline void mortonquantize(const vec3<T>& p, const aabb<T>& bounds, u32 cells, u32& x, u32& y, u32& z) noexcept
+    {
+        vec3<T> extent = bounds.max - bounds.min;
+        T n = static_cast<T>(cells);
+        T top = static_cast<T>(cells - 1);
+
+        if constexpr (std::is_same<T, f32>::value)
+        {
+            // Degenerate axes get a zero scale, NaN coordinates are dropped by the clamp operand order
+            __m128 e = simd::load(extent.v);
+            __m128 scale = _mm_and_ps(_mm_div_ps(_mm_set1_ps(n), e), _mm_cmpgt_ps(e, _mm_setzero_ps()));
+            __m128 q = _mm_mul_ps(_mm_sub_ps(simd::load(p.v), simd::load(bounds.min.v)), scale);
+
+            q = _mm_min_ps(_mm_max_ps(q, _mm_setzero_ps()), _mm_set1_ps(top));
+
+            alignas(16) s32 cell[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(cell), _mm_cvttps_epi32(q));
+
+            x = static_cast<u32>(cell[0]);
+            y = static_cast<u32>(cell[1]);
+            z = static_cast<u32>(cell[2]);
+        }
+        else
+        {
+            auto axis = [&](s32 a)
+            {
+                T q = extent.v[a] > static_cast<T>(0) ? (p.v[a] - bounds.min.v[a]) * (n / extent.v[a]) : static_cast<T>(0);
+
+                return static_cast<u32>(q > static_cast<T>(0) ? (q < top ? q : top) : static_cast<T>(0));
+            };
+
+            x = axis(0);
+            y = axis(1);
+            z = axis(2);
+        }
+    }
+
+    template<typename T>
+    SML_NO_DISCARD inline u32 morton30(const vec3<T>& p, const aabb<T>& bounds) noexcept
+    {
+        u32 x, y, z;
+        mortonquantize(p, bounds, 1u << 10, x, y, z);
+
+        return morton30(x, y, z);
+    }
+
+    template<typename T>
+    SML_NO_DISCARD inline u64 morton63(const vec3<T>& p, const aabb<T>& bounds) noexcept
+    {
+        u32 x, y, z;
+        mortonquantize(p, bounds, 1u << 21, x, y, z);
+
+        return morton63(x, y, z);
+    }
+
+    // Stable least significant digit radix sort of keys, values are permuted along with their keys.
+    // Eleven bit digits, so 30 bit codes take three passes. Each pass histograms and scatters contiguous
+    // chunks in parallel, passes in which every key has the same digit are skipped.
+    // Scratch buffers of count elements are passed in by callers that sort every frame.
+    template<typename K>
+    inline void radixsort(K* keys, u32* values, size_t count, K* tempkeys, u32* tempvalues, u32 threads = 0)
+    {
+        static_assert(std::is_unsigned<K>::value, "radixsort sorts unsigned keys");
+
+        if (count < 2)
+            return;
+
+        const size_t grain = 65536;
+        const u32 bits = 11, digits = 1u << bits;
+        u32 chunks = threadcount(threads);
+
+        std::vector<size_t> histogram(static_cast<size_t>(chunks) * digits);
+
+        K* srckeys = keys;
+        u32* srcvalues = values;
+        K* dstkeys = tempkeys;
+        u32* dstvalues = tempvalues;
+
+        for (u32 shift = 0; shift < sizeof(K) * 8; shift += bits)
+        {
+            std::fill(histogram.begin(), histogram.end(), 0);
+
+            parallelfor(0, count, grain, [&](size_t begin, size_t end, u32 chunk)
+            {
+                size_t* h = histogram.data() + chunk * digits;
+
+                for (size_t i = begin; i < end; i++)
+                {
+                    h[(srckeys[i] >> shift) & (digits - 1)]++;
+                }
+            }, chunks);
+
+            // Exclusive prefix over (digit, chunk) so every chunk scatters to its own ranges
+            size_t offset = 0;
+            bool skip = false;
+
+            for (u32 digit = 0; digit < digits; digit++)
+            {
+                size_t total = 0;
+
+                for (u32 chunk = 0; chunk < chunks; chunk++)
+                {
+                    size_t& h = histogram[chunk * digits + digit];
+                    size_t n = h;
+
+                    h = offset;
+                    offset += n;
+                    total += n;
+                }
+
+                if (total == count)
+                    skip = true;
+            }
+
+            if (skip)
+                continue;
+
+            parallelfor(0, count, grain, [&](size_t begin, size_t end, u32 chunk)
+            {
+                size_t* h = histogram.data() + chunk * digits;
+
+                for (size_t i = begin; i < end; i++)
+                {
+                    size_t d = h[(srckeys[i] >> shift) & (digits - 1)]++;
+
+                    dstkeys[d] = srckeys[i];
+                    dstvalues[d] = srcvalues[i];
+                }
+            }, chunks);
+
+            std::swap(srckeys, dstkeys);
+            std::swap(srcvalues, dstvalues);
+        }
+
+        if (srckeys != keys)
+        {
+            std::memcpy(keys, srckeys, count * sizeof(K));
+            std::memcpy(values, srcvalues, count * sizeof(u32));
+        }
+    }
+
+    template<typename K>
+    inline void radixsort(K* keys, u32* values, size_t count, u32 threads = 0)
+    {
+        if (count < 2)
+            return;
+
+        std::vector<K> tempkeys(count);
+        std::vector<u32> tempvalues(count);
+
+        radixsort(keys, values, count, tempkeys.data(), tempvalues.data(), threads);
+    }
+} // namespace sml
+
+#endif // sml_morton_h__
@@ -0,0 +1,316 @@
+#ifndef sml_obb_h__
+#define sml_obb_h__
+
+/* obb.h -- oriented bounding box implementation of the 'Simple Math Library'
+  Copyright (C) 2020 Roderick Griffioen
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <immintrin.h>
+
+#include "smltypes.h"
+#include "common.h"
+#include "vec3.h"
+#include "mat3.h"
+#include "mat4.h"
+#include "quat.h"
+#include "aabb.h"
+#include "ray.h"
+
+namespace sml
+{
+    // Box with its own frame, the columns of axes are orthonormal and halfextents is measured along
+    // them. Default constructed boxes are a point at the origin.
+    template<typename T>
+    class alignas(simdalign<T>::value) obb
+    {
+        public:
+            constexpr obb() noexcept : center(static_cast<T>(0)), axes(), halfextents(static_cast<T>(0))
+            {
+            }
+
+            constexpr obb(const vec3<T>& center, const vec3<T>& halfextents, const mat3<T>& axes) noexcept
+                : center(center), axes(axes), halfextents(halfextents)
+            {
+            }
+
+            constexpr obb(const vec3<T>& center, const vec3<T>& halfextents, const quat<T>& rotation) noexcept
+                : center(center), axes(), halfextents(halfextents)
+            {
+                axes.col0 = rotation * vec3<T>(1, 0, 0);
+                axes.col1 = rotation * vec3<T>(0, 1, 0);
+                axes.col2 = rotation * vec3<T>(0, 0, 1);
+            }
+
+            constexpr explicit obb(const aabb<T>& box) noexcept : center(box.center()), axes(), halfextents(box.extents())
+            {
+            }
+
+            // Operations
+            SML_NO_DISCARD inline constexpr T volume() const noexcept
+            {
+                return static_cast<T>(8) * halfextents.x * halfextents.y * halfextents.z;
+            }
+
+            SML_NO_DISCARD inline constexpr quat<T> rotation() const noexcept
+            {
+                return quat<T>::frommatrix3(axes);
+            }
+
+            // Point in the frame of the box, centered on the box
+            SML_NO_DISCARD inline constexpr vec3<T> tolocal(const vec3<T>& point) const noexcept
+            {
+                vec3<T> d = point - center;
+
+                return vec3<T>(d.dot(axes.col0), d.dot(axes.col1), d.dot(axes.col2));
+            }
+
+            SML_NO_DISCARD inline constexpr vec3<T> toworld(const vec3<T>& local) const noexcept
+            {
+                return center + axes * local;
+            }
+
+            SML_NO_DISCARD inline constexpr bool contains(const vec3<T>& point) const noexcept
+            {
+                vec3<T> local = tolocal(point);
+
+                return sml::abs(local.x) <= halfextents.x && sml::abs(local.y) <= halfextents.y && sml::abs(local.z) <= halfextents.z;
+            }
+
+            SML_NO_DISCARD inline constexpr vec3<T> closestpoint(const vec3<T>& point) const noexcept
+            {
+                return toworld(vec3<T>::clamp(tolocal(point), -halfextents, halfextents));
+            }
+
+            // Separating axis test over the 3 + 3 face normals and the 9 edge cross products (Gottschalk).
+            // The epsilon on the absolute rotation keeps near parallel edges, whose cross products are
+            // close to zero, from reporting a separation that is only rounding noise.
+            SML_NO_DISCARD inline constexpr bool overlaps(const obb& other) const noexcept
+            {
+                const T epsilon = static_cast<T>(1e-6);
+
+                T r[3][3], absr[3][3];
+
+                for (s32 i = 0; i < 3; i++)
+                {
+                    for (s32 j = 0; j < 3; j++)
+                    {
+                        r[i][j] = axes.col[i].dot(other.axes.col[j]);
+                        absr[i][j] = sml::abs(r[i][j]) + epsilon;
+                    }
+                }
+
+                vec3<T> d = other.center - center;
+                T t[3] = { d.dot(axes.col0), d.dot(axes.col1), d.dot(axes.col2) };
+
+                const T* a = halfextents.v;
+                const T* b = other.halfextents.v;
+
+                for (s32 i = 0; i < 3; i++)
+                {
+                    if (sml::abs(t[i]) > a[i] + b[0] * absr[i][0] + b[1] * absr[i][1] + b[2] * absr[i][2])
+                        return false;
+                }
+
+                for (s32 j = 0; j < 3; j++)
+                {
+                    if (sml::abs(t[0] * r[0][j] + t[1] * r[1][j] + t[2] * r[2][j]) > a[0] * absr[0][j] + a[1] * absr[1][j] + a[2] * absr[2][j] + b[j])
+                        return false;
+                }
+
+                // Axis i of this box crossed with axis j of the other
+                for (s32 i = 0; i < 3; i++)
+                {
+                    s32 i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+
+                    for (s32 j = 0; j < 3; j++)
+                    {
+                        s32 j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+
+                        T ra = a[i1] * absr[i2][j] + a[i2] * absr[i1][j];
+                        T rb = b[j1] * absr[i][j2] + b[j2] * absr[i][j1];
+
+                        if (sml::abs(t[i2] * r[i1][j] - t[i1] * r[i2][j]) > ra + rb)
+                            return false;
+                    }
+                }
+
+                return true;
+            }
+
+            SML_NO_DISCARD inline bool intersects(const ray<T>& r) const noexcept
+            {
+                T entry, exit;
+
+                return intersects(r, static_cast<T>(0), std::numeric_limits<T>::infinity(), entry, exit);
+            }
+
+            // Slab test in the frame of the box, the rotation keeps lengths so the interval is the same
+            // as in world space
+            SML_NO_DISCARD inline bool intersects(const ray<T>& r, T tmin, T tmax, T& entry, T& exit) const noexcept
+            {
+                vec3<T> direction(r.direction.dot(axes.col0), r.direction.dot(axes.col1), r.direction.dot(axes.col2));
+                ray<T> local(tolocal(r.origin), direction);
+
+                return local.intersects(aabb<T>(-halfextents, halfextents), tmin, tmax, entry, exit);
+            }
+
+            SML_NO_DISCARD inline constexpr aabb<T> bounds() const noexcept
+            {
+                vec3<T> extents(
+                    sml::abs(axes.m00) * halfextents.x + sml::abs(axes.m10) * halfextents.y + sml::abs(axes.m20) * halfextents.z,
+                    sml::abs(axes.m01) * halfextents.x + sml::abs(axes.m11) * halfextents.y + sml::abs(axes.m21) * halfextents.z,
+                    sml::abs(axes.m02) * halfextents.x + sml::abs(axes.m12) * halfextents.y + sml::abs(axes.m22) * halfextents.z);
+
+                return aabb<T>(center - extents, center + extents);
+            }
+
+            // Box around the transformed box. Rotation, translation and scale along the box axes give
+            // the exact image, a scale that shears the box is absorbed by projecting the scaled edges
+            // onto the re-orthonormalized axes, which still encloses every transformed corner.
+            SML_NO_DISCARD inline constexpr obb transformed(const mat4<T>& transform) const noexcept
+            {
+                auto apply = [&](const vec3<T>& v, T w)
+                {
+                    return vec3<T>(transform.m00 * v.x + transform.m10 * v.y + transform.m20 * v.z + transform.m30 * w,
+                                   transform.m01 * v.x + transform.m11 * v.y + transform.m21 * v.z + transform.m31 * w,
+                                   transform.m02 * v.x + transform.m12 * v.y + transform.m22 * v.z + transform.m32 * w);
+                };
+
+                vec3<T> edges[3];
+                for (s32 i = 0; i < 3; i++)
+                {
+                    edges[i] = apply(axes.col[i] * halfextents.v[i], static_cast<T>(0));
+                }
+
+                obb res;
+                res.center = apply(center, static_cast<T>(1));
+
+                // Gram-Schmidt on the transformed unit axes, starting from the most stretched one. Using the
+                // unit axes rather than the edges keeps the frame of a flat box well defined.
+                vec3<T> u[3];
+                for (s32 i = 0; i < 3; i++)
+                {
+                    u[i] = apply(axes.col[i], static_cast<T>(0));
+                }
+
+                s32 order[3] = { 0, 1, 2 };
+                if (u[order[0]].lengthsquared() < u[order[1]].lengthsquared()) std::swap(order[0], order[1]);
+                if (u[order[1]].lengthsquared() < u[order[2]].lengthsquared()) std::swap(order[1], order[2]);
+                if (u[order[0]].lengthsquared() < u[order[1]].lengthsquared()) std::swap(order[0], order[1]);
+
+                vec3<T> a0 = normal(u[order[0]], axes.col[order[0]]);
+                vec3<T> a1 = normal(u[order[1]] - a0 * u[order[1]].dot(a0), perpendicular(a0));
+
+                vec3<T> a2 = vec3<T>::cross(a0, a1);
+                if ((order[1] - order[0] + 3) % 3 != 1)
+                    a2 = -a2;
+
+                res.axes.col[order[0]] = a0;
+                res.axes.col[order[1]] = a1;
+                res.axes.col[order[2]] = a2;
+
+                for (s32 i = 0; i < 3; i++)
+                {
+                    res.halfextents.v[i] = sml::abs(res.axes.col[i].dot(edges[0])) + sml::abs(res.axes.col[i].dot(edges[1])) + sml::abs(res.axes.col[i].dot(edges[2]));
+                }
+
+                return res;
+            }
+
+            // Statics
+            // Box around a point set from the principal axes of its covariance. The covariance weighs
+            // dense regions more, so for clustered input the axis aligned box may be the tighter one; the
+            // smaller of the two is returned. A point at the origin for count == 0.
+            SML_NO_DISCARD static inline obb fit(const vec3<T>* points, size_t count) noexcept
+            {
+                if (count == 0)
+                    return obb();
+
+                vec3<T> mean(static_cast<T>(0));
+                for (size_t i = 0; i < count; i++)
+                {
+                    mean += points[i];
+                }
+                mean *= static_cast<T>(1) / static_cast<T>(count);
+
+                T xx = 0, xy = 0, xz = 0, yy = 0, yz = 0, zz = 0;
+                for (size_t i = 0; i < count; i++)
+                {
+                    vec3<T> d = points[i] - mean;
+
+                    xx += d.x * d.x;
+                    xy += d.x * d.y;
+                    xz += d.x * d.z;
+                    yy += d.y * d.y;
+                    yz += d.y * d.z;
+                    zz += d.z * d.z;
+                }
+
+                mat3<T> axes;
+                vec3<T> variances;
+                eigensymmetric(mat3<T>(xx, xy, xz, xy, yy, yz, xz, yz, zz), axes, variances);
+
+                // Right handed so the axes are a rotation
+                axes.col2 = vec3<T>::cross(axes.col0, axes.col1);
+
+                vec3<T> lo(std::numeric_limits<T>::infinity());
+                vec3<T> hi(-std::numeric_limits<T>::infinity());
+
+                for (size_t i = 0; i < count; i++)
+                {
+                    vec3<T> d = points[i] - mean;
+                    vec3<T> local(d.dot(axes.col0), d.dot(axes.col1), d.dot(axes.col2));
+
+                    lo = vec3<T>::min(lo, local);
+                    hi = vec3<T>::max(hi, local);
+                }
+
+                obb res(mean + axes * ((lo + hi) * static_cast<T>(0.5)), (hi - lo) * static_cast<T>(0.5), axes);
+                obb aligned(sml::bounds(points, count));
+
+                return aligned.volume() < res.volume() ? aligned : res;
+            }
+
+            // Data
+            vec3<T> center;
+            mat3<T> axes;
+            vec3<T> halfextents;
+
+        private:
+            SML_NO_DISCARD static inline constexpr vec3<T> normal(const vec3<T>& v, const vec3<T>& fallback) noexcept
+            {
+                T length = v.length();
+
+                return length > std::numeric_limits<T>::min() ? v * (static_cast<T>(1) / length) : fallback;
+            }
+
+            SML_NO_DISCARD static inline constexpr vec3<T> perpendicular(const vec3<T>& v) noexcept
+            {
+                vec3<T> other = sml::abs(v.x) < static_cast<T>(0.57) ? vec3<T>(1, 0, 0) : vec3<T>(0, 1, 0);
+
+                return vec3<T>::normalize(vec3<T>::cross(v, other));
+            }
+    };
+
+    typedef obb<f32> fobb;
+    typedef obb<f64> dobb;
+} // namespace sml
+
+#endif // sml_obb_h__
@@ -0,0 +1,569 @@
+#ifndef sml_octree_h__
+#define sml_octree_h__
+
+/* octree.h -- sparse loose octree of the 'Simple Math Library'
+  Copyright (C) 2020 Roderick Griffioen
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "smltypes.h"
+#include "common.h"
+#include "vec3.h"
+#include "mat4.h"
+#include "aabb.h"
+#include "frustum.h"
+#include "parallel.h"
+#include "morton.h"
+
+namespace sml
+{
+    // Pixels covered per unit of size at unit distance for a mat4::perspective projection rendered at
+    // viewportheight pixels, an object of size s at distance d covers about s * scale / d pixels
+    template<typename T>
+    SML_NO_DISCARD inline T projectionscale(const mat4<T>& projection, T viewportheight) noexcept
+    {
+        return projection.m11 * viewportheight * static_cast<T>(0.5);
+    }
+
+    // Sparse loose octree over a cubic world. An object lives in the deepest node whose cell is at
+    // least as large as the object, at the cell holding its center, so it always fits the node's
+    // loose bounds of twice the cell size and inserting it needs no descent decisions. Objects with
+    // their center outside the world live in the root, which is never culled. Nodes are keyed by
+    // locational codes, a leading one bit above the Morton code of the cell, and come from a pool.
+    // Bulk builds lay nodes out in depth first Morton order, later inserts reuse freed nodes.
+    template<typename T>
+    class octree
+    {
+        static_assert(std::is_same<T, f32>::value || std::is_same<T, f64>::value, "octree stores f32 or f64 bounds");
+
+        public:
+            static constexpr u32 none = 0xffffffffu;
+
+            explicit octree(const aabb<T>& world, u32 maxdepth = 10) noexcept : origin(world.min), maxdepth(std::min(std::max(maxdepth, 1u), 20u))
+            {
+                vec3<T> s = world.size();
+
+                size = std::max(s.x, std::max(s.y, s.z));
+                clear();
+            }
+
+            // Operations
+            void clear()
+            {
+                nodes.clear();
+                objects.clear();
+                freenodes.clear();
+                freeobjects.clear();
+                live = 0;
+
+                nodes.push_back(makenode(1, none));
+            }
+
+            // Bulk construction from points, which become objects 0 to count - 1. Points are sorted by
+            // their Morton code in parallel and every node is created and linked in parallel from the
+            // sorted codes.
+            void build(const vec3<T>* points, size_t count, u32 threads = 0)
+            {
+                clear();
+
+                if (count == 0)
+                    return;
+
+                u32 chunks = threadcount(threads);
+                u32 cells = 1u << maxdepth;
+                u64 sentinel = u64(1) << (3 * maxdepth);
+                aabb<T> cube(origin, origin + vec3<T>(size));
+
+                std::vector<u64> keys(count);
+                std::vector<u32> order(count);
+                objects.resize(count);
+                live = count;
+
+                parallelfor(0, count, 65536, [&](size_t begin, size_t end, u32)
+                {
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        u32 x, y, z;
+                        mortonquantize(points[i], cube, cells, x, y, z);
+
+                        keys[i] = cube.contains(points[i]) ? sentinel | morton63(x, y, z) : 0;
+                        order[i] = static_cast<u32>(i);
+                        objects[i].box = aabb<T>(points[i]);
+                    }
+                }, chunks);
+
+                radixsort(keys.data(), order.data(), count, chunks);
+
+                // Outside points sort first with a zero key, every other point creates the nodes of its
+                // path below the deepest node it shares with the point before it
+                size_t first = static_cast<size_t>(std::partition_point(keys.begin(), keys.end(), [](u64 k) { return k == 0; }) - keys.begin());
+                std::vector<u32> created(count + 1, 0);
+
+                parallelfor(first, count, 65536, [&](size_t begin, size_t end, u32)
+                {
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        if (i == first)
+                            created[i] = maxdepth;
+                        else if (keys[i] != keys[i - 1])
+                            created[i] = highestbit(keys[i] ^ keys[i - 1]) / 3 + 1;
+                    }
+                }, chunks);
+
+                // Exclusive scan, created[i] becomes the first node of point i
+                u32 total = 1;
+
+                for (size_t i = first; i <= count; i++)
+                {
+                    u32 n = created[i];
+
+                    created[i] = total;
+                    total += n;
+                }
+
+                nodes.resize(total);
+
+                parallelfor(first, count, 65536, [&](size_t begin, size_t end, u32)
+                {
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        u32 n = created[i + 1] - created[i];
+
+                        for (u32 j = 0; j < n; j++)
+                        {
+                            u32 depth = maxdepth - n + 1 + j;
+
+                            nodes[created[i] + j] = makenode(keys[i] >> (3 * (maxdepth - depth)), none);
+                        }
+                    }
+                }, chunks);
+
+                // Nodes are in depth first order, a node follows its parent unless it starts a new branch.
+                // The parent of a branch precedes it by the size of its earlier subtrees, which is usually
+                // small, so its padded code is searched galloping backwards.
+                parallelfor(1, total, 65536, [&](size_t begin, size_t end, u32)
+                {
+                    for (size_t n = begin; n < end; n++)
+                    {
+                        u64 key = nodes[n].key;
+                        u64 parentkey = key >> 3;
+                        u32 parent = static_cast<u32>(n - 1);
+
+                        if (nodes[parent].key != parentkey)
+                        {
+                            size_t lo = 0, hi = n - 1;
+
+                            for (size_t step = 1; step < n; step *= 2)
+                            {
+                                if (before(nodes[n - 1 - step].key, parentkey))
+                                {
+                                    lo = n - step;
+                                    break;
+                                }
+
+                                hi = n - 1 - step;
+                            }
+
+                            parent = static_cast<u32>(std::lower_bound(nodes.begin() + lo, nodes.begin() + hi, parentkey, [this](const node& a, u64 k)
+                            {
+                                return before(a.key, k);
+                            }) - nodes.begin());
+                        }
+
+                        nodes[n].parent = parent;
+                        nodes[parent].children[key & 7] = static_cast<u32>(n);
+                    }
+                }, chunks);
+
+                // Objects of one cell are consecutive after the sort and are linked in that order
+                auto link = [&](size_t i, u32 owner)
+                {
+                    object& o = objects[order[i]];
+
+                    o.node = owner;
+                    o.prev = i > 0 && keys[i - 1] == keys[i] ? order[i - 1] : none;
+                    o.next = i + 1 < count && keys[i + 1] == keys[i] ? order[i + 1] : none;
+
+                    if (o.prev == none)
+                        nodes[owner].objects = order[i];
+                };
+
+                for (size_t i = 0; i < first; i++)
+                {
+                    link(i, 0);
+                }
+
+                parallelfor(first, count, 65536, [&](size_t begin, size_t end, u32)
+                {
+                    size_t head = begin;
+
+                    while (created[head + 1] == created[head])
+                    {
+                        head--;
+                    }
+
+                    u32 leaf = created[head + 1] - 1;
+
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        if (created[i + 1] != created[i])
+                            leaf = created[i + 1] - 1;
+
+                        link(i, leaf);
+                    }
+                }, chunks);
+            }
+
+            // Adds an object and returns its handle
+            u32 insert(const aabb<T>& box)
+            {
+                u32 handle;
+
+                if (!freeobjects.empty())
+                {
+                    handle = freeobjects.back();
+                    freeobjects.pop_back();
+                }
+                else
+                {
+                    handle = static_cast<u32>(objects.size());
+                    objects.emplace_back();
+                }
+
+                objects[handle].box = box;
+                place(handle, locate(box));
+                live++;
+
+                return handle;
+            }
+
+            void remove(u32 handle)
+            {
+                u32 owner = objects[handle].node;
+
+                unlink(handle);
+                prune(owner);
+
+                objects[handle].node = none;
+                freeobjects.push_back(handle);
+                live--;
+            }
+
+            // Moves an object to new bounds, it stays in its node when the node still fits it
+            void update(u32 handle, const aabb<T>& box)
+            {
+                u32 owner = objects[handle].node;
+                u64 key = locate(box);
+
+                objects[handle].box = box;
+
+                if (nodes[owner].key == key)
+                    return;
+
+                unlink(handle);
+                place(handle, key);
+                prune(owner);
+            }
+
+            SML_NO_DISCARD inline const aabb<T>& bounds(u32 handle) const noexcept
+            {
+                return objects[handle].box;
+            }
+
+            SML_NO_DISCARD inline bool empty() const noexcept
+            {
+                return live == 0;
+            }
+
+            // Number of objects
+            SML_NO_DISCARD inline size_t count() const noexcept
+            {
+                return live;
+            }
+
+            // Number of nodes in use, the root included
+            SML_NO_DISCARD inline size_t nodecount() const noexcept
+            {
+                return nodes.size() - freenodes.size();
+            }
+
+            // Calls visit(handle, box) for every object overlapping region
+            template<typename F>
+            void overlapping(const aabb<T>& region, F&& visit) const
+            {
+                descend(0, [&](u32 n) { return n == 0 || loosebounds(nodes[n].key).overlaps(region); }, [&](u32 handle)
+                {
+                    if (objects[handle].box.overlaps(region))
+                        visit(handle, objects[handle].box);
+                });
+            }
+
+            // Calls visit(handle, box) for the objects intersecting f, nodes roughly front to back as
+            // seen from eye. Subtrees whose loose bounds project to fewer than minsize pixels are cut,
+            // scale comes from projectionscale.
+            template<typename F>
+            void visible(const frustum<T>& f, const vec3<T>& eye, T scale, T minsize, F&& visit) const
+            {
+                visiblenode(0, f, eye, scale, minsize, visit);
+            }
+
+        private:
+            struct node
+            {
+                u64 key;
+                u32 parent;
+                u32 objects;
+                u32 children[8];
+            };
+
+            struct object
+            {
+                aabb<T> box;
+                u32 node = none;
+                u32 prev = none;
+                u32 next = none;
+            };
+
+            static inline node makenode(u64 key, u32 parent) noexcept
+            {
+                node n;
+
+                n.key = key;
+                n.parent = parent;
+                n.objects = none;
+                std::fill(n.children, n.children + 8, none);
+
+                return n;
+            }
+
+            static inline u32 depthof(u64 key) noexcept
+            {
+                return highestbit(key) / 3;
+            }
+
+            // Depth first order of locational codes, a node comes before its descendants
+            inline bool before(u64 a, u64 b) const noexcept
+            {
+                u32 da = depthof(a), db = depthof(b);
+                u64 pa = (a ^ (u64(1) << (3 * da))) << (3 * (maxdepth - da));
+                u64 pb = (b ^ (u64(1) << (3 * db))) << (3 * (maxdepth - db));
+
+                return pa != pb ? pa < pb : da < db;
+            }
+
+            inline T cellsize(u32 depth) const noexcept
+            {
+                return size / static_cast<T>(u64(1) << depth);
+            }
+
+            // Cell of a node grown by half a cell on every side
+            inline aabb<T> loosebounds(u64 key) const noexcept
+            {
+                u32 depth = depthof(key);
+                u64 x, y, z;
+                mortondecode63(key ^ (u64(1) << (3 * depth)), x, y, z);
+
+                T cell = cellsize(depth);
+                vec3<T> min = origin + vec3<T>(static_cast<T>(x), static_cast<T>(y), static_cast<T>(z)) * cell;
+                vec3<T> half(cell * static_cast<T>(0.5));
+
+                return aabb<T>(min - half, min + vec3<T>(cell) + half);
+            }
+
+            // Locational code of the node an object belongs in
+            inline u64 locate(const aabb<T>& box) const noexcept
+            {
+                vec3<T> center = box.center();
+                aabb<T> cube(origin, origin + vec3<T>(size));
+
+                if (!cube.contains(center))
+                    return 1;
+
+                vec3<T> s = box.size();
+                T extent = std::max(s.x, std::max(s.y, s.z));
+                u32 depth = 0;
+
+                while (depth < maxdepth && cellsize(depth + 1) >= extent)
+                {
+                    depth++;
+                }
+
+                u32 x, y, z;
+                mortonquantize(center, cube, 1u << maxdepth, x, y, z);
+
+                return (u64(1) << (3 * depth)) | (morton63(x, y, z) >> (3 * (maxdepth - depth)));
+            }
+
+            // Links an object into the node with the given code, creating the missing nodes on its path
+            void place(u32 handle, u64 key)
+            {
+                u32 depth = depthof(key);
+                u32 n = 0;
+
+                for (u32 d = 1; d <= depth; d++)
+                {
+                    u64 k = key >> (3 * (depth - d));
+                    u32 child = nodes[n].children[k & 7];
+
+                    if (child == none)
+                    {
+                        if (!freenodes.empty())
+                        {
+                            child = freenodes.back();
+                            freenodes.pop_back();
+                            nodes[child] = makenode(k, n);
+                        }
+                        else
+                        {
+                            child = static_cast<u32>(nodes.size());
+                            nodes.push_back(makenode(k, n));
+                        }
+
+                        nodes[n].children[k & 7] = child;
+                    }
+
+                    n = child;
+                }
+
+                object& o = objects[handle];
+
+                o.node = n;
+                o.prev = none;
+                o.next = nodes[n].objects;
+
+                if (o.next != none)
+                    objects[o.next].prev = handle;
+
+                nodes[n].objects = handle;
+            }
+
+            void unlink(u32 handle)
+            {
+                object& o = objects[handle];
+
+                if (o.prev != none)
+                    objects[o.prev].next = o.next;
+                else
+                    nodes[o.node].objects = o.next;
+
+                if (o.next != none)
+                    objects[o.next].prev = o.prev;
+
+                o.prev = o.next = none;
+            }
+
+            // Frees empty leaves from n upwards, the root always stays
+            void prune(u32 n)
+            {
+                while (n != 0 && nodes[n].objects == none &&
+                       std::all_of(nodes[n].children, nodes[n].children + 8, [](u32 c) { return c == none; }))
+                {
+                    u32 parent = nodes[n].parent;
+
+                    nodes[parent].children[nodes[n].key & 7] = none;
+                    freenodes.push_back(n);
+                    n = parent;
+                }
+            }
+
+            // Visits the objects of every node accepted by enter, children of rejected nodes are skipped
+            template<typename E, typename V>
+            void descend(u32 n, E&& enter, V&& visit) const
+            {
+                if (!enter(n))
+                    return;
+
+                for (u32 o = nodes[n].objects; o != none; o = objects[o].next)
+                {
+                    visit(o);
+                }
+
+                for (u32 c : nodes[n].children)
+                {
+                    if (c != none)
+                        descend(c, enter, visit);
+                }
+            }
+
+            template<typename F>
+            void visiblenode(u32 n, const frustum<T>& f, const vec3<T>& eye, T scale, T minsize, F& visit) const
+            {
+                const node& current = nodes[n];
+                aabb<T> loose = loosebounds(current.key);
+
+                if (n != 0)
+                {
+                    if (!f.intersects(loose))
+                        return;
+
+                    T d2 = 0;
+
+                    for (u32 a = 0; a < 3; a++)
+                    {
+                        T d = std::max(loose.min.v[a] - eye.v[a], std::max(eye.v[a] - loose.max.v[a], static_cast<T>(0)));
+
+                        d2 += d * d;
+                    }
+
+                    T projected = (loose.max.x - loose.min.x) * scale;
+
+                    if (projected * projected < minsize * minsize * d2)
+                        return;
+                }
+
+                for (u32 o = current.objects; o != none; o = objects[o].next)
+                {
+                    if (f.intersects(objects[o].box))
+                        visit(o, objects[o].box);
+                }
+
+                // Children in order of i ^ near, the child on the side of the eye first
+                vec3<T> center = loose.center();
+                u32 near = (eye.x >= center.x ? 1u : 0u) | (eye.y >= center.y ? 2u : 0u) | (eye.z >= center.z ? 4u : 0u);
+
+                for (u32 i = 0; i < 8; i++)
+                {
+                    u32 c = current.children[i ^ near];
+
+                    if (c != none)
+                        visiblenode(c, f, eye, scale, minsize, visit);
+                }
+            }
+
+            // Data
+            vec3<T> origin;
+            T size;
+            u32 maxdepth;
+            size_t live = 0;
+
+            std::vector<node> nodes;
+            std::vector<object> objects;
+            std::vector<u32> freenodes;
+            std::vector<u32> freeobjects;
+    };
+
+    typedef octree<f32> foctree;
+    typedef octree<f64> doctree;
+} // namespace sml
+
+#endif // sml_octree_h__
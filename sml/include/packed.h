@@ -0,0 +1,208 @@
+#ifndef sml_packed_h__
+#define sml_packed_h__
+
+/* packed.h -- packed vector storage types of the 'Simple Math Library'
+  Copyright (C) 2020 Roderick Griffioen
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <cstddef>
+#include <immintrin.h>
+
+#include "smltypes.h"
+#include "simd.h"
+#include "vec2.h"
+#include "vec3.h"
+#include "unaligned.h"
+
+namespace sml
+{
+    // Packed vectors hold only their components (8 / 12 bytes for f32, 16 / 24 bytes for f64)
+    // and have no alignment requirement, use them for large arrays and convert to vec2 / vec3 for math
+    template<typename T>
+    struct packed_vec2
+    {
+        constexpr packed_vec2() noexcept : x(static_cast<T>(0)), y(static_cast<T>(0))
+        {
+        }
+
+        constexpr packed_vec2(T x, T y) noexcept : x(x), y(y)
+        {
+        }
+
+        packed_vec2(const vec2<T>& other) noexcept
+        {
+            unaligned<vec2<T>>::store(&x, other);
+        }
+
+        operator vec2<T>() const noexcept
+        {
+            return unaligned<vec2<T>>::load(&x);
+        }
+
+        T x, y;
+    };
+
+    template<typename T>
+    struct packed_vec3
+    {
+        constexpr packed_vec3() noexcept : x(static_cast<T>(0)), y(static_cast<T>(0)), z(static_cast<T>(0))
+        {
+        }
+
+        constexpr packed_vec3(T x, T y, T z) noexcept : x(x), y(y), z(z)
+        {
+        }
+
+        packed_vec3(const vec3<T>& other) noexcept
+        {
+            unaligned<vec3<T>>::store(&x, other);
+        }
+
+        operator vec3<T>() const noexcept
+        {
+            return unaligned<vec3<T>>::load(&x);
+        }
+
+        T x, y, z;
+    };
+
+    static_assert(sizeof(packed_vec2<f32>) == 8, "packed_vec2<f32> must not be padded");
+    static_assert(sizeof(packed_vec3<f32>) == 12, "packed_vec3<f32> must not be padded");
+    static_assert(sizeof(packed_vec3<f64>) == 24, "packed_vec3<f64> must not be padded");
+
+    // Bulk expansion, reads count packed vectors from src and writes them to dst
+    template<typename T>
+    inline void unpack(const packed_vec2<T>* src, vec2<T>* dst, size_t count) noexcept
+    {
+        size_t i = 0;
+
+        if constexpr (std::is_same<T, f32>::value)
+        {
+            __m128 zero = _mm_setzero_ps();
+
+            for (; i + 2 <= count; i += 2)
+            {
+                // x0 y0 x1 y1
+                __m128 q = _mm_loadu_ps(&src[i].x);
+
+                simd::store(dst[i + 0].v, _mm_movelh_ps(q, zero));
+                simd::store(dst[i + 1].v, _mm_movehl_ps(zero, q));
+            }
+        }
+
+        for (; i < count; i++)
+        {
+            dst[i] = src[i];
+        }
+    }
+
+    template<typename T>
+    inline void unpack(const packed_vec3<T>* src, vec3<T>* dst, size_t count) noexcept
+    {
+        size_t i = 0;
+
+        if constexpr (std::is_same<T, f32>::value)
+        {
+            for (; i + 4 <= count; i += 4)
+            {
+                // x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3
+                __m128i a = _mm_castps_si128(_mm_loadu_ps(&src[i].x));
+                __m128i b = _mm_castps_si128(_mm_loadu_ps(&src[i].x + 4));
+                __m128i c = _mm_castps_si128(_mm_loadu_ps(&src[i].x + 8));
+
+                __m128 v0 = _mm_castsi128_ps(a);
+                __m128 v1 = _mm_castsi128_ps(_mm_alignr_epi8(b, a, 12));
+                __m128 v2 = _mm_castsi128_ps(_mm_alignr_epi8(c, b, 8));
+                __m128 v3 = _mm_castsi128_ps(_mm_srli_si128(c, 4));
+
+                __m128 zero = _mm_setzero_ps();
+
+                simd::store(dst[i + 0].v, _mm_blend_ps(v0, zero, 0x8));
+                simd::store(dst[i + 1].v, _mm_blend_ps(v1, zero, 0x8));
+                simd::store(dst[i + 2].v, _mm_blend_ps(v2, zero, 0x8));
+                simd::store(dst[i + 3].v, v3);
+            }
+        }
+
+        for (; i < count; i++)
+        {
+            dst[i] = src[i];
+        }
+    }
+
+    // Bulk compaction, reads count vectors from src and writes them packed to dst
+    template<typename T>
+    inline void pack(const vec2<T>* src, packed_vec2<T>* dst, size_t count) noexcept
+    {
+        size_t i = 0;
+
+        if constexpr (std::is_same<T, f32>::value)
+        {
+            for (; i + 2 <= count; i += 2)
+            {
+                __m128 v0 = simd::load(src[i + 0].v);
+                __m128 v1 = simd::load(src[i + 1].v);
+
+                _mm_storeu_ps(&dst[i].x, _mm_movelh_ps(v0, v1));
+            }
+        }
+
+        for (; i < count; i++)
+        {
+            dst[i] = src[i];
+        }
+    }
+
+    template<typename T>
+    inline void pack(const vec3<T>* src, packed_vec3<T>* dst, size_t count) noexcept
+    {
+        size_t i = 0;
+
+        if constexpr (std::is_same<T, f32>::value)
+        {
+            for (; i + 4 <= count; i += 4)
+            {
+                __m128 v0 = simd::load(src[i + 0].v);
+                __m128 v1 = simd::load(src[i + 1].v);
+                __m128 v2 = simd::load(src[i + 2].v);
+                __m128 v3 = simd::load(src[i + 3].v);
+
+                // x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3
+                __m128 x1 = simd::shuffle<0, 0, 0, 0>(v1);
+                __m128 a = _mm_blend_ps(v0, x1, 0x8);
+                __m128 b = _mm_shuffle_ps(v1, v2, _MM_SHUFFLE(1, 0, 2, 1));
+                __m128 c = _mm_move_ss(simd::shuffle<0, 0, 1, 2>(v3), simd::shuffle<2, 2, 2, 2>(v2));
+
+                _mm_storeu_ps(&dst[i].x, a);
+                _mm_storeu_ps(&dst[i].x + 4, b);
+                _mm_storeu_ps(&dst[i].x + 8, c);
+            }
+        }
+
+        for (; i < count; i++)
+        {
+            dst[i] = src[i];
+        }
+    }
+
+    // Predefined types
+    typedef packed_vec2<f32> packed_fvec2;
+    typedef packed_vec2<f64> packed_dvec2;
+    typedef packed_vec3<f32> packed_fvec3;
+    typedef packed_vec3<f64> packed_dvec3;
+} // namespace sml
+
+#endif // sml_packed_h__
@@ -0,0 +1,102 @@
+#ifndef sml_parallel_h__
+#define sml_parallel_h__
+
+/* parallel.h -- thread helpers of the 'Simple Math Library'
+  Copyright (C) 2020 Roderick Griffioen
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include "smltypes.h"
+
+namespace sml
+{
+    // Worker count for the parallel builders, 0 selects one thread per hardware thread
+    inline u32 threadcount(u32 requested = 0) noexcept
+    {
+        if (requested != 0)
+            return requested;
+
+        u32 hardware = std::thread::hardware_concurrency();
+
+        return hardware != 0 ? hardware : 1;
+    }
+
+    // Splits [begin, end) into at most threads chunks of at least grain elements and calls
+    // f(chunkbegin, chunkend, thread) for each of them, the calling thread runs the last chunk.
+    // Thread indices are dense so they can index per thread scratch of threadcount(threads) entries.
+    template<typename F>
+    inline void parallelfor(size_t begin, size_t end, size_t grain, F&& f, u32 threads = 0)
+    {
+        size_t count = end > begin ? end - begin : 0;
+        size_t chunks = (count + grain - 1) / (grain != 0 ? grain : 1);
+
+        if (chunks > threadcount(threads))
+            chunks = threadcount(threads);
+
+        if (chunks <= 1)
+        {
+            if (count != 0)
+                f(begin, end, 0u);
+
+            return;
+        }
+
+        std::vector<std::thread> workers;
+        workers.reserve(chunks - 1);
+
+        size_t step = count / chunks, remainder = count % chunks, first = begin;
+
+        for (size_t i = 0; i < chunks; i++)
+        {
+            size_t last = first + step + (i < remainder ? 1 : 0);
+
+            if (i + 1 < chunks)
+                workers.emplace_back([&f, first, last, i]() { f(first, last, static_cast<u32>(i)); });
+            else
+                f(first, last, static_cast<u32>(i));
+
+            first = last;
+        }
+
+        for (std::thread& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    // Runs a on a new thread and b on the calling thread when parallel is set, otherwise both in order
+    template<typename A, typename B>
+    inline void parallelinvoke(bool parallel, A&& a, B&& b)
+    {
+        if (!parallel)
+        {
+            a();
+            b();
+
+            return;
+        }
+
+        std::thread worker([&a]() { a(); });
+        b();
+        worker.join();
+    }
+} // namespace sml
+
+#endif // sml_parallel_h__
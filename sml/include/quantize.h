@@ -0,0 +1,985 @@
+#ifndef sml_quantize_h__
+#define sml_quantize_h__
+
+/* quantize.h -- quantised vector encodings of the 'Simple Math Library'
+  Copyright (C) 2020 Roderick Griffioen
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <immintrin.h>
+
+#include "smltypes.h"
+#include "common.h"
+#include "simd.h"
+#include "vec2.h"
+#include "vec3.h"
+#include "vec4.h"
+#include "mat3.h"
+#include "quat.h"
+
+namespace sml
+{
+    // Normalised integers, a signed S stores snorm in [-1, 1] and an unsigned S stores unorm in [0, 1].
+    // Values are clamped and rounded to nearest even, the most negative snorm decodes to -1 like the GPU does.
+    template<typename S>
+    SML_NO_DISCARD inline S quantize(f32 value) noexcept
+    {
+        static_assert(std::is_integral<S>::value && sizeof(S) <= 2, "quantize stores 8 or 16 bit integers");
+
+        constexpr f32 scale = static_cast<f32>(std::numeric_limits<S>::max());
+        constexpr f32 lower = std::is_signed<S>::value ? -1.0f : 0.0f;
+
+        return static_cast<S>(std::nearbyint(sml::max(sml::min(value, 1.0f), lower) * scale));
+    }
+
+    template<typename S>
+    SML_NO_DISCARD inline f32 dequantize(S value) noexcept
+    {
+        static_assert(std::is_integral<S>::value && sizeof(S) <= 2, "dequantize reads 8 or 16 bit integers");
+
+        constexpr f32 scale = 1.0f / static_cast<f32>(std::numeric_limits<S>::max());
+
+        return sml::max(static_cast<f32>(value) * scale, -1.0f);
+    }
+
+    // Byte shuffle that moves N components of B bytes out of two padded four component vectors, and back
+    template<u32 N, u32 B>
+    inline __m128i compactmask() noexcept
+    {
+        alignas(16) s8 mask[16];
+
+        for (u32 i = 0; i < 16; i++)
+        {
+            mask[i] = i < 2 * N * B ? static_cast<s8>((i / (N * B)) * 4 * B + i % (N * B)) : -128;
+        }
+
+        return _mm_load_si128(reinterpret_cast<const __m128i*>(mask));
+    }
+
+    template<u32 N, u32 B>
+    inline __m128i expandmask() noexcept
+    {
+        alignas(16) s8 mask[16];
+
+        for (u32 i = 0; i < 16; i++)
+        {
+            u32 component = i % (4 * B);
+
+            mask[i] = i < 8 * B && component < N * B ? static_cast<s8>((i / (4 * B)) * N * B + component) : -128;
+        }
+
+        return _mm_load_si128(reinterpret_cast<const __m128i*>(mask));
+    }
+
+    // Narrows eight 32 bit lanes to S with saturation, the result is in the low 8 * sizeof(S) bytes
+    template<typename S>
+    inline __m128i narrowlanes(__m128i lo, __m128i hi) noexcept
+    {
+        if constexpr (std::is_same<S, s16>::value)
+            return _mm_packs_epi32(lo, hi);
+        else if constexpr (std::is_same<S, u16>::value)
+            return _mm_packus_epi32(lo, hi);
+        else if constexpr (std::is_same<S, s8>::value)
+            return _mm_packs_epi16(_mm_packs_epi32(lo, hi), _mm_setzero_si128());
+        else
+            return _mm_packus_epi16(_mm_packs_epi32(lo, hi), _mm_setzero_si128());
+    }
+
+    // Widens the low eight S lanes of packed to 32 bit
+    template<typename S>
+    inline void widenlanes(__m128i packed, __m128i& lo, __m128i& hi) noexcept
+    {
+        if constexpr (std::is_same<S, s16>::value)
+        {
+            lo = _mm_cvtepi16_epi32(packed);
+            hi = _mm_cvtepi16_epi32(_mm_srli_si128(packed, 8));
+        }
+        else if constexpr (std::is_same<S, u16>::value)
+        {
+            lo = _mm_cvtepu16_epi32(packed);
+            hi = _mm_cvtepu16_epi32(_mm_srli_si128(packed, 8));
+        }
+        else if constexpr (std::is_same<S, s8>::value)
+        {
+            lo = _mm_cvtepi8_epi32(packed);
+            hi = _mm_cvtepi8_epi32(_mm_srli_si128(packed, 4));
+        }
+        else
+        {
+            lo = _mm_cvtepu8_epi32(packed);
+            hi = _mm_cvtepu8_epi32(_mm_srli_si128(packed, 4));
+        }
+    }
+
+    // Quantises count padded N component vectors (four floats apart) to N tightly packed S per vector.
+    // Two vectors are converted per iteration, each 16 byte store runs ahead into elements written later.
+    template<u32 N, typename S>
+    inline void quantizevectors(const f32* src, S* dst, size_t count) noexcept
+    {
+        constexpr size_t bytes = N * sizeof(S);
+        constexpr f32 lower = std::is_signed<S>::value ? -1.0f : 0.0f;
+
+        __m256 low = _mm256_set1_ps(lower);
+        __m256 one = _mm256_set1_ps(1.0f);
+        __m256 scale = _mm256_set1_ps(static_cast<f32>(std::numeric_limits<S>::max()));
+        __m128i compact = compactmask<N, sizeof(S)>();
+        u8* out = reinterpret_cast<u8*>(dst);
+        size_t i = 0;
+
+        for (; i * bytes + 16 <= count * bytes; i += 2)
+        {
+            __m256 v = _mm256_mul_ps(_mm256_max_ps(_mm256_min_ps(_mm256_loadu_ps(src + i * 4), one), low), scale);
+            __m256i r = _mm256_cvtps_epi32(v);
+            __m128i packed = narrowlanes<S>(_mm256_castsi256_si128(r), _mm256_extractf128_si256(r, 1));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * bytes), _mm_shuffle_epi8(packed, compact));
+        }
+
+        for (; i < count; i++)
+        {
+            for (u32 c = 0; c < N; c++)
+            {
+                dst[i * N + c] = quantize<S>(src[i * 4 + c]);
+            }
+        }
+    }
+
+    template<u32 N, typename S>
+    inline void dequantizevectors(const S* src, f32* dst, size_t count) noexcept
+    {
+        constexpr size_t bytes = N * sizeof(S);
+
+        __m256 minusone = _mm256_set1_ps(-1.0f);
+        __m256 scale = _mm256_set1_ps(1.0f / static_cast<f32>(std::numeric_limits<S>::max()));
+        __m128i expand = expandmask<N, sizeof(S)>();
+        const u8* in = reinterpret_cast<const u8*>(src);
+        size_t i = 0;
+
+        for (; i * bytes + 16 <= count * bytes; i += 2)
+        {
+            __m128i lo, hi;
+            widenlanes<S>(_mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * bytes)), expand), lo, hi);
+
+            __m256 v = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_cvtepi32_ps(lo)), _mm_cvtepi32_ps(hi), 1);
+
+            _mm256_storeu_ps(dst + i * 4, _mm256_max_ps(_mm256_mul_ps(v, scale), minusone));
+        }
+
+        for (; i < count; i++)
+        {
+            for (u32 c = 0; c < N; c++)
+            {
+                dst[i * 4 + c] = dequantize(src[i * N + c]);
+            }
+        }
+    }
+
+    // Bulk snorm/unorm packing, dst holds 2, 3 or 4 integers per vector
+    template<typename S>
+    inline void quantize(const vec2<f32>* src, S* dst, size_t count) noexcept
+    {
+        quantizevectors<2>(src[0].v, dst, count);
+    }
+
+    template<typename S>
+    inline void quantize(const vec3<f32>* src, S* dst, size_t count) noexcept
+    {
+        quantizevectors<3>(src[0].v, dst, count);
+    }
+
+    template<typename S>
+    inline void quantize(const vec4<f32>* src, S* dst, size_t count) noexcept
+    {
+        quantizevectors<4>(src[0].v, dst, count);
+    }
+
+    template<typename S>
+    inline void dequantize(const S* src, vec2<f32>* dst, size_t count) noexcept
+    {
+        dequantizevectors<2>(src, dst[0].v, count);
+    }
+
+    template<typename S>
+    inline void dequantize(const S* src, vec3<f32>* dst, size_t count) noexcept
+    {
+        dequantizevectors<3>(src, dst[0].v, count);
+    }
+
+    template<typename S>
+    inline void dequantize(const S* src, vec4<f32>* dst, size_t count) noexcept
+    {
+        dequantizevectors<4>(src, dst[0].v, count);
+    }
+
+    // Octahedral unit vector encoding, the sphere is projected onto the octahedron |x| + |y| + |z| = 1
+    // and the lower half is folded over the diagonals so every direction maps into [-1, 1]^2
+    template<typename T>
+    SML_NO_DISCARD inline vec2<T> octencode(const vec3<T>& n) noexcept
+    {
+        const T one = static_cast<T>(1);
+        T l1 = sml::abs(n.x) + sml::abs(n.y) + sml::abs(n.z);
+        T x = n.x / l1;
+        T y = n.y / l1;
+
+        if (n.z < static_cast<T>(0))
+        {
+            T fx = (one - sml::abs(y)) * (std::signbit(x) ? -one : one);
+            T fy = (one - sml::abs(x)) * (std::signbit(y) ? -one : one);
+
+            x = fx;
+            y = fy;
+        }
+
+        return vec2<T>(x, y);
+    }
+
+    template<typename T>
+    SML_NO_DISCARD inline vec3<T> octdecode(const vec2<T>& e) noexcept
+    {
+        vec3<T> n(e.x, e.y, static_cast<T>(1) - sml::abs(e.x) - sml::abs(e.y));
+        T t = sml::max(-n.z, static_cast<T>(0));
+
+        n.x += std::signbit(n.x) ? t : -t;
+        n.y += std::signbit(n.y) ? t : -t;
+
+        return n.normalized();
+    }
+
+    // Eight wide octahedral encode and decode on x, y and z registers
+    inline void octencode(__m256 x, __m256 y, __m256 z, __m256& ex, __m256& ey) noexcept
+    {
+        __m256 signmask = _mm256_set1_ps(-0.0f);
+        __m256 one = _mm256_set1_ps(1.0f);
+
+        __m256 l1 = _mm256_add_ps(_mm256_add_ps(_mm256_andnot_ps(signmask, x), _mm256_andnot_ps(signmask, y)), _mm256_andnot_ps(signmask, z));
+        __m256 px = _mm256_div_ps(x, l1);
+        __m256 py = _mm256_div_ps(y, l1);
+
+        __m256 fx = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_andnot_ps(signmask, py)), _mm256_or_ps(_mm256_and_ps(px, signmask), one));
+        __m256 fy = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_andnot_ps(signmask, px)), _mm256_or_ps(_mm256_and_ps(py, signmask), one));
+        __m256 lower = _mm256_cmp_ps(z, _mm256_setzero_ps(), _CMP_LT_OQ);
+
+        ex = simd::select(lower, px, fx);
+        ey = simd::select(lower, py, fy);
+    }
+
+    inline void octdecode(__m256 ex, __m256 ey, __m256& x, __m256& y, __m256& z) noexcept
+    {
+        __m256 signmask = _mm256_set1_ps(-0.0f);
+
+        z = _mm256_sub_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), _mm256_andnot_ps(signmask, ex)), _mm256_andnot_ps(signmask, ey));
+
+        __m256 t = _mm256_max_ps(_mm256_sub_ps(_mm256_setzero_ps(), z), _mm256_setzero_ps());
+
+        x = _mm256_sub_ps(ex, _mm256_xor_ps(t, _mm256_and_ps(ex, signmask)));
+        y = _mm256_sub_ps(ey, _mm256_xor_ps(t, _mm256_and_ps(ey, signmask)));
+
+        __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z)));
+
+        x = _mm256_div_ps(x, length);
+        y = _mm256_div_ps(y, length);
+        z = _mm256_div_ps(z, length);
+    }
+
+    // Octahedral normals stored as 2 x snorm16 (S = s16) or 2 x unorm8 (S = u8), the unorm form maps [-1, 1] to [0, 1]
+    template<typename S>
+    inline void octencode(const vec3<f32>* src, S* dst, size_t count) noexcept
+    {
+        static_assert(std::is_same<S, s16>::value || std::is_same<S, u8>::value, "octahedral normals are stored as snorm16 or unorm8");
+
+        constexpr bool unorm = std::is_same<S, u8>::value;
+        __m256 scale = _mm256_set1_ps(unorm ? 127.5f : 32767.0f);
+        __m256 bias = _mm256_set1_ps(unorm ? 127.5f : 0.0f);
+        size_t i = 0;
+
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256 x = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(src[i + 0].v)), simd::load(src[i + 4].v), 1);
+            __m256 y = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(src[i + 1].v)), simd::load(src[i + 5].v), 1);
+            __m256 z = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(src[i + 2].v)), simd::load(src[i + 6].v), 1);
+            __m256 w = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(src[i + 3].v)), simd::load(src[i + 7].v), 1);
+
+            simd::transpose(x, y, z, w);
+
+            __m256 ex, ey;
+            octencode(x, y, z, ex, ey);
+
+            __m256i qx = _mm256_cvtps_epi32(_mm256_add_ps(_mm256_mul_ps(ex, scale), bias));
+            __m256i qy = _mm256_cvtps_epi32(_mm256_add_ps(_mm256_mul_ps(ey, scale), bias));
+            __m128i px = narrowlanes<S>(_mm256_castsi256_si128(qx), _mm256_extractf128_si256(qx, 1));
+            __m128i py = narrowlanes<S>(_mm256_castsi256_si128(qy), _mm256_extractf128_si256(qy, 1));
+
+            if constexpr (unorm)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * i), _mm_unpacklo_epi8(px, py));
+            }
+            else
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * i + 0), _mm_unpacklo_epi16(px, py));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * i + 8), _mm_unpackhi_epi16(px, py));
+            }
+        }
+
+        for (; i < count; i++)
+        {
+            vec2<f32> e = octencode(src[i]);
+
+            if constexpr (unorm)
+            {
+                e = e * 0.5f + vec2<f32>(0.5f, 0.5f);
+            }
+
+            dst[2 * i + 0] = quantize<S>(e.x);
+            dst[2 * i + 1] = quantize<S>(e.y);
+        }
+    }
+
+    template<typename S>
+    inline void octdecode(const S* src, vec3<f32>* dst, size_t count) noexcept
+    {
+        static_assert(std::is_same<S, s16>::value || std::is_same<S, u8>::value, "octahedral normals are stored as snorm16 or unorm8");
+
+        constexpr bool unorm = std::is_same<S, u8>::value;
+        __m256 scale = _mm256_set1_ps(unorm ? 2.0f / 255.0f : 1.0f / 32767.0f);
+        __m256 bias = _mm256_set1_ps(unorm ? -1.0f : 0.0f);
+        __m256 minusone = _mm256_set1_ps(-1.0f);
+        size_t i = 0;
+
+        for (; i + 8 <= count; i += 8)
+        {
+            __m128i xlo, xhi, ylo, yhi;
+
+            if constexpr (unorm)
+            {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i));
+                __m128i x = _mm_and_si128(v, _mm_set1_epi16(0xFF));
+                __m128i y = _mm_srli_epi16(v, 8);
+
+                xlo = _mm_cvtepu16_epi32(x);
+                xhi = _mm_cvtepu16_epi32(_mm_srli_si128(x, 8));
+                ylo = _mm_cvtepu16_epi32(y);
+                yhi = _mm_cvtepu16_epi32(_mm_srli_si128(y, 8));
+            }
+            else
+            {
+                __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i + 0));
+                __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i + 8));
+
+                xlo = _mm_srai_epi32(_mm_slli_epi32(v0, 16), 16);
+                xhi = _mm_srai_epi32(_mm_slli_epi32(v1, 16), 16);
+                ylo = _mm_srai_epi32(v0, 16);
+                yhi = _mm_srai_epi32(v1, 16);
+            }
+
+            __m256 ex = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_cvtepi32_ps(xlo)), _mm_cvtepi32_ps(xhi), 1);
+            __m256 ey = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_cvtepi32_ps(ylo)), _mm_cvtepi32_ps(yhi), 1);
+
+            ex = _mm256_max_ps(_mm256_add_ps(_mm256_mul_ps(ex, scale), bias), minusone);
+            ey = _mm256_max_ps(_mm256_add_ps(_mm256_mul_ps(ey, scale), bias), minusone);
+
+            __m256 x, y, z, w = _mm256_setzero_ps();
+            octdecode(ex, ey, x, y, z);
+
+            simd::transpose(x, y, z, w);
+
+            simd::store(dst[i + 0].v, _mm256_castps256_ps128(x));
+            simd::store(dst[i + 1].v, _mm256_castps256_ps128(y));
+            simd::store(dst[i + 2].v, _mm256_castps256_ps128(z));
+            simd::store(dst[i + 3].v, _mm256_castps256_ps128(w));
+            simd::store(dst[i + 4].v, _mm256_extractf128_ps(x, 1));
+            simd::store(dst[i + 5].v, _mm256_extractf128_ps(y, 1));
+            simd::store(dst[i + 6].v, _mm256_extractf128_ps(z, 1));
+            simd::store(dst[i + 7].v, _mm256_extractf128_ps(w, 1));
+        }
+
+        for (; i < count; i++)
+        {
+            vec2<f32> e(dequantize(src[2 * i + 0]), dequantize(src[2 * i + 1]));
+
+            if constexpr (unorm)
+            {
+                e = e * 2.0f - vec2<f32>(1.0f, 1.0f);
+            }
+
+            dst[i] = octdecode(e);
+        }
+    }
+
+    // Tangent frame whose rotation takes (1, 0, 0) to the tangent and (0, 0, 1) to the normal. The
+    // tangent is orthogonalised against the normal and the bitangent is cross(normal, tangent).
+    template<typename T>
+    SML_NO_DISCARD inline quat<T> tangentframe(const vec3<T>& normal, const vec3<T>& tangent) noexcept
+    {
+        vec3<T> n = normal.normalized();
+        vec3<T> t = (tangent - n * n.dot(tangent)).normalized();
+        vec3<T> b = vec3<T>::cross(n, t);
+
+        return quat<T>::frommatrix3(mat3<T>(t.x, t.y, t.z, b.x, b.y, b.z, n.x, n.y, n.z)).normalized();
+    }
+
+    // QTangent, a tangent frame with the bitangent sign stored in the sign of w. q and -q are the same
+    // rotation, so w is made positive and held at least one snorm16 step away from zero before the
+    // reflection negates the whole quaternion.
+    template<typename T>
+    SML_NO_DISCARD inline quat<T> qtangent(const quat<T>& frame, T handedness) noexcept
+    {
+        const T bias = static_cast<T>(1) / static_cast<T>(32767);
+        quat<T> q = frame.normalized();
+
+        if (q.w < static_cast<T>(0))
+        {
+            q = quat<T>(-q.x, -q.y, -q.z, -q.w);
+        }
+
+        if (q.w < bias)
+        {
+            q = quat<T>(q.xyz * sml::sqrt(static_cast<T>(1) - bias * bias), bias);
+        }
+
+        if (handedness < static_cast<T>(0))
+        {
+            q = quat<T>(-q.x, -q.y, -q.z, -q.w);
+        }
+
+        return q;
+    }
+
+    // Decodes a QTangent to a normal and a tangent with the bitangent sign in w
+    template<typename T>
+    inline void qtangentdecode(const quat<T>& q, vec3<T>& normal, vec4<T>& tangent) noexcept
+    {
+        const T one = static_cast<T>(1);
+        T s = static_cast<T>(2) / q.lengthsquared();
+
+        normal.set(s * (q.x * q.z + q.w * q.y), s * (q.y * q.z - q.w * q.x), one - s * (q.x * q.x + q.y * q.y));
+        tangent.set(one - s * (q.y * q.y + q.z * q.z), s * (q.x * q.y + q.w * q.z), s * (q.x * q.z - q.w * q.y), std::signbit(q.w) ? -one : one);
+    }
+
+    // Bulk QTangent encode to 4 x snorm16 per vertex, two frames per iteration
+    inline void qtangentencode(const quat<f32>* frames, const f32* handedness, s16* dst, size_t count) noexcept
+    {
+        __m256 signmask = _mm256_set1_ps(-0.0f);
+        __m256 bias = _mm256_set1_ps(1.0f / 32767.0f);
+        __m256 shrink = _mm256_set1_ps(std::sqrt(1.0f - (1.0f / 32767.0f) * (1.0f / 32767.0f)));
+        __m256 scale = _mm256_set1_ps(32767.0f);
+        size_t i = 0;
+
+        for (; i + 2 <= count; i += 2)
+        {
+            __m256 q = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(frames[i + 0].v.v)), simd::load(frames[i + 1].v.v), 1);
+            __m256 h = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(handedness[i + 0])), _mm_set1_ps(handedness[i + 1]), 1);
+
+            __m256 lengthsquared = _mm256_mul_ps(q, q);
+            lengthsquared = _mm256_hadd_ps(lengthsquared, lengthsquared);
+            lengthsquared = _mm256_hadd_ps(lengthsquared, lengthsquared);
+            q = _mm256_div_ps(q, _mm256_sqrt_ps(lengthsquared));
+
+            // Flip to positive w, then clamp small w to the bias while keeping unit length
+            q = _mm256_xor_ps(q, _mm256_and_ps(_mm256_permute_ps(q, 0xFF), signmask));
+
+            __m256 small = _mm256_cmp_ps(_mm256_permute_ps(q, 0xFF), bias, _CMP_LT_OQ);
+            __m256 clamped = _mm256_blend_ps(_mm256_mul_ps(q, shrink), bias, 0x88);
+
+            q = simd::select(small, q, clamped);
+            q = _mm256_xor_ps(q, _mm256_and_ps(_mm256_cmp_ps(h, _mm256_setzero_ps(), _CMP_LT_OQ), signmask));
+
+            __m256i r = _mm256_cvtps_epi32(_mm256_mul_ps(q, scale));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4 * i), _mm_packs_epi32(_mm256_castsi256_si128(r), _mm256_extractf128_si256(r, 1)));
+        }
+
+        for (; i < count; i++)
+        {
+            quat<f32> q = qtangent(frames[i], handedness[i]);
+
+            dst[4 * i + 0] = quantize<s16>(q.x);
+            dst[4 * i + 1] = quantize<s16>(q.y);
+            dst[4 * i + 2] = quantize<s16>(q.z);
+            dst[4 * i + 3] = quantize<s16>(q.w);
+        }
+    }
+
+    // Bulk QTangent decode, eight frames per iteration
+    inline void qtangentdecode(const s16* src, vec3<f32>* normals, vec4<f32>* tangents, size_t count) noexcept
+    {
+        __m256 one = _mm256_set1_ps(1.0f);
+        __m256 two = _mm256_set1_ps(2.0f);
+        __m256 minusone = _mm256_set1_ps(-1.0f);
+        __m256 scale = _mm256_set1_ps(1.0f / 32767.0f);
+        __m256 r[4];
+        size_t i = 0;
+
+        for (; i + 8 <= count; i += 8)
+        {
+            for (u32 k = 0; k < 4; k++)
+            {
+                __m128 lo = _mm_cvtepi32_ps(_mm_cvtepi16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + 4 * (i + k)))));
+                __m128 hi = _mm_cvtepi32_ps(_mm_cvtepi16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + 4 * (i + k + 4)))));
+
+                r[k] = _mm256_max_ps(_mm256_mul_ps(_mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1), scale), minusone);
+            }
+
+            simd::transpose(r[0], r[1], r[2], r[3]);
+
+            __m256 x = r[0], y = r[1], z = r[2], w = r[3];
+            __m256 s = _mm256_div_ps(two, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_add_ps(_mm256_mul_ps(z, z), _mm256_mul_ps(w, w))));
+
+            __m256 nx = _mm256_mul_ps(s, _mm256_add_ps(_mm256_mul_ps(x, z), _mm256_mul_ps(w, y)));
+            __m256 ny = _mm256_mul_ps(s, _mm256_sub_ps(_mm256_mul_ps(y, z), _mm256_mul_ps(w, x)));
+            __m256 nz = _mm256_sub_ps(one, _mm256_mul_ps(s, _mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y))));
+            __m256 nw = _mm256_setzero_ps();
+
+            __m256 tx = _mm256_sub_ps(one, _mm256_mul_ps(s, _mm256_add_ps(_mm256_mul_ps(y, y), _mm256_mul_ps(z, z))));
+            __m256 ty = _mm256_mul_ps(s, _mm256_add_ps(_mm256_mul_ps(x, y), _mm256_mul_ps(w, z)));
+            __m256 tz = _mm256_mul_ps(s, _mm256_sub_ps(_mm256_mul_ps(x, z), _mm256_mul_ps(w, y)));
+            __m256 tw = _mm256_or_ps(_mm256_and_ps(w, _mm256_set1_ps(-0.0f)), one);
+
+            simd::transpose(nx, ny, nz, nw);
+            simd::transpose(tx, ty, tz, tw);
+
+            __m256 n[4] = { nx, ny, nz, nw };
+            __m256 t[4] = { tx, ty, tz, tw };
+
+            for (u32 k = 0; k < 4; k++)
+            {
+                simd::store(normals[i + k].v, _mm256_castps256_ps128(n[k]));
+                simd::store(normals[i + k + 4].v, _mm256_extractf128_ps(n[k], 1));
+                simd::store(tangents[i + k].v, _mm256_castps256_ps128(t[k]));
+                simd::store(tangents[i + k + 4].v, _mm256_extractf128_ps(t[k], 1));
+            }
+        }
+
+        for (; i < count; i++)
+        {
+            quat<f32> q(dequantize(src[4 * i + 0]), dequantize(src[4 * i + 1]), dequantize(src[4 * i + 2]), dequantize(src[4 * i + 3]));
+
+            qtangentdecode(q, normals[i], tangents[i]);
+        }
+    }
+
+    // Smallest three quaternion compression. The largest magnitude component is dropped and rebuilt from
+    // unit length, the quaternion is negated so the dropped component is positive and the remaining three
+    // lie in [-1/sqrt(2), 1/sqrt(2)] where they are stored with Bits bits each. An even number of steps is
+    // used so zero, and with it the identity and axis rotations, round trip exactly.
+    template<u32 Bits, typename T>
+    inline u32 encodesmallestthree(const quat<T>& q, u32 (&c)[3]) noexcept
+    {
+        constexpr T range = static_cast<T>((1u << Bits) - 2);
+        const T scale = static_cast<T>(0.70710678118654752440) * range;
+        const T bias = static_cast<T>(0.5) * range;
+
+        quat<T> n = q.normalized();
+        const T v[4] = { n.x, n.y, n.z, n.w };
+        u32 index = 0;
+
+        for (u32 k = 1; k < 4; k++)
+        {
+            if (sml::abs(v[k]) > sml::abs(v[index]))
+                index = k;
+        }
+
+        T sign = v[index] < static_cast<T>(0) ? static_cast<T>(-1) : static_cast<T>(1);
+
+        for (u32 k = 0, j = 0; k < 4; k++)
+        {
+            if (k != index)
+                c[j++] = static_cast<u32>(std::nearbyint(sml::clamp(v[k] * sign * scale + bias, static_cast<T>(0), range)));
+        }
+
+        return index;
+    }
+
+    template<u32 Bits, typename T>
+    SML_NO_DISCARD inline quat<T> decodesmallestthree(u32 index, const u32 (&c)[3]) noexcept
+    {
+        constexpr T range = static_cast<T>((1u << Bits) - 2);
+        const T scale = static_cast<T>(1.41421356237309504880) / range;
+        const T bias = static_cast<T>(0.70710678118654752440);
+
+        T v[4];
+        T sum = 0;
+
+        for (u32 k = 0, j = 0; k < 4; k++)
+        {
+            if (k != index)
+            {
+                v[k] = static_cast<T>(c[j++]) * scale - bias;
+                sum += v[k] * v[k];
+            }
+        }
+
+        v[index] = sml::sqrt(sml::max(static_cast<T>(1) - sum, static_cast<T>(0)));
+
+        return quat<T>(v[0], v[1], v[2], v[3]);
+    }
+
+    // Eight wide smallest three on x, y, z and w registers, index and the three stored components are
+    // returned as 32 bit integers
+    template<u32 Bits>
+    inline void encodesmallestthree(__m256 x, __m256 y, __m256 z, __m256 w, __m256i& index, __m256i& a, __m256i& b, __m256i& c) noexcept
+    {
+        constexpr f32 range = static_cast<f32>((1u << Bits) - 2);
+        __m256 signmask = _mm256_set1_ps(-0.0f);
+
+        __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_add_ps(_mm256_mul_ps(z, z), _mm256_mul_ps(w, w))));
+        x = _mm256_div_ps(x, length);
+        y = _mm256_div_ps(y, length);
+        z = _mm256_div_ps(z, length);
+        w = _mm256_div_ps(w, length);
+
+        __m256 ax = _mm256_andnot_ps(signmask, x);
+        __m256 ay = _mm256_andnot_ps(signmask, y);
+        __m256 az = _mm256_andnot_ps(signmask, z);
+        __m256 aw = _mm256_andnot_ps(signmask, w);
+        __m256 largest = _mm256_max_ps(_mm256_max_ps(ax, ay), _mm256_max_ps(az, aw));
+
+        // Lowest index wins ties like the scalar version
+        __m256 is0 = _mm256_cmp_ps(ax, largest, _CMP_EQ_OQ);
+        __m256 is1 = _mm256_andnot_ps(is0, _mm256_cmp_ps(ay, largest, _CMP_EQ_OQ));
+        __m256 le1 = _mm256_or_ps(is0, is1);
+        __m256 le2 = _mm256_or_ps(le1, _mm256_cmp_ps(az, largest, _CMP_EQ_OQ));
+
+        __m256 idx = simd::select(le2, _mm256_set1_ps(3.0f), _mm256_set1_ps(2.0f));
+        idx = simd::select(le1, idx, _mm256_set1_ps(1.0f));
+        idx = simd::select(is0, idx, _mm256_setzero_ps());
+
+        __m256 dropped = simd::select(is0, simd::select(le1, simd::select(le2, w, z), y), x);
+        __m256 sign = _mm256_and_ps(dropped, signmask);
+
+        __m256 scale = _mm256_set1_ps(0.70710678118654752440f * range);
+        __m256 bias = _mm256_set1_ps(0.5f * range);
+        __m256 upper = _mm256_set1_ps(range);
+        __m256 zero = _mm256_setzero_ps();
+
+        __m256 fa = _mm256_xor_ps(simd::select(is0, x, y), sign);
+        __m256 fb = _mm256_xor_ps(simd::select(le1, y, z), sign);
+        __m256 fc = _mm256_xor_ps(simd::select(le2, z, w), sign);
+
+        index = _mm256_cvtps_epi32(idx);
+        a = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(_mm256_add_ps(_mm256_mul_ps(fa, scale), bias), zero), upper));
+        b = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(_mm256_add_ps(_mm256_mul_ps(fb, scale), bias), zero), upper));
+        c = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(_mm256_add_ps(_mm256_mul_ps(fc, scale), bias), zero), upper));
+    }
+
+    template<u32 Bits>
+    inline void decodesmallestthree(__m256i index, __m256i a, __m256i b, __m256i c, __m256& x, __m256& y, __m256& z, __m256& w) noexcept
+    {
+        constexpr f32 range = static_cast<f32>((1u << Bits) - 2);
+        __m256 scale = _mm256_set1_ps(1.41421356237309504880f / range);
+        __m256 bias = _mm256_set1_ps(0.70710678118654752440f);
+
+        __m256 idx = _mm256_cvtepi32_ps(index);
+        __m256 fa = _mm256_sub_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(a), scale), bias);
+        __m256 fb = _mm256_sub_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(b), scale), bias);
+        __m256 fc = _mm256_sub_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(c), scale), bias);
+
+        __m256 sum = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(fa, fa), _mm256_mul_ps(fb, fb)), _mm256_mul_ps(fc, fc));
+        __m256 dropped = _mm256_sqrt_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), sum), _mm256_setzero_ps()));
+
+        __m256 is0 = _mm256_cmp_ps(idx, _mm256_setzero_ps(), _CMP_EQ_OQ);
+        __m256 is1 = _mm256_cmp_ps(idx, _mm256_set1_ps(1.0f), _CMP_EQ_OQ);
+        __m256 is2 = _mm256_cmp_ps(idx, _mm256_set1_ps(2.0f), _CMP_EQ_OQ);
+        __m256 is3 = _mm256_cmp_ps(idx, _mm256_set1_ps(3.0f), _CMP_EQ_OQ);
+
+        x = simd::select(is0, fa, dropped);
+        y = simd::select(is0, simd::select(is1, fb, dropped), fa);
+        z = simd::select(_mm256_or_ps(is0, is1), simd::select(is2, fc, dropped), fb);
+        w = simd::select(is3, fc, dropped);
+    }
+
+    // Eight quaternions as x, y, z and w registers
+    inline void loadquats(const quat<f32>* src, __m256& x, __m256& y, __m256& z, __m256& w) noexcept
+    {
+        x = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(src[0].v.v)), simd::load(src[4].v.v), 1);
+        y = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(src[1].v.v)), simd::load(src[5].v.v), 1);
+        z = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(src[2].v.v)), simd::load(src[6].v.v), 1);
+        w = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(src[3].v.v)), simd::load(src[7].v.v), 1);
+
+        simd::transpose(x, y, z, w);
+    }
+
+    inline void storequats(quat<f32>* dst, __m256 x, __m256 y, __m256 z, __m256 w) noexcept
+    {
+        simd::transpose(x, y, z, w);
+
+        simd::store(dst[0].v.v, _mm256_castps256_ps128(x));
+        simd::store(dst[1].v.v, _mm256_castps256_ps128(y));
+        simd::store(dst[2].v.v, _mm256_castps256_ps128(z));
+        simd::store(dst[3].v.v, _mm256_castps256_ps128(w));
+        simd::store(dst[4].v.v, _mm256_extractf128_ps(x, 1));
+        simd::store(dst[5].v.v, _mm256_extractf128_ps(y, 1));
+        simd::store(dst[6].v.v, _mm256_extractf128_ps(z, 1));
+        simd::store(dst[7].v.v, _mm256_extractf128_ps(w, 1));
+    }
+
+    // 32 bit smallest three, 2 bit index and 3 x 10 bit components. Worst case error is about 0.25 degrees.
+    struct quat32
+    {
+        constexpr quat32() noexcept : bits(0)
+        {
+        }
+
+        template<typename T>
+        quat32(const quat<T>& q) noexcept
+        {
+            u32 c[3];
+            u32 index = encodesmallestthree<10>(q, c);
+
+            bits = (index << 30) | (c[0] << 20) | (c[1] << 10) | c[2];
+        }
+
+        template<typename T>
+        operator quat<T>() const noexcept
+        {
+            const u32 c[3] = { (bits >> 20) & 0x3FF, (bits >> 10) & 0x3FF, bits & 0x3FF };
+
+            return decodesmallestthree<10, T>(bits >> 30, c);
+        }
+
+        u32 bits;
+    };
+
+    // 48 bit smallest three, 3 x 15 bit components with the index in the top bits of the first two.
+    // Worst case error is about 0.008 degrees.
+    struct quat48
+    {
+        constexpr quat48() noexcept : bits{ 0, 0, 0 }
+        {
+        }
+
+        template<typename T>
+        quat48(const quat<T>& q) noexcept
+        {
+            u32 c[3];
+            u32 index = encodesmallestthree<15>(q, c);
+
+            bits[0] = static_cast<u16>(c[0] | ((index & 1) << 15));
+            bits[1] = static_cast<u16>(c[1] | ((index >> 1) << 15));
+            bits[2] = static_cast<u16>(c[2]);
+        }
+
+        template<typename T>
+        operator quat<T>() const noexcept
+        {
+            const u32 c[3] = { bits[0] & 0x7FFFu, bits[1] & 0x7FFFu, bits[2] & 0x7FFFu };
+
+            return decodesmallestthree<15, T>((bits[0] >> 15) | ((bits[1] >> 15) << 1), c);
+        }
+
+        u16 bits[3];
+    };
+
+    static_assert(sizeof(quat48) == 6, "quat48 must not be padded");
+
+    template<typename T>
+    inline void pack(const quat<T>* src, quat32* dst, size_t count) noexcept
+    {
+        size_t i = 0;
+
+        if constexpr (std::is_same<T, f32>::value)
+        {
+            for (; i + 8 <= count; i += 8)
+            {
+                __m256 x, y, z, w;
+                __m256i index, a, b, c;
+
+                loadquats(src + i, x, y, z, w);
+                encodesmallestthree<10>(x, y, z, w, index, a, b, c);
+
+                for (s32 h = 0; h < 2; h++)
+                {
+                    __m128i hindex = h ? _mm256_extractf128_si256(index, 1) : _mm256_castsi256_si128(index);
+                    __m128i ha = h ? _mm256_extractf128_si256(a, 1) : _mm256_castsi256_si128(a);
+                    __m128i hb = h ? _mm256_extractf128_si256(b, 1) : _mm256_castsi256_si128(b);
+                    __m128i hc = h ? _mm256_extractf128_si256(c, 1) : _mm256_castsi256_si128(c);
+
+                    __m128i bits = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(hindex, 30), _mm_slli_epi32(ha, 20)), _mm_or_si128(_mm_slli_epi32(hb, 10), hc));
+
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 4 * h), bits);
+                }
+            }
+        }
+
+        for (; i < count; i++)
+        {
+            dst[i] = src[i];
+        }
+    }
+
+    template<typename T>
+    inline void unpack(const quat32* src, quat<T>* dst, size_t count) noexcept
+    {
+        size_t i = 0;
+
+        if constexpr (std::is_same<T, f32>::value)
+        {
+            __m128i mask = _mm_set1_epi32(0x3FF);
+
+            for (; i + 8 <= count; i += 8)
+            {
+                __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+                __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 4));
+
+                __m256i index = _mm256_setr_m128i(_mm_srli_epi32(lo, 30), _mm_srli_epi32(hi, 30));
+                __m256i a = _mm256_setr_m128i(_mm_and_si128(_mm_srli_epi32(lo, 20), mask), _mm_and_si128(_mm_srli_epi32(hi, 20), mask));
+                __m256i b = _mm256_setr_m128i(_mm_and_si128(_mm_srli_epi32(lo, 10), mask), _mm_and_si128(_mm_srli_epi32(hi, 10), mask));
+                __m256i c = _mm256_setr_m128i(_mm_and_si128(lo, mask), _mm_and_si128(hi, mask));
+
+                __m256 x, y, z, w;
+                decodesmallestthree<10>(index, a, b, c, x, y, z, w);
+                storequats(dst + i, x, y, z, w);
+            }
+        }
+
+        for (; i < count; i++)
+        {
+            dst[i] = src[i];
+        }
+    }
+
+    // Byte shuffles between three registers of eight u16 lanes a, b and c and the 48 byte stream a0 b0 c0 a1 b1 c1 ...
+    struct interleave3
+    {
+        interleave3() noexcept
+        {
+            for (u32 r = 0; r < 3; r++)
+            {
+                for (u32 s = 0; s < 3; s++)
+                {
+                    alignas(16) s8 pack[16];
+                    alignas(16) s8 unpack[16];
+
+                    for (u32 j = 0; j < 16; j++)
+                    {
+                        u32 lane = (r * 16 + j) / 2;
+                        pack[j] = lane % 3 == s ? static_cast<s8>((lane / 3) * 2 + (j & 1)) : -128;
+
+                        u32 offset = ((j / 2) * 3 + s) * 2 + (j & 1);
+                        unpack[j] = offset / 16 == r ? static_cast<s8>(offset % 16) : -128;
+                    }
+
+                    packmask[r][s] = _mm_load_si128(reinterpret_cast<const __m128i*>(pack));
+                    unpackmask[s][r] = _mm_load_si128(reinterpret_cast<const __m128i*>(unpack));
+                }
+            }
+        }
+
+        inline void interleave(__m128i a, __m128i b, __m128i c, u8* dst) const noexcept
+        {
+            for (u32 r = 0; r < 3; r++)
+            {
+                __m128i res = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, packmask[r][0]), _mm_shuffle_epi8(b, packmask[r][1])), _mm_shuffle_epi8(c, packmask[r][2]));
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 16 * r), res);
+            }
+        }
+
+        inline void deinterleave(const u8* src, __m128i& a, __m128i& b, __m128i& c) const noexcept
+        {
+            __m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 0));
+            __m128i r1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+            __m128i r2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32));
+            __m128i* out[3] = { &a, &b, &c };
+
+            for (u32 s = 0; s < 3; s++)
+            {
+                *out[s] = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r0, unpackmask[s][0]), _mm_shuffle_epi8(r1, unpackmask[s][1])), _mm_shuffle_epi8(r2, unpackmask[s][2]));
+            }
+        }
+
+        __m128i packmask[3][3];
+        __m128i unpackmask[3][3];
+    };
+
+    template<typename T>
+    inline void pack(const quat<T>* src, quat48* dst, size_t count) noexcept
+    {
+        size_t i = 0;
+
+        if constexpr (std::is_same<T, f32>::value)
+        {
+            interleave3 shuffles;
+
+            for (; i + 8 <= count; i += 8)
+            {
+                __m256 x, y, z, w;
+                __m256i index, a, b, c;
+
+                loadquats(src + i, x, y, z, w);
+                encodesmallestthree<15>(x, y, z, w, index, a, b, c);
+
+                __m128i index0 = _mm_slli_epi32(_mm_and_si128(_mm256_castsi256_si128(index), _mm_set1_epi32(1)), 15);
+                __m128i index1 = _mm_slli_epi32(_mm_and_si128(_mm256_extractf128_si256(index, 1), _mm_set1_epi32(1)), 15);
+                __m128i index2 = _mm_slli_epi32(_mm_srli_epi32(_mm256_castsi256_si128(index), 1), 15);
+                __m128i index3 = _mm_slli_epi32(_mm_srli_epi32(_mm256_extractf128_si256(index, 1), 1), 15);
+
+                __m128i ha = _mm_packus_epi32(_mm_or_si128(_mm256_castsi256_si128(a), index0), _mm_or_si128(_mm256_extractf128_si256(a, 1), index1));
+                __m128i hb = _mm_packus_epi32(_mm_or_si128(_mm256_castsi256_si128(b), index2), _mm_or_si128(_mm256_extractf128_si256(b, 1), index3));
+                __m128i hc = _mm_packus_epi32(_mm256_castsi256_si128(c), _mm256_extractf128_si256(c, 1));
+
+                shuffles.interleave(ha, hb, hc, reinterpret_cast<u8*>(dst + i));
+            }
+        }
+
+        for (; i < count; i++)
+        {
+            dst[i] = src[i];
+        }
+    }
+
+    template<typename T>
+    inline void unpack(const quat48* src, quat<T>* dst, size_t count) noexcept
+    {
+        size_t i = 0;
+
+        if constexpr (std::is_same<T, f32>::value)
+        {
+            interleave3 shuffles;
+            __m128i mask = _mm_set1_epi32(0x7FFF);
+
+            for (; i + 8 <= count; i += 8)
+            {
+                __m128i ha, hb, hc;
+                shuffles.deinterleave(reinterpret_cast<const u8*>(src + i), ha, hb, hc);
+
+                __m128i alo = _mm_cvtepu16_epi32(ha), ahi = _mm_cvtepu16_epi32(_mm_srli_si128(ha, 8));
+                __m128i blo = _mm_cvtepu16_epi32(hb), bhi = _mm_cvtepu16_epi32(_mm_srli_si128(hb, 8));
+                __m128i clo = _mm_cvtepu16_epi32(hc), chi = _mm_cvtepu16_epi32(_mm_srli_si128(hc, 8));
+
+                __m128i indexlo = _mm_or_si128(_mm_srli_epi32(alo, 15), _mm_slli_epi32(_mm_srli_epi32(blo, 15), 1));
+                __m128i indexhi = _mm_or_si128(_mm_srli_epi32(ahi, 15), _mm_slli_epi32(_mm_srli_epi32(bhi, 15), 1));
+
+                __m256i index = _mm256_setr_m128i(indexlo, indexhi);
+                __m256i a = _mm256_setr_m128i(_mm_and_si128(alo, mask), _mm_and_si128(ahi, mask));
+                __m256i b = _mm256_setr_m128i(_mm_and_si128(blo, mask), _mm_and_si128(bhi, mask));
+                __m256i c = _mm256_setr_m128i(_mm_and_si128(clo, mask), _mm_and_si128(chi, mask));
+
+                __m256 x, y, z, w;
+                decodesmallestthree<15>(index, a, b, c, x, y, z, w);
+                storequats(dst + i, x, y, z, w);
+            }
+        }
+
+        for (; i < count; i++)
+        {
+            dst[i] = src[i];
+        }
+    }
+} // namespace sml
+
+#endif // sml_quantize_h__
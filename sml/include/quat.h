@@ -345,9 +345,8 @@ namespace sml
                 quat q = identity();
 
                 angle *= static_cast<T>(0.5);
-                axis.normalize();
 
-                q.xyz = axis * sml::sin(angle);
+                q.xyz = axis.normalized() * sml::sin(angle);
                 q.w = sml::cos(angle);
 
                 return q.normalized();
@@ -355,8 +354,35 @@ namespace sml
 
             SML_NO_DISCARD inline static constexpr quat frommatrix3(const mat3<T>& matrix)
             {
-                // TODO (Roderick): Implement this
-                return quat();
+                // Shepperd's method, the largest of w, x, y and z is taken from the diagonal to stay well conditioned
+                const T one = static_cast<T>(1);
+                const T quarter = static_cast<T>(0.25);
+                T trace = matrix.m00 + matrix.m11 + matrix.m22;
+
+                if (trace > static_cast<T>(0))
+                {
+                    T s = sml::sqrt(trace + one) * static_cast<T>(2);
+
+                    return quat((matrix.m12 - matrix.m21) / s, (matrix.m20 - matrix.m02) / s, (matrix.m01 - matrix.m10) / s, quarter * s);
+                }
+
+                if (matrix.m00 > matrix.m11 && matrix.m00 > matrix.m22)
+                {
+                    T s = sml::sqrt(one + matrix.m00 - matrix.m11 - matrix.m22) * static_cast<T>(2);
+
+                    return quat(quarter * s, (matrix.m10 + matrix.m01) / s, (matrix.m20 + matrix.m02) / s, (matrix.m12 - matrix.m21) / s);
+                }
+
+                if (matrix.m11 > matrix.m22)
+                {
+                    T s = sml::sqrt(one + matrix.m11 - matrix.m00 - matrix.m22) * static_cast<T>(2);
+
+                    return quat((matrix.m10 + matrix.m01) / s, quarter * s, (matrix.m21 + matrix.m12) / s, (matrix.m20 - matrix.m02) / s);
+                }
+
+                T s = sml::sqrt(one + matrix.m22 - matrix.m00 - matrix.m11) * static_cast<T>(2);
+
+                return quat((matrix.m20 + matrix.m02) / s, (matrix.m21 + matrix.m12) / s, quarter * s, (matrix.m01 - matrix.m10) / s);
             }
 
             SML_NO_DISCARD inline static constexpr quat slerp(const quat<T>& a, const quat<T>& b, T blend) noexcept
@@ -0,0 +1,221 @@
+#ifndef sml_ray_h__
+#define sml_ray_h__
+
+/* ray.h -- ray implementation of the 'Simple Math Library'
+  Copyright (C) 2020 Roderick Griffioen
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <limits>
+#include <immintrin.h>
+
+#include "smltypes.h"
+#include "common.h"
+#include "simd.h"
+#include "vec3.h"
+#include "aabb.h"
+
+namespace sml
+{
+    // Slab tests pick the near and far plane of every axis from the sign of the inverse direction, so
+    // empty boxes never hit. Axis parallel rays get an infinite inverse direction, a ray lying exactly
+    // on a face plane produces 0 * inf = NaN there and the min/max operand order drops that plane.
+    template<typename T>
+    class alignas(simdalign<T>::value) ray
+    {
+        public:
+            ray() noexcept : ray(vec3<T>(static_cast<T>(0)), vec3<T>(0, 0, 1))
+            {
+            }
+
+            ray(const vec3<T>& origin, const vec3<T>& direction) noexcept : origin(origin), direction(direction),
+                invdirection(inverse(direction.x), inverse(direction.y), inverse(direction.z))
+            {
+            }
+
+            // Operations
+            SML_NO_DISCARD inline constexpr vec3<T> at(T t) const noexcept
+            {
+                return origin + direction * t;
+            }
+
+            SML_NO_DISCARD inline bool intersects(const aabb<T>& box) const noexcept
+            {
+                T entry, exit;
+
+                return intersects(box, static_cast<T>(0), std::numeric_limits<T>::infinity(), entry, exit);
+            }
+
+            // Clips [tmin, tmax] against the box, entry and exit receive the clipped interval
+            SML_NO_DISCARD inline bool intersects(const aabb<T>& box, T tmin, T tmax, T& entry, T& exit) const noexcept
+            {
+                if constexpr (std::is_same<T, f32>::value)
+                {
+                    __m128 o = simd::load(origin.v);
+                    __m128 inv = simd::load(invdirection.v);
+                    __m128 lo = simd::load(box.min.v);
+                    __m128 hi = simd::load(box.max.v);
+
+                    __m128 tnear = _mm_mul_ps(_mm_sub_ps(_mm_blendv_ps(lo, hi, inv), o), inv);
+                    __m128 tfar = _mm_mul_ps(_mm_sub_ps(_mm_blendv_ps(hi, lo, inv), o), inv);
+
+                    __m128 e = _mm_max_ps(tnear, _mm_set1_ps(tmin));
+                    __m128 x = _mm_min_ps(tfar, _mm_set1_ps(tmax));
+
+                    e = _mm_max_ps(e, simd::shuffle<1, 2, 0, 3>(e));
+                    e = _mm_max_ps(e, simd::shuffle<2, 0, 1, 3>(e));
+                    x = _mm_min_ps(x, simd::shuffle<1, 2, 0, 3>(x));
+                    x = _mm_min_ps(x, simd::shuffle<2, 0, 1, 3>(x));
+
+                    entry = _mm_cvtss_f32(e);
+                    exit = _mm_cvtss_f32(x);
+
+                    return entry <= exit;
+                }
+
+                if constexpr (std::is_same<T, f64>::value)
+                {
+                    __m256d o = simd::load(origin.v);
+                    __m256d inv = simd::load(invdirection.v);
+                    __m256d lo = simd::load(box.min.v);
+                    __m256d hi = simd::load(box.max.v);
+
+                    __m256d tnear = _mm256_mul_pd(_mm256_sub_pd(_mm256_blendv_pd(lo, hi, inv), o), inv);
+                    __m256d tfar = _mm256_mul_pd(_mm256_sub_pd(_mm256_blendv_pd(hi, lo, inv), o), inv);
+
+                    __m256d e = _mm256_max_pd(tnear, _mm256_set1_pd(tmin));
+                    __m256d x = _mm256_min_pd(tfar, _mm256_set1_pd(tmax));
+
+                    __m128d exy = _mm256_castpd256_pd128(e);
+                    __m128d xxy = _mm256_castpd256_pd128(x);
+
+                    __m128d emax = _mm_max_sd(_mm_max_sd(exy, _mm_unpackhi_pd(exy, exy)), _mm256_extractf128_pd(e, 1));
+                    __m128d xmin = _mm_min_sd(_mm_min_sd(xxy, _mm_unpackhi_pd(xxy, xxy)), _mm256_extractf128_pd(x, 1));
+
+                    entry = _mm_cvtsd_f64(emax);
+                    exit = _mm_cvtsd_f64(xmin);
+
+                    return entry <= exit;
+                }
+
+                entry = tmin;
+                exit = tmax;
+
+                for (s32 i = 0; i < 3; i++)
+                {
+                    bool negative = invdirection.v[i] < static_cast<T>(0);
+                    T tnear = ((negative ? box.max.v[i] : box.min.v[i]) - origin.v[i]) * invdirection.v[i];
+                    T tfar = ((negative ? box.min.v[i] : box.max.v[i]) - origin.v[i]) * invdirection.v[i];
+
+                    entry = sml::max(tnear, entry);
+                    exit = sml::min(tfar, exit);
+                }
+
+                return entry <= exit;
+            }
+
+            // Data
+            vec3<T> origin;
+            vec3<T> direction;
+            vec3<T> invdirection;
+
+        private:
+            SML_NO_DISCARD static inline T inverse(T d) noexcept
+            {
+                return d == static_cast<T>(0) ? std::numeric_limits<T>::infinity() : static_cast<T>(1) / d;
+            }
+    };
+
+    typedef ray<f32> fray;
+    typedef ray<f64> dray;
+
+    // Eight f32 rays in SoA layout
+    class alignas(32) ray8
+    {
+        public:
+            explicit ray8(const ray<f32>* rays) noexcept
+            {
+                __m256 r0 = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(rays[0].origin.v)), simd::load(rays[4].origin.v), 1);
+                __m256 r1 = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(rays[1].origin.v)), simd::load(rays[5].origin.v), 1);
+                __m256 r2 = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(rays[2].origin.v)), simd::load(rays[6].origin.v), 1);
+                __m256 r3 = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(rays[3].origin.v)), simd::load(rays[7].origin.v), 1);
+
+                simd::transpose(r0, r1, r2, r3);
+
+                ox = r0;
+                oy = r1;
+                oz = r2;
+
+                r0 = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(rays[0].invdirection.v)), simd::load(rays[4].invdirection.v), 1);
+                r1 = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(rays[1].invdirection.v)), simd::load(rays[5].invdirection.v), 1);
+                r2 = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(rays[2].invdirection.v)), simd::load(rays[6].invdirection.v), 1);
+                r3 = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(rays[3].invdirection.v)), simd::load(rays[7].invdirection.v), 1);
+
+                simd::transpose(r0, r1, r2, r3);
+
+                ix = r0;
+                iy = r1;
+                iz = r2;
+            }
+
+            // Data
+            __m256 ox, oy, oz;
+            __m256 ix, iy, iz;
+    };
+
+    // One ray against eight boxes, bit i of the result is set when box i is hit within [tmin, tmax]
+    inline u32 intersects(const ray<f32>& r, const aabb8& boxes, f32 tmin, f32 tmax, __m256& entry, __m256& exit) noexcept
+    {
+        // The near plane of every axis is the same for all boxes, select it once
+        bool nx = r.invdirection.x < 0.0f, ny = r.invdirection.y < 0.0f, nz = r.invdirection.z < 0.0f;
+
+        __m256 ox = _mm256_set1_ps(r.origin.x), oy = _mm256_set1_ps(r.origin.y), oz = _mm256_set1_ps(r.origin.z);
+        __m256 ix = _mm256_set1_ps(r.invdirection.x), iy = _mm256_set1_ps(r.invdirection.y), iz = _mm256_set1_ps(r.invdirection.z);
+
+        __m256 nearx = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(nx ? boxes.maxx : boxes.minx), ox), ix);
+        __m256 neary = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(ny ? boxes.maxy : boxes.miny), oy), iy);
+        __m256 nearz = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(nz ? boxes.maxz : boxes.minz), oz), iz);
+        __m256 farx = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(nx ? boxes.minx : boxes.maxx), ox), ix);
+        __m256 fary = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(ny ? boxes.miny : boxes.maxy), oy), iy);
+        __m256 farz = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(nz ? boxes.minz : boxes.maxz), oz), iz);
+
+        entry = _mm256_max_ps(nearz, _mm256_max_ps(neary, _mm256_max_ps(nearx, _mm256_set1_ps(tmin))));
+        exit = _mm256_min_ps(farz, _mm256_min_ps(fary, _mm256_min_ps(farx, _mm256_set1_ps(tmax))));
+
+        return static_cast<u32>(_mm256_movemask_ps(_mm256_cmp_ps(entry, exit, _CMP_LE_OQ)));
+    }
+
+    // Eight rays against one box, bit i of the result is set when ray i hits the box within [tmin, tmax]
+    inline u32 intersects(const ray8& rays, const aabb<f32>& box, __m256 tmin, __m256 tmax, __m256& entry, __m256& exit) noexcept
+    {
+        __m256 minx = _mm256_set1_ps(box.min.x), miny = _mm256_set1_ps(box.min.y), minz = _mm256_set1_ps(box.min.z);
+        __m256 maxx = _mm256_set1_ps(box.max.x), maxy = _mm256_set1_ps(box.max.y), maxz = _mm256_set1_ps(box.max.z);
+
+        __m256 nearx = _mm256_mul_ps(_mm256_sub_ps(_mm256_blendv_ps(minx, maxx, rays.ix), rays.ox), rays.ix);
+        __m256 neary = _mm256_mul_ps(_mm256_sub_ps(_mm256_blendv_ps(miny, maxy, rays.iy), rays.oy), rays.iy);
+        __m256 nearz = _mm256_mul_ps(_mm256_sub_ps(_mm256_blendv_ps(minz, maxz, rays.iz), rays.oz), rays.iz);
+        __m256 farx = _mm256_mul_ps(_mm256_sub_ps(_mm256_blendv_ps(maxx, minx, rays.ix), rays.ox), rays.ix);
+        __m256 fary = _mm256_mul_ps(_mm256_sub_ps(_mm256_blendv_ps(maxy, miny, rays.iy), rays.oy), rays.iy);
+        __m256 farz = _mm256_mul_ps(_mm256_sub_ps(_mm256_blendv_ps(maxz, minz, rays.iz), rays.oz), rays.iz);
+
+        entry = _mm256_max_ps(nearz, _mm256_max_ps(neary, _mm256_max_ps(nearx, tmin)));
+        exit = _mm256_min_ps(farz, _mm256_min_ps(fary, _mm256_min_ps(farx, tmax)));
+
+        return static_cast<u32>(_mm256_movemask_ps(_mm256_cmp_ps(entry, exit, _CMP_LE_OQ)));
+    }
+} // namespace sml
+
+#endif // sml_ray_h__
@@ -0,0 +1,156 @@
+#ifndef sml_simd_h__
+#define sml_simd_h__
+
+/* simd.h -- simd register helpers of the 'Simple Math Library'
+  Copyright (C) 2020 Roderick Griffioen
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <immintrin.h>
+
+#include "smltypes.h"
+
+namespace sml
+{
+    namespace simd
+    {
+        // Aligned loads and stores, SML_DEBUG builds check the alignment the instruction faults on
+        inline __m128 load(const f32* p) noexcept
+        {
+            SML_ASSERT_ALIGNED(p, 16);
+
+            return _mm_load_ps(p);
+        }
+
+        inline __m256d load(const f64* p) noexcept
+        {
+            SML_ASSERT_ALIGNED(p, 32);
+
+            return _mm256_load_pd(p);
+        }
+
+        inline __m128d load2(const f64* p) noexcept
+        {
+            SML_ASSERT_ALIGNED(p, 16);
+
+            return _mm_load_pd(p);
+        }
+
+        inline void store(f32* p, __m128 a) noexcept
+        {
+            SML_ASSERT_ALIGNED(p, 16);
+
+            _mm_store_ps(p, a);
+        }
+
+        inline void store(f64* p, __m256d a) noexcept
+        {
+            SML_ASSERT_ALIGNED(p, 32);
+
+            _mm256_store_pd(p, a);
+        }
+
+        inline void store2(f64* p, __m128d a) noexcept
+        {
+            SML_ASSERT_ALIGNED(p, 16);
+
+            _mm_store_pd(p, a);
+        }
+
+        // Lane permutes, lane i of the result is taken from lane Ii of the source
+        template<u32 I0, u32 I1>
+        inline __m128d shuffle(__m128d a) noexcept
+        {
+            static_assert(I0 < 2 && I1 < 2, "lane index out of range");
+
+            return _mm_shuffle_pd(a, a, I0 | (I1 << 1));
+        }
+
+        template<u32 I0, u32 I1, u32 I2, u32 I3>
+        inline __m128 shuffle(__m128 a) noexcept
+        {
+            static_assert(I0 < 4 && I1 < 4 && I2 < 4 && I3 < 4, "lane index out of range");
+
+            return _mm_shuffle_ps(a, a, _MM_SHUFFLE(I3, I2, I1, I0));
+        }
+
+        template<u32 I0, u32 I1, u32 I2, u32 I3>
+        inline __m256d shuffle(__m256d a) noexcept
+        {
+            static_assert(I0 < 4 && I1 < 4 && I2 < 4 && I3 < 4, "lane index out of range");
+
+#ifdef __AVX2__
+            return _mm256_permute4x64_pd(a, _MM_SHUFFLE(I3, I2, I1, I0));
+#else
+            // AVX only permutes within 128 bit lanes, so pick from both halves and blend
+            constexpr s32 select = (I0 & 1) | ((I1 & 1) << 1) | ((I2 & 1) << 2) | ((I3 & 1) << 3);
+            constexpr s32 high = (I0 >> 1) | ((I1 >> 1) << 1) | ((I2 >> 1) << 2) | ((I3 >> 1) << 3);
+
+            __m256d lo = _mm256_permute2f128_pd(a, a, 0x00);
+            __m256d hi = _mm256_permute2f128_pd(a, a, 0x11);
+
+            return _mm256_blend_pd(_mm256_permute_pd(lo, select), _mm256_permute_pd(hi, select), high);
+#endif
+        }
+
+        // 4x4 transposes, the 256 bit float version transposes both 128 bit halves independently
+        // so eight xyzw rows r0..r3 | r4..r7 become x0..x3 | x4..x7, y0..y3 | y4..y7 and so on
+        inline void transpose(__m128& r0, __m128& r1, __m128& r2, __m128& r3) noexcept
+        {
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        }
+
+        inline void transpose(__m256& r0, __m256& r1, __m256& r2, __m256& r3) noexcept
+        {
+            __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+            __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+            __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+            __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+
+            r0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+            r1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+            r2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+            r3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+        }
+
+        inline void transpose(__m256d& r0, __m256d& r1, __m256d& r2, __m256d& r3) noexcept
+        {
+            __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+            __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+            __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+            __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+
+            r0 = _mm256_permute2f128_pd(t0, t2, 0x20);
+            r1 = _mm256_permute2f128_pd(t1, t3, 0x20);
+            r2 = _mm256_permute2f128_pd(t0, t2, 0x31);
+            r3 = _mm256_permute2f128_pd(t1, t3, 0x31);
+        }
+
+        // Lanes of b where mask is set, of a elsewhere, for the all ones / all zeros lanes of compares.
+        // Bitwise, because GCC turns blendv on compare masks into per lane branches when only AVX is enabled.
+        inline __m256 select(__m256 mask, __m256 a, __m256 b) noexcept
+        {
+            return _mm256_or_ps(_mm256_and_ps(mask, b), _mm256_andnot_ps(mask, a));
+        }
+
+        // NaN lanes of v clamp to lo
+        inline __m256 clamp(__m256 v, __m256 lo, __m256 hi) noexcept
+        {
+            return _mm256_min_ps(_mm256_max_ps(v, lo), hi);
+        }
+    } // namespace simd
+} // namespace sml
+
+#endif // sml_simd_h__
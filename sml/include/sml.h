@@ -21,15 +21,45 @@
 #include <smltypes.h>
 #include <config.h>
 #include <common.h>
+#include <simd.h>
 
 #include <vec2.h>
 #include <vec3.h>
 #include <vec4.h>
+#include <swizzle.h>
 
 #include <mat2.h>
 #include <mat3.h>
 #include <mat4.h>
+#include <mat.h>
 
 #include <quat.h>
 
+#include <unaligned.h>
+#include <packed.h>
+#include <half.h>
+#include <quantize.h>
+
+#include <aabb.h>
+#include <sphere.h>
+#include <frustum.h>
+#include <ray.h>
+#include <obb.h>
+#include <triangle.h>
+
+#include <parallel.h>
+#include <morton.h>
+#include <bvh.h>
+#include <sweepandprune.h>
+#include <hashgrid.h>
+#include <kdtree.h>
+#include <octree.h>
+#include <gjk.h>
+#include <vec3x8.h>
+#include <mat3x8.h>
+#include <svd.h>
+#include <closest.h>
+#include <contacts.h>
+#include <strided.h>
+
 #endif // sml_h__
\ No newline at end of file
@@ -18,6 +18,7 @@
   3. This notice may not be removed or altered from any source distribution.
 */
 
+#include <cassert>
 #include <cstdint>
 #include <type_traits>
 
@@ -36,6 +37,14 @@ typedef double f64;
 
 #define SML_NO_DISCARD [[nodiscard]]
 
+#ifdef SML_DEBUG
+#define SML_ASSERT(condition) assert(condition)
+#else
+#define SML_ASSERT(condition)
+#endif
+
+#define SML_ASSERT_ALIGNED(pointer, alignment) SML_ASSERT((reinterpret_cast<uintptr_t>(pointer) & ((alignment) - 1)) == 0)
+
 namespace sml
 {
     template<typename T>
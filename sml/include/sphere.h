@@ -0,0 +1,569 @@
+#ifndef sml_sphere_h__
+#define sml_sphere_h__
+
+/* sphere.h -- bounding sphere implementation of the 'Simple Math Library'
+  Copyright (C) 2020 Roderick Griffioen
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+#include <immintrin.h>
+
+#include "smltypes.h"
+#include "common.h"
+#include "vec3.h"
+#include "vec3x8.h"
+#include "aabb.h"
+#include "parallel.h"
+
+namespace sml
+{
+    // Center and radius packed into four components, so an f32 sphere is one 16 byte load.
+    // A negative radius marks an empty sphere.
+    template<typename T>
+    class alignas(simdalign<T>::value) sphere
+    {
+        public:
+            constexpr sphere() noexcept : x(0), y(0), z(0), radius(static_cast<T>(-1))
+            {
+            }
+
+            constexpr sphere(const vec3<T>& center, T radius) noexcept : x(center.x), y(center.y), z(center.z), radius(radius)
+            {
+            }
+
+            // Operators
+            inline constexpr bool operator == (const sphere& other) const noexcept
+            {
+                return x == other.x && y == other.y && z == other.z && radius == other.radius;
+            }
+
+            inline constexpr bool operator != (const sphere& other) const noexcept
+            {
+                return !(*this == other);
+            }
+
+            // Operations
+            SML_NO_DISCARD inline constexpr bool empty() const noexcept
+            {
+                return radius < static_cast<T>(0);
+            }
+
+            SML_NO_DISCARD inline constexpr vec3<T> center() const noexcept
+            {
+                return vec3<T>(x, y, z);
+            }
+
+            SML_NO_DISCARD inline constexpr bool contains(const vec3<T>& point) const noexcept
+            {
+                return (point - center()).lengthsquared() <= radius * radius && !empty();
+            }
+
+            SML_NO_DISCARD inline constexpr bool overlaps(const sphere& other) const noexcept
+            {
+                vec3<T> d = other.center() - center();
+                T r = radius + other.radius;
+
+                return d.lengthsquared() <= r * r && !empty() && !other.empty();
+            }
+
+            SML_NO_DISCARD inline constexpr aabb<T> bounds() const noexcept
+            {
+                if (empty())
+                    return aabb<T>();
+
+                return aabb<T>(center() - vec3<T>(radius), center() + vec3<T>(radius));
+            }
+
+            // Ritter step, moves the center towards an outside point just far enough to reach it. The
+            // grown sphere contains the old one, so points inside before stay inside.
+            inline constexpr void expand(const vec3<T>& point) noexcept
+            {
+                if (empty())
+                {
+                    *this = sphere(point, static_cast<T>(0));
+                    return;
+                }
+
+                vec3<T> d = point - center();
+                T distancesquared = d.lengthsquared();
+
+                if (distancesquared <= radius * radius)
+                    return;
+
+                T distance = sml::sqrt(distancesquared);
+                T grown = (radius + distance) * static_cast<T>(0.5);
+                vec3<T> c = center() + d * ((grown - radius) / distance);
+
+                x = c.x;
+                y = c.y;
+                z = c.z;
+                radius = grown;
+            }
+
+            // Statics
+            // Smallest sphere around both spheres
+            SML_NO_DISCARD static inline constexpr sphere merge(const sphere& a, const sphere& b) noexcept
+            {
+                if (a.empty())
+                    return b;
+
+                if (b.empty())
+                    return a;
+
+                vec3<T> d = b.center() - a.center();
+                T distance = d.length();
+
+                if (distance + b.radius <= a.radius)
+                    return a;
+
+                if (distance + a.radius <= b.radius)
+                    return b;
+
+                T radius = (distance + a.radius + b.radius) * static_cast<T>(0.5);
+
+                return sphere(a.center() + d * ((radius - a.radius) / distance), radius);
+            }
+
+            // Data
+            T x, y, z, radius;
+    };
+
+    typedef sphere<f32> fsphere;
+    typedef sphere<f64> dsphere;
+
+    namespace detail
+    {
+        // Points with the smallest and largest x, y and z in [begin, end)
+        template<typename T>
+        inline void extremes(const vec3<T>* points, size_t begin, size_t end, vec3<T> lo[3], vec3<T> hi[3]) noexcept
+        {
+            for (s32 a = 0; a < 3; a++)
+            {
+                lo[a] = hi[a] = points[begin];
+            }
+
+            size_t i = begin;
+
+            if constexpr (std::is_same<T, f32>::value)
+            {
+                if (end - begin >= 8)
+                {
+                    // Every lane keeps its own six candidates, the lanes are reduced at the end
+                    vec3x8 first(points + i);
+                    vec3x8 best[6] = { first, first, first, first, first, first };
+                    __m256 key[6] = { first.x, first.y, first.z, first.x, first.y, first.z };
+
+                    for (i += 8; i + 8 <= end; i += 8)
+                    {
+                        vec3x8 p(points + i);
+                        __m256 c[3] = { p.x, p.y, p.z };
+
+                        for (s32 a = 0; a < 3; a++)
+                        {
+                            __m256 less = _mm256_cmp_ps(c[a], key[a], _CMP_LT_OQ);
+                            __m256 greater = _mm256_cmp_ps(c[a], key[a + 3], _CMP_GT_OQ);
+
+                            key[a] = _mm256_min_ps(key[a], c[a]);
+                            key[a + 3] = _mm256_max_ps(key[a + 3], c[a]);
+                            best[a] = vec3x8::select(less, best[a], p);
+                            best[a + 3] = vec3x8::select(greater, best[a + 3], p);
+                        }
+                    }
+
+                    for (s32 lane = 0; lane < 8; lane++)
+                    {
+                        for (s32 a = 0; a < 3; a++)
+                        {
+                            vec3<f32> l = best[a].lane(lane), h = best[a + 3].lane(lane);
+
+                            if (l.v[a] < lo[a].v[a])
+                                lo[a] = l;
+
+                            if (h.v[a] > hi[a].v[a])
+                                hi[a] = h;
+                        }
+                    }
+                }
+            }
+
+            for (; i < end; i++)
+            {
+                for (s32 a = 0; a < 3; a++)
+                {
+                    if (points[i].v[a] < lo[a].v[a])
+                        lo[a] = points[i];
+
+                    if (points[i].v[a] > hi[a].v[a])
+                        hi[a] = points[i];
+                }
+            }
+        }
+
+        // Ritter pass over [begin, end), blocks of eight inside the sphere are skipped with one compare
+        template<typename T>
+        inline void grow(sphere<T>& s, const vec3<T>* points, size_t begin, size_t end) noexcept
+        {
+            size_t i = begin;
+
+            if constexpr (std::is_same<T, f32>::value)
+            {
+                vec3x8 center(s.center());
+                __m256 radiussquared = _mm256_set1_ps(s.radius * s.radius);
+
+                for (; i + 8 <= end; i += 8)
+                {
+                    vec3x8 d = vec3x8(points + i) - center;
+                    u32 mask = static_cast<u32>(_mm256_movemask_ps(_mm256_cmp_ps(d.lengthsquared(), radiussquared, _CMP_GT_OQ)));
+
+                    if (mask == 0)
+                        continue;
+
+                    for (; mask != 0; mask &= mask - 1)
+                    {
+                        s.expand(points[i + lowestbit(mask)]);
+                    }
+
+                    center = vec3x8(s.center());
+                    radiussquared = _mm256_set1_ps(s.radius * s.radius);
+                }
+            }
+
+            for (; i < end; i++)
+            {
+                s.expand(points[i]);
+            }
+        }
+
+        // Squared distance from center to the farthest point in [begin, end), index receives that point
+        template<typename T>
+        inline T farthest(const vec3<T>& center, const vec3<T>* points, size_t begin, size_t end, size_t& index) noexcept
+        {
+            T best = static_cast<T>(-1);
+            size_t i = begin;
+
+            index = begin;
+
+            if constexpr (std::is_same<T, f32>::value)
+            {
+                vec3x8 c(center);
+                __m256 threshold = _mm256_set1_ps(best);
+
+                for (; i + 8 <= end; i += 8)
+                {
+                    __m256 distances = (vec3x8(points + i) - c).lengthsquared();
+                    u32 mask = static_cast<u32>(_mm256_movemask_ps(_mm256_cmp_ps(distances, threshold, _CMP_GT_OQ)));
+
+                    if (mask == 0)
+                        continue;
+
+                    alignas(32) f32 lanes[8];
+                    _mm256_store_ps(lanes, distances);
+
+                    for (; mask != 0; mask &= mask - 1)
+                    {
+                        u32 lane = lowestbit(mask);
+
+                        if (lanes[lane] > best)
+                        {
+                            best = lanes[lane];
+                            index = i + lane;
+                        }
+                    }
+
+                    threshold = _mm256_set1_ps(best);
+                }
+            }
+
+            for (; i < end; i++)
+            {
+                T d = (points[i] - center).lengthsquared();
+
+                if (d > best)
+                {
+                    best = d;
+                    index = i;
+                }
+            }
+
+            return best;
+        }
+
+        template<typename T>
+        inline void parallelextremes(const vec3<T>* points, size_t count, vec3<T> lo[3], vec3<T> hi[3], u32 threads)
+        {
+            std::vector<vec3<T>> scratch(6 * threadcount(threads), points[0]);
+
+            parallelfor(0, count, 65536, [&](size_t begin, size_t end, u32 thread)
+            {
+                extremes(points, begin, end, &scratch[6 * thread], &scratch[6 * thread + 3]);
+            }, threads);
+
+            for (s32 a = 0; a < 3; a++)
+            {
+                lo[a] = scratch[a];
+                hi[a] = scratch[a + 3];
+            }
+
+            for (size_t t = 1; t < scratch.size() / 6; t++)
+            {
+                for (s32 a = 0; a < 3; a++)
+                {
+                    if (scratch[6 * t + a].v[a] < lo[a].v[a])
+                        lo[a] = scratch[6 * t + a];
+
+                    if (scratch[6 * t + a + 3].v[a] > hi[a].v[a])
+                        hi[a] = scratch[6 * t + a + 3];
+                }
+            }
+        }
+
+        // Every chunk grows its own copy, the copies are merged into one sphere around all of them
+        template<typename T>
+        inline sphere<T> parallelgrow(const sphere<T>& s, const vec3<T>* points, size_t count, u32 threads)
+        {
+            std::vector<sphere<T>> scratch(threadcount(threads), sphere<T>());
+
+            parallelfor(0, count, 65536, [&](size_t begin, size_t end, u32 thread)
+            {
+                scratch[thread] = s;
+                grow(scratch[thread], points, begin, end);
+            }, threads);
+
+            sphere<T> res = s;
+            for (const sphere<T>& chunk : scratch)
+            {
+                res = sphere<T>::merge(res, chunk);
+            }
+
+            return res;
+        }
+
+        template<typename T>
+        inline T parallelfarthest(const vec3<T>& center, const vec3<T>* points, size_t count, size_t& index, u32 threads)
+        {
+            std::vector<std::pair<T, size_t>> scratch(threadcount(threads), std::pair<T, size_t>(static_cast<T>(-1), 0));
+
+            parallelfor(0, count, 65536, [&](size_t begin, size_t end, u32 thread)
+            {
+                scratch[thread].first = farthest(center, points, begin, end, scratch[thread].second);
+            }, threads);
+
+            T best = static_cast<T>(-1);
+            for (const std::pair<T, size_t>& chunk : scratch)
+            {
+                if (chunk.first > best)
+                {
+                    best = chunk.first;
+                    index = chunk.second;
+                }
+            }
+
+            return best;
+        }
+
+        // Sphere with the up to four boundary points of a Welzl step on its surface. Degenerate sets
+        // (coincident, collinear or coplanar points) fall back to a subset that still encloses them.
+        template<typename T>
+        inline sphere<T> circumsphere(const vec3<T>* b, s32 n) noexcept
+        {
+            const T epsilon = std::numeric_limits<T>::epsilon() * static_cast<T>(64);
+
+            auto enclose = [&](const vec3<T>& center)
+            {
+                T r = static_cast<T>(0);
+                for (s32 i = 0; i < n; i++)
+                {
+                    r = sml::max(r, (b[i] - center).lengthsquared());
+                }
+
+                return sphere<T>(center, sml::sqrt(r));
+            };
+
+            if (n == 0)
+                return sphere<T>();
+
+            if (n == 1)
+                return sphere<T>(b[0], static_cast<T>(0));
+
+            if (n == 2)
+                return enclose((b[0] + b[1]) * static_cast<T>(0.5));
+
+            if (n == 3)
+            {
+                vec3<T> a = b[0] - b[2], c = b[1] - b[2];
+                vec3<T> normal = vec3<T>::cross(a, c);
+                T denominator = static_cast<T>(2) * normal.lengthsquared();
+
+                if (denominator <= epsilon * a.lengthsquared() * c.lengthsquared())
+                {
+                    // Collinear, the two points farthest apart span the sphere
+                    s32 i = 0, j = 1;
+                    T best = (b[1] - b[0]).lengthsquared();
+
+                    if ((b[2] - b[0]).lengthsquared() > best) { best = (b[2] - b[0]).lengthsquared(); j = 2; }
+                    if ((b[2] - b[1]).lengthsquared() > best) { i = 1; j = 2; }
+
+                    return enclose((b[i] + b[j]) * static_cast<T>(0.5));
+                }
+
+                vec3<T> offset = vec3<T>::cross(c * a.lengthsquared() - a * c.lengthsquared(), normal) * (static_cast<T>(1) / denominator);
+
+                return enclose(b[2] + offset);
+            }
+
+            vec3<T> a = b[1] - b[0], c = b[2] - b[0], d = b[3] - b[0];
+            T determinant = static_cast<T>(2) * a.dot(vec3<T>::cross(c, d));
+
+            if (sml::abs(determinant) <= epsilon * a.length() * c.length() * d.length())
+            {
+                // Coplanar, the smallest face circle around all four points
+                const s32 faces[4][3] = { { 0, 1, 2 }, { 0, 1, 3 }, { 0, 2, 3 }, { 1, 2, 3 } };
+                sphere<T> best;
+
+                for (const s32* face : faces)
+                {
+                    vec3<T> tri[3] = { b[face[0]], b[face[1]], b[face[2]] };
+                    sphere<T> candidate = circumsphere(tri, 3);
+                    candidate = enclose(candidate.center());
+
+                    if (best.empty() || candidate.radius < best.radius)
+                        best = candidate;
+                }
+
+                return best;
+            }
+
+            vec3<T> offset = (vec3<T>::cross(c, d) * a.lengthsquared() + vec3<T>::cross(d, a) * c.lengthsquared() + vec3<T>::cross(a, c) * d.lengthsquared()) * (static_cast<T>(1) / determinant);
+
+            return enclose(b[0] + offset);
+        }
+
+        // Welzl's recursion with move to front, points outside the current sphere join the boundary
+        // and move to the front of the list so later calls test them first
+        template<typename T>
+        inline sphere<T> welzl(vec3<T>* points, size_t count, vec3<T>* boundary, s32 n) noexcept
+        {
+            sphere<T> s = circumsphere(boundary, n);
+
+            if (n == 4)
+                return s;
+
+            const T tolerance = static_cast<T>(1) + std::numeric_limits<T>::epsilon() * static_cast<T>(64);
+
+            for (size_t i = 0; i < count; i++)
+            {
+                if (!s.empty() && (points[i] - s.center()).lengthsquared() <= s.radius * s.radius * tolerance)
+                    continue;
+
+                boundary[n] = points[i];
+                s = welzl(points, i, boundary, n + 1);
+
+                std::rotate(points, points + i, points + i + 1);
+            }
+
+            return s;
+        }
+
+        // Minimal sphere of a support set grown by the point farthest outside it, for at most rounds
+        // rounds. Every round is one pass over the input and the radius grows every round, so the loop
+        // ends on the exact sphere or when rounding stops the progress. The radius always reaches the
+        // farthest point, so the result bounds the input even when the rounds run out.
+        template<typename T>
+        inline sphere<T> coresetsphere(const vec3<T>* points, size_t count, std::vector<vec3<T>>& support, u32 rounds, u32 threads)
+        {
+            const T tolerance = static_cast<T>(1) + std::numeric_limits<T>::epsilon() * static_cast<T>(64);
+
+            sphere<T> s;
+            T previous = static_cast<T>(-1);
+
+            for (u32 round = 0; ; round++)
+            {
+                vec3<T> boundary[4];
+                s = welzl(support.data(), support.size(), boundary, 0);
+
+                size_t index = 0;
+                T distancesquared = parallelfarthest(s.center(), points, count, index, threads);
+
+                if (distancesquared <= s.radius * s.radius * tolerance || s.radius <= previous || round >= rounds)
+                {
+                    s.radius = sml::max(s.radius, sml::sqrt(distancesquared));
+                    break;
+                }
+
+                previous = s.radius;
+                support.insert(support.begin(), points[index]);
+            }
+
+            return s;
+        }
+    } // namespace detail
+
+    // Approximate bounding sphere. Ritter's sphere is seeded from the widest pair of axis extremes and
+    // grown in one pass. The refinement runs a few rounds of the exact search below from the extremes,
+    // and the smaller of the two spheres is returned. Over threads every chunk grows its own Ritter
+    // sphere and the chunk spheres are merged.
+    template<typename T>
+    SML_NO_DISCARD inline sphere<T> boundingsphere(const vec3<T>* points, size_t count, u32 refinements = 2, u32 threads = 0)
+    {
+        if (count == 0)
+            return sphere<T>();
+
+        vec3<T> lo[3], hi[3];
+        detail::parallelextremes(points, count, lo, hi, threads);
+
+        s32 axis = 0;
+        for (s32 a = 1; a < 3; a++)
+        {
+            if ((hi[a] - lo[a]).lengthsquared() > (hi[axis] - lo[axis]).lengthsquared())
+                axis = a;
+        }
+
+        sphere<T> seed((lo[axis] + hi[axis]) * static_cast<T>(0.5), (hi[axis] - lo[axis]).length() * static_cast<T>(0.5));
+        sphere<T> ritter = detail::parallelgrow(seed, points, count, threads);
+
+        if (refinements == 0)
+            return ritter;
+
+        std::vector<vec3<T>> support = { lo[0], hi[0], lo[1], hi[1], lo[2], hi[2] };
+        sphere<T> refined = detail::coresetsphere(points, count, support, refinements, threads);
+
+        return refined.radius < ritter.radius ? refined : ritter;
+    }
+
+    // Minimal bounding sphere. Welzl with move to front runs on a small support set that starts with
+    // the axis extremes, and the point farthest outside the current sphere joins the set until none is
+    // left. The search for that point is the only pass over the input, it is SIMD and multithreaded.
+    template<typename T>
+    SML_NO_DISCARD inline sphere<T> minimalsphere(const vec3<T>* points, size_t count, u32 threads = 0)
+    {
+        if (count == 0)
+            return sphere<T>();
+
+        vec3<T> lo[3], hi[3];
+        detail::parallelextremes(points, count, lo, hi, threads);
+
+        std::vector<vec3<T>> support = { lo[0], hi[0], lo[1], hi[1], lo[2], hi[2] };
+
+        return detail::coresetsphere(points, count, support, std::numeric_limits<u32>::max(), threads);
+    }
+} // namespace sml
+
+#endif // sml_sphere_h__
@@ -0,0 +1,249 @@
+#ifndef sml_strided_h__
+#define sml_strided_h__
+
+/* strided.h -- strided views and kernels of the 'Simple Math Library'
+  Copyright (C) 2020 Roderick Griffioen
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <cstddef>
+#include <immintrin.h>
+
+#include "smltypes.h"
+#include "common.h"
+#include "simd.h"
+#include "vec3.h"
+#include "mat3.h"
+#include "mat4.h"
+#include "swizzle.h"
+#include "unaligned.h"
+
+namespace sml
+{
+    // Non-owning view of count vectors spaced stride bytes apart, such as the position or normal
+    // attribute of an interleaved vertex buffer. Elements are packed components at any alignment.
+    template<typename V>
+    class strided_span
+    {
+        public:
+            typedef typename vectraits<V>::type type;
+
+            constexpr strided_span() noexcept : data(nullptr), count(0), stride(0)
+            {
+            }
+
+            strided_span(void* data, size_t count, size_t stride) noexcept : data(static_cast<u8*>(data)), count(count), stride(stride)
+            {
+            }
+
+            SML_NO_DISCARD inline size_t size() const noexcept
+            {
+                return count;
+            }
+
+            SML_NO_DISCARD inline type* element(size_t i) const noexcept
+            {
+                return reinterpret_cast<type*>(data + i * stride);
+            }
+
+            SML_NO_DISCARD inline unaligned<V> operator [] (size_t i) const noexcept
+            {
+                return unaligned<V>(element(i));
+            }
+
+            // Data
+            u8* data;
+            size_t count;
+            size_t stride;
+    };
+
+    // Reads elements i..i+7 as x, y and z registers. Every element is read with a full 16 byte load,
+    // so the caller must guarantee that i + 7 is not the last element of the span.
+    inline void stridedload(const strided_span<vec3<f32>>& span, size_t i, __m256& x, __m256& y, __m256& z) noexcept
+    {
+        __m256 r0 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(span.element(i + 0))), _mm_loadu_ps(span.element(i + 4)), 1);
+        __m256 r1 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(span.element(i + 1))), _mm_loadu_ps(span.element(i + 5)), 1);
+        __m256 r2 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(span.element(i + 2))), _mm_loadu_ps(span.element(i + 6)), 1);
+        __m256 r3 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(span.element(i + 3))), _mm_loadu_ps(span.element(i + 7)), 1);
+
+        simd::transpose(r0, r1, r2, r3);
+
+        x = r0;
+        y = r1;
+        z = r2;
+    }
+
+    // Writes x, y and z back to elements i..i+7, the bytes following each element are left untouched
+    inline void stridedstore(const strided_span<vec3<f32>>& span, size_t i, __m256 x, __m256 y, __m256 z) noexcept
+    {
+        __m256 w = _mm256_setzero_ps();
+        __m128i mask = _mm_setr_epi32(-1, -1, -1, 0);
+
+        simd::transpose(x, y, z, w);
+
+        _mm_maskstore_ps(span.element(i + 0), mask, _mm256_castps256_ps128(x));
+        _mm_maskstore_ps(span.element(i + 1), mask, _mm256_castps256_ps128(y));
+        _mm_maskstore_ps(span.element(i + 2), mask, _mm256_castps256_ps128(z));
+        _mm_maskstore_ps(span.element(i + 3), mask, _mm256_castps256_ps128(w));
+        _mm_maskstore_ps(span.element(i + 4), mask, _mm256_extractf128_ps(x, 1));
+        _mm_maskstore_ps(span.element(i + 5), mask, _mm256_extractf128_ps(y, 1));
+        _mm_maskstore_ps(span.element(i + 6), mask, _mm256_extractf128_ps(z, 1));
+        _mm_maskstore_ps(span.element(i + 7), mask, _mm256_extractf128_ps(w, 1));
+    }
+
+    // Scales eight vectors to unit length, vectors shorter than epsilon become zero
+    inline void stridednormalize(__m256& x, __m256& y, __m256& z) noexcept
+    {
+        __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z)));
+        __m256 valid = _mm256_cmp_ps(length, _mm256_set1_ps(constants::epsilon), _CMP_GT_OQ);
+        __m256 scale = _mm256_and_ps(_mm256_div_ps(_mm256_set1_ps(1.0f), length), valid);
+
+        x = _mm256_mul_ps(x, scale);
+        y = _mm256_mul_ps(y, scale);
+        z = _mm256_mul_ps(z, scale);
+    }
+
+    // The same for one vector of the scalar tails
+    template<typename T>
+    inline void stridednormalize(vec3<T>& v) noexcept
+    {
+        T length = v.length();
+
+        v = length > static_cast<T>(constants::epsilon) ? v / length : vec3<T>(static_cast<T>(0));
+    }
+
+    // Inverse transpose of the upper 3x3 of a transform, the matrix normals are transformed by
+    template<typename T>
+    SML_NO_DISCARD inline mat3<T> normalmatrix(const mat4<T>& transform) noexcept
+    {
+        mat3<T> res(transform.m00, transform.m01, transform.m02,
+                    transform.m10, transform.m11, transform.m12,
+                    transform.m20, transform.m21, transform.m22);
+
+        res.invert();
+        res.transpose();
+
+        return res;
+    }
+
+    // Transforms points in place by an affine transform, p = (transform * (p, 1)).xyz
+    template<typename T>
+    inline void transformpositions(strided_span<vec3<T>> positions, const mat4<T>& transform) noexcept
+    {
+        // Elements are read and written in place, they must not overlap
+        SML_ASSERT(positions.stride >= vectraits<vec3<T>>::size * sizeof(T));
+
+        size_t i = 0;
+
+        if constexpr (std::is_same<T, f32>::value)
+        {
+            __m256 m00 = _mm256_set1_ps(transform.m00), m01 = _mm256_set1_ps(transform.m01), m02 = _mm256_set1_ps(transform.m02);
+            __m256 m10 = _mm256_set1_ps(transform.m10), m11 = _mm256_set1_ps(transform.m11), m12 = _mm256_set1_ps(transform.m12);
+            __m256 m20 = _mm256_set1_ps(transform.m20), m21 = _mm256_set1_ps(transform.m21), m22 = _mm256_set1_ps(transform.m22);
+            __m256 m30 = _mm256_set1_ps(transform.m30), m31 = _mm256_set1_ps(transform.m31), m32 = _mm256_set1_ps(transform.m32);
+
+            for (; i + 8 < positions.count; i += 8)
+            {
+                __m256 x, y, z;
+                stridedload(positions, i, x, y, z);
+
+                __m256 rx = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m00, x), _mm256_mul_ps(m10, y)), _mm256_add_ps(_mm256_mul_ps(m20, z), m30));
+                __m256 ry = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m01, x), _mm256_mul_ps(m11, y)), _mm256_add_ps(_mm256_mul_ps(m21, z), m31));
+                __m256 rz = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m02, x), _mm256_mul_ps(m12, y)), _mm256_add_ps(_mm256_mul_ps(m22, z), m32));
+
+                stridedstore(positions, i, rx, ry, rz);
+            }
+        }
+
+        for (; i < positions.count; i++)
+        {
+            unaligned<vec3<T>> position = positions[i];
+            vec3<T> p = position;
+            vec4<T> res = transform * vec4<T>(p.x, p.y, p.z, static_cast<T>(1));
+
+            position = vec3<T>(res.x, res.y, res.z);
+        }
+    }
+
+    // Transforms normals in place by the inverse transpose of transform and renormalises them
+    template<typename T>
+    inline void transformnormals(strided_span<vec3<T>> normals, const mat4<T>& transform) noexcept
+    {
+        SML_ASSERT(normals.stride >= vectraits<vec3<T>>::size * sizeof(T));
+
+        mat3<T> nm = normalmatrix(transform);
+        size_t i = 0;
+
+        if constexpr (std::is_same<T, f32>::value)
+        {
+            __m256 m00 = _mm256_set1_ps(nm.m00), m01 = _mm256_set1_ps(nm.m01), m02 = _mm256_set1_ps(nm.m02);
+            __m256 m10 = _mm256_set1_ps(nm.m10), m11 = _mm256_set1_ps(nm.m11), m12 = _mm256_set1_ps(nm.m12);
+            __m256 m20 = _mm256_set1_ps(nm.m20), m21 = _mm256_set1_ps(nm.m21), m22 = _mm256_set1_ps(nm.m22);
+
+            for (; i + 8 < normals.count; i += 8)
+            {
+                __m256 x, y, z;
+                stridedload(normals, i, x, y, z);
+
+                __m256 rx = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m00, x), _mm256_mul_ps(m10, y)), _mm256_mul_ps(m20, z));
+                __m256 ry = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m01, x), _mm256_mul_ps(m11, y)), _mm256_mul_ps(m21, z));
+                __m256 rz = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m02, x), _mm256_mul_ps(m12, y)), _mm256_mul_ps(m22, z));
+
+                stridednormalize(rx, ry, rz);
+                stridedstore(normals, i, rx, ry, rz);
+            }
+        }
+
+        for (; i < normals.count; i++)
+        {
+            unaligned<vec3<T>> normal = normals[i];
+            vec3<T> n = nm * normal.load();
+            stridednormalize(n);
+
+            normal = n;
+        }
+    }
+
+    // Rescales every vector of the span to unit length
+    template<typename T>
+    inline void renormalize(strided_span<vec3<T>> normals) noexcept
+    {
+        SML_ASSERT(normals.stride >= vectraits<vec3<T>>::size * sizeof(T));
+
+        size_t i = 0;
+
+        if constexpr (std::is_same<T, f32>::value)
+        {
+            for (; i + 8 < normals.count; i += 8)
+            {
+                __m256 x, y, z;
+                stridedload(normals, i, x, y, z);
+                stridednormalize(x, y, z);
+                stridedstore(normals, i, x, y, z);
+            }
+        }
+
+        for (; i < normals.count; i++)
+        {
+            unaligned<vec3<T>> normal = normals[i];
+            vec3<T> n = normal;
+            stridednormalize(n);
+
+            normal = n;
+        }
+    }
+} // namespace sml
+
+#endif // sml_strided_h__
@@ -0,0 +1,459 @@
+#ifndef sml_svd_h__
+#define sml_svd_h__
+
+/* svd.h -- 3x3 singular value and polar decomposition of the 'Simple Math Library'
+  Copyright (C) 2020 Roderick Griffioen
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <limits>
+#include <type_traits>
+#include <immintrin.h>
+
+#include "smltypes.h"
+#include "common.h"
+#include "simd.h"
+#include "vec3.h"
+#include "mat3.h"
+#include "quat.h"
+#include "vec3x8.h"
+#include "mat3x8.h"
+
+namespace sml
+{
+    // Singular value decomposition A = U diag(sigma) V^T of 3x3 matrices after McAdams et al., Computing the
+    // Singular Value Decomposition of 3x3 matrices with minimal branching and elementary floating point
+    // operations. A fixed number of Jacobi sweeps with approximate Givens rotations diagonalizes A^T A into
+    // V. One sweep of exact one sided rotations on A V wins back what forming A^T A loses on small singular
+    // values, then the columns of A V are sorted by length and a Givens QR of A V yields U and sigma. U and V
+    // are rotations, sigma is sorted by decreasing magnitude and only sigma.z turns negative, when det(A) < 0.
+    // There are no data dependent branches, the 8-wide versions run eight independent matrices in SoA layout.
+    namespace detail
+    {
+        template<typename T>
+        struct svdconstants
+        {
+            // Jacobi sweeps, every sweep visits the pairs (0, 1), (1, 2) and (0, 2)
+            static constexpr s32 sweeps = std::is_same<T, f32>::value ? 4 : 6;
+
+            // 3 + 2 sqrt(2), above it the rotation is pinned at pi / 8
+            static constexpr T gamma = static_cast<T>(5.82842712474619);
+            static constexpr T cstar = static_cast<T>(0.923879532511287);
+            static constexpr T sstar = static_cast<T>(0.38268343236509);
+        };
+
+        // Conjugates the symmetric s with the approximate Givens rotation that reduces s[p][q] and accumulates
+        // it into the columns of v
+        template<s32 p, s32 q, s32 k, typename T>
+        inline void svdjacobi(T (&s)[3][3], T (&v)[3][3]) noexcept
+        {
+            typedef svdconstants<T> constants;
+
+            // Converged pairs rotate no further, which keeps their squares from turning denormal
+            T limit = std::numeric_limits<T>::epsilon() * std::numeric_limits<T>::epsilon() * (s[p][p] + s[q][q]);
+            T ch = static_cast<T>(2) * (s[p][p] - s[q][q]), sh = sml::abs(s[p][q]) > limit ? s[p][q] : static_cast<T>(0);
+            bool exact = constants::gamma * sh * sh < ch * ch;
+            T w = static_cast<T>(1) / sml::sqrt(ch * ch + sh * sh);
+
+            ch = exact ? w * ch : constants::cstar;
+            sh = exact ? w * sh : constants::sstar;
+
+            T c = ch * ch - sh * sh, sn = static_cast<T>(2) * ch * sh;
+            T spp = s[p][p], sqq = s[q][q], spq = s[p][q], skp = s[k][p], skq = s[k][q];
+
+            s[p][p] = c * c * spp + static_cast<T>(2) * c * sn * spq + sn * sn * sqq;
+            s[q][q] = sn * sn * spp - static_cast<T>(2) * c * sn * spq + c * c * sqq;
+            s[p][q] = s[q][p] = (c * c - sn * sn) * spq - c * sn * (spp - sqq);
+            s[k][p] = s[p][k] = c * skp + sn * skq;
+            s[k][q] = s[q][k] = c * skq - sn * skp;
+
+            for (s32 r = 0; r < 3; r++)
+            {
+                T vp = v[p][r], vq = v[q][r];
+                v[p][r] = c * vp + sn * vq;
+                v[q][r] = c * vq - sn * vp;
+            }
+        }
+
+        // Exact Jacobi rotation of columns p and q of b that makes them orthogonal, accumulated into v. The
+        // dot products come from b itself rather than from A^T A, so small singular values keep their accuracy.
+        template<s32 p, s32 q, typename T>
+        inline void svdpolish(T (&b)[3][3], T (&v)[3][3]) noexcept
+        {
+            // rho squared stays clear of denormals
+            const T epsilon = sml::sqrt(std::numeric_limits<T>::min()) * static_cast<T>(4096);
+
+            T x = static_cast<T>(0), y = static_cast<T>(0);
+            for (s32 r = 0; r < 3; r++)
+            {
+                x += b[p][r] * b[p][r] - b[q][r] * b[q][r];
+                y += static_cast<T>(2) * b[p][r] * b[q][r];
+            }
+
+            // cos 2 theta >= 0 keeps the rotation within pi / 4
+            T rho = sml::sqrt(x * x + y * y);
+            T c2 = rho > epsilon ? sml::abs(x) / rho : static_cast<T>(1);
+            T s2 = rho > epsilon ? (x < static_cast<T>(0) ? -y : y) / rho : static_cast<T>(0);
+            T c = sml::sqrt(static_cast<T>(0.5) * (static_cast<T>(1) + c2));
+            T sn = s2 / (static_cast<T>(2) * c);
+
+            for (s32 r = 0; r < 3; r++)
+            {
+                T bp = b[p][r], bq = b[q][r], vp = v[p][r], vq = v[q][r];
+                b[p][r] = c * bp + sn * bq;
+                b[q][r] = c * bq - sn * bp;
+                v[p][r] = c * vp + sn * vq;
+                v[q][r] = c * vq - sn * vp;
+            }
+        }
+
+        // Swaps columns i and j of b and v when column j of b is longer, negating one to keep v a rotation
+        template<s32 i, s32 j, typename T>
+        inline void svdsort(T (&b)[3][3], T (&v)[3][3], T (&length)[3]) noexcept
+        {
+            bool swap = length[i] < length[j];
+
+            for (s32 r = 0; r < 3; r++)
+            {
+                T bi = b[i][r], bj = b[j][r], vi = v[i][r], vj = v[j][r];
+                b[i][r] = swap ? bj : bi;
+                b[j][r] = swap ? -bi : bj;
+                v[i][r] = swap ? vj : vi;
+                v[j][r] = swap ? -vi : vj;
+            }
+
+            T li = length[i], lj = length[j];
+            length[i] = swap ? lj : li;
+            length[j] = swap ? li : lj;
+        }
+
+        // Givens rotation of rows p and q of b that zeroes b[pivot][q], accumulated into the columns of u
+        template<s32 p, s32 q, s32 pivot, typename T>
+        inline void svdqr(T (&b)[3][3], T (&u)[3][3]) noexcept
+        {
+            const T epsilon = sml::sqrt(std::numeric_limits<T>::min()) * static_cast<T>(16);
+
+            T a1 = b[pivot][p], a2 = b[pivot][q];
+            T rho = sml::sqrt(a1 * a1 + a2 * a2);
+            T sh = rho > epsilon ? a2 : static_cast<T>(0);
+            T ch = sml::abs(a1) + sml::max(rho, epsilon);
+
+            T x = a1 < static_cast<T>(0) ? sh : ch;
+            T y = a1 < static_cast<T>(0) ? ch : sh;
+            T w = static_cast<T>(1) / sml::sqrt(x * x + y * y);
+
+            ch = x * w;
+            sh = y * w;
+
+            T c = ch * ch - sh * sh, sn = static_cast<T>(2) * ch * sh;
+
+            for (s32 j = 0; j < 3; j++)
+            {
+                T bp = b[j][p], bq = b[j][q];
+                b[j][p] = c * bp + sn * bq;
+                b[j][q] = c * bq - sn * bp;
+
+                T up = u[p][j], uq = u[q][j];
+                u[p][j] = c * up + sn * uq;
+                u[q][j] = c * uq - sn * up;
+            }
+        }
+
+        // 8-wide reciprocal square root, the estimate refined by one Newton step
+        inline __m256 svdrsqrt(__m256 x) noexcept
+        {
+            __m256 r = _mm256_rsqrt_ps(x);
+
+            return _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), r), _mm256_sub_ps(_mm256_set1_ps(3.0f), _mm256_mul_ps(_mm256_mul_ps(x, r), r)));
+        }
+
+        template<s32 p, s32 q, s32 k>
+        inline void svdjacobi(__m256 (&s)[3][3], vec3x8 (&v)[3]) noexcept
+        {
+            typedef svdconstants<f32> constants;
+
+            const __m256 two = _mm256_set1_ps(2.0f);
+
+            __m256 limit = _mm256_mul_ps(_mm256_set1_ps(std::numeric_limits<f32>::epsilon() * std::numeric_limits<f32>::epsilon()), _mm256_add_ps(s[p][p], s[q][q]));
+            __m256 converged = _mm256_cmp_ps(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), s[p][q]), limit, _CMP_LE_OQ);
+            __m256 ch = _mm256_mul_ps(two, _mm256_sub_ps(s[p][p], s[q][q])), sh = _mm256_andnot_ps(converged, s[p][q]);
+            __m256 ch2 = _mm256_mul_ps(ch, ch), sh2 = _mm256_mul_ps(sh, sh);
+            __m256 exact = _mm256_cmp_ps(_mm256_mul_ps(_mm256_set1_ps(constants::gamma), sh2), ch2, _CMP_LT_OQ);
+            __m256 w = svdrsqrt(_mm256_add_ps(ch2, sh2));
+
+            ch = simd::select(exact, _mm256_set1_ps(constants::cstar), _mm256_mul_ps(w, ch));
+            sh = simd::select(exact, _mm256_set1_ps(constants::sstar), _mm256_mul_ps(w, sh));
+
+            __m256 cc = _mm256_mul_ps(ch, ch), ss = _mm256_mul_ps(sh, sh);
+            __m256 c = _mm256_sub_ps(cc, ss), sn = _mm256_mul_ps(two, _mm256_mul_ps(ch, sh));
+            __m256 c2 = _mm256_mul_ps(c, c), s2 = _mm256_mul_ps(sn, sn), cs = _mm256_mul_ps(c, sn);
+            __m256 spp = s[p][p], sqq = s[q][q], spq = s[p][q], skp = s[k][p], skq = s[k][q];
+            __m256 twocsspq = _mm256_mul_ps(_mm256_mul_ps(two, cs), spq);
+
+            s[p][p] = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(c2, spp), twocsspq), _mm256_mul_ps(s2, sqq));
+            s[q][q] = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(s2, spp), twocsspq), _mm256_mul_ps(c2, sqq));
+            s[p][q] = s[q][p] = _mm256_sub_ps(_mm256_mul_ps(_mm256_sub_ps(c2, s2), spq), _mm256_mul_ps(cs, _mm256_sub_ps(spp, sqq)));
+            s[k][p] = s[p][k] = _mm256_add_ps(_mm256_mul_ps(c, skp), _mm256_mul_ps(sn, skq));
+            s[k][q] = s[q][k] = _mm256_sub_ps(_mm256_mul_ps(c, skq), _mm256_mul_ps(sn, skp));
+
+            vec3x8 vp = v[p], vq = v[q];
+            v[p] = vp * c + vq * sn;
+            v[q] = vq * c - vp * sn;
+        }
+
+        template<s32 p, s32 q>
+        inline void svdpolish(vec3x8 (&b)[3], vec3x8 (&v)[3]) noexcept
+        {
+            const __m256 one = _mm256_set1_ps(1.0f);
+            const __m256 sign = _mm256_set1_ps(-0.0f);
+
+            __m256 x = _mm256_sub_ps(b[p].lengthsquared(), b[q].lengthsquared());
+            __m256 y = _mm256_mul_ps(_mm256_set1_ps(2.0f), vec3x8::dot(b[p], b[q]));
+
+            __m256 rho = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)));
+            __m256 valid = _mm256_cmp_ps(rho, _mm256_set1_ps(sml::sqrt(std::numeric_limits<f32>::min()) * 4096.0f), _CMP_GT_OQ);
+            __m256 inverse = _mm256_div_ps(one, rho);
+            __m256 c2 = simd::select(valid, one, _mm256_mul_ps(_mm256_andnot_ps(sign, x), inverse));
+            __m256 s2 = _mm256_and_ps(valid, _mm256_mul_ps(_mm256_xor_ps(y, _mm256_and_ps(sign, x)), inverse));
+            __m256 c = _mm256_sqrt_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), _mm256_add_ps(one, c2)));
+            __m256 sn = _mm256_div_ps(s2, _mm256_add_ps(c, c));
+
+            vec3x8 bp = b[p], bq = b[q], vp = v[p], vq = v[q];
+            b[p] = bp * c + bq * sn;
+            b[q] = bq * c - bp * sn;
+            v[p] = vp * c + vq * sn;
+            v[q] = vq * c - vp * sn;
+        }
+
+        template<s32 i, s32 j>
+        inline void svdsort(vec3x8 (&b)[3], vec3x8 (&v)[3], __m256 (&length)[3]) noexcept
+        {
+            __m256 swap = _mm256_cmp_ps(length[i], length[j], _CMP_LT_OQ);
+
+            vec3x8 bi = b[i], bj = b[j], vi = v[i], vj = v[j];
+            b[i] = vec3x8::select(swap, bi, bj);
+            b[j] = vec3x8::select(swap, bj, -bi);
+            v[i] = vec3x8::select(swap, vi, vj);
+            v[j] = vec3x8::select(swap, vj, -vi);
+
+            __m256 li = length[i], lj = length[j];
+            length[i] = simd::select(swap, li, lj);
+            length[j] = simd::select(swap, lj, li);
+        }
+
+        // Rows of the SoA columns, b[j] holds column j
+        template<s32 r>
+        inline __m256& svdrow(vec3x8& column) noexcept
+        {
+            if constexpr (r == 0)
+            {
+                return column.x;
+            }
+            else if constexpr (r == 1)
+            {
+                return column.y;
+            }
+            else
+            {
+                return column.z;
+            }
+        }
+
+        template<s32 p, s32 q, s32 pivot>
+        inline void svdqr(vec3x8 (&b)[3], vec3x8 (&u)[3]) noexcept
+        {
+            const __m256 zero = _mm256_setzero_ps();
+            const __m256 epsilon = _mm256_set1_ps(sml::sqrt(std::numeric_limits<f32>::min()) * 16.0f);
+
+            __m256 a1 = svdrow<p>(b[pivot]), a2 = svdrow<q>(b[pivot]);
+            __m256 rho = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(a1, a1), _mm256_mul_ps(a2, a2)));
+            __m256 sh = _mm256_and_ps(_mm256_cmp_ps(rho, epsilon, _CMP_GT_OQ), a2);
+            __m256 ch = _mm256_add_ps(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a1), _mm256_max_ps(rho, epsilon));
+
+            __m256 negative = _mm256_cmp_ps(a1, zero, _CMP_LT_OQ);
+            __m256 x = simd::select(negative, ch, sh);
+            __m256 y = simd::select(negative, sh, ch);
+            __m256 w = svdrsqrt(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)));
+
+            ch = _mm256_mul_ps(x, w);
+            sh = _mm256_mul_ps(y, w);
+
+            __m256 c = _mm256_sub_ps(_mm256_mul_ps(ch, ch), _mm256_mul_ps(sh, sh));
+            __m256 sn = _mm256_mul_ps(_mm256_set1_ps(2.0f), _mm256_mul_ps(ch, sh));
+
+            for (s32 j = 0; j < 3; j++)
+            {
+                __m256& bp = svdrow<p>(b[j]);
+                __m256& bq = svdrow<q>(b[j]);
+                __m256 op = bp, oq = bq;
+
+                bp = _mm256_add_ps(_mm256_mul_ps(c, op), _mm256_mul_ps(sn, oq));
+                bq = _mm256_sub_ps(_mm256_mul_ps(c, oq), _mm256_mul_ps(sn, op));
+            }
+
+            vec3x8 up = u[p], uq = u[q];
+            u[p] = up * c + uq * sn;
+            u[q] = uq * c - up * sn;
+        }
+    } // namespace detail
+
+    template<typename T>
+    inline void svd(const mat3<T>& a, mat3<T>& u, vec3<T>& sigma, mat3<T>& v) noexcept
+    {
+        // Symmetric eigenproblem of A^T A, arrays are indexed [column][row]
+        T s[3][3], vm[3][3] = { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+        for (s32 i = 0; i < 3; i++)
+        {
+            for (s32 j = 0; j < 3; j++)
+            {
+                s[i][j] = vec3<T>::dot(a.col[i], a.col[j]);
+            }
+        }
+
+        for (s32 sweep = 0; sweep < detail::svdconstants<T>::sweeps; sweep++)
+        {
+            detail::svdjacobi<0, 1, 2>(s, vm);
+            detail::svdjacobi<1, 2, 0>(s, vm);
+            detail::svdjacobi<0, 2, 1>(s, vm);
+        }
+
+        // B = A V, orthogonalized once more and with its columns by decreasing length
+        T b[3][3], length[3];
+        for (s32 j = 0; j < 3; j++)
+        {
+            vec3<T> column = a.col[0] * vm[j][0] + a.col[1] * vm[j][1] + a.col[2] * vm[j][2];
+
+            b[j][0] = column.x;
+            b[j][1] = column.y;
+            b[j][2] = column.z;
+        }
+
+        detail::svdpolish<0, 1>(b, vm);
+        detail::svdpolish<1, 2>(b, vm);
+        detail::svdpolish<0, 2>(b, vm);
+
+        for (s32 j = 0; j < 3; j++)
+        {
+            length[j] = b[j][0] * b[j][0] + b[j][1] * b[j][1] + b[j][2] * b[j][2];
+        }
+
+        detail::svdsort<0, 1>(b, vm, length);
+        detail::svdsort<0, 2>(b, vm, length);
+        detail::svdsort<1, 2>(b, vm, length);
+
+        // B = U R, R is diagonal up to rounding once B has orthogonal columns
+        T um[3][3] = { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+        detail::svdqr<0, 1, 0>(b, um);
+        detail::svdqr<0, 2, 0>(b, um);
+        detail::svdqr<1, 2, 1>(b, um);
+
+        u = mat3<T>(um[0][0], um[0][1], um[0][2], um[1][0], um[1][1], um[1][2], um[2][0], um[2][1], um[2][2]);
+        v = mat3<T>(vm[0][0], vm[0][1], vm[0][2], vm[1][0], vm[1][1], vm[1][2], vm[2][0], vm[2][1], vm[2][2]);
+        sigma = vec3<T>(b[0][0], b[1][1], b[2][2]);
+    }
+
+    // U and V as unit quaternions
+    template<typename T>
+    inline void svd(const mat3<T>& a, quat<T>& u, vec3<T>& sigma, quat<T>& v) noexcept
+    {
+        mat3<T> mu, mv;
+        svd(a, mu, sigma, mv);
+
+        u = quat<T>::frommatrix3(mu);
+        v = quat<T>::frommatrix3(mv);
+    }
+
+    // Polar decomposition A = R S with R = U V^T a rotation and S = V diag(sigma) V^T symmetric. S is
+    // positive semidefinite unless det(A) < 0, then it carries the reflection.
+    template<typename T>
+    inline void polar(const mat3<T>& a, mat3<T>& r, mat3<T>& s) noexcept
+    {
+        mat3<T> u, v;
+        vec3<T> sigma;
+        svd(a, u, sigma, v);
+
+        mat3<T> vt = v.transposed();
+        r = u * vt;
+
+        mat3<T> scaled = v;
+        scaled.col0 *= sigma.x;
+        scaled.col1 *= sigma.y;
+        scaled.col2 *= sigma.z;
+        s = scaled * vt;
+    }
+
+    inline void svd(const mat3x8& a, mat3x8& u, vec3x8& sigma, mat3x8& v) noexcept
+    {
+        __m256 s[3][3];
+        for (s32 i = 0; i < 3; i++)
+        {
+            for (s32 j = i; j < 3; j++)
+            {
+                s[i][j] = s[j][i] = vec3x8::dot(a.col[i], a.col[j]);
+            }
+        }
+
+        vec3x8 vm[3] = { mat3x8().col[0], mat3x8().col[1], mat3x8().col[2] };
+        for (s32 sweep = 0; sweep < detail::svdconstants<f32>::sweeps; sweep++)
+        {
+            detail::svdjacobi<0, 1, 2>(s, vm);
+            detail::svdjacobi<1, 2, 0>(s, vm);
+            detail::svdjacobi<0, 2, 1>(s, vm);
+        }
+
+        vec3x8 b[3];
+        __m256 length[3];
+        for (s32 j = 0; j < 3; j++)
+        {
+            b[j] = a * vm[j];
+        }
+
+        detail::svdpolish<0, 1>(b, vm);
+        detail::svdpolish<1, 2>(b, vm);
+        detail::svdpolish<0, 2>(b, vm);
+
+        for (s32 j = 0; j < 3; j++)
+        {
+            length[j] = b[j].lengthsquared();
+        }
+
+        detail::svdsort<0, 1>(b, vm, length);
+        detail::svdsort<0, 2>(b, vm, length);
+        detail::svdsort<1, 2>(b, vm, length);
+
+        vec3x8 um[3] = { mat3x8().col[0], mat3x8().col[1], mat3x8().col[2] };
+        detail::svdqr<0, 1, 0>(b, um);
+        detail::svdqr<0, 2, 0>(b, um);
+        detail::svdqr<1, 2, 1>(b, um);
+
+        u = mat3x8(um[0], um[1], um[2]);
+        v = mat3x8(vm[0], vm[1], vm[2]);
+        sigma = vec3x8(b[0].x, b[1].y, b[2].z);
+    }
+
+    inline void polar(const mat3x8& a, mat3x8& r, mat3x8& s) noexcept
+    {
+        mat3x8 u, v;
+        vec3x8 sigma;
+        svd(a, u, sigma, v);
+
+        mat3x8 vt = v.transposed();
+        r = u * vt;
+        s = mat3x8(v.col[0] * sigma.x, v.col[1] * sigma.y, v.col[2] * sigma.z) * vt;
+    }
+} // namespace sml
+
+#endif // sml_svd_h__
@@ -0,0 +1,299 @@
+#ifndef sml_sweepandprune_h__
+#define sml_sweepandprune_h__
+
+/* sweepandprune.h -- sweep and prune broadphase of the 'Simple Math Library'
+  Copyright (C) 2020 Roderick Griffioen
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include <immintrin.h>
+
+#include "smltypes.h"
+#include "common.h"
+#include "simd.h"
+#include "aabb.h"
+#include "morton.h"
+#include "parallel.h"
+
+namespace sml
+{
+    // Two boxes that overlap, a < b
+    struct overlappair
+    {
+        u32 a;
+        u32 b;
+    };
+
+    // Sweep and prune over an array of boxes. Intervals are sorted along the axis in which the box
+    // centers vary most and every box is tested against the boxes that start before it ends, eight
+    // at a time on the other two axes. Between frames the previous order is kept and re-sorted with
+    // an insertion sort, which is close to linear when boxes move a little per frame.
+    class sweepandprune
+    {
+        public:
+            sweepandprune() noexcept = default;
+
+            // Operations
+
+            // Sorts boxes for the next findpairs. Keeps the previous order when count and axis are unchanged.
+            void update(const aabb<f32>* boxes, size_t count, u32 threads = 0)
+            {
+                s32 best = largestvariance(boxes, count, threads);
+                bool resort = best != axis || count != order.size();
+
+                axis = best;
+                lo.resize(count + 8);
+                hi.resize(count + 8);
+                lo1.resize(count + 8);
+                hi1.resize(count + 8);
+                lo2.resize(count + 8);
+                hi2.resize(count + 8);
+
+                if (!resort)
+                    resort = !insertionsort(boxes, count);
+
+                if (resort)
+                {
+                    std::vector<u32> keys(count);
+                    order.resize(count);
+
+                    parallelfor(0, count, 16384, [&](size_t begin, size_t end, u32)
+                    {
+                        for (size_t i = begin; i < end; i++)
+                        {
+                            keys[i] = sortable(boxes[i].min.v[axis]);
+                            order[i] = static_cast<u32>(i);
+                        }
+                    }, threads);
+
+                    radixsort(keys.data(), order.data(), count, threads);
+
+                    for (size_t i = 0; i < count; i++)
+                    {
+                        lo[i] = boxes[order[i]].min.v[axis];
+                    }
+                }
+
+                s32 a1 = (axis + 1) % 3, a2 = (axis + 2) % 3;
+
+                parallelfor(0, count, 16384, [&](size_t begin, size_t end, u32)
+                {
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        const aabb<f32>& box = boxes[order[i]];
+
+                        hi[i] = box.max.v[axis];
+                        lo1[i] = box.min.v[a1];
+                        hi1[i] = box.max.v[a1];
+                        lo2[i] = box.min.v[a2];
+                        hi2[i] = box.max.v[a2];
+                    }
+                }, threads);
+
+                // Sentinels start after everything, so sweeps stop and eight wide loads stay in bounds
+                for (size_t i = count; i < count + 8; i++)
+                {
+                    lo[i] = std::numeric_limits<f32>::infinity();
+                    hi[i] = -std::numeric_limits<f32>::infinity();
+                    lo1[i] = lo2[i] = std::numeric_limits<f32>::infinity();
+                    hi1[i] = hi2[i] = -std::numeric_limits<f32>::infinity();
+                }
+            }
+
+            // Writes up to capacity overlapping pairs to out and returns the number of overlapping pairs,
+            // which is larger than capacity when out was too small. Pairs come in sweep order with one
+            // thread and in no particular order with more.
+            size_t findpairs(overlappair* out, size_t capacity, u32 threads = 0) const
+            {
+                std::atomic<size_t> cursor(0);
+                size_t count = order.size();
+
+                parallelfor(0, count, 4096, [&](size_t begin, size_t end, u32)
+                {
+                    // Pairs are staged on the stack and published a block at a time
+                    const u32 staged = 256;
+                    overlappair local[staged];
+                    u32 used = 0;
+
+                    auto flush = [&]()
+                    {
+                        size_t at = cursor.fetch_add(used);
+
+                        if (at < capacity)
+                            std::memcpy(out + at, local, std::min<size_t>(used, capacity - at) * sizeof(overlappair));
+
+                        used = 0;
+                    };
+
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        __m256 h = _mm256_set1_ps(hi[i]);
+                        __m256 l1 = _mm256_set1_ps(lo1[i]), h1 = _mm256_set1_ps(hi1[i]);
+                        __m256 l2 = _mm256_set1_ps(lo2[i]), h2 = _mm256_set1_ps(hi2[i]);
+
+                        // Bounded by count as well, boxes reaching +inf on the sweep axis never pass the sentinels
+                        for (size_t j = i + 1; j < count; j += 8)
+                        {
+                            __m256 start = _mm256_loadu_ps(&lo[j]);
+                            __m256 m = _mm256_cmp_ps(start, h, _CMP_LE_OQ);
+
+                            m = _mm256_and_ps(m, _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(&lo1[j]), h1, _CMP_LE_OQ), _mm256_cmp_ps(l1, _mm256_loadu_ps(&hi1[j]), _CMP_LE_OQ)));
+                            m = _mm256_and_ps(m, _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(&lo2[j]), h2, _CMP_LE_OQ), _mm256_cmp_ps(l2, _mm256_loadu_ps(&hi2[j]), _CMP_LE_OQ)));
+
+                            u32 valid = count - j < 8 ? (1u << (count - j)) - 1 : 0xFFu;
+
+                            for (u32 mask = static_cast<u32>(_mm256_movemask_ps(m)) & valid; mask != 0; mask &= mask - 1)
+                            {
+                                u32 a = order[i], b = order[j + lowestbit(mask)];
+
+                                local[used++] = a < b ? overlappair{ a, b } : overlappair{ b, a };
+
+                                if (used == staged)
+                                    flush();
+                            }
+
+                            // Keys are sorted, once the last of the eight starts past this box the sweep is done
+                            if (!(lo[j + 7] <= hi[i]))
+                                break;
+                        }
+                    }
+
+                    if (used > 0)
+                        flush();
+                }, threads);
+
+                return cursor.load();
+            }
+
+            SML_NO_DISCARD inline s32 sweepaxis() const noexcept
+            {
+                return axis;
+            }
+
+        private:
+            // Insertion sort of the previous order by the new keys. Gives up once it has moved 32 keys
+            // per box, the radix sort is faster than that.
+            bool insertionsort(const aabb<f32>* boxes, size_t count) noexcept
+            {
+                size_t budget = count * 32;
+
+                for (size_t i = 0; i < count; i++)
+                {
+                    lo[i] = boxes[order[i]].min.v[axis];
+                }
+
+                for (size_t i = 1; i < count; i++)
+                {
+                    f32 key = lo[i];
+
+                    if (!(key < lo[i - 1]))
+                        continue;
+
+                    u32 index = order[i];
+                    size_t j = i;
+
+                    for (; j > 0 && key < lo[j - 1]; j--)
+                    {
+                        lo[j] = lo[j - 1];
+                        order[j] = order[j - 1];
+                    }
+
+                    lo[j] = key;
+                    order[j] = index;
+
+                    if (i - j > budget)
+                        return false;
+
+                    budget -= i - j;
+                }
+
+                return true;
+            }
+
+            // Flips f32 bits so unsigned order matches float order
+            static inline u32 sortable(f32 value) noexcept
+            {
+                u32 bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+
+                return bits ^ ((bits >> 31) != 0 ? 0xFFFFFFFFu : 0x80000000u);
+            }
+
+            static s32 largestvariance(const aabb<f32>* boxes, size_t count, u32 threads)
+            {
+                if (count == 0)
+                    return 0;
+
+                u32 chunks = threadcount(threads);
+                std::vector<f64> partial(chunks * 8, 0.0);
+
+                // Sums of doubled centres and their squares, accumulated in double
+                parallelfor(0, count, 16384, [&](size_t begin, size_t end, u32 chunk)
+                {
+                    __m256d sum = _mm256_setzero_pd(), sumsq = _mm256_setzero_pd();
+
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        __m256d c = _mm256_cvtps_pd(_mm_add_ps(simd::load(boxes[i].min.v), simd::load(boxes[i].max.v)));
+
+                        sum = _mm256_add_pd(sum, c);
+                        sumsq = _mm256_add_pd(sumsq, _mm256_mul_pd(c, c));
+                    }
+
+                    _mm256_storeu_pd(&partial[chunk * 8], sum);
+                    _mm256_storeu_pd(&partial[chunk * 8 + 4], sumsq);
+                }, threads);
+
+                __m256d sum = _mm256_setzero_pd(), sumsq = _mm256_setzero_pd();
+
+                for (u32 c = 0; c < chunks; c++)
+                {
+                    sum = _mm256_add_pd(sum, _mm256_loadu_pd(&partial[c * 8]));
+                    sumsq = _mm256_add_pd(sumsq, _mm256_loadu_pd(&partial[c * 8 + 4]));
+                }
+
+                // n * variance = sumsq - sum^2 / n, the common factor does not change the largest axis
+                __m256d n = _mm256_set1_pd(static_cast<f64>(count));
+                alignas(32) f64 variance[4];
+                _mm256_store_pd(variance, _mm256_sub_pd(sumsq, _mm256_div_pd(_mm256_mul_pd(sum, sum), n)));
+
+                s32 res = 0;
+
+                for (s32 a = 1; a < 3; a++)
+                {
+                    if (variance[a] > variance[res])
+                        res = a;
+                }
+
+                return res;
+            }
+
+            // Data
+            s32 axis = -1;
+            std::vector<u32> order;
+            std::vector<f32> lo, hi;
+            std::vector<f32> lo1, hi1;
+            std::vector<f32> lo2, hi2;
+    };
+} // namespace sml
+
+#endif // sml_sweepandprune_h__
@@ -0,0 +1,120 @@
+#ifndef sml_swizzle_h__
+#define sml_swizzle_h__
+
+/* swizzle.h -- compile time swizzles of the 'Simple Math Library'
+  Copyright (C) 2020 Roderick Griffioen
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <immintrin.h>
+
+#include "smltypes.h"
+#include "simd.h"
+#include "vec2.h"
+#include "vec3.h"
+#include "vec4.h"
+
+namespace sml
+{
+    template<typename V>
+    struct vectraits;
+
+    template<typename T>
+    struct vectraits<vec2<T>>
+    {
+        typedef T type;
+        static constexpr u32 size = 2;
+    };
+
+    template<typename T>
+    struct vectraits<vec3<T>>
+    {
+        typedef T type;
+        static constexpr u32 size = 3;
+    };
+
+    template<typename T>
+    struct vectraits<vec4<T>>
+    {
+        typedef T type;
+        static constexpr u32 size = 4;
+    };
+
+    // Copies lanes I0..I3 of src into dst and zeroes every lane from N upwards,
+    // all vector types store four lanes so this works for any source and result size
+    template<u32 N, u32 I0, u32 I1, u32 I2, u32 I3, typename T>
+    inline void swizzlelanes(const T* src, T* dst) noexcept
+    {
+        constexpr s32 unused = (0xF << N) & 0xF;
+
+        if constexpr (std::is_same<T, f32>::value)
+        {
+            __m128 res = simd::shuffle<I0, I1, I2, I3>(simd::load(src));
+
+            simd::store(dst, _mm_blend_ps(res, _mm_setzero_ps(), unused));
+        }
+        else if constexpr (std::is_same<T, f64>::value)
+        {
+            __m256d res = simd::shuffle<I0, I1, I2, I3>(simd::load(src));
+
+            simd::store(dst, _mm256_blend_pd(res, _mm256_setzero_pd(), unused));
+        }
+        else
+        {
+            const T lanes[4] = { src[I0], src[I1], src[I2], src[I3] };
+
+            for (u32 i = 0; i < 4; i++)
+            {
+                dst[i] = i < N ? lanes[i] : static_cast<T>(0);
+            }
+        }
+    }
+
+    // swizzle<1, 0>(v), swizzle<2, 1, 0>(v) and swizzle<2, 1, 0, 3>(v) build a vec2, vec3 or vec4 from any vector
+    template<u32 I0, u32 I1, typename V>
+    SML_NO_DISCARD inline vec2<typename vectraits<V>::type> swizzle(const V& v) noexcept
+    {
+        static_assert(I0 < vectraits<V>::size && I1 < vectraits<V>::size, "swizzle index out of range");
+
+        vec2<typename vectraits<V>::type> result;
+        swizzlelanes<2, I0, I1, 0, 0>(v.v, result.v);
+
+        return result;
+    }
+
+    template<u32 I0, u32 I1, u32 I2, typename V>
+    SML_NO_DISCARD inline vec3<typename vectraits<V>::type> swizzle(const V& v) noexcept
+    {
+        static_assert(I0 < vectraits<V>::size && I1 < vectraits<V>::size && I2 < vectraits<V>::size, "swizzle index out of range");
+
+        vec3<typename vectraits<V>::type> result;
+        swizzlelanes<3, I0, I1, I2, 0>(v.v, result.v);
+
+        return result;
+    }
+
+    template<u32 I0, u32 I1, u32 I2, u32 I3, typename V>
+    SML_NO_DISCARD inline vec4<typename vectraits<V>::type> swizzle(const V& v) noexcept
+    {
+        static_assert(I0 < vectraits<V>::size && I1 < vectraits<V>::size && I2 < vectraits<V>::size && I3 < vectraits<V>::size, "swizzle index out of range");
+
+        vec4<typename vectraits<V>::type> result;
+        swizzlelanes<4, I0, I1, I2, I3>(v.v, result.v);
+
+        return result;
+    }
+} // namespace sml
+
+#endif // sml_swizzle_h__
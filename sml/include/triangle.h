@@ -0,0 +1,449 @@
+#ifndef sml_triangle_h__
+#define sml_triangle_h__
+
+/* triangle.h -- ray triangle intersection of the 'Simple Math Library'
+  Copyright (C) 2020 Roderick Griffioen
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <cstddef>
+#include <limits>
+#include <immintrin.h>
+
+#include "smltypes.h"
+#include "common.h"
+#include "simd.h"
+#include "vec3.h"
+#include "ray.h"
+
+namespace sml
+{
+    // Closest hit so far, t doubles as the upper bound of the search. The hit point is
+    // (1 - u - v) * v0 + u * v1 + v * v2.
+    struct trianglehit
+    {
+        f32 t = std::numeric_limits<f32>::infinity();
+        f32 u = 0.0f;
+        f32 v = 0.0f;
+        u32 triangle = ~0u;
+    };
+
+    // Moller-Trumbore, returns true for hits with 0 < t < tmax
+    template<typename T>
+    SML_NO_DISCARD inline bool intersects(const ray<T>& r, const vec3<T>& v0, const vec3<T>& v1, const vec3<T>& v2, T tmax, T& t, T& u, T& v) noexcept
+    {
+        vec3<T> e1 = v1 - v0;
+        vec3<T> e2 = v2 - v0;
+        vec3<T> p = vec3<T>::cross(r.direction, e2);
+        T det = vec3<T>::dot(e1, p);
+
+        if (det == static_cast<T>(0))
+            return false;
+
+        T inv = static_cast<T>(1) / det;
+        vec3<T> s = r.origin - v0;
+
+        u = vec3<T>::dot(s, p) * inv;
+        if (u < static_cast<T>(0) || u > static_cast<T>(1))
+            return false;
+
+        vec3<T> q = vec3<T>::cross(s, e1);
+
+        v = vec3<T>::dot(r.direction, q) * inv;
+        if (v < static_cast<T>(0) || u + v > static_cast<T>(1))
+            return false;
+
+        t = vec3<T>::dot(e2, q) * inv;
+
+        return t > static_cast<T>(0) && t < tmax;
+    }
+
+    // Ray in the sheared space of the watertight test (Woop, Benthin and Wald), z is the dominant
+    // direction axis and the shear maps the direction onto +z
+    template<typename T>
+    class watertightray
+    {
+        public:
+            explicit watertightray(const ray<T>& r) noexcept : origin(r.origin)
+            {
+                vec3<T> d = r.direction;
+
+                kz = sml::abs(d.x) > sml::abs(d.y) ? (sml::abs(d.x) > sml::abs(d.z) ? 0 : 2) : (sml::abs(d.y) > sml::abs(d.z) ? 1 : 2);
+                kx = (kz + 1) % 3;
+                ky = (kx + 1) % 3;
+
+                // Keep the winding independent of the direction
+                if (d.v[kz] < static_cast<T>(0))
+                {
+                    s32 k = kx;
+                    kx = ky;
+                    ky = k;
+                }
+
+                sx = d.v[kx] / d.v[kz];
+                sy = d.v[ky] / d.v[kz];
+                sz = static_cast<T>(1) / d.v[kz];
+            }
+
+            // Data
+            vec3<T> origin;
+            s32 kx, ky, kz;
+            T sx, sy, sz;
+    };
+
+    // Watertight test, a ray through an edge or vertex shared by several triangles hits at least one of
+    // them and never slips through a closed mesh. Without a tie-break it may report more than one.
+    template<typename T>
+    SML_NO_DISCARD inline bool intersectswatertight(const watertightray<T>& r, const vec3<T>& v0, const vec3<T>& v1, const vec3<T>& v2, T tmax, T& t, T& u, T& v) noexcept
+    {
+        vec3<T> a = v0 - r.origin;
+        vec3<T> b = v1 - r.origin;
+        vec3<T> c = v2 - r.origin;
+
+        T ax = a.v[r.kx] - r.sx * a.v[r.kz], ay = a.v[r.ky] - r.sy * a.v[r.kz];
+        T bx = b.v[r.kx] - r.sx * b.v[r.kz], by = b.v[r.ky] - r.sy * b.v[r.kz];
+        T cx = c.v[r.kx] - r.sx * c.v[r.kz], cy = c.v[r.ky] - r.sy * c.v[r.kz];
+
+        T e0 = cx * by - cy * bx;
+        T e1 = ax * cy - ay * cx;
+        T e2 = bx * ay - by * ax;
+
+        // Edges through the ray are decided in double precision
+        if constexpr (std::is_same<T, f32>::value)
+        {
+            if (e0 == 0.0f || e1 == 0.0f || e2 == 0.0f)
+            {
+                e0 = static_cast<f32>(static_cast<f64>(cx) * by - static_cast<f64>(cy) * bx);
+                e1 = static_cast<f32>(static_cast<f64>(ax) * cy - static_cast<f64>(ay) * cx);
+                e2 = static_cast<f32>(static_cast<f64>(bx) * ay - static_cast<f64>(by) * ax);
+            }
+        }
+
+        T zero = static_cast<T>(0);
+
+        if ((e0 < zero || e1 < zero || e2 < zero) && (e0 > zero || e1 > zero || e2 > zero))
+            return false;
+
+        T det = e0 + e1 + e2;
+
+        if (det == zero)
+            return false;
+
+        T az = r.sz * a.v[r.kz], bz = r.sz * b.v[r.kz], cz = r.sz * c.v[r.kz];
+        T scaled = e0 * az + e1 * bz + e2 * cz;
+
+        // t = scaled / det must lie in (0, tmax), compared without dividing
+        T sign = det < zero ? static_cast<T>(-1) : static_cast<T>(1);
+
+        if (scaled * sign <= zero || scaled * sign >= tmax * det * sign)
+            return false;
+
+        T inv = static_cast<T>(1) / det;
+
+        t = scaled * inv;
+        u = e1 * inv;
+        v = e2 * inv;
+
+        return true;
+    }
+
+    template<typename T>
+    SML_NO_DISCARD inline bool intersectswatertight(const ray<T>& r, const vec3<T>& v0, const vec3<T>& v1, const vec3<T>& v2, T tmax, T& t, T& u, T& v) noexcept
+    {
+        return intersectswatertight(watertightray<T>(r), v0, v1, v2, tmax, t, u, v);
+    }
+
+    // Eight triangles in SoA layout, v0[axis][lane]. Unused lanes are degenerate and never hit.
+    class alignas(32) triangle8
+    {
+        public:
+            triangle8() noexcept
+            {
+                for (s32 i = 0; i < 8; i++)
+                {
+                    set(i, vec3<f32>(0.0f), vec3<f32>(0.0f), vec3<f32>(0.0f), ~0u);
+                }
+            }
+
+            // Operations
+            inline void set(s32 i, const vec3<f32>& a, const vec3<f32>& b, const vec3<f32>& c, u32 triangle) noexcept
+            {
+                for (s32 k = 0; k < 3; k++)
+                {
+                    v0[k][i] = a.v[k];
+                    v1[k][i] = b.v[k];
+                    v2[k][i] = c.v[k];
+                }
+
+                index[i] = triangle;
+            }
+
+            // Data
+            f32 v0[3][8];
+            f32 v1[3][8];
+            f32 v2[3][8];
+            u32 index[8];
+    };
+
+    // Fills (trianglecount + 7) / 8 blocks from an indexed mesh, triangle i uses vertices indices[3i..3i+2]
+    inline size_t packtriangles(const vec3<f32>* vertices, const u32* indices, size_t trianglecount, triangle8* blocks) noexcept
+    {
+        size_t blockcount = (trianglecount + 7) / 8;
+
+        for (size_t b = 0; b < blockcount; b++)
+        {
+            blocks[b] = triangle8();
+
+            for (size_t i = 0; i < 8 && b * 8 + i < trianglecount; i++)
+            {
+                const u32* tri = indices + (b * 8 + i) * 3;
+
+                blocks[b].set(static_cast<s32>(i), vertices[tri[0]], vertices[tri[1]], vertices[tri[2]], static_cast<u32>(b * 8 + i));
+            }
+        }
+
+        return blockcount;
+    }
+
+    // Triangle soup variant, triangle i uses vertices 3i..3i+2
+    inline size_t packtriangles(const vec3<f32>* vertices, size_t trianglecount, triangle8* blocks) noexcept
+    {
+        size_t blockcount = (trianglecount + 7) / 8;
+
+        for (size_t b = 0; b < blockcount; b++)
+        {
+            blocks[b] = triangle8();
+
+            for (size_t i = 0; i < 8 && b * 8 + i < trianglecount; i++)
+            {
+                const vec3<f32>* tri = vertices + (b * 8 + i) * 3;
+
+                blocks[b].set(static_cast<s32>(i), tri[0], tri[1], tri[2], static_cast<u32>(b * 8 + i));
+            }
+        }
+
+        return blockcount;
+    }
+
+    // Moller-Trumbore against eight triangles, bit i is set when triangle i is hit with 0 < t < tmax
+    inline u32 intersects(const ray<f32>& r, const triangle8& block, __m256 tmax, __m256& t, __m256& u, __m256& v) noexcept
+    {
+        __m256 zero = _mm256_setzero_ps();
+        __m256 one = _mm256_set1_ps(1.0f);
+
+        __m256 dx = _mm256_set1_ps(r.direction.x), dy = _mm256_set1_ps(r.direction.y), dz = _mm256_set1_ps(r.direction.z);
+
+        __m256 v0x = _mm256_load_ps(block.v0[0]), v0y = _mm256_load_ps(block.v0[1]), v0z = _mm256_load_ps(block.v0[2]);
+
+        __m256 e1x = _mm256_sub_ps(_mm256_load_ps(block.v1[0]), v0x);
+        __m256 e1y = _mm256_sub_ps(_mm256_load_ps(block.v1[1]), v0y);
+        __m256 e1z = _mm256_sub_ps(_mm256_load_ps(block.v1[2]), v0z);
+        __m256 e2x = _mm256_sub_ps(_mm256_load_ps(block.v2[0]), v0x);
+        __m256 e2y = _mm256_sub_ps(_mm256_load_ps(block.v2[1]), v0y);
+        __m256 e2z = _mm256_sub_ps(_mm256_load_ps(block.v2[2]), v0z);
+
+        // p = d x e2
+        __m256 px = _mm256_sub_ps(_mm256_mul_ps(dy, e2z), _mm256_mul_ps(dz, e2y));
+        __m256 py = _mm256_sub_ps(_mm256_mul_ps(dz, e2x), _mm256_mul_ps(dx, e2z));
+        __m256 pz = _mm256_sub_ps(_mm256_mul_ps(dx, e2y), _mm256_mul_ps(dy, e2x));
+
+        __m256 det = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e1x, px), _mm256_mul_ps(e1y, py)), _mm256_mul_ps(e1z, pz));
+        __m256 inv = _mm256_div_ps(one, det);
+
+        __m256 sx = _mm256_sub_ps(_mm256_set1_ps(r.origin.x), v0x);
+        __m256 sy = _mm256_sub_ps(_mm256_set1_ps(r.origin.y), v0y);
+        __m256 sz = _mm256_sub_ps(_mm256_set1_ps(r.origin.z), v0z);
+
+        u = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(sx, px), _mm256_mul_ps(sy, py)), _mm256_mul_ps(sz, pz)), inv);
+
+        // q = s x e1
+        __m256 qx = _mm256_sub_ps(_mm256_mul_ps(sy, e1z), _mm256_mul_ps(sz, e1y));
+        __m256 qy = _mm256_sub_ps(_mm256_mul_ps(sz, e1x), _mm256_mul_ps(sx, e1z));
+        __m256 qz = _mm256_sub_ps(_mm256_mul_ps(sx, e1y), _mm256_mul_ps(sy, e1x));
+
+        v = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, qx), _mm256_mul_ps(dy, qy)), _mm256_mul_ps(dz, qz)), inv);
+        t = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e2x, qx), _mm256_mul_ps(e2y, qy)), _mm256_mul_ps(e2z, qz)), inv);
+
+        // Degenerate triangles and parallel rays give det == 0, inv = inf and NaN or inf coordinates
+        // which fail the ordered compares below
+        __m256 valid = _mm256_cmp_ps(det, zero, _CMP_NEQ_OQ);
+        valid = _mm256_and_ps(valid, _mm256_cmp_ps(u, zero, _CMP_GE_OQ));
+        valid = _mm256_and_ps(valid, _mm256_cmp_ps(v, zero, _CMP_GE_OQ));
+        valid = _mm256_and_ps(valid, _mm256_cmp_ps(_mm256_add_ps(u, v), one, _CMP_LE_OQ));
+        valid = _mm256_and_ps(valid, _mm256_cmp_ps(t, zero, _CMP_GT_OQ));
+        valid = _mm256_and_ps(valid, _mm256_cmp_ps(t, tmax, _CMP_LT_OQ));
+
+        return static_cast<u32>(_mm256_movemask_ps(valid));
+    }
+
+    // Watertight test against eight triangles
+    inline u32 intersectswatertight(const watertightray<f32>& r, const triangle8& block, __m256 tmax, __m256& t, __m256& u, __m256& v) noexcept
+    {
+        __m256 zero = _mm256_setzero_ps();
+        __m256 sx = _mm256_set1_ps(r.sx), sy = _mm256_set1_ps(r.sy), sz = _mm256_set1_ps(r.sz);
+        __m256 ox = _mm256_set1_ps(r.origin.v[r.kx]), oy = _mm256_set1_ps(r.origin.v[r.ky]), oz = _mm256_set1_ps(r.origin.v[r.kz]);
+
+        // The permutation of the axes is the same for every lane, so it selects rows of the block
+        __m256 az = _mm256_sub_ps(_mm256_load_ps(block.v0[r.kz]), oz);
+        __m256 bz = _mm256_sub_ps(_mm256_load_ps(block.v1[r.kz]), oz);
+        __m256 cz = _mm256_sub_ps(_mm256_load_ps(block.v2[r.kz]), oz);
+
+        __m256 ax = _mm256_sub_ps(_mm256_sub_ps(_mm256_load_ps(block.v0[r.kx]), ox), _mm256_mul_ps(sx, az));
+        __m256 ay = _mm256_sub_ps(_mm256_sub_ps(_mm256_load_ps(block.v0[r.ky]), oy), _mm256_mul_ps(sy, az));
+        __m256 bx = _mm256_sub_ps(_mm256_sub_ps(_mm256_load_ps(block.v1[r.kx]), ox), _mm256_mul_ps(sx, bz));
+        __m256 by = _mm256_sub_ps(_mm256_sub_ps(_mm256_load_ps(block.v1[r.ky]), oy), _mm256_mul_ps(sy, bz));
+        __m256 cx = _mm256_sub_ps(_mm256_sub_ps(_mm256_load_ps(block.v2[r.kx]), ox), _mm256_mul_ps(sx, cz));
+        __m256 cy = _mm256_sub_ps(_mm256_sub_ps(_mm256_load_ps(block.v2[r.ky]), oy), _mm256_mul_ps(sy, cz));
+
+        __m256 e0 = _mm256_sub_ps(_mm256_mul_ps(cx, by), _mm256_mul_ps(cy, bx));
+        __m256 e1 = _mm256_sub_ps(_mm256_mul_ps(ax, cy), _mm256_mul_ps(ay, cx));
+        __m256 e2 = _mm256_sub_ps(_mm256_mul_ps(bx, ay), _mm256_mul_ps(by, ax));
+
+        // Edges through the ray are decided in double precision, this is rare enough to branch on
+        __m256 exact = _mm256_or_ps(_mm256_or_ps(_mm256_cmp_ps(e0, zero, _CMP_EQ_OQ), _mm256_cmp_ps(e1, zero, _CMP_EQ_OQ)), _mm256_cmp_ps(e2, zero, _CMP_EQ_OQ));
+
+        if (_mm256_movemask_ps(exact) != 0)
+        {
+            __m256d d[2][3];
+
+            for (s32 h = 0; h < 2; h++)
+            {
+                __m256d dax = _mm256_cvtps_pd(h == 0 ? _mm256_castps256_ps128(ax) : _mm256_extractf128_ps(ax, 1));
+                __m256d day = _mm256_cvtps_pd(h == 0 ? _mm256_castps256_ps128(ay) : _mm256_extractf128_ps(ay, 1));
+                __m256d dbx = _mm256_cvtps_pd(h == 0 ? _mm256_castps256_ps128(bx) : _mm256_extractf128_ps(bx, 1));
+                __m256d dby = _mm256_cvtps_pd(h == 0 ? _mm256_castps256_ps128(by) : _mm256_extractf128_ps(by, 1));
+                __m256d dcx = _mm256_cvtps_pd(h == 0 ? _mm256_castps256_ps128(cx) : _mm256_extractf128_ps(cx, 1));
+                __m256d dcy = _mm256_cvtps_pd(h == 0 ? _mm256_castps256_ps128(cy) : _mm256_extractf128_ps(cy, 1));
+
+                d[h][0] = _mm256_sub_pd(_mm256_mul_pd(dcx, dby), _mm256_mul_pd(dcy, dbx));
+                d[h][1] = _mm256_sub_pd(_mm256_mul_pd(dax, dcy), _mm256_mul_pd(day, dcx));
+                d[h][2] = _mm256_sub_pd(_mm256_mul_pd(dbx, day), _mm256_mul_pd(dby, dax));
+            }
+
+            e0 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(d[0][0])), _mm256_cvtpd_ps(d[1][0]), 1);
+            e1 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(d[0][1])), _mm256_cvtpd_ps(d[1][1]), 1);
+            e2 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(d[0][2])), _mm256_cvtpd_ps(d[1][2]), 1);
+        }
+
+        __m256 anynegative = _mm256_or_ps(_mm256_or_ps(_mm256_cmp_ps(e0, zero, _CMP_LT_OQ), _mm256_cmp_ps(e1, zero, _CMP_LT_OQ)), _mm256_cmp_ps(e2, zero, _CMP_LT_OQ));
+        __m256 anypositive = _mm256_or_ps(_mm256_or_ps(_mm256_cmp_ps(e0, zero, _CMP_GT_OQ), _mm256_cmp_ps(e1, zero, _CMP_GT_OQ)), _mm256_cmp_ps(e2, zero, _CMP_GT_OQ));
+
+        __m256 det = _mm256_add_ps(_mm256_add_ps(e0, e1), e2);
+        __m256 scaled = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e0, _mm256_mul_ps(sz, az)), _mm256_mul_ps(e1, _mm256_mul_ps(sz, bz))),
+                                      _mm256_mul_ps(e2, _mm256_mul_ps(sz, cz)));
+
+        // Compare t = scaled / det against (0, tmax) with the sign of det moved onto both sides
+        __m256 sign = _mm256_and_ps(det, _mm256_set1_ps(-0.0f));
+        __m256 signedscaled = _mm256_xor_ps(scaled, sign);
+        __m256 absdet = _mm256_xor_ps(det, sign);
+
+        __m256 valid = _mm256_andnot_ps(_mm256_and_ps(anynegative, anypositive), _mm256_cmp_ps(det, zero, _CMP_NEQ_OQ));
+        valid = _mm256_and_ps(valid, _mm256_cmp_ps(signedscaled, zero, _CMP_GT_OQ));
+        valid = _mm256_and_ps(valid, _mm256_cmp_ps(signedscaled, _mm256_mul_ps(tmax, absdet), _CMP_LT_OQ));
+
+        __m256 inv = _mm256_div_ps(_mm256_set1_ps(1.0f), det);
+
+        t = _mm256_mul_ps(scaled, inv);
+        u = _mm256_mul_ps(e1, inv);
+        v = _mm256_mul_ps(e2, inv);
+
+        return static_cast<u32>(_mm256_movemask_ps(valid));
+    }
+
+    // Moves the nearest of the masked lanes into hit, hits must be closer than hit.t
+    inline void closesthit(u32 mask, const triangle8& block, __m256 t, __m256 u, __m256 v, trianglehit& hit) noexcept
+    {
+        // Expand the lane mask back into a register, AVX has no 256 bit integer compare so go through float
+        __m256 bits = _mm256_and_ps(_mm256_castsi256_ps(_mm256_set1_epi32(static_cast<s32>(mask))), _mm256_castsi256_ps(_mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128)));
+        __m256 selected = _mm256_cmp_ps(_mm256_cvtepi32_ps(_mm256_castps_si256(bits)), _mm256_setzero_ps(), _CMP_NEQ_OQ);
+        __m256 masked = simd::select(selected, _mm256_set1_ps(std::numeric_limits<f32>::infinity()), t);
+
+        __m256 nearest = _mm256_min_ps(masked, _mm256_permute2f128_ps(masked, masked, 0x01));
+        nearest = _mm256_min_ps(nearest, _mm256_permute_ps(nearest, _MM_SHUFFLE(1, 0, 3, 2)));
+        nearest = _mm256_min_ps(nearest, _mm256_permute_ps(nearest, _MM_SHUFFLE(2, 3, 0, 1)));
+
+        u32 lane = lowestbit(static_cast<u32>(_mm256_movemask_ps(_mm256_cmp_ps(masked, nearest, _CMP_EQ_OQ))) & mask);
+
+        alignas(32) f32 ts[8], us[8], vs[8];
+        _mm256_store_ps(ts, t);
+        _mm256_store_ps(us, u);
+        _mm256_store_ps(vs, v);
+
+        hit.t = ts[lane];
+        hit.u = us[lane];
+        hit.v = vs[lane];
+        hit.triangle = block.index[lane];
+    }
+
+    // Closest hit over all blocks, returns true when hit was updated
+    inline bool intersects(const ray<f32>& r, const triangle8* blocks, size_t blockcount, trianglehit& hit) noexcept
+    {
+        bool found = false;
+
+        for (size_t b = 0; b < blockcount; b++)
+        {
+            __m256 t, u, v;
+            u32 mask = intersects(r, blocks[b], _mm256_set1_ps(hit.t), t, u, v);
+
+            if (mask != 0)
+            {
+                closesthit(mask, blocks[b], t, u, v, hit);
+                found = true;
+            }
+        }
+
+        return found;
+    }
+
+    inline bool intersectswatertight(const ray<f32>& r, const triangle8* blocks, size_t blockcount, trianglehit& hit) noexcept
+    {
+        watertightray<f32> sheared(r);
+        bool found = false;
+
+        for (size_t b = 0; b < blockcount; b++)
+        {
+            __m256 t, u, v;
+            u32 mask = intersectswatertight(sheared, blocks[b], _mm256_set1_ps(hit.t), t, u, v);
+
+            if (mask != 0)
+            {
+                closesthit(mask, blocks[b], t, u, v, hit);
+                found = true;
+            }
+        }
+
+        return found;
+    }
+
+    // Any hit with 0 < t < tmax, the early out query of line of sight checks
+    inline bool occluded(const ray<f32>& r, const triangle8* blocks, size_t blockcount, f32 tmax) noexcept
+    {
+        watertightray<f32> sheared(r);
+        __m256 limit = _mm256_set1_ps(tmax);
+
+        for (size_t b = 0; b < blockcount; b++)
+        {
+            __m256 t, u, v;
+
+            if (intersectswatertight(sheared, blocks[b], limit, t, u, v) != 0)
+                return true;
+        }
+
+        return false;
+    }
+} // namespace sml
+
+#endif // sml_triangle_h__
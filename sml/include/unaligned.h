@@ -0,0 +1,541 @@
+#ifndef sml_unaligned_h__
+#define sml_unaligned_h__
+
+/* unaligned.h -- unaligned vector and matrix views of the 'Simple Math Library'
+  Copyright (C) 2020 Roderick Griffioen
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <immintrin.h>
+
+#include "smltypes.h"
+#include "simd.h"
+#include "vec2.h"
+#include "vec3.h"
+#include "vec4.h"
+#include "mat2.h"
+#include "mat3.h"
+#include "mat4.h"
+
+namespace sml
+{
+    // unaligned<V> is a non-owning view of the tightly packed components of a V (2, 3 or 4 scalars for
+    // vectors, column major 4, 9 or 16 scalars for matrices) at any address, such as a vertex buffer,
+    // a network packet or a mapped file. Loads and stores never touch memory past the last component.
+    template<typename V>
+    class unaligned;
+
+    template<typename T>
+    class unaligned<vec2<T>>
+    {
+        public:
+            constexpr explicit unaligned(T* data) noexcept : data(data)
+            {
+            }
+
+            explicit unaligned(void* data) noexcept : data(static_cast<T*>(data))
+            {
+            }
+
+            SML_NO_DISCARD inline vec2<T> load() const noexcept
+            {
+                return load(data);
+            }
+
+            inline void store(const vec2<T>& value) noexcept
+            {
+                store(data, value);
+            }
+
+            operator vec2<T>() const noexcept
+            {
+                return load(data);
+            }
+
+            unaligned& operator = (const vec2<T>& value) noexcept
+            {
+                store(data, value);
+
+                return *this;
+            }
+
+            // Statics
+            SML_NO_DISCARD static inline vec2<T> load(const T* p) noexcept
+            {
+                vec2<T> result;
+
+                if constexpr (std::is_same<T, f32>::value)
+                {
+                    simd::store(result.v, _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(p)));
+
+                    return result;
+                }
+
+                if constexpr (std::is_same<T, f64>::value)
+                {
+                    simd::store2(result.v, _mm_loadu_pd(p));
+
+                    return result;
+                }
+
+                result.set(p[0], p[1]);
+
+                return result;
+            }
+
+            static inline void store(T* p, const vec2<T>& value) noexcept
+            {
+                if constexpr (std::is_same<T, f32>::value)
+                {
+                    _mm_storel_pi(reinterpret_cast<__m64*>(p), simd::load(value.v));
+
+                    return;
+                }
+
+                if constexpr (std::is_same<T, f64>::value)
+                {
+                    _mm_storeu_pd(p, simd::load2(value.v));
+
+                    return;
+                }
+
+                p[0] = value.x;
+                p[1] = value.y;
+            }
+
+            // Data
+            T* data;
+    };
+
+    template<typename T>
+    class unaligned<vec3<T>>
+    {
+        public:
+            constexpr explicit unaligned(T* data) noexcept : data(data)
+            {
+            }
+
+            explicit unaligned(void* data) noexcept : data(static_cast<T*>(data))
+            {
+            }
+
+            SML_NO_DISCARD inline vec3<T> load() const noexcept
+            {
+                return load(data);
+            }
+
+            inline void store(const vec3<T>& value) noexcept
+            {
+                store(data, value);
+            }
+
+            operator vec3<T>() const noexcept
+            {
+                return load(data);
+            }
+
+            unaligned& operator = (const vec3<T>& value) noexcept
+            {
+                store(data, value);
+
+                return *this;
+            }
+
+            // Statics
+            SML_NO_DISCARD static inline vec3<T> load(const T* p) noexcept
+            {
+                vec3<T> result;
+
+                if constexpr (std::is_same<T, f32>::value)
+                {
+                    __m128 xy = _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(p));
+
+                    simd::store(result.v, _mm_movelh_ps(xy, _mm_load_ss(p + 2)));
+
+                    return result;
+                }
+
+                if constexpr (std::is_same<T, f64>::value)
+                {
+                    simd::store(result.v, _mm256_maskload_pd(p, _mm256_setr_epi64x(-1, -1, -1, 0)));
+
+                    return result;
+                }
+
+                result.set(p[0], p[1], p[2]);
+
+                return result;
+            }
+
+            static inline void store(T* p, const vec3<T>& value) noexcept
+            {
+                if constexpr (std::is_same<T, f32>::value)
+                {
+                    __m128 v = simd::load(value.v);
+
+                    _mm_storel_pi(reinterpret_cast<__m64*>(p), v);
+                    _mm_store_ss(p + 2, _mm_movehl_ps(v, v));
+
+                    return;
+                }
+
+                if constexpr (std::is_same<T, f64>::value)
+                {
+                    _mm256_maskstore_pd(p, _mm256_setr_epi64x(-1, -1, -1, 0), simd::load(value.v));
+
+                    return;
+                }
+
+                p[0] = value.x;
+                p[1] = value.y;
+                p[2] = value.z;
+            }
+
+            // Data
+            T* data;
+    };
+
+    template<typename T>
+    class unaligned<vec4<T>>
+    {
+        public:
+            constexpr explicit unaligned(T* data) noexcept : data(data)
+            {
+            }
+
+            explicit unaligned(void* data) noexcept : data(static_cast<T*>(data))
+            {
+            }
+
+            SML_NO_DISCARD inline vec4<T> load() const noexcept
+            {
+                return load(data);
+            }
+
+            inline void store(const vec4<T>& value) noexcept
+            {
+                store(data, value);
+            }
+
+            operator vec4<T>() const noexcept
+            {
+                return load(data);
+            }
+
+            unaligned& operator = (const vec4<T>& value) noexcept
+            {
+                store(data, value);
+
+                return *this;
+            }
+
+            // Statics
+            SML_NO_DISCARD static inline vec4<T> load(const T* p) noexcept
+            {
+                vec4<T> result;
+
+                if constexpr (std::is_same<T, f32>::value)
+                {
+                    simd::store(result.v, _mm_loadu_ps(p));
+
+                    return result;
+                }
+
+                if constexpr (std::is_same<T, f64>::value)
+                {
+                    simd::store(result.v, _mm256_loadu_pd(p));
+
+                    return result;
+                }
+
+                result.set(p[0], p[1], p[2], p[3]);
+
+                return result;
+            }
+
+            static inline void store(T* p, const vec4<T>& value) noexcept
+            {
+                if constexpr (std::is_same<T, f32>::value)
+                {
+                    _mm_storeu_ps(p, simd::load(value.v));
+
+                    return;
+                }
+
+                if constexpr (std::is_same<T, f64>::value)
+                {
+                    _mm256_storeu_pd(p, simd::load(value.v));
+
+                    return;
+                }
+
+                p[0] = value.x;
+                p[1] = value.y;
+                p[2] = value.z;
+                p[3] = value.w;
+            }
+
+            // Data
+            T* data;
+    };
+
+    template<typename T>
+    class unaligned<mat2<T>>
+    {
+        public:
+            constexpr explicit unaligned(T* data) noexcept : data(data)
+            {
+            }
+
+            explicit unaligned(void* data) noexcept : data(static_cast<T*>(data))
+            {
+            }
+
+            SML_NO_DISCARD inline mat2<T> load() const noexcept
+            {
+                return load(data);
+            }
+
+            inline void store(const mat2<T>& value) noexcept
+            {
+                store(data, value);
+            }
+
+            operator mat2<T>() const noexcept
+            {
+                return load(data);
+            }
+
+            unaligned& operator = (const mat2<T>& value) noexcept
+            {
+                store(data, value);
+
+                return *this;
+            }
+
+            // Statics
+            SML_NO_DISCARD static inline mat2<T> load(const T* p) noexcept
+            {
+                mat2<T> result;
+
+                if constexpr (std::is_same<T, f32>::value)
+                {
+                    simd::store(result.v, _mm_loadu_ps(p));
+
+                    return result;
+                }
+
+                if constexpr (std::is_same<T, f64>::value)
+                {
+                    simd::store(result.v, _mm256_loadu_pd(p));
+
+                    return result;
+                }
+
+                for (s32 i = 0; i < 4; i++)
+                {
+                    result.v[i] = p[i];
+                }
+
+                return result;
+            }
+
+            static inline void store(T* p, const mat2<T>& value) noexcept
+            {
+                if constexpr (std::is_same<T, f32>::value)
+                {
+                    _mm_storeu_ps(p, simd::load(value.v));
+
+                    return;
+                }
+
+                if constexpr (std::is_same<T, f64>::value)
+                {
+                    _mm256_storeu_pd(p, simd::load(value.v));
+
+                    return;
+                }
+
+                for (s32 i = 0; i < 4; i++)
+                {
+                    p[i] = value.v[i];
+                }
+            }
+
+            // Data
+            T* data;
+    };
+
+    template<typename T>
+    class unaligned<mat3<T>>
+    {
+        public:
+            constexpr explicit unaligned(T* data) noexcept : data(data)
+            {
+            }
+
+            explicit unaligned(void* data) noexcept : data(static_cast<T*>(data))
+            {
+            }
+
+            SML_NO_DISCARD inline mat3<T> load() const noexcept
+            {
+                return load(data);
+            }
+
+            inline void store(const mat3<T>& value) noexcept
+            {
+                store(data, value);
+            }
+
+            operator mat3<T>() const noexcept
+            {
+                return load(data);
+            }
+
+            unaligned& operator = (const mat3<T>& value) noexcept
+            {
+                store(data, value);
+
+                return *this;
+            }
+
+            // Statics
+            SML_NO_DISCARD static inline mat3<T> load(const T* p) noexcept
+            {
+                mat3<T> result;
+
+                result.col0 = unaligned<vec3<T>>::load(p + 0);
+                result.col1 = unaligned<vec3<T>>::load(p + 3);
+                result.col2 = unaligned<vec3<T>>::load(p + 6);
+
+                return result;
+            }
+
+            static inline void store(T* p, const mat3<T>& value) noexcept
+            {
+                unaligned<vec3<T>>::store(p + 0, value.col0);
+                unaligned<vec3<T>>::store(p + 3, value.col1);
+                unaligned<vec3<T>>::store(p + 6, value.col2);
+            }
+
+            // Data
+            T* data;
+    };
+
+    template<typename T>
+    class unaligned<mat4<T>>
+    {
+        public:
+            constexpr explicit unaligned(T* data) noexcept : data(data)
+            {
+            }
+
+            explicit unaligned(void* data) noexcept : data(static_cast<T*>(data))
+            {
+            }
+
+            SML_NO_DISCARD inline mat4<T> load() const noexcept
+            {
+                return load(data);
+            }
+
+            inline void store(const mat4<T>& value) noexcept
+            {
+                store(data, value);
+            }
+
+            operator mat4<T>() const noexcept
+            {
+                return load(data);
+            }
+
+            unaligned& operator = (const mat4<T>& value) noexcept
+            {
+                store(data, value);
+
+                return *this;
+            }
+
+            // Statics
+            SML_NO_DISCARD static inline mat4<T> load(const T* p) noexcept
+            {
+                mat4<T> result;
+
+                for (s32 i = 0; i < 4; i++)
+                {
+                    result.col[i] = unaligned<vec4<T>>::load(p + 4 * i);
+                }
+
+                return result;
+            }
+
+            static inline void store(T* p, const mat4<T>& value) noexcept
+            {
+                for (s32 i = 0; i < 4; i++)
+                {
+                    unaligned<vec4<T>>::store(p + 4 * i, value.col[i]);
+                }
+            }
+
+            // Data
+            T* data;
+    };
+
+    // Free function forms, loadu<fvec3>(p) and storeu(p, v)
+    template<typename V, typename T>
+    SML_NO_DISCARD inline V loadu(const T* p) noexcept
+    {
+        return unaligned<V>::load(p);
+    }
+
+    template<typename T>
+    inline void storeu(T* p, const vec2<T>& value) noexcept
+    {
+        unaligned<vec2<T>>::store(p, value);
+    }
+
+    template<typename T>
+    inline void storeu(T* p, const vec3<T>& value) noexcept
+    {
+        unaligned<vec3<T>>::store(p, value);
+    }
+
+    template<typename T>
+    inline void storeu(T* p, const vec4<T>& value) noexcept
+    {
+        unaligned<vec4<T>>::store(p, value);
+    }
+
+    template<typename T>
+    inline void storeu(T* p, const mat2<T>& value) noexcept
+    {
+        unaligned<mat2<T>>::store(p, value);
+    }
+
+    template<typename T>
+    inline void storeu(T* p, const mat3<T>& value) noexcept
+    {
+        unaligned<mat3<T>>::store(p, value);
+    }
+
+    template<typename T>
+    inline void storeu(T* p, const mat4<T>& value) noexcept
+    {
+        unaligned<mat4<T>>::store(p, value);
+    }
+} // namespace sml
+
+#endif // sml_unaligned_h__
@@ -23,6 +23,7 @@
 
 #include "smltypes.h"
 #include "common.h"
+#include "simd.h"
 
 namespace sml
 {
@@ -126,23 +127,23 @@ namespace sml
             {
                 if constexpr(std::is_same<T, f32>::value)
                 {
-                    __m128 me = _mm_load_ps(v);
-                    __m128 ot = _mm_load_ps(other.v);
+                    __m128 me = simd::load(v);
+                    __m128 ot = simd::load(other.v);
 
                     __m128 res = _mm_add_ps(me, ot);
 
-                    _mm_store_ps(v, res);
+                    simd::store(v, res);
 
                     return *this;
                 }
 
                 if constexpr(std::is_same<T, f64>::value)
                 {
-                    __m128d me = _mm_load_pd(v);
-                    __m128d ot = _mm_load_pd(other.v);
+                    __m128d me = simd::load2(v);
+                    __m128d ot = simd::load2(other.v);
                     __m128d res = _mm_add_pd(me, ot);
 
-                    _mm_store_pd(v, res);
+                    simd::store2(v, res);
 
                     return *this;
                 }
@@ -157,22 +158,22 @@ namespace sml
             {
                 if constexpr(std::is_same<T, f32>::value)
                 {
-                    __m128 me = _mm_load_ps(v);
-                    __m128 ot = _mm_load_ps(other.v);
+                    __m128 me = simd::load(v);
+                    __m128 ot = simd::load(other.v);
                     __m128 res = _mm_sub_ps(me, ot);
 
-                    _mm_store_ps(v, res);
+                    simd::store(v, res);
 
                     return *this;
                 }
 
                 if constexpr(std::is_same<T, f64>::value)
                 {
-                    __m128d me = _mm_load_pd(v);
-                    __m128d ot = _mm_load_pd(other.v);
+                    __m128d me = simd::load2(v);
+                    __m128d ot = simd::load2(other.v);
                     __m128d res = _mm_sub_pd(me, ot);
 
-                    _mm_store_pd(v, res);
+                    simd::store2(v, res);
 
                     return *this;
                 }
@@ -187,22 +188,22 @@ namespace sml
             {
                 if constexpr(std::is_same<T, f32>::value)
                 {
-                    __m128 me = _mm_load_ps(v);
-                    __m128 ot = _mm_load_ps(other.v);
+                    __m128 me = simd::load(v);
+                    __m128 ot = simd::load(other.v);
                     __m128 res = _mm_mul_ps(me, ot);
 
-                    _mm_store_ps(v, res);
+                    simd::store(v, res);
 
                     return *this;
                 }
 
                 if constexpr(std::is_same<T, f64>::value)
                 {
-                    __m128d me = _mm_load_pd(v);
-                    __m128d ot = _mm_load_pd(other.v);
+                    __m128d me = simd::load2(v);
+                    __m128d ot = simd::load2(other.v);
                     __m128d res = _mm_mul_pd(me, ot);
 
-                    _mm_store_pd(v, res);
+                    simd::store2(v, res);
 
                     return *this;
                 }
@@ -217,22 +218,22 @@ namespace sml
             {
                 if constexpr(std::is_same<T, f32>::value)
                 {
-                    __m128 me = _mm_load_ps(v);
+                    __m128 me = simd::load(v);
                     __m128 ot = _mm_broadcast_ss(&other);
                     __m128 res = _mm_mul_ps(me, ot);
 
-                    _mm_store_ps(v, res);
+                    simd::store(v, res);
 
                     return *this;
                 }
 
                 if constexpr(std::is_same<T, f64>::value)
                 {
-                    __m128d me = _mm_load_pd(v);
+                    __m128d me = simd::load2(v);
                     __m128d ot = _mm_set1_pd(other);
                     __m128d res = _mm_mul_pd(me, ot);
 
-                    _mm_store_pd(v, res);
+                    simd::store2(v, res);
 
                     return *this;
                 }
@@ -247,22 +248,22 @@ namespace sml
             {
                 if constexpr(std::is_same<T, f32>::value)
                 {
-                    __m128 me = _mm_load_ps(v);
-                    __m128 ot = _mm_load_ps(other.v);
+                    __m128 me = simd::load(v);
+                    __m128 ot = simd::load(other.v);
                     __m128 res = _mm_div_ps(me, ot);
 
-                    _mm_store_ps(v, res);
+                    simd::store(v, res);
 
                     return *this;
                 }
 
                 if constexpr(std::is_same<T, f64>::value)
                 {
-                    __m128d me = _mm_load_pd(v);
-                    __m128d ot = _mm_load_pd(other.v);
+                    __m128d me = simd::load2(v);
+                    __m128d ot = simd::load2(other.v);
                     __m128d res = _mm_div_pd(me, ot);
 
-                    _mm_store_pd(v, res);
+                    simd::store2(v, res);
 
                     return *this;
                 }
@@ -277,11 +278,11 @@ namespace sml
             {
                 if constexpr(std::is_same<T, f32>::value)
                 {
-                    __m128 me = _mm_load_ps(v);
+                    __m128 me = simd::load(v);
                     __m128 ot = _mm_broadcast_ss(&other);
                     __m128 res = _mm_div_ps(me, ot);
 
-                    _mm_store_ps(v, res);
+                    simd::store(v, res);
 
                     v[2] = v[3] = static_cast<T>(0);
 
@@ -290,11 +291,11 @@ namespace sml
 
                 if constexpr(std::is_same<T, f64>::value)
                 {
-                    __m128d me = _mm_load_pd(v);
+                    __m128d me = simd::load2(v);
                     __m128d ot = _mm_set1_pd(other);
                     __m128d res = _mm_div_pd(me, ot);
 
-                    _mm_store_pd(v, res);
+                    simd::store2(v, res);
 
                     v[2] = v[3] = static_cast<T>(0);
 
@@ -312,8 +313,8 @@ namespace sml
             {
                 if constexpr (std::is_same<T, f32>::value)
                 {
-                    __m128 me = _mm_load_ps(v);
-                    __m128 ot = _mm_load_ps(other.v);
+                    __m128 me = simd::load(v);
+                    __m128 ot = simd::load(other.v);
                     __m128 product = _mm_mul_ps(me, ot);
                     __m128 dp = _mm_hadd_ps(product, product);
 
@@ -347,7 +348,7 @@ namespace sml
 
             SML_NO_DISCARD inline constexpr vec2 normalized() const  noexcept
             {
-                vec2 copy(v);
+                vec2 copy(*this);
                 copy.normalize();
 
                 return copy;
@@ -368,6 +369,36 @@ namespace sml
                 return !x && !y;
             }
 
+            template<u32 X, u32 Y>
+            SML_NO_DISCARD inline vec2 swizzle() const noexcept
+            {
+                static_assert(X < 2 && Y < 2, "vec2 swizzle index out of range");
+
+                vec2 result;
+
+                if constexpr (std::is_same<T, f32>::value)
+                {
+                    simd::store(result.v, simd::shuffle<X, Y, 2, 3>(simd::load(v)));
+
+                    return result;
+                }
+
+                if constexpr (std::is_same<T, f64>::value)
+                {
+                    simd::store2(result.v, simd::shuffle<X, Y>(simd::load2(v)));
+
+                    return result;
+                }
+
+                result.set(v[X], v[Y]);
+
+                return result;
+            }
+
+            SML_NO_DISCARD inline vec2 xx() const noexcept { return swizzle<0, 0>(); }
+            SML_NO_DISCARD inline vec2 yx() const noexcept { return swizzle<1, 0>(); }
+            SML_NO_DISCARD inline vec2 yy() const noexcept { return swizzle<1, 1>(); }
+
             SML_NO_DISCARD inline std::string toString() const noexcept
             {
                 return std::to_string(x) + ", " + std::to_string(y);
@@ -376,7 +407,7 @@ namespace sml
             // Statics
             SML_NO_DISCARD static inline constexpr vec2 normalize(const vec2& a) noexcept
             {
-                vec2 copy(a.v);
+                vec2 copy(a);
                 copy.normalize();
 
                 return copy;
@@ -399,24 +430,24 @@ namespace sml
 
                 if constexpr (std::is_same<T, f32>::value)
                 {
-                    __m128 me = _mm_load_ps(a.v);
-                    __m128 ot = _mm_load_ps(b.v);
+                    __m128 me = simd::load(a.v);
+                    __m128 ot = simd::load(b.v);
 
                     __m128 maxres = _mm_min_ps(me, ot);
 
-                    _mm_store_ps(result.v, maxres);
+                    simd::store(result.v, maxres);
 
                     return result;
                 }
 
                 if constexpr (std::is_same<T, f64>::value)
                 {
-                    __m256d me = _mm256_load_pd(a.v);
-                    __m256d ot = _mm256_load_pd(b.v);
+                    __m256d me = simd::load(a.v);
+                    __m256d ot = simd::load(b.v);
 
                     __m256d maxres = _mm256_min_pd(me, ot);
 
-                    _mm256_store_pd(result.v, maxres);
+                    simd::store(result.v, maxres);
 
                     return result;
                 }
@@ -434,24 +465,24 @@ namespace sml
 
                 if constexpr (std::is_same<T, f32>::value)
                 {
-                    __m128 me = _mm_load_ps(a.v);
-                    __m128 ot = _mm_load_ps(b.v);
+                    __m128 me = simd::load(a.v);
+                    __m128 ot = simd::load(b.v);
 
                     __m128 maxres = _mm_max_ps(me, ot);
 
-                    _mm_store_ps(result.v, maxres);
+                    simd::store(result.v, maxres);
 
                     return result;
                 }
 
                 if constexpr (std::is_same<T, f64>::value)
                 {
-                    __m256d me = _mm256_load_pd(a.v);
-                    __m256d ot = _mm256_load_pd(b.v);
+                    __m256d me = simd::load(a.v);
+                    __m256d ot = simd::load(b.v);
 
                     __m256d maxres = _mm256_max_pd(me, ot);
 
-                    _mm256_store_pd(result.v, maxres);
+                    simd::store(result.v, maxres);
 
                     return result;
                 }
@@ -23,6 +23,7 @@
 
 #include "smltypes.h"
 #include "common.h"
+#include "simd.h"
 
 namespace sml
 {
@@ -124,22 +125,22 @@ namespace sml
             {
                 if constexpr(std::is_same<T, f32>::value)
                 {
-                    __m128 me = _mm_load_ps(v);
-                    __m128 him = _mm_load_ps(other.v);
+                    __m128 me = simd::load(v);
+                    __m128 him = simd::load(other.v);
                     __m128 res = _mm_add_ps(me, him);
 
-                    _mm_store_ps(v, res);
+                    simd::store(v, res);
 
                     return *this;
                 }
 
                 if constexpr(std::is_same<T, f64>::value)
                 {
-                    __m256d me = _mm256_load_pd(v);
-                    __m256d him = _mm256_load_pd(other.v);
+                    __m256d me = simd::load(v);
+                    __m256d him = simd::load(other.v);
                     __m256d res = _mm256_add_pd(me, him);
 
-                    _mm256_store_pd(v, res);
+                    simd::store(v, res);
 
                     return *this;
                 }
@@ -155,22 +156,22 @@ namespace sml
             {
                 if constexpr(std::is_same<T, f32>::value)
                 {
-                    __m128 me = _mm_load_ps(v);
-                    __m128 him = _mm_load_ps(other.v);
+                    __m128 me = simd::load(v);
+                    __m128 him = simd::load(other.v);
                     __m128 res = _mm_sub_ps(me, him);
 
-                    _mm_store_ps(v, res);
+                    simd::store(v, res);
 
                     return *this;
                 }
 
                 if constexpr(std::is_same<T, f64>::value)
                 {
-                    __m256d me = _mm256_load_pd(v);
-                    __m256d him = _mm256_load_pd(other.v);
+                    __m256d me = simd::load(v);
+                    __m256d him = simd::load(other.v);
                     __m256d res = _mm256_sub_pd(me, him);
 
-                    _mm256_store_pd(v, res);
+                    simd::store(v, res);
 
                     return *this;
                 }
@@ -186,22 +187,22 @@ namespace sml
             {
                 if constexpr(std::is_same<T, f32>::value)
                 {
-                    __m128 me = _mm_load_ps(v);
-                    __m128 him = _mm_load_ps(other.v);
+                    __m128 me = simd::load(v);
+                    __m128 him = simd::load(other.v);
                     __m128 res = _mm_mul_ps(me, him);
 
-                    _mm_store_ps(v, res);
+                    simd::store(v, res);
 
                     return *this;
                 }
 
                 if constexpr(std::is_same<T, f64>::value)
                 {
-                    __m256d me = _mm256_load_pd(v);
-                    __m256d him = _mm256_load_pd(other.v);
+                    __m256d me = simd::load(v);
+                    __m256d him = simd::load(other.v);
                     __m256d res = _mm256_mul_pd(me, him);
 
-                    _mm256_store_pd(v, res);
+                    simd::store(v, res);
 
                     return *this;
                 }
@@ -217,22 +218,22 @@ namespace sml
             {
                 if constexpr(std::is_same<T, f32>::value)
                 {
-                    __m128 me = _mm_load_ps(v);
+                    __m128 me = simd::load(v);
                     __m128 him = _mm_broadcast_ss(&other);
                     __m128 res = _mm_mul_ps(me, him);
 
-                    _mm_store_ps(v, res);
+                    simd::store(v, res);
 
                     return *this;
                 }
 
                 if constexpr(std::is_same<T, f64>::value)
                 {
-                    __m256d me = _mm256_load_pd(v);
+                    __m256d me = simd::load(v);
                     __m256d him = _mm256_set1_pd(other);
                     __m256d res = _mm256_mul_pd(me, him);
 
-                    _mm256_store_pd(v, res);
+                    simd::store(v, res);
 
                     return *this;
                 }
@@ -248,22 +249,22 @@ namespace sml
             {
                 if constexpr(std::is_same<T, f32>::value)
                 {
-                    __m128 me = _mm_load_ps(v);
-                    __m128 him = _mm_load_ps(other.v);
+                    __m128 me = simd::load(v);
+                    __m128 him = simd::load(other.v);
                     __m128 res = _mm_div_ps(me, him);
 
-                    _mm_store_ps(v, res);
+                    simd::store(v, res);
 
                     return *this;
                 }
 
                 if constexpr(std::is_same<T, f64>::value)
                 {
-                    __m256d me = _mm256_load_pd(v);
-                    __m256d him = _mm256_load_pd(other.v);
+                    __m256d me = simd::load(v);
+                    __m256d him = simd::load(other.v);
                     __m256d res = _mm256_div_pd(me, him);
 
-                    _mm256_store_pd(v, res);
+                    simd::store(v, res);
 
                     return *this;
                 }
@@ -279,22 +280,22 @@ namespace sml
             {
                 if constexpr(std::is_same<T, f32>::value)
                 {
-                    __m128 me = _mm_load_ps(v);
+                    __m128 me = simd::load(v);
                     __m128 him = _mm_broadcast_ss(&other);
                     __m128 res = _mm_div_ps(me, him);
 
-                    _mm_store_ps(v, res);
+                    simd::store(v, res);
 
                     return *this;
                 }
 
                 if constexpr(std::is_same<T, f64>::value)
                 {
-                    __m256d me = _mm256_load_pd(v);
+                    __m256d me = simd::load(v);
                     __m256d him = _mm256_set1_pd(other);
                     __m256d res = _mm256_div_pd(me, him);
 
-                    _mm256_store_pd(v, res);
+                    simd::store(v, res);
 
                     return *this;
                 }
@@ -311,8 +312,8 @@ namespace sml
             {
                 if constexpr (std::is_same<T, f32>::value)
                 {
-                    __m128 me = _mm_load_ps(v);
-                    __m128 ot = _mm_load_ps(other.v);
+                    __m128 me = simd::load(v);
+                    __m128 ot = simd::load(other.v);
                     __m128 product = _mm_mul_ps(me, ot);
                     __m128 dp = _mm_hadd_ps(product, product);
 
@@ -346,7 +347,7 @@ namespace sml
 
             SML_NO_DISCARD inline constexpr vec3 normalized() const noexcept
             {
-                vec3 copy(v);
+                vec3 copy(*this);
                 copy.normalize();
 
                 return copy;
@@ -367,6 +368,41 @@ namespace sml
                 return !x && !y && !z;
             }
 
+            template<u32 X, u32 Y, u32 Z>
+            SML_NO_DISCARD inline vec3 swizzle() const noexcept
+            {
+                static_assert(X < 3 && Y < 3 && Z < 3, "vec3 swizzle index out of range");
+
+                vec3 result;
+
+                if constexpr (std::is_same<T, f32>::value)
+                {
+                    simd::store(result.v, simd::shuffle<X, Y, Z, 3>(simd::load(v)));
+
+                    return result;
+                }
+
+                if constexpr (std::is_same<T, f64>::value)
+                {
+                    simd::store(result.v, simd::shuffle<X, Y, Z, 3>(simd::load(v)));
+
+                    return result;
+                }
+
+                result.set(v[X], v[Y], v[Z]);
+
+                return result;
+            }
+
+            SML_NO_DISCARD inline vec3 xxx() const noexcept { return swizzle<0, 0, 0>(); }
+            SML_NO_DISCARD inline vec3 yyy() const noexcept { return swizzle<1, 1, 1>(); }
+            SML_NO_DISCARD inline vec3 zzz() const noexcept { return swizzle<2, 2, 2>(); }
+            SML_NO_DISCARD inline vec3 xzy() const noexcept { return swizzle<0, 2, 1>(); }
+            SML_NO_DISCARD inline vec3 yxz() const noexcept { return swizzle<1, 0, 2>(); }
+            SML_NO_DISCARD inline vec3 yzx() const noexcept { return swizzle<1, 2, 0>(); }
+            SML_NO_DISCARD inline vec3 zxy() const noexcept { return swizzle<2, 0, 1>(); }
+            SML_NO_DISCARD inline vec3 zyx() const noexcept { return swizzle<2, 1, 0>(); }
+
             SML_NO_DISCARD inline std::string toString() const noexcept
             {
                 return std::to_string(x) + ", " + std::to_string(y) + ", " + std::to_string(z);
@@ -375,7 +411,7 @@ namespace sml
             // Statics
             SML_NO_DISCARD static inline constexpr vec3 normalize(const vec3& a) noexcept
             {
-                vec3 copy(a.v);
+                vec3 copy(a);
                 copy.normalize();
 
                 return copy;
@@ -398,24 +434,24 @@ namespace sml
 
                 if constexpr (std::is_same<T, f32>::value)
                 {
-                    __m128 me = _mm_load_ps(a.v);
-                    __m128 ot = _mm_load_ps(b.v);
+                    __m128 me = simd::load(a.v);
+                    __m128 ot = simd::load(b.v);
 
                     __m128 maxres = _mm_min_ps(me, ot);
 
-                    _mm_store_ps(result.v, maxres);
+                    simd::store(result.v, maxres);
 
                     return result;
                 }
 
                 if constexpr (std::is_same<T, f64>::value)
                 {
-                    __m256d me = _mm256_load_pd(a.v);
-                    __m256d ot = _mm256_load_pd(b.v);
+                    __m256d me = simd::load(a.v);
+                    __m256d ot = simd::load(b.v);
 
                     __m256d maxres = _mm256_min_pd(me, ot);
 
-                    _mm256_store_pd(result.v, maxres);
+                    simd::store(result.v, maxres);
 
                     return result;
                 }
@@ -434,31 +470,31 @@ namespace sml
 
                 if constexpr (std::is_same<T, f32>::value)
                 {
-                    __m128 me = _mm_load_ps(a.v);
-                    __m128 ot = _mm_load_ps(b.v);
+                    __m128 me = simd::load(a.v);
+                    __m128 ot = simd::load(b.v);
 
                     __m128 maxres = _mm_max_ps(me, ot);
 
-                    _mm_store_ps(result.v, maxres);
+                    simd::store(result.v, maxres);
 
                     return result;
                 }
 
                 if constexpr (std::is_same<T, f64>::value)
                 {
-                    __m256d me = _mm256_load_pd(a.v);
-                    __m256d ot = _mm256_load_pd(b.v);
+                    __m256d me = simd::load(a.v);
+                    __m256d ot = simd::load(b.v);
 
                     __m256d maxres = _mm256_max_pd(me, ot);
 
-                    _mm256_store_pd(result.v, maxres);
+                    simd::store(result.v, maxres);
 
                     return result;
                 }
 
                 return 
                 {
-                    sml::max(a.x, b.y), 
+                    sml::max(a.x, b.x), 
                     sml::max(a.y, b.y),
                     sml::max(a.z, b.z)
                 };
@@ -489,6 +525,33 @@ namespace sml
 
             SML_NO_DISCARD static inline constexpr vec3 cross(const vec3& left, const vec3& right) noexcept
             {
+                // (a * b.yzx - a.yzx * b).yzx, three shuffles instead of six
+                if constexpr (std::is_same<T, f32>::value)
+                {
+                    vec3 result;
+
+                    __m128 a = simd::load(left.v);
+                    __m128 b = simd::load(right.v);
+                    __m128 res = _mm_sub_ps(_mm_mul_ps(a, simd::shuffle<1, 2, 0, 3>(b)), _mm_mul_ps(simd::shuffle<1, 2, 0, 3>(a), b));
+
+                    simd::store(result.v, simd::shuffle<1, 2, 0, 3>(res));
+
+                    return result;
+                }
+
+                if constexpr (std::is_same<T, f64>::value)
+                {
+                    vec3 result;
+
+                    __m256d a = simd::load(left.v);
+                    __m256d b = simd::load(right.v);
+                    __m256d res = _mm256_sub_pd(_mm256_mul_pd(a, simd::shuffle<1, 2, 0, 3>(b)), _mm256_mul_pd(simd::shuffle<1, 2, 0, 3>(a), b));
+
+                    simd::store(result.v, simd::shuffle<1, 2, 0, 3>(res));
+
+                    return result;
+                }
+
                 return
                 {
                     left.y * right.z - left.z * right.y,
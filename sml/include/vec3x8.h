@@ -0,0 +1,221 @@
+#ifndef sml_vec3x8_h__
+#define sml_vec3x8_h__
+
+/* vec3x8.h -- eight 3d vectors in SoA layout of the 'Simple Math Library'
+  Copyright (C) 2020 Roderick Griffioen
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+
+#include <immintrin.h>
+
+#include "smltypes.h"
+#include "simd.h"
+#include "vec3.h"
+
+namespace sml
+{
+    // Eight f32 vectors in SoA layout for kernels that work on eight independent problems at once.
+    // Masks are the all ones / all zeros lanes of AVX compares.
+    class alignas(32) vec3x8
+    {
+        public:
+            vec3x8() noexcept : x(_mm256_setzero_ps()), y(_mm256_setzero_ps()), z(_mm256_setzero_ps())
+            {
+            }
+
+            vec3x8(__m256 x, __m256 y, __m256 z) noexcept : x(x), y(y), z(z)
+            {
+            }
+
+            explicit vec3x8(const vec3<f32>& v) noexcept : x(_mm256_set1_ps(v.x)), y(_mm256_set1_ps(v.y)), z(_mm256_set1_ps(v.z))
+            {
+            }
+
+            // Eight consecutive vectors
+            explicit vec3x8(const vec3<f32>* p) noexcept
+            {
+                load(p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7]);
+            }
+
+            // Gathers p[indices[0]] .. p[indices[7]]
+            vec3x8(const vec3<f32>* p, const u32* indices) noexcept
+            {
+                load(p[indices[0]], p[indices[1]], p[indices[2]], p[indices[3]], p[indices[4]], p[indices[5]], p[indices[6]], p[indices[7]]);
+            }
+
+            // Operators
+            vec3x8& operator += (const vec3x8& other) noexcept
+            {
+                x = _mm256_add_ps(x, other.x);
+                y = _mm256_add_ps(y, other.y);
+                z = _mm256_add_ps(z, other.z);
+
+                return *this;
+            }
+
+            vec3x8& operator -= (const vec3x8& other) noexcept
+            {
+                x = _mm256_sub_ps(x, other.x);
+                y = _mm256_sub_ps(y, other.y);
+                z = _mm256_sub_ps(z, other.z);
+
+                return *this;
+            }
+
+            vec3x8& operator *= (__m256 s) noexcept
+            {
+                x = _mm256_mul_ps(x, s);
+                y = _mm256_mul_ps(y, s);
+                z = _mm256_mul_ps(z, s);
+
+                return *this;
+            }
+
+            // Operations
+            SML_NO_DISCARD inline vec3<f32> lane(s32 i) const noexcept
+            {
+                alignas(32) f32 lx[8], ly[8], lz[8];
+                _mm256_store_ps(lx, x);
+                _mm256_store_ps(ly, y);
+                _mm256_store_ps(lz, z);
+
+                return vec3<f32>(lx[i], ly[i], lz[i]);
+            }
+
+            // Writes the eight vectors to p[0] .. p[7]
+            inline void store(vec3<f32>* p) const noexcept
+            {
+                __m256 r0 = x, r1 = y, r2 = z, r3 = _mm256_setzero_ps();
+
+                simd::transpose(r0, r1, r2, r3);
+
+                simd::store(p[0].v, _mm256_castps256_ps128(r0));
+                simd::store(p[1].v, _mm256_castps256_ps128(r1));
+                simd::store(p[2].v, _mm256_castps256_ps128(r2));
+                simd::store(p[3].v, _mm256_castps256_ps128(r3));
+                simd::store(p[4].v, _mm256_extractf128_ps(r0, 1));
+                simd::store(p[5].v, _mm256_extractf128_ps(r1, 1));
+                simd::store(p[6].v, _mm256_extractf128_ps(r2, 1));
+                simd::store(p[7].v, _mm256_extractf128_ps(r3, 1));
+            }
+
+            // Scatters the eight vectors to p[indices[0]] .. p[indices[7]]
+            inline void store(vec3<f32>* p, const u32* indices) const noexcept
+            {
+                __m256 r0 = x, r1 = y, r2 = z, r3 = _mm256_setzero_ps();
+
+                simd::transpose(r0, r1, r2, r3);
+
+                simd::store(p[indices[0]].v, _mm256_castps256_ps128(r0));
+                simd::store(p[indices[1]].v, _mm256_castps256_ps128(r1));
+                simd::store(p[indices[2]].v, _mm256_castps256_ps128(r2));
+                simd::store(p[indices[3]].v, _mm256_castps256_ps128(r3));
+                simd::store(p[indices[4]].v, _mm256_extractf128_ps(r0, 1));
+                simd::store(p[indices[5]].v, _mm256_extractf128_ps(r1, 1));
+                simd::store(p[indices[6]].v, _mm256_extractf128_ps(r2, 1));
+                simd::store(p[indices[7]].v, _mm256_extractf128_ps(r3, 1));
+            }
+
+            SML_NO_DISCARD inline __m256 lengthsquared() const noexcept
+            {
+                return dot(*this, *this);
+            }
+
+            SML_NO_DISCARD inline __m256 length() const noexcept
+            {
+                return _mm256_sqrt_ps(lengthsquared());
+            }
+
+            // Statics
+            SML_NO_DISCARD static inline __m256 dot(const vec3x8& a, const vec3x8& b) noexcept
+            {
+                return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a.x, b.x), _mm256_mul_ps(a.y, b.y)), _mm256_mul_ps(a.z, b.z));
+            }
+
+            SML_NO_DISCARD static inline vec3x8 cross(const vec3x8& a, const vec3x8& b) noexcept
+            {
+                return vec3x8(_mm256_sub_ps(_mm256_mul_ps(a.y, b.z), _mm256_mul_ps(a.z, b.y)),
+                              _mm256_sub_ps(_mm256_mul_ps(a.z, b.x), _mm256_mul_ps(a.x, b.z)),
+                              _mm256_sub_ps(_mm256_mul_ps(a.x, b.y), _mm256_mul_ps(a.y, b.x)));
+            }
+
+            // Lanes of b where mask is set, of a elsewhere
+            SML_NO_DISCARD static inline vec3x8 select(__m256 mask, const vec3x8& a, const vec3x8& b) noexcept
+            {
+                return vec3x8(simd::select(mask, a.x, b.x), simd::select(mask, a.y, b.y), simd::select(mask, a.z, b.z));
+            }
+
+            SML_NO_DISCARD static inline vec3x8 min(const vec3x8& a, const vec3x8& b) noexcept
+            {
+                return vec3x8(_mm256_min_ps(a.x, b.x), _mm256_min_ps(a.y, b.y), _mm256_min_ps(a.z, b.z));
+            }
+
+            SML_NO_DISCARD static inline vec3x8 max(const vec3x8& a, const vec3x8& b) noexcept
+            {
+                return vec3x8(_mm256_max_ps(a.x, b.x), _mm256_max_ps(a.y, b.y), _mm256_max_ps(a.z, b.z));
+            }
+
+            // Data
+            __m256 x, y, z;
+
+        private:
+            inline void load(const vec3<f32>& p0, const vec3<f32>& p1, const vec3<f32>& p2, const vec3<f32>& p3,
+                             const vec3<f32>& p4, const vec3<f32>& p5, const vec3<f32>& p6, const vec3<f32>& p7) noexcept
+            {
+                __m256 r0 = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(p0.v)), simd::load(p4.v), 1);
+                __m256 r1 = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(p1.v)), simd::load(p5.v), 1);
+                __m256 r2 = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(p2.v)), simd::load(p6.v), 1);
+                __m256 r3 = _mm256_insertf128_ps(_mm256_castps128_ps256(simd::load(p3.v)), simd::load(p7.v), 1);
+
+                simd::transpose(r0, r1, r2, r3);
+
+                x = r0;
+                y = r1;
+                z = r2;
+            }
+    };
+
+    // Operators
+    inline vec3x8 operator + (vec3x8 left, const vec3x8& right) noexcept
+    {
+        return left += right;
+    }
+
+    inline vec3x8 operator - (vec3x8 left, const vec3x8& right) noexcept
+    {
+        return left -= right;
+    }
+
+    inline vec3x8 operator - (const vec3x8& v) noexcept
+    {
+        __m256 sign = _mm256_set1_ps(-0.0f);
+
+        return vec3x8(_mm256_xor_ps(v.x, sign), _mm256_xor_ps(v.y, sign), _mm256_xor_ps(v.z, sign));
+    }
+
+    inline vec3x8 operator * (vec3x8 left, __m256 right) noexcept
+    {
+        return left *= right;
+    }
+
+    inline vec3x8 operator * (__m256 left, vec3x8 right) noexcept
+    {
+        return right *= left;
+    }
+} // namespace sml
+
+#endif // sml_vec3x8_h__
@@ -23,6 +23,7 @@
 
 #include "smltypes.h"
 #include "common.h"
+#include "simd.h"
 
 
 namespace sml
@@ -123,22 +124,22 @@ namespace sml
             {
                 if constexpr(std::is_same<T, f32>::value)
                 {
-                    __m128 me = _mm_load_ps(v);
-                    __m128 him = _mm_load_ps(other.v);
+                    __m128 me = simd::load(v);
+                    __m128 him = simd::load(other.v);
                     __m128 res = _mm_add_ps(me, him);
 
-                    _mm_store_ps(v, res);
+                    simd::store(v, res);
 
                     return *this;
                 }
 
                 if constexpr(std::is_same<T, f64>::value)
                 {
-                    __m256d me = _mm256_load_pd(v);
-                    __m256d him = _mm256_load_pd(other.v);
+                    __m256d me = simd::load(v);
+                    __m256d him = simd::load(other.v);
                     __m256d res = _mm256_add_pd(me, him);
 
-                    _mm256_store_pd(v, res);
+                    simd::store(v, res);
 
                     return *this;
                 }
@@ -155,22 +156,22 @@ namespace sml
             {
                 if constexpr(std::is_same<T, f32>::value)
                 {
-                    __m128 me = _mm_load_ps(v);
-                    __m128 him = _mm_load_ps(other.v);
+                    __m128 me = simd::load(v);
+                    __m128 him = simd::load(other.v);
                     __m128 res = _mm_sub_ps(me, him);
 
-                    _mm_store_ps(v, res);
+                    simd::store(v, res);
 
                     return *this;
                 }
 
                 if constexpr(std::is_same<T, f64>::value)
                 {
-                    __m256d me = _mm256_load_pd(v);
-                    __m256d him = _mm256_load_pd(other.v);
+                    __m256d me = simd::load(v);
+                    __m256d him = simd::load(other.v);
                     __m256d res = _mm256_sub_pd(me, him);
 
-                    _mm256_store_pd(v, res);
+                    simd::store(v, res);
 
                     return *this;
                 }
@@ -187,22 +188,22 @@ namespace sml
             {
                 if constexpr(std::is_same<T, f32>::value)
                 {
-                    __m128 me = _mm_load_ps(v);
-                    __m128 him = _mm_load_ps(other.v);
+                    __m128 me = simd::load(v);
+                    __m128 him = simd::load(other.v);
                     __m128 res = _mm_mul_ps(me, him);
 
-                    _mm_store_ps(v, res);
+                    simd::store(v, res);
 
                     return *this;
                 }
 
                 if constexpr(std::is_same<T, f64>::value)
                 {
-                    __m256d me = _mm256_load_pd(v);
-                    __m256d him = _mm256_load_pd(other.v);
+                    __m256d me = simd::load(v);
+                    __m256d him = simd::load(other.v);
                     __m256d res = _mm256_mul_pd(me, him);
 
-                    _mm256_store_pd(v, res);
+                    simd::store(v, res);
 
                     return *this;
                 }
@@ -219,22 +220,22 @@ namespace sml
             {
                 if constexpr(std::is_same<T, f32>::value)
                 {
-                    __m128 me = _mm_load_ps(v);
+                    __m128 me = simd::load(v);
                     __m128 him = _mm_broadcast_ss(&other);
                     __m128 res = _mm_mul_ps(me, him);
 
-                    _mm_store_ps(v, res);
+                    simd::store(v, res);
 
                     return *this;
                 }
 
                 if constexpr(std::is_same<T, f64>::value)
                 {
-                    __m256d me = _mm256_load_pd(v);
+                    __m256d me = simd::load(v);
                     __m256d him = _mm256_set1_pd(other);
                     __m256d res = _mm256_mul_pd(me, him);
 
-                    _mm256_store_pd(v, res);
+                    simd::store(v, res);
 
                     return *this;
                 }
@@ -251,22 +252,22 @@ namespace sml
             {
                 if constexpr(std::is_same<T, f32>::value)
                 {
-                    __m128 me = _mm_load_ps(v);
-                    __m128 him = _mm_load_ps(other.v);
+                    __m128 me = simd::load(v);
+                    __m128 him = simd::load(other.v);
                     __m128 res = _mm_div_ps(me, him);
 
-                    _mm_store_ps(v, res);
+                    simd::store(v, res);
 
                     return *this;
                 }
 
                 if constexpr(std::is_same<T, f64>::value)
                 {
-                    __m256d me = _mm256_load_pd(v);
-                    __m256d him = _mm256_load_pd(other.v);
+                    __m256d me = simd::load(v);
+                    __m256d him = simd::load(other.v);
                     __m256d res = _mm256_div_pd(me, him);
 
-                    _mm256_store_pd(v, res);
+                    simd::store(v, res);
 
                     return *this;
                 }
@@ -283,22 +284,22 @@ namespace sml
             {
                 if constexpr(std::is_same<T, f32>::value)
                 {
-                    __m128 me = _mm_load_ps(v);
+                    __m128 me = simd::load(v);
                     __m128 him = _mm_broadcast_ss(&other);
                     __m128 res = _mm_div_ps(me, him);
 
-                    _mm_store_ps(v, res);
+                    simd::store(v, res);
 
                     return *this;
                 }
 
                 if constexpr(std::is_same<T, f64>::value)
                 {
-                    __m256d me = _mm256_load_pd(v);
+                    __m256d me = simd::load(v);
                     __m256d him = _mm256_set1_pd(other);
                     __m256d res = _mm256_div_pd(me, him);
 
-                    _mm256_store_pd(v, res);
+                    simd::store(v, res);
 
                     return *this;
                 }
@@ -316,8 +317,8 @@ namespace sml
             {
                 if constexpr (std::is_same<T, f32>::value)
                 {
-                    __m128 me = _mm_load_ps(v);
-                    __m128 ot = _mm_load_ps(other.v);
+                    __m128 me = simd::load(v);
+                    __m128 ot = simd::load(other.v);
                     __m128 product = _mm_mul_ps(me, ot);
                     __m128 dp = _mm_hadd_ps(product, product);
 
@@ -372,6 +373,41 @@ namespace sml
                 return !x && !y && !z && !w;
             }
 
+            template<u32 X, u32 Y, u32 Z, u32 W>
+            SML_NO_DISCARD inline vec4 swizzle() const noexcept
+            {
+                static_assert(X < 4 && Y < 4 && Z < 4 && W < 4, "vec4 swizzle index out of range");
+
+                vec4 result;
+
+                if constexpr (std::is_same<T, f32>::value)
+                {
+                    simd::store(result.v, simd::shuffle<X, Y, Z, W>(simd::load(v)));
+
+                    return result;
+                }
+
+                if constexpr (std::is_same<T, f64>::value)
+                {
+                    simd::store(result.v, simd::shuffle<X, Y, Z, W>(simd::load(v)));
+
+                    return result;
+                }
+
+                result.set(v[X], v[Y], v[Z], v[W]);
+
+                return result;
+            }
+
+            SML_NO_DISCARD inline vec4 xxxx() const noexcept { return swizzle<0, 0, 0, 0>(); }
+            SML_NO_DISCARD inline vec4 yyyy() const noexcept { return swizzle<1, 1, 1, 1>(); }
+            SML_NO_DISCARD inline vec4 zzzz() const noexcept { return swizzle<2, 2, 2, 2>(); }
+            SML_NO_DISCARD inline vec4 wwww() const noexcept { return swizzle<3, 3, 3, 3>(); }
+            SML_NO_DISCARD inline vec4 yzxw() const noexcept { return swizzle<1, 2, 0, 3>(); }
+            SML_NO_DISCARD inline vec4 zxyw() const noexcept { return swizzle<2, 0, 1, 3>(); }
+            SML_NO_DISCARD inline vec4 zyxw() const noexcept { return swizzle<2, 1, 0, 3>(); }
+            SML_NO_DISCARD inline vec4 wzyx() const noexcept { return swizzle<3, 2, 1, 0>(); }
+
             SML_NO_DISCARD inline std::string toString() const noexcept
             {
                 return std::to_string(x) + ", " + std::to_string(y) + ", " + std::to_string(z) + ", " + std::to_string(w);
@@ -380,7 +416,7 @@ namespace sml
             // Statics
             SML_NO_DISCARD static inline constexpr vec4 normalize(const vec4& a) noexcept
             {
-                vec4 copy(a.v);
+                vec4 copy(a);
                 copy.normalize();
 
                 return copy;
@@ -403,24 +439,24 @@ namespace sml
 
                 if constexpr (std::is_same<T, f32>::value)
                 {
-                    __m128 me = _mm_load_ps(a.v);
-                    __m128 ot = _mm_load_ps(b.v);
+                    __m128 me = simd::load(a.v);
+                    __m128 ot = simd::load(b.v);
 
                     __m128 maxres = _mm_min_ps(me, ot);
 
-                    _mm_store_ps(result.v, maxres);
+                    simd::store(result.v, maxres);
 
                     return result;
                 }
 
                 if constexpr (std::is_same<T, f64>::value)
                 {
-                    __m256d me = _mm256_load_pd(a.v);
-                    __m256d ot = _mm256_load_pd(b.v);
+                    __m256d me = simd::load(a.v);
+                    __m256d ot = simd::load(b.v);
 
                     __m256d maxres = _mm256_min_pd(me, ot);
 
-                    _mm256_store_pd(result.v, maxres);
+                    simd::store(result.v, maxres);
 
                     return result;
                 }
@@ -440,24 +476,24 @@ namespace sml
 
                 if constexpr (std::is_same<T, f32>::value)
                 {
-                    __m128 me = _mm_load_ps(a.v);
-                    __m128 ot = _mm_load_ps(b.v);
+                    __m128 me = simd::load(a.v);
+                    __m128 ot = simd::load(b.v);
 
                     __m128 maxres = _mm_max_ps(me, ot);
 
-                    _mm_store_ps(result.v, maxres);
+                    simd::store(result.v, maxres);
 
                     return result;
                 }
 
                 if constexpr (std::is_same<T, f64>::value)
                 {
-                    __m256d me = _mm256_load_pd(a.v);
-                    __m256d ot = _mm256_load_pd(b.v);
+                    __m256d me = simd::load(a.v);
+                    __m256d ot = simd::load(b.v);
 
                     __m256d maxres = _mm256_max_pd(me, ot);
 
-                    _mm256_store_pd(result.v, maxres);
+                    simd::store(result.v, maxres);
 
                     return result;
                 }
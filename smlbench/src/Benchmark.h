@@ -0,0 +1,61 @@
+#ifndef smlbench_benchmark_h__
+#define smlbench_benchmark_h__
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+// Benchmarks register themselves at static initialisation and are run by name from Main.cpp
+struct Benchmark
+{
+	typedef void (*Function)(size_t count);
+
+	const char* name;
+	Function run;
+	size_t defaultcount;
+
+	static std::vector<Benchmark>& registry()
+	{
+		static std::vector<Benchmark> benchmarks;
+
+		return benchmarks;
+	}
+};
+
+struct BenchmarkRegistrar
+{
+	BenchmarkRegistrar(const char* name, Benchmark::Function run, size_t defaultcount)
+	{
+		Benchmark::registry().push_back({ name, run, defaultcount });
+	}
+};
+
+#define SML_BENCHMARK(name, defaultcount) \
+	static void name##Benchmark(size_t count); \
+	static BenchmarkRegistrar name##Registrar(#name, name##Benchmark, defaultcount); \
+	static void name##Benchmark(size_t count)
+
+class Timer
+{
+public:
+	Timer() : start(std::chrono::steady_clock::now())
+	{
+	}
+
+	double milliseconds() const
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+private:
+	std::chrono::steady_clock::time_point start;
+};
+
+// Prints one result line, rate is the number of operations per second when count operations took ms
+inline void report(const char* what, double ms, size_t count)
+{
+	std::printf("  %-40s %10.2f ms %14.0f /s\n", what, ms, static_cast<double>(count) * 1000.0 / ms);
+}
+
+#endif // smlbench_benchmark_h__
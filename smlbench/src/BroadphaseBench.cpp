@@ -0,0 +1,63 @@
+#include "Benchmark.h"
+
+#include <sweepandprune.h>
+
+#include <random>
+#include <vector>
+
+using namespace sml;
+
+// Moving boxes in a flat world, as in a typical physics scene
+SML_BENCHMARK(sweepandprune, 200000)
+{
+	std::mt19937 rng(4);
+	std::uniform_real_distribution<f32> position(-1000.0f, 1000.0f);
+	std::uniform_real_distribution<f32> height(0.0f, 50.0f);
+	std::uniform_real_distribution<f32> extent(0.5f, 4.0f);
+	std::uniform_real_distribution<f32> velocity(-0.25f, 0.25f);
+
+	std::vector<faabb> boxes(count);
+
+	for (faabb& box : boxes)
+	{
+		fvec3 c(position(rng), height(rng), position(rng));
+		box = faabb(c, c + fvec3(extent(rng), extent(rng), extent(rng)));
+	}
+
+	std::vector<overlappair> pairs(count * 8);
+	sweepandprune sap;
+
+	Timer first;
+	sap.update(boxes.data(), count);
+	report("first update with full sort (boxes)", first.milliseconds(), count);
+
+	const s32 frames = 10;
+	double incremental = 0.0, single = 0.0, all = 0.0;
+	size_t found = 0;
+
+	for (s32 frame = 0; frame < frames; frame++)
+	{
+		for (faabb& box : boxes)
+		{
+			fvec3 d(velocity(rng), velocity(rng), velocity(rng));
+			box = faabb(box.min + d, box.max + d);
+		}
+
+		Timer update;
+		sap.update(boxes.data(), count);
+		incremental += update.milliseconds();
+
+		Timer a;
+		found = sap.findpairs(pairs.data(), pairs.size(), 1);
+		single += a.milliseconds();
+
+		Timer b;
+		found = sap.findpairs(pairs.data(), pairs.size());
+		all += b.milliseconds();
+	}
+
+	report("incremental update (frames)", incremental, frames);
+	report("pairs, 1 thread (frames)", single, frames);
+	report("pairs, all threads (frames)", all, frames);
+	std::printf("  %zu pairs, sweep axis %d\n", found, sap.sweepaxis());
+}
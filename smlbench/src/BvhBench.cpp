@@ -0,0 +1,363 @@
+#include "Benchmark.h"
+
+#include <bvh.h>
+#include <morton.h>
+#include <triangle.h>
+
+#include <atomic>
+#include <random>
+#include <vector>
+
+using namespace sml;
+
+// Random small triangles filling a cube
+static void randomtriangles(std::mt19937& rng, size_t count, std::vector<fvec3>& vertices, std::vector<faabb>& boxes)
+{
+	std::uniform_real_distribution<f32> position(-100.0f, 100.0f);
+	std::uniform_real_distribution<f32> offset(-1.0f, 1.0f);
+
+	vertices.resize(count * 3);
+	boxes.assign(count, faabb());
+
+	for (size_t i = 0; i < count; i++)
+	{
+		fvec3 c(position(rng), position(rng), position(rng));
+
+		for (size_t k = 0; k < 3; k++)
+		{
+			vertices[i * 3 + k] = c + fvec3(offset(rng), offset(rng), offset(rng));
+			boxes[i].expand(vertices[i * 3 + k]);
+		}
+	}
+}
+
+// Rays start inside the cube of triangles in random directions
+SML_BENCHMARK(bvh, 1000000)
+{
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<f32> position(-100.0f, 100.0f);
+	std::uniform_real_distribution<f32> offset(-1.0f, 1.0f);
+
+	std::vector<fvec3> vertices;
+	std::vector<faabb> boxes;
+	randomtriangles(rng, count, vertices, boxes);
+
+	bvh tree;
+
+	bvhsettings single;
+	single.threads = 1;
+
+	Timer singlebuild;
+	tree.build(boxes.data(), count, single);
+	report("build, 1 thread (primitives)", singlebuild.milliseconds(), count);
+
+	Timer build;
+	tree.build(boxes.data(), count);
+	report("build, all threads (primitives)", build.milliseconds(), count);
+
+	std::printf("  %zu nodes, %.1f MB\n", tree.nodes.size(), static_cast<double>(tree.nodes.size() * sizeof(bvhnode8) + tree.indices.size() * sizeof(u32)) / (1024.0 * 1024.0));
+
+	const size_t queries = 200000;
+	std::vector<fray> rays(queries);
+	std::vector<faabb> regions(queries);
+	std::vector<fvec3> points(queries);
+
+	for (size_t i = 0; i < queries; i++)
+	{
+		rays[i] = fray(fvec3(position(rng), position(rng), position(rng)), fvec3(offset(rng), offset(rng), offset(rng)));
+
+		fvec3 c(position(rng), position(rng), position(rng));
+		regions[i] = faabb(c, c + fvec3(4.0f));
+		points[i] = fvec3(position(rng), position(rng), position(rng));
+	}
+
+	auto triangle = [&](u32 primitive, const fray& r, f32 tmax, f32& t)
+	{
+		f32 u, v;
+
+		return intersectswatertight(r, vertices[primitive * 3], vertices[primitive * 3 + 1], vertices[primitive * 3 + 2], tmax, t, u, v);
+	};
+
+	std::atomic<size_t> hits(0);
+
+	auto closest = [&](size_t begin, size_t end, u32)
+	{
+		size_t local = 0;
+
+		for (size_t i = begin; i < end; i++)
+		{
+			f32 tmax = std::numeric_limits<f32>::infinity();
+
+			local += tree.closesthit(rays[i], tmax, [&](u32 p, f32& limit)
+			{
+				f32 t;
+
+				if (!triangle(p, rays[i], limit, t))
+					return false;
+
+				limit = t;
+
+				return true;
+			}) ? 1 : 0;
+		}
+
+		hits += local;
+	};
+
+	Timer closestsingle;
+	closest(0, queries, 0);
+	report("closest hit rays, 1 thread", closestsingle.milliseconds(), queries);
+
+	Timer closestall;
+	parallelfor(0, queries, 1024, closest);
+	report("closest hit rays, all threads", closestall.milliseconds(), queries);
+
+	std::atomic<size_t> occluded(0);
+
+	auto any = [&](size_t begin, size_t end, u32)
+	{
+		size_t local = 0;
+
+		for (size_t i = begin; i < end; i++)
+		{
+			local += tree.anyhit(rays[i], 50.0f, [&](u32 p, f32 limit)
+			{
+				f32 t;
+
+				return triangle(p, rays[i], limit, t);
+			}) ? 1 : 0;
+		}
+
+		occluded += local;
+	};
+
+	Timer anysingle;
+	any(0, queries, 0);
+	report("any hit rays (t < 50), 1 thread", anysingle.milliseconds(), queries);
+
+	Timer anyall;
+	parallelfor(0, queries, 1024, any);
+	report("any hit rays (t < 50), all threads", anyall.milliseconds(), queries);
+
+	std::atomic<size_t> overlapping(0);
+
+	Timer overlap;
+	parallelfor(0, queries, 1024, [&](size_t begin, size_t end, u32)
+	{
+		size_t local = 0;
+
+		for (size_t i = begin; i < end; i++)
+		{
+			tree.overlaps(regions[i], [&](u32 p) { local += boxes[p].overlaps(regions[i]) ? 1 : 0; });
+		}
+
+		overlapping += local;
+	});
+	report("box overlap queries, all threads", overlap.milliseconds(), queries);
+
+	std::atomic<size_t> found(0);
+
+	Timer nearest;
+	parallelfor(0, queries, 1024, [&](size_t begin, size_t end, u32)
+	{
+		size_t local = 0;
+
+		for (size_t i = begin; i < end; i++)
+		{
+			f32 distancesq = std::numeric_limits<f32>::infinity();
+
+			local += tree.nearest(points[i], distancesq, [&](u32 p) { return (boxes[p].center() - points[i]).lengthsquared(); }) != ~0u ? 1 : 0;
+		}
+
+		found += local;
+	});
+	report("nearest primitive queries, all threads", nearest.milliseconds(), queries);
+
+	std::printf("  %zu closest hits, %zu occluded, %zu overlaps, %zu nearest\n", hits.load(), occluded.load(), overlapping.load(), found.load());
+}
+
+// Morton ordered rebuilds against the SAH build, ray throughput shows what the faster build costs in tree quality
+SML_BENCHMARK(lbvh, 1000000)
+{
+	std::mt19937 rng(2);
+	std::uniform_real_distribution<f32> position(-100.0f, 100.0f);
+	std::uniform_real_distribution<f32> offset(-1.0f, 1.0f);
+
+	std::vector<fvec3> vertices;
+	std::vector<faabb> boxes;
+	randomtriangles(rng, count, vertices, boxes);
+
+	faabb bounds;
+	for (const faabb& box : boxes)
+	{
+		bounds.expand(box);
+	}
+
+	std::vector<u32> codes(count), order(count);
+
+	Timer encode;
+	parallelfor(0, count, 16384, [&](size_t begin, size_t end, u32)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			codes[i] = morton30(boxes[i].center(), bounds);
+			order[i] = static_cast<u32>(i);
+		}
+	});
+	report("morton30 encode, all threads", encode.milliseconds(), count);
+
+	Timer sort;
+	radixsort(codes.data(), order.data(), count);
+	report("radix sort, all threads", sort.milliseconds(), count);
+
+	bvh linear, sah;
+
+	bvhsettings single;
+	single.threads = 1;
+
+	Timer linearsingle;
+	linear.buildlinear(boxes.data(), count, single);
+	report("linear build, 1 thread (primitives)", linearsingle.milliseconds(), count);
+
+	Timer linearall;
+	linear.buildlinear(boxes.data(), count);
+	report("linear build, all threads (primitives)", linearall.milliseconds(), count);
+
+	Timer sahall;
+	sah.build(boxes.data(), count);
+	report("SAH build, all threads (primitives)", sahall.milliseconds(), count);
+
+	const size_t queries = 200000;
+	std::vector<fray> rays(queries);
+
+	for (size_t i = 0; i < queries; i++)
+	{
+		rays[i] = fray(fvec3(position(rng), position(rng), position(rng)), fvec3(offset(rng), offset(rng), offset(rng)));
+	}
+
+	for (const bvh* tree : { &linear, &sah })
+	{
+		std::atomic<size_t> hits(0);
+
+		Timer trace;
+		parallelfor(0, queries, 1024, [&](size_t begin, size_t end, u32)
+		{
+			size_t local = 0;
+
+			for (size_t i = begin; i < end; i++)
+			{
+				f32 tmax = std::numeric_limits<f32>::infinity();
+
+				local += tree->closesthit(rays[i], tmax, [&](u32 p, f32& limit)
+				{
+					f32 t, u, v;
+
+					if (!intersectswatertight(rays[i], vertices[p * 3], vertices[p * 3 + 1], vertices[p * 3 + 2], limit, t, u, v))
+						return false;
+
+					limit = t;
+
+					return true;
+				}) ? 1 : 0;
+			}
+
+			hits += local;
+		});
+		report(tree == &linear ? "closest hit rays, linear tree" : "closest hit rays, SAH tree", trace.milliseconds(), queries);
+
+		std::printf("  %zu hits, %zu nodes\n", hits.load(), tree->nodes.size());
+	}
+}
+
+// A tenth of the objects move a little every frame, refits against rebuilding from scratch
+SML_BENCHMARK(refit, 1000000)
+{
+	std::mt19937 rng(3);
+	std::uniform_real_distribution<f32> position(-100.0f, 100.0f);
+	std::uniform_real_distribution<f32> extent(0.0f, 2.0f);
+	std::uniform_real_distribution<f32> velocity(-0.5f, 0.5f);
+	std::uniform_int_distribution<u32> pick(0, static_cast<u32>(count - 1));
+
+	std::vector<faabb> boxes(count);
+
+	for (faabb& box : boxes)
+	{
+		fvec3 c(position(rng), position(rng), position(rng));
+		box = faabb(c, c + fvec3(extent(rng), extent(rng), extent(rng)));
+	}
+
+	const s32 frames = 10;
+	std::vector<std::vector<u32>> movers(frames);
+
+	for (std::vector<u32>& frame : movers)
+	{
+		for (size_t k = 0; k < count / 10; k++)
+		{
+			frame.push_back(pick(rng));
+		}
+	}
+
+	auto move = [&](const std::vector<u32>& frame)
+	{
+		for (u32 p : frame)
+		{
+			fvec3 d(velocity(rng), velocity(rng), velocity(rng));
+			boxes[p] = faabb(boxes[p].min + d, boxes[p].max + d);
+		}
+	};
+
+	bvh tree(boxes.data(), count);
+	std::printf("  SAH cost after build %.2f\n", tree.sahcost());
+
+	Timer fullsingle;
+	tree.refit(boxes.data(), 1);
+	report("full refit, 1 thread (primitives)", fullsingle.milliseconds(), count);
+
+	Timer fullall;
+	tree.refit(boxes.data());
+	report("full refit, all threads (primitives)", fullall.milliseconds(), count);
+
+	double single = 0.0, all = 0.0;
+
+	for (s32 frame = 0; frame < frames; frame++)
+	{
+		move(movers[frame]);
+
+		Timer a;
+		tree.refit(boxes.data(), movers[frame].data(), movers[frame].size(), 1);
+		single += a.milliseconds();
+
+		Timer b;
+		tree.refit(boxes.data(), movers[frame].data(), movers[frame].size());
+		all += b.milliseconds();
+	}
+
+	report("dirty refit, 1 thread (frames)", single, frames);
+	report("dirty refit, all threads (frames)", all, frames);
+	std::printf("  SAH cost after %d frames of refits %.2f\n", frames, tree.sahcost());
+
+	tree.build(boxes.data(), count);
+
+	double update = 0.0;
+	u32 rebuilt = 0;
+
+	for (s32 frame = 0; frame < frames; frame++)
+	{
+		move(movers[frame]);
+
+		Timer a;
+		rebuilt += tree.update(boxes.data(), movers[frame].data(), movers[frame].size());
+		update += a.milliseconds();
+	}
+
+	report("update with rebuilds, all threads (frames)", update, frames);
+	std::printf("  %u subtrees rebuilt, SAH cost %.2f\n", rebuilt, tree.sahcost());
+
+	Timer rebuild;
+	tree.buildlinear(boxes.data(), count);
+	report("linear rebuild, all threads (frames)", rebuild.milliseconds(), 1);
+
+	Timer sah;
+	tree.build(boxes.data(), count);
+	report("SAH rebuild, all threads (frames)", sah.milliseconds(), 1);
+}
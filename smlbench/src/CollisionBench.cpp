@@ -0,0 +1,203 @@
+#include "Benchmark.h"
+
+#include <closest.h>
+#include <contacts.h>
+#include <gjk.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace sml;
+
+// Pairs of 32 vertex hulls tumbling past each other, queried every frame with and without the cache
+SML_BENCHMARK(gjk, 100000)
+{
+	std::mt19937 rng(21);
+	std::uniform_real_distribution<f32> unit(-1.0f, 1.0f);
+
+	std::vector<fvec3> vertices;
+	for (s32 i = 0; i < 32; i++)
+	{
+		vertices.push_back(fvec3::normalize(fvec3(unit(rng), unit(rng), unit(rng))) * (1.0f + unit(rng) * 0.2f));
+	}
+
+	convexhull a(vertices.data(), vertices.size()), b(vertices.data(), vertices.size());
+
+	auto place = [&](size_t frame)
+	{
+		f32 t = static_cast<f32>(frame) * 0.001f;
+
+		a.settransform(fquat::axisangle(fvec3(0.0f, 1.0f, 0.0f), t * 3.0f), fvec3(0.0f));
+		b.settransform(fquat::axisangle(fvec3(1.0f, 0.0f, 0.0f), t * 5.0f), fvec3(1.2f + std::sin(t * 7.0f) * 1.5f, 0.3f, 0.0f));
+	};
+
+	f32 checksum = 0.0f;
+	u32 iterations = 0;
+
+	Timer cold;
+	for (size_t frame = 0; frame < count; frame++)
+	{
+		place(frame);
+		gjkresult r = gjk(a, b);
+		checksum += r.distance;
+		iterations += r.iterations;
+	}
+	report("gjk distance, cold", cold.milliseconds(), count);
+	std::printf("  %.2f iterations per query\n", static_cast<f64>(iterations) / count);
+
+	gjkcache cache;
+	iterations = 0;
+
+	Timer warm;
+	for (size_t frame = 0; frame < count; frame++)
+	{
+		place(frame);
+		gjkresult r = gjk(a, b, &cache);
+		checksum += r.distance;
+		iterations += r.iterations;
+	}
+	report("gjk distance, warm started", warm.milliseconds(), count);
+	std::printf("  %.2f iterations per query\n", static_cast<f64>(iterations) / count);
+
+	Timer penetration;
+	for (size_t frame = 0; frame < count; frame++)
+	{
+		place(frame);
+		checksum += epa(a, b, &cache).distance;
+	}
+	report("epa penetration, warm started", penetration.milliseconds(), count);
+
+	std::printf("  checksum %g\n", checksum);
+}
+
+// Closest points of random points to random triangles, one query at a time and eight per call
+SML_BENCHMARK(closest, 1000000)
+{
+	std::mt19937 rng(23);
+	std::uniform_real_distribution<f32> unit(-1.0f, 1.0f);
+
+	size_t n = (count + 7) & ~size_t(7);
+	std::vector<fvec3> p(n), a(n), b(n), c(n), scalar(n), batched(n);
+
+	for (size_t i = 0; i < n; i++)
+	{
+		p[i] = fvec3(unit(rng), unit(rng), unit(rng)) * 2.0f;
+		a[i] = fvec3(unit(rng), unit(rng), unit(rng));
+		b[i] = fvec3(unit(rng), unit(rng), unit(rng));
+		c[i] = fvec3(unit(rng), unit(rng), unit(rng));
+	}
+
+	Timer one;
+	for (size_t i = 0; i < n; i++)
+	{
+		fvec3 barycentric;
+		scalar[i] = closestpointtriangle(p[i], a[i], b[i], c[i], barycentric);
+	}
+	report("point triangle, scalar", one.milliseconds(), n);
+
+	Timer eight;
+	for (size_t i = 0; i < n; i += 8)
+	{
+		vec3x8 barycentric;
+		closestpointtriangle(vec3x8(&p[i]), vec3x8(&a[i]), vec3x8(&b[i]), vec3x8(&c[i]), barycentric).store(&batched[i]);
+	}
+	report("point triangle, 8-wide", eight.milliseconds(), n);
+
+	Timer segments;
+	for (size_t i = 0; i < n; i += 8)
+	{
+		__m256 s, t;
+		vec3x8 c1, c2;
+		closestsegmentsegment(vec3x8(&a[i]), vec3x8(&b[i]), vec3x8(&c[i]), vec3x8(&p[i]), s, t, c1, c2);
+		c1.store(&batched[i]);
+	}
+	report("segment segment, 8-wide", segments.milliseconds(), n);
+
+	f32 checksum = 0.0f;
+	for (size_t i = 0; i < n; i++)
+	{
+		checksum += batched[i].x + scalar[i].y;
+	}
+
+	std::printf("  checksum %g\n", checksum);
+}
+
+// Candidate pairs between two sets of shapes, every b shape placed next to its a partner so that about
+// half of the pairs touch, run through every batched kernel and through EPA one pair at a time
+SML_BENCHMARK(contacts, 1000000)
+{
+	const u32 bodies = 4096;
+
+	std::mt19937 rng(22);
+	std::uniform_real_distribution<f32> unit(-1.0f, 1.0f);
+	std::uniform_int_distribution<u32> body(0, bodies - 1);
+
+	std::vector<fvec3> positions, halfextents;
+	std::vector<fquat> orientations;
+	std::vector<f32> radii, halfheights;
+
+	for (u32 i = 0; i < 2 * bodies; i++)
+	{
+		fvec3 partner = i < bodies ? fvec3(0.0f) : positions[i - bodies];
+
+		positions.push_back(partner + fvec3(unit(rng), unit(rng), unit(rng)) * (i < bodies ? 8.0f : 1.2f));
+		orientations.push_back(fquat::axisangle(fvec3::normalize(fvec3(unit(rng), unit(rng), unit(rng))), unit(rng) * 3.0f));
+		radii.push_back(0.5f + unit(rng) * 0.2f);
+		halfheights.push_back(0.5f + unit(rng) * 0.2f);
+		halfextents.push_back(fvec3(0.5f + unit(rng) * 0.2f, 0.5f + unit(rng) * 0.2f, 0.5f + unit(rng) * 0.2f));
+	}
+
+	// Random order so the gathers miss like broadphase output does
+	std::vector<overlappair> pairs(count);
+	for (overlappair& p : pairs)
+	{
+		p.a = body(rng);
+		p.b = p.a;
+	}
+
+	contactbodies a, b;
+	a.positions = positions.data();
+	a.orientations = orientations.data();
+	a.radii = radii.data();
+	a.halfheights = halfheights.data();
+	a.halfextents = halfextents.data();
+
+	b.positions = a.positions + bodies;
+	b.orientations = a.orientations + bodies;
+	b.radii = a.radii + bodies;
+	b.halfheights = a.halfheights + bodies;
+	b.halfextents = a.halfextents + bodies;
+
+	std::vector<contact> contacts(count);
+
+	auto run = [&](const char* what, size_t (*kernel)(const contactbodies&, const contactbodies&, const overlappair*, size_t, contact*, f32))
+	{
+		Timer timer;
+		size_t n = kernel(a, b, pairs.data(), count, contacts.data(), 0.0f);
+		report(what, timer.milliseconds(), count);
+
+		std::printf("  %.1f%% touching\n", 100.0 * static_cast<f64>(n) / count);
+	};
+
+	run("sphere sphere contacts", spherespherecontacts);
+	run("sphere capsule contacts", spherecapsulecontacts);
+	run("capsule capsule contacts", capsulecapsulecontacts);
+	run("sphere box contacts", sphereboxcontacts);
+	run("capsule box contacts", capsuleboxcontacts);
+	run("box box contacts", boxboxcontacts);
+
+	size_t scalar = count / 10;
+	f32 checksum = 0.0f;
+
+	Timer reference;
+	for (size_t i = 0; i < scalar; i++)
+	{
+		u32 ia = pairs[i].a, ib = pairs[i].b + bodies;
+
+		checksum += epa(convexbox(positions[ia], halfextents[ia], orientations[ia]), convexbox(positions[ib], halfextents[ib], orientations[ib])).distance;
+	}
+	report("box box epa, one pair at a time", reference.milliseconds(), scalar);
+
+	std::printf("  checksum %g\n", checksum);
+}
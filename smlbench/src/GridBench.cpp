@@ -0,0 +1,90 @@
+#include "Benchmark.h"
+
+#include <hashgrid.h>
+
+#include <atomic>
+#include <random>
+#include <vector>
+
+using namespace sml;
+
+// Particles at roughly eight per cell, rebuilt every step as a simulation would
+SML_BENCHMARK(hashgrid, 1000000)
+{
+	std::mt19937 rng(5);
+	f32 range = std::cbrt(static_cast<f32>(count) / 8.0f) * 0.5f;
+	std::uniform_real_distribution<f32> position(-range, range);
+	std::uniform_real_distribution<f32> velocity(-0.05f, 0.05f);
+
+	std::vector<fvec3> particles(count);
+	for (fvec3& p : particles)
+	{
+		p = fvec3(position(rng), position(rng), position(rng));
+	}
+
+	hashgrid grid(0.5f);
+
+	Timer first;
+	grid.build(particles.data(), count);
+	report("first build, all threads (particles)", first.milliseconds(), count);
+
+	const s32 steps = 10;
+	double single = 0.0, all = 0.0;
+
+	for (s32 step = 0; step < steps; step++)
+	{
+		for (fvec3& p : particles)
+		{
+			p += fvec3(velocity(rng), velocity(rng), velocity(rng));
+		}
+
+		Timer a;
+		grid.build(particles.data(), count, 1);
+		single += a.milliseconds();
+
+		Timer b;
+		grid.build(particles.data(), count);
+		all += b.milliseconds();
+	}
+
+	report("rebuild, 1 thread (steps)", single, steps);
+	report("rebuild, all threads (steps)", all, steps);
+
+	const size_t queries = 200000;
+	std::atomic<size_t> neighbours(0);
+
+	Timer radius;
+	parallelfor(0, queries, 1024, [&](size_t begin, size_t end, u32)
+	{
+		size_t local = 0;
+
+		for (size_t i = begin; i < end; i++)
+		{
+			grid.withinradius(particles[i], 0.5f, [&](u32, f32) { local++; });
+		}
+
+		neighbours += local;
+	});
+	report("radius queries, all threads", radius.milliseconds(), queries);
+
+	Timer knn;
+	parallelfor(0, queries, 1024, [&](size_t begin, size_t end, u32)
+	{
+		u32 result[8];
+		f32 distancesq[8];
+
+		for (size_t i = begin; i < end; i++)
+		{
+			neighbours += grid.nearest(particles[i], 8, result, distancesq);
+		}
+	});
+	report("8 nearest queries, all threads", knn.milliseconds(), queries);
+
+	std::atomic<size_t> pairs(0);
+
+	Timer allpairs;
+	grid.pairswithin(0.25f, [&](u32, u32, f32, u32) { pairs.fetch_add(1, std::memory_order_relaxed); });
+	report("pairs within 0.25, all threads (particles)", allpairs.milliseconds(), count);
+
+	std::printf("  %zu neighbours, %zu pairs\n", neighbours.load(), pairs.load());
+}
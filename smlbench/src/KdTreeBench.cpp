@@ -0,0 +1,85 @@
+#include "Benchmark.h"
+
+#include <kdtree.h>
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace sml;
+
+// Scan like clouds of double precision points far from the origin, against a brute force scan
+SML_BENCHMARK(kdtree, 2000000)
+{
+	std::mt19937_64 rng(9);
+	std::uniform_real_distribution<f64> position(-500.0, 500.0);
+	std::uniform_real_distribution<f64> height(0.0, 20.0);
+
+	std::vector<dvec3> points(count);
+	for (dvec3& p : points)
+	{
+		p = dvec3(position(rng) + 4.5e6, position(rng) + 5.5e6, height(rng));
+	}
+
+	const size_t queries = 100000;
+	std::vector<dvec3> targets(queries);
+	for (size_t i = 0; i < queries; i++)
+	{
+		targets[i] = points[(i * 7919) % count] + dvec3(0.5, -0.25, 0.1);
+	}
+
+	dkdtree tree;
+
+	Timer single;
+	tree.build(points.data(), count, 1);
+	report("build, 1 thread (points)", single.milliseconds(), count);
+
+	Timer all;
+	tree.build(points.data(), count);
+	report("build, all threads (points)", all.milliseconds(), count);
+
+	std::printf("  %.1f MB for %.1f MB of points\n", tree.memory() / 1048576.0, count * 3 * sizeof(f64) / 1048576.0);
+
+	const u32 k = 8;
+	std::vector<u32> result(queries * k), found(queries);
+	std::vector<f64> distancesq(queries * k);
+
+	Timer knn;
+	for (size_t i = 0; i < queries; i++)
+	{
+		found[i] = tree.nearest(targets[i], k, &result[i * k], &distancesq[i * k]);
+	}
+	report("8 nearest, 1 thread", knn.milliseconds(), queries);
+
+	Timer batched;
+	tree.nearest(targets.data(), queries, k, result.data(), distancesq.data(), found.data());
+	report("8 nearest batched, all threads", batched.milliseconds(), queries);
+
+	std::atomic<size_t> neighbours(0);
+
+	Timer radius;
+	tree.withinradius(targets.data(), queries, 2.0, [&](u32, u32, f64, u32) { neighbours.fetch_add(1, std::memory_order_relaxed); });
+	report("radius 2 batched, all threads", radius.milliseconds(), queries);
+
+	// Brute force on a few queries, its rate is per query as well
+	const size_t brute = 20;
+	f64 checksum = 0.0;
+
+	Timer scan;
+	for (size_t i = 0; i < brute; i++)
+	{
+		f64 best = std::numeric_limits<f64>::infinity();
+
+		for (const dvec3& p : points)
+		{
+			best = std::min(best, (p - targets[i]).lengthsquared());
+		}
+
+		checksum += best - distancesq[i * k];
+	}
+	report("nearest brute force, 1 thread", scan.milliseconds(), brute);
+
+	std::printf("  %zu neighbours, brute force mismatch %g\n", neighbours.load(), checksum);
+}
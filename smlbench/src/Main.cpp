@@ -0,0 +1,38 @@
+#include "Benchmark.h"
+
+#include <cstdlib>
+#include <cstring>
+
+// SMLBench [name] [count], runs every benchmark with its default size when no name is given
+int main(int argc, char** argv)
+{
+	const char* name = argc > 1 ? argv[1] : nullptr;
+	size_t count = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 0;
+	bool found = false;
+
+	for (const Benchmark& benchmark : Benchmark::registry())
+	{
+		if (name != nullptr && std::strcmp(name, benchmark.name) != 0)
+			continue;
+
+		size_t n = count != 0 ? count : benchmark.defaultcount;
+
+		std::printf("%s (%zu)\n", benchmark.name, n);
+		benchmark.run(n);
+		found = true;
+	}
+
+	if (!found)
+	{
+		std::printf("Unknown benchmark %s, available:\n", name);
+
+		for (const Benchmark& benchmark : Benchmark::registry())
+		{
+			std::printf("  %s\n", benchmark.name);
+		}
+
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,171 @@
+#include "Benchmark.h"
+
+#include <mat.h>
+#include <svd.h>
+
+#include <random>
+#include <vector>
+
+using namespace sml;
+
+template<size_t R, size_t C, typename T>
+static std::vector<mat<R, C, T>> randommats(std::mt19937& rng, size_t count)
+{
+	std::uniform_real_distribution<T> unit(-1, 1);
+	std::vector<mat<R, C, T>> res(count);
+
+	for (mat<R, C, T>& m : res)
+	{
+		for (size_t i = 0; i < R * C; i++)
+		{
+			m(i % R, i / R) = unit(rng);
+		}
+	}
+
+	return res;
+}
+
+// Textbook triple loop over the same storage as the baseline for the register kernels
+template<size_t N, typename T>
+static mat<N, N, T> naivemultiply(const mat<N, N, T>& a, const mat<N, N, T>& b)
+{
+	mat<N, N, T> res(static_cast<T>(0));
+
+	for (size_t r = 0; r < N; r++)
+	{
+		for (size_t c = 0; c < N; c++)
+		{
+			T sum = 0;
+			for (size_t k = 0; k < N; k++)
+			{
+				sum += a(r, k) * b(k, c);
+			}
+
+			res(r, c) = sum;
+		}
+	}
+
+	return res;
+}
+
+// Products of independent matrices and small dense solves as a constraint solver or filter runs them
+SML_BENCHMARK(matrix, 1000000)
+{
+	std::mt19937 rng(61);
+
+	std::vector<fmat88> a = randommats<8, 8, f32>(rng, 1024), b = randommats<8, 8, f32>(rng, 1024);
+	f32 checksum = 0.0f;
+
+	Timer naive;
+	for (size_t i = 0; i < count; i++)
+	{
+		checksum += naivemultiply(a[i & 1023], b[(i * 7) & 1023])(3, 5);
+	}
+	report("8x8 f32 multiply, triple loop", naive.milliseconds(), count);
+
+	Timer kernel;
+	for (size_t i = 0; i < count; i++)
+	{
+		checksum += (a[i & 1023] * b[(i * 7) & 1023])(3, 5);
+	}
+	report("8x8 f32 multiply", kernel.milliseconds(), count);
+
+	std::vector<dmat66> d = randommats<6, 6, f64>(rng, 1024);
+	std::vector<mat<6, 1, f64>> rhs = randommats<6, 1, f64>(rng, 1024);
+	for (dmat66& m : d)
+	{
+		m = m * m.transposed() + dmat66(6.0);
+	}
+
+	f64 dchecksum = 0.0;
+
+	Timer lu;
+	for (size_t i = 0; i < count; i++)
+	{
+		mat<6, 1, f64> x;
+		solve(d[i & 1023], rhs[(i * 7) & 1023], x);
+		dchecksum += x(0, 0);
+	}
+	report("6x6 f64 solve, lu", lu.milliseconds(), count);
+
+	Timer cholesky;
+	for (size_t i = 0; i < count; i++)
+	{
+		dmat66 l = d[i & 1023];
+		choleskydecompose(l);
+		dchecksum += choleskysolve(l, rhs[(i * 7) & 1023])(0, 0);
+	}
+	report("6x6 f64 solve, cholesky", cholesky.milliseconds(), count);
+
+	std::printf("  checksum %g %g\n", checksum, dchecksum);
+}
+
+// Deformation gradients of a simulation step, near rotations with some stretch, decomposed one at a time,
+// eight per call, and through the general symmetric eigensolver as the baseline
+SML_BENCHMARK(svd, 1000000)
+{
+	std::mt19937 rng(62);
+	std::uniform_real_distribution<f32> unit(-1.0f, 1.0f);
+
+	size_t n = (count + 7) & ~size_t(7);
+	std::vector<fmat3> f(n), rotations(n);
+
+	for (size_t i = 0; i < n; i++)
+	{
+		fquat q = fquat::axisangle(fvec3::normalize(fvec3(unit(rng), unit(rng), unit(rng))), unit(rng) * 3.0f);
+
+		for (s32 c = 0; c < 3; c++)
+		{
+			fvec3 axis(c == 0 ? 1.0f : 0.0f, c == 1 ? 1.0f : 0.0f, c == 2 ? 1.0f : 0.0f);
+			f[i].col[c] = q * (axis + fvec3(unit(rng), unit(rng), unit(rng)) * 0.3f);
+		}
+	}
+
+	f32 checksum = 0.0f;
+
+	Timer eigen;
+	for (size_t i = 0; i < n; i++)
+	{
+		fmat3 ata = f[i].transposed() * f[i], vectors;
+		fvec3 values;
+		eigensymmetric(ata, vectors, values);
+		checksum += values.x;
+	}
+	report("eigensymmetric of F^T F", eigen.milliseconds(), n);
+
+	Timer scalar;
+	for (size_t i = 0; i < n; i++)
+	{
+		fmat3 u, v;
+		fvec3 sigma;
+		svd(f[i], u, sigma, v);
+		checksum += sigma.x;
+	}
+	report("svd, scalar", scalar.milliseconds(), n);
+
+	Timer eight;
+	for (size_t i = 0; i < n; i += 8)
+	{
+		mat3x8 u, v;
+		vec3x8 sigma;
+		svd(mat3x8(&f[i]), u, sigma, v);
+		checksum += sigma.lane(0).x;
+	}
+	report("svd, 8-wide", eight.milliseconds(), n);
+
+	Timer rotation;
+	for (size_t i = 0; i < n; i += 8)
+	{
+		mat3x8 r, s;
+		polar(mat3x8(&f[i]), r, s);
+		r.store(&rotations[i]);
+	}
+	report("polar, 8-wide", rotation.milliseconds(), n);
+
+	for (size_t i = 0; i < n; i++)
+	{
+		checksum += rotations[i].m00;
+	}
+
+	std::printf("  checksum %g\n", checksum);
+}
@@ -0,0 +1,84 @@
+#include "Benchmark.h"
+
+#include <octree.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace sml;
+
+// Streaming world of a kilometre cube, bulk built from points and then edited object by object
+SML_BENCHMARK(octree, 1000000)
+{
+	std::mt19937 rng(13);
+	std::uniform_real_distribution<f32> position(-500.0f, 500.0f);
+	std::uniform_real_distribution<f32> extent(0.1f, 8.0f);
+
+	std::vector<fvec3> points(count);
+	for (fvec3& p : points)
+	{
+		p = fvec3(position(rng), position(rng), position(rng));
+	}
+
+	faabb world(fvec3(-500.0f), fvec3(500.0f));
+	foctree tree(world, 10);
+
+	Timer single;
+	tree.build(points.data(), count, 1);
+	report("bulk build, 1 thread (points)", single.milliseconds(), count);
+
+	Timer all;
+	tree.build(points.data(), count);
+	report("bulk build, all threads (points)", all.milliseconds(), count);
+
+	std::printf("  %zu nodes\n", tree.nodecount());
+
+	foctree boxes(world, 10);
+	std::vector<u32> handles(count);
+
+	Timer insert;
+	for (size_t i = 0; i < count; i++)
+	{
+		fvec3 e(extent(rng));
+		handles[i] = boxes.insert(faabb(points[i] - e, points[i] + e));
+	}
+	report("insert boxes", insert.milliseconds(), count);
+
+	Timer update;
+	for (size_t i = 0; i < count; i++)
+	{
+		fvec3 e(extent(rng)), p = points[i] + fvec3(1.0f, 0.5f, -0.25f);
+		boxes.update(handles[i], faabb(p - e, p + e));
+	}
+	report("update boxes", update.milliseconds(), count);
+
+	fvec3 eye(0.0f, 0.0f, 0.0f);
+	fmat4 projection = fmat4::perspective(1.2f, 16.0f / 9.0f, 0.5f, 1000.0f);
+	f32 scale = projectionscale(projection, 1080.0f);
+
+	const s32 views = 20;
+	size_t visible = 0, culled = 0;
+
+	Timer frustumtimer;
+	for (s32 v = 0; v < views; v++)
+	{
+		f32 angle = static_cast<f32>(v) * 0.3f;
+		ffrustum f(projection * fmat4::view(eye, fvec3(std::sin(angle), 0.0f, std::cos(angle)), fvec3(0.0f, 1.0f, 0.0f)));
+
+		boxes.visible(f, eye, scale, 0.0f, [&](u32, const faabb&) { visible++; });
+	}
+	report("frustum traversal (views)", frustumtimer.milliseconds(), views);
+
+	Timer lod;
+	for (s32 v = 0; v < views; v++)
+	{
+		f32 angle = static_cast<f32>(v) * 0.3f;
+		ffrustum f(projection * fmat4::view(eye, fvec3(std::sin(angle), 0.0f, std::cos(angle)), fvec3(0.0f, 1.0f, 0.0f)));
+
+		boxes.visible(f, eye, scale, 16.0f, [&](u32, const faabb&) { culled++; });
+	}
+	report("frustum traversal, 16 pixel cutoff (views)", lod.milliseconds(), views);
+
+	std::printf("  %zu visible, %zu above the cutoff\n", visible / views, culled / views);
+}
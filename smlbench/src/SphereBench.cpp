@@ -0,0 +1,99 @@
+#include "Benchmark.h"
+
+#include <sphere.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace sml;
+
+// Scalar Ritter as the baseline: axis extremes, widest pair as the seed, one growing pass
+static fsphere scalarritter(const std::vector<fvec3>& points)
+{
+	fvec3 lo[3] = { points[0], points[0], points[0] }, hi[3] = { points[0], points[0], points[0] };
+
+	for (const fvec3& p : points)
+	{
+		for (s32 a = 0; a < 3; a++)
+		{
+			if (p.v[a] < lo[a].v[a])
+				lo[a] = p;
+
+			if (p.v[a] > hi[a].v[a])
+				hi[a] = p;
+		}
+	}
+
+	s32 axis = 0;
+	for (s32 a = 1; a < 3; a++)
+	{
+		if ((hi[a] - lo[a]).lengthsquared() > (hi[axis] - lo[axis]).lengthsquared())
+			axis = a;
+	}
+
+	fsphere s((lo[axis] + hi[axis]) * 0.5f, (hi[axis] - lo[axis]).length() * 0.5f);
+
+	for (const fvec3& p : points)
+	{
+		fvec3 d = p - s.center();
+		f32 distance = d.length();
+
+		if (distance > s.radius)
+		{
+			f32 grown = (s.radius + distance) * 0.5f;
+			s = fsphere(s.center() + d * ((grown - s.radius) / distance), grown);
+		}
+	}
+
+	return s;
+}
+
+// Scanned mesh like point sets (a noisy ellipsoid shell) and a gaussian cloud, with the radius of
+// every method relative to the minimal sphere
+SML_BENCHMARK(boundingsphere, 1000000)
+{
+	std::mt19937 rng(43);
+	std::normal_distribution<f32> normal(0.0f, 1.0f);
+
+	const char* names[2] = { "ellipsoid shell", "gaussian cloud" };
+
+	for (s32 kind = 0; kind < 2; kind++)
+	{
+		std::vector<fvec3> points(count);
+		for (fvec3& p : points)
+		{
+			fvec3 g(normal(rng), normal(rng), normal(rng));
+			p = kind == 0 ? fvec3::normalize(g) * fvec3(3.0f, 1.5f, 0.7f) + g * 0.01f : g;
+		}
+
+		std::printf("  %s\n", names[kind]);
+
+		Timer scalar;
+		fsphere baseline = scalarritter(points);
+		report("scalar ritter", scalar.milliseconds(), count);
+
+		Timer ritter;
+		fsphere grown = boundingsphere(points.data(), count, 0);
+		report("ritter, simd", ritter.milliseconds(), count);
+
+		Timer approximate1;
+		fsphere approximate = boundingsphere(points.data(), count, 2, 1);
+		report("approximate, 1 thread", approximate1.milliseconds(), count);
+
+		Timer approximateall;
+		approximate = boundingsphere(points.data(), count);
+		report("approximate, all threads", approximateall.milliseconds(), count);
+
+		Timer exact1;
+		fsphere exact = minimalsphere(points.data(), count, 1);
+		report("exact, 1 thread", exact1.milliseconds(), count);
+
+		Timer exactall;
+		exact = minimalsphere(points.data(), count);
+		report("exact, all threads", exactall.milliseconds(), count);
+
+		std::printf("  radius %g, scalar ritter %+.2f%%, ritter %+.2f%%, approximate %+.2f%%\n", exact.radius,
+			100.0 * (baseline.radius / exact.radius - 1.0), 100.0 * (grown.radius / exact.radius - 1.0), 100.0 * (approximate.radius / exact.radius - 1.0));
+	}
+}
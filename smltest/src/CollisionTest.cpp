@@ -0,0 +1,785 @@
+#include <closest.h>
+#include <contacts.h>
+#include <gjk.h>
+#include <sweepandprune.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace sml;
+
+// SWEEP AND PRUNE TESTS
+
+static std::vector<faabb> scatteredboxes(size_t count, u32 seed, fvec3 range, f32 size)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<f32> unit(-1.0f, 1.0f);
+	std::uniform_real_distribution<f32> extent(0.1f, size);
+
+	std::vector<faabb> boxes(count);
+	for (faabb& box : boxes)
+	{
+		fvec3 c(unit(rng) * range.x, unit(rng) * range.y, unit(rng) * range.z);
+		box = faabb(c, c + fvec3(extent(rng), extent(rng), extent(rng)));
+	}
+
+	return boxes;
+}
+
+static std::vector<u64> bruteforcepairs(const std::vector<faabb>& boxes)
+{
+	std::vector<u64> res;
+
+	for (u32 a = 0; a < boxes.size(); a++)
+	{
+		for (u32 b = a + 1; b < boxes.size(); b++)
+		{
+			if (boxes[a].overlaps(boxes[b]))
+				res.push_back((static_cast<u64>(a) << 32) | b);
+		}
+	}
+
+	return res;
+}
+
+static std::vector<u64> sweptpairs(const sweepandprune& sap, size_t capacity, u32 threads)
+{
+	std::vector<overlappair> pairs(capacity);
+	size_t count = sap.findpairs(pairs.data(), pairs.size(), threads);
+
+	EXPECT_LE(count, capacity);
+
+	std::vector<u64> res;
+	for (size_t i = 0; i < count && i < capacity; i++)
+	{
+		EXPECT_LT(pairs[i].a, pairs[i].b);
+		res.push_back((static_cast<u64>(pairs[i].a) << 32) | pairs[i].b);
+	}
+
+	std::sort(res.begin(), res.end());
+
+	return res;
+}
+
+TEST(sweepandprune, Pairs)
+{
+	std::vector<faabb> boxes = scatteredboxes(3000, 1, fvec3(10.0f, 50.0f, 20.0f), 2.0f);
+	std::vector<u64> reference = bruteforcepairs(boxes);
+
+	sweepandprune sap;
+	sap.update(boxes.data(), boxes.size());
+
+	EXPECT_EQ(sap.sweepaxis(), 1);
+	EXPECT_EQ(sweptpairs(sap, reference.size() + 10, 1), reference);
+	EXPECT_EQ(sweptpairs(sap, reference.size() + 10, 4), reference);
+
+	// A short buffer is filled and the full count is still reported
+	std::vector<overlappair> few(5);
+	EXPECT_EQ(sap.findpairs(few.data(), few.size(), 4), reference.size());
+
+	sweepandprune empty;
+	empty.update(boxes.data(), 0);
+	EXPECT_EQ(empty.findpairs(few.data(), few.size()), 0u);
+}
+
+// World and ground boxes reach +inf on the sweep axis, their sweeps must stop at the last box
+TEST(sweepandprune, InfiniteBoxes)
+{
+	const f32 inf = std::numeric_limits<f32>::infinity();
+
+	std::vector<faabb> boxes = scatteredboxes(37, 4, fvec3(20.0f, 5.0f, 20.0f), 2.0f);
+	boxes.push_back(faabb(fvec3(-inf), fvec3(inf)));
+	boxes.push_back(faabb(fvec3(-inf, -1.0f, -inf), fvec3(inf, 0.0f, inf)));
+
+	std::vector<u64> reference = bruteforcepairs(boxes);
+
+	sweepandprune sap;
+	sap.update(boxes.data(), boxes.size());
+
+	EXPECT_EQ(sweptpairs(sap, reference.size(), 1), reference);
+	EXPECT_EQ(sweptpairs(sap, reference.size(), 4), reference);
+}
+
+TEST(sweepandprune, Incremental)
+{
+	std::vector<faabb> boxes = scatteredboxes(2000, 2, fvec3(30.0f, 10.0f, 10.0f), 2.0f);
+
+	sweepandprune sap;
+	sap.update(boxes.data(), boxes.size());
+	EXPECT_EQ(sap.sweepaxis(), 0);
+
+	std::mt19937 rng(3);
+	std::uniform_real_distribution<f32> step(-0.5f, 0.5f);
+
+	for (s32 frame = 0; frame < 10; frame++)
+	{
+		for (faabb& box : boxes)
+		{
+			fvec3 d(step(rng), step(rng), step(rng));
+			box = faabb(box.min + d, box.max + d);
+		}
+
+		sap.update(boxes.data(), boxes.size(), 2);
+
+		std::vector<u64> reference = bruteforcepairs(boxes);
+		EXPECT_EQ(sweptpairs(sap, reference.size(), 2), reference);
+	}
+
+	// Boxes that jump across the scene exhaust the insertion sort, which falls back to a full sort
+	std::shuffle(boxes.begin(), boxes.end(), rng);
+	sap.update(boxes.data(), boxes.size());
+
+	{
+		std::vector<u64> reference = bruteforcepairs(boxes);
+		EXPECT_EQ(sweptpairs(sap, reference.size(), 1), reference);
+	}
+
+	// Stretching the scene along z moves the sweep to z and re-sorts from scratch
+	for (faabb& box : boxes)
+	{
+		box = faabb(fvec3(box.min.x, box.min.y, box.min.z * 10.0f), fvec3(box.max.x, box.max.y, box.min.z * 10.0f + 1.0f));
+	}
+
+	sap.update(boxes.data(), boxes.size());
+	EXPECT_EQ(sap.sweepaxis(), 2);
+
+	std::vector<u64> reference = bruteforcepairs(boxes);
+	EXPECT_EQ(sweptpairs(sap, reference.size(), 1), reference);
+}
+
+// GJK AND EPA TESTS
+
+static std::vector<fvec3> cubevertices(const fvec3& halfextents)
+{
+	std::vector<fvec3> vertices;
+
+	for (s32 i = 0; i < 8; i++)
+	{
+		vertices.push_back(fvec3(i & 1 ? halfextents.x : -halfextents.x, i & 2 ? halfextents.y : -halfextents.y, i & 4 ? halfextents.z : -halfextents.z));
+	}
+
+	// Interior points only pad the hull
+	vertices.push_back(fvec3(0.0f));
+	vertices.push_back(halfextents * 0.5f);
+
+	return vertices;
+}
+
+TEST(gjk, Distance)
+{
+	gjkresult r = gjk(convexbox(fvec3(0.0f), fvec3(1.0f)), convexbox(fvec3(5.0f, 0.0f, 0.0f), fvec3(1.0f)));
+
+	EXPECT_FALSE(r.intersecting);
+	EXPECT_NEAR(r.distance, 3.0f, 1e-5f);
+	EXPECT_NEAR(r.normal.x, 1.0f, 1e-5f);
+	EXPECT_NEAR(r.pointa.x, 1.0f, 1e-5f);
+	EXPECT_NEAR(r.pointb.x, 4.0f, 1e-5f);
+
+	r = gjk(convexsphere(fvec3(0.0f), 1.0f), convexsphere(fvec3(3.0f, 4.0f, 0.0f), 2.0f));
+
+	EXPECT_NEAR(r.distance, 2.0f, 1e-5f);
+	EXPECT_NEAR(r.normal.x, 0.6f, 1e-5f);
+	EXPECT_NEAR(r.normal.y, 0.8f, 1e-5f);
+	EXPECT_NEAR(r.pointb.x, 1.8f, 1e-5f);
+
+	r = gjk(convexcapsule(fvec3(-1.0f, 0.0f, 0.0f), fvec3(1.0f, 0.0f, 0.0f), 0.5f), convexcapsule(fvec3(0.0f, -1.0f, 3.0f), fvec3(0.0f, 1.0f, 3.0f), 0.5f));
+
+	EXPECT_NEAR(r.distance, 2.0f, 1e-5f);
+	EXPECT_NEAR(r.normal.z, 1.0f, 1e-5f);
+
+	// Hulls agree with boxes under quaternion and matrix transforms
+	std::mt19937 rng(50);
+	std::uniform_real_distribution<f32> unit(-1.0f, 1.0f);
+
+	fvec3 extents(1.0f, 0.5f, 2.0f);
+	std::vector<fvec3> vertices = cubevertices(extents);
+	convexhull a(vertices.data(), vertices.size()), b(vertices.data(), vertices.size());
+
+	for (s32 i = 0; i < 200; i++)
+	{
+		fquat qa = fquat::axisangle(fvec3::normalize(fvec3(unit(rng), unit(rng), unit(rng))), unit(rng) * 3.0f);
+		fquat qb = fquat::axisangle(fvec3::normalize(fvec3(unit(rng), unit(rng), unit(rng))), unit(rng) * 3.0f);
+		fvec3 pa(unit(rng), unit(rng), unit(rng)), pb = fvec3(unit(rng), unit(rng), unit(rng)) * 6.0f;
+
+		a.settransform(qa, pa);
+		b.settransform(qb, pb);
+
+		gjkresult boxes = gjk(convexbox(pa, extents, qa), convexbox(pb, extents, qb));
+		gjkresult hulls = gjk(a, b);
+
+		EXPECT_EQ(boxes.intersecting, hulls.intersecting);
+
+		if (!boxes.intersecting)
+		{
+			EXPECT_NEAR(boxes.distance, hulls.distance, 1e-4f);
+			EXPECT_NEAR((boxes.pointb - boxes.pointa).length(), boxes.distance, 1e-4f);
+		}
+
+		fvec3 d = fvec3::normalize(fvec3(unit(rng), unit(rng), unit(rng)));
+		EXPECT_NEAR((a.support(d) - convexbox(pa, extents, qa).support(d)).length(), 0.0f, 1e-5f);
+	}
+
+	fmat4 transform = fmat4::translate(fvec3(3.0f, 0.0f, 0.0f)) * fmat4::scale(fvec3(2.0f, 1.0f, 1.0f));
+	a.settransform(transform);
+
+	EXPECT_NEAR(a.support(fvec3(1.0f, 0.0f, 0.0f)).x, 5.0f, 1e-5f);
+	EXPECT_NEAR(a.support(fvec3(-1.0f, 0.0f, 0.0f)).x, 1.0f, 1e-5f);
+	EXPECT_NEAR(a.center().x, 3.0f + 2.0f * extents.x * 0.05f, 1e-5f);
+}
+
+TEST(gjk, Spheres)
+{
+	std::mt19937 rng(51);
+	std::uniform_real_distribution<f32> unit(-1.0f, 1.0f);
+
+	for (s32 i = 0; i < 500; i++)
+	{
+		fvec3 ca(unit(rng), unit(rng), unit(rng)), cb = fvec3(unit(rng), unit(rng), unit(rng)) * 3.0f;
+		f32 ra = unit(rng) * 0.5f + 1.0f, rb = unit(rng) * 0.5f + 1.0f;
+		f32 expected = (cb - ca).length() - ra - rb;
+
+		gjkresult r = gjk(convexsphere(ca, ra), convexsphere(cb, rb));
+
+		EXPECT_EQ(r.intersecting, expected < 0.0f);
+		EXPECT_NEAR(r.distance, expected, 1e-4f);
+	}
+}
+
+TEST(epa, Penetration)
+{
+	gjkresult r = epa(convexbox(fvec3(0.0f), fvec3(1.0f)), convexbox(fvec3(1.5f, 0.2f, 0.1f), fvec3(1.0f)));
+
+	EXPECT_TRUE(r.intersecting);
+	EXPECT_NEAR(r.distance, -0.5f, 1e-4f);
+	EXPECT_NEAR(r.normal.x, 1.0f, 1e-4f);
+
+	// Axis aligned boxes against the smallest overlap of their extents
+	std::mt19937 rng(52);
+	std::uniform_real_distribution<f32> unit(-1.0f, 1.0f);
+	s32 overlapping = 0;
+
+	for (s32 i = 0; i < 300; i++)
+	{
+		fvec3 ea(unit(rng) * 0.5f + 1.0f, unit(rng) * 0.5f + 1.0f, unit(rng) * 0.5f + 1.0f);
+		fvec3 eb(unit(rng) * 0.5f + 1.0f, unit(rng) * 0.5f + 1.0f, unit(rng) * 0.5f + 1.0f);
+		fvec3 ca(unit(rng), unit(rng), unit(rng)), cb = fvec3(unit(rng), unit(rng), unit(rng)) * 2.0f;
+
+		fvec3 overlap = ea + eb - fvec3(std::abs(cb.x - ca.x), std::abs(cb.y - ca.y), std::abs(cb.z - ca.z));
+		f32 depth = std::min(overlap.x, std::min(overlap.y, overlap.z));
+
+		convexbox a(ca, ea), b(cb, eb);
+		gjkresult p = epa(a, b);
+
+		if (depth <= 1e-3f)
+		{
+			EXPECT_GE(p.distance, -1e-3f);
+			continue;
+		}
+
+		overlapping++;
+
+		ASSERT_TRUE(p.intersecting);
+		EXPECT_NEAR(p.distance, -depth, 1e-3f);
+		EXPECT_NEAR(p.normal.length(), 1.0f, 1e-4f);
+
+		// Moving b out along the normal by the depth leaves the boxes touching
+		gjkresult moved = gjk(a, convexbox(cb - p.normal * p.distance * 1.001f, eb));
+		EXPECT_GE(moved.distance, -1e-3f);
+		EXPECT_LT(moved.distance, 1e-2f);
+	}
+
+	EXPECT_GT(overlapping, 100);
+
+	// Deep sphere against a box face, the sphere core lies inside the box
+	gjkresult deep = epa(convexbox(fvec3(0.0f), fvec3(2.0f)), convexsphere(fvec3(1.5f, 0.0f, 0.0f), 1.0f));
+
+	EXPECT_NEAR(deep.distance, -1.5f, 1e-3f);
+	EXPECT_NEAR(deep.normal.x, 1.0f, 1e-3f);
+
+	// Shallow margin contacts need no polytope
+	gjkresult shallow = epa(convexsphere(fvec3(0.0f), 1.0f), convexcapsule(fvec3(1.5f, -1.0f, 0.0f), fvec3(1.5f, 1.0f, 0.0f), 1.0f));
+
+	EXPECT_NEAR(shallow.distance, -0.5f, 1e-5f);
+	EXPECT_NEAR(shallow.pointa.x, 1.0f, 1e-5f);
+	EXPECT_NEAR(shallow.pointb.x, 0.5f, 1e-5f);
+
+	// Coincident flat shapes have no direction between their centers
+	fvec3 square[4] = { fvec3(-1.0f, -1.0f, 0.0f), fvec3(1.0f, -1.0f, 0.0f), fvec3(1.0f, 1.0f, 0.0f), fvec3(-1.0f, 1.0f, 0.0f) };
+	gjkresult flat = epa(convexhull(square, 4), convexhull(square, 4));
+
+	EXPECT_EQ(flat.distance, 0.0f);
+	EXPECT_NEAR(flat.normal.length(), 1.0f, 1e-5f);
+}
+
+TEST(gjk, WarmStart)
+{
+	std::vector<fvec3> vertices;
+	std::mt19937 rng(53);
+	std::uniform_real_distribution<f32> unit(-1.0f, 1.0f);
+
+	for (s32 i = 0; i < 64; i++)
+	{
+		vertices.push_back(fvec3::normalize(fvec3(unit(rng), unit(rng), unit(rng))));
+	}
+
+	convexhull a(vertices.data(), vertices.size()), b(vertices.data(), vertices.size());
+	gjkcache cache;
+	u32 cold = 0, warm = 0;
+
+	for (s32 frame = 0; frame < 50; frame++)
+	{
+		f32 t = static_cast<f32>(frame) * 0.01f;
+
+		a.settransform(fquat::axisangle(fvec3(0.0f, 1.0f, 0.0f), t), fvec3(0.0f));
+		b.settransform(fquat::axisangle(fvec3(1.0f, 0.0f, 0.0f), -t), fvec3(2.5f, t, 0.0f));
+
+		gjkresult reference = gjk(a, b);
+		gjkresult cached = gjk(a, b, &cache);
+
+		EXPECT_NEAR(cached.distance, reference.distance, 1e-4f);
+
+		if (frame > 0)
+		{
+			cold += reference.iterations;
+			warm += cached.iterations;
+		}
+	}
+
+	EXPECT_LT(warm, cold);
+}
+
+// CLOSEST POINT TESTS
+
+// Closest point of a triangle from the plane projection when it lies inside and the edges otherwise
+static fvec3 referencetriangle(const fvec3& p, const fvec3& a, const fvec3& b, const fvec3& c)
+{
+	fvec3 n = fvec3::cross(b - a, c - a);
+	f32 area = n.lengthsquared();
+
+	if (area > 1e-10f)
+	{
+		fvec3 q = p - n * (fvec3::dot(p - a, n) / area);
+
+		if (fvec3::dot(fvec3::cross(b - a, q - a), n) >= 0.0f && fvec3::dot(fvec3::cross(c - b, q - b), n) >= 0.0f && fvec3::dot(fvec3::cross(a - c, q - c), n) >= 0.0f)
+			return q;
+	}
+
+	f32 t;
+	fvec3 best = closestpointsegment(p, a, b, t);
+
+	for (fvec3 candidate : { closestpointsegment(p, b, c, t), closestpointsegment(p, c, a, t) })
+	{
+		if ((candidate - p).lengthsquared() < (best - p).lengthsquared())
+			best = candidate;
+	}
+
+	return best;
+}
+
+TEST(closest, PointSegment)
+{
+	f32 t;
+	fvec3 q = closestpointsegment(fvec3(1.0f, 2.0f, 0.0f), fvec3(0.0f), fvec3(4.0f, 0.0f, 0.0f), t);
+
+	EXPECT_FLOAT_EQ(t, 0.25f);
+	EXPECT_FLOAT_EQ(q.x, 1.0f);
+	EXPECT_FLOAT_EQ(q.y, 0.0f);
+
+	q = closestpointsegment(fvec3(-3.0f, 1.0f, 0.0f), fvec3(0.0f), fvec3(4.0f, 0.0f, 0.0f), t);
+	EXPECT_FLOAT_EQ(t, 0.0f);
+
+	q = closestpointsegment(fvec3(9.0f, 1.0f, 0.0f), fvec3(0.0f), fvec3(4.0f, 0.0f, 0.0f), t);
+	EXPECT_FLOAT_EQ(t, 1.0f);
+	EXPECT_FLOAT_EQ(q.x, 4.0f);
+
+	// Zero length segments are points
+	q = closestpointsegment(fvec3(9.0f, 1.0f, 0.0f), fvec3(2.0f), fvec3(2.0f), t);
+	EXPECT_FLOAT_EQ(t, 0.0f);
+	EXPECT_FLOAT_EQ(q.x, 2.0f);
+
+	f64 td;
+	dvec3 qd = closestpointsegment(dvec3(1.0, 2.0, 3.0), dvec3(0.0), dvec3(0.0, 0.0, 6.0), td);
+	EXPECT_DOUBLE_EQ(td, 0.5);
+	EXPECT_DOUBLE_EQ(qd.z, 3.0);
+}
+
+TEST(closest, SegmentSegment)
+{
+	f32 s, t;
+	fvec3 c1, c2;
+
+	// Skew segments crossing over each other
+	f32 d = closestsegmentsegment(fvec3(-1.0f, 0.0f, 0.0f), fvec3(1.0f, 0.0f, 0.0f), fvec3(0.5f, -1.0f, 2.0f), fvec3(0.5f, 1.0f, 2.0f), s, t, c1, c2);
+
+	EXPECT_FLOAT_EQ(d, 4.0f);
+	EXPECT_FLOAT_EQ(s, 0.75f);
+	EXPECT_FLOAT_EQ(t, 0.5f);
+
+	// Parallel overlapping segments get a pair at the same distance
+	d = closestsegmentsegment(fvec3(0.0f), fvec3(4.0f, 0.0f, 0.0f), fvec3(2.0f, 1.0f, 0.0f), fvec3(6.0f, 1.0f, 0.0f), s, t, c1, c2);
+
+	EXPECT_FLOAT_EQ(d, 1.0f);
+	EXPECT_FLOAT_EQ((c2 - c1).lengthsquared(), 1.0f);
+
+	// Points
+	d = closestsegmentsegment(fvec3(1.0f), fvec3(1.0f), fvec3(0.0f, 0.0f, 3.0f), fvec3(2.0f, 0.0f, 3.0f), s, t, c1, c2);
+
+	EXPECT_FLOAT_EQ(d, 5.0f);
+	EXPECT_FLOAT_EQ(s, 0.0f);
+	EXPECT_FLOAT_EQ(t, 0.5f);
+
+	d = closestsegmentsegment(fvec3(1.0f), fvec3(1.0f), fvec3(0.0f), fvec3(0.0f), s, t, c1, c2);
+	EXPECT_FLOAT_EQ(d, 3.0f);
+
+	// Against sampling both segments
+	std::mt19937 rng(70);
+	std::uniform_real_distribution<f32> unit(-1.0f, 1.0f);
+
+	for (s32 i = 0; i < 200; i++)
+	{
+		fvec3 p1(unit(rng), unit(rng), unit(rng)), q1(unit(rng), unit(rng), unit(rng));
+		fvec3 p2(unit(rng), unit(rng), unit(rng)), q2(unit(rng), unit(rng), unit(rng));
+
+		d = closestsegmentsegment(p1, q1, p2, q2, s, t, c1, c2);
+
+		f32 sampled = std::numeric_limits<f32>::infinity();
+
+		for (s32 j = 0; j <= 100; j++)
+		{
+			fvec3 a = p1 + (q1 - p1) * (j * 0.01f);
+			f32 ta;
+
+			sampled = std::min(sampled, (closestpointsegment(a, p2, q2, ta) - a).lengthsquared());
+		}
+
+		EXPECT_LE(d, sampled + 1e-5f);
+		EXPECT_GE(d, sampled - 0.02f);
+		EXPECT_NEAR((c1 - (p1 + (q1 - p1) * s)).length(), 0.0f, 1e-5f);
+		EXPECT_NEAR((c2 - (p2 + (q2 - p2) * t)).length(), 0.0f, 1e-5f);
+	}
+}
+
+TEST(closest, PointTriangle)
+{
+	fvec3 a(0.0f), b(2.0f, 0.0f, 0.0f), c(0.0f, 2.0f, 0.0f);
+	fvec3 bary;
+
+	// Interior, edge and vertex regions
+	fvec3 q = closestpointtriangle(fvec3(0.5f, 0.5f, 3.0f), a, b, c, bary);
+	EXPECT_NEAR((q - fvec3(0.5f, 0.5f, 0.0f)).length(), 0.0f, 1e-6f);
+	EXPECT_NEAR(bary.x, 0.5f, 1e-6f);
+	EXPECT_NEAR(bary.y, 0.25f, 1e-6f);
+	EXPECT_NEAR(bary.z, 0.25f, 1e-6f);
+
+	q = closestpointtriangle(fvec3(1.0f, -1.0f, 0.0f), a, b, c, bary);
+	EXPECT_NEAR((q - fvec3(1.0f, 0.0f, 0.0f)).length(), 0.0f, 1e-6f);
+	EXPECT_NEAR(bary.z, 0.0f, 1e-6f);
+
+	q = closestpointtriangle(fvec3(2.0f, 2.0f, 1.0f), a, b, c, bary);
+	EXPECT_NEAR((q - fvec3(1.0f, 1.0f, 0.0f)).length(), 0.0f, 1e-6f);
+	EXPECT_NEAR(bary.x, 0.0f, 1e-6f);
+
+	q = closestpointtriangle(fvec3(-1.0f, -1.0f, 0.0f), a, b, c, bary);
+	EXPECT_EQ(bary, fvec3(1.0f, 0.0f, 0.0f));
+	q = closestpointtriangle(fvec3(3.0f, -1.0f, 0.0f), a, b, c, bary);
+	EXPECT_EQ(bary, fvec3(0.0f, 1.0f, 0.0f));
+	q = closestpointtriangle(fvec3(-1.0f, 3.0f, 0.0f), a, b, c, bary);
+	EXPECT_EQ(bary, fvec3(0.0f, 0.0f, 1.0f));
+
+	// Collinear and collapsed triangles fall back to edges and points
+	q = closestpointtriangle(fvec3(1.5f, 1.0f, 0.0f), a, b, fvec3(1.0f, 0.0f, 0.0f), bary);
+	EXPECT_NEAR((q - fvec3(1.5f, 0.0f, 0.0f)).length(), 0.0f, 1e-6f);
+	EXPECT_NEAR(bary.x + bary.y + bary.z, 1.0f, 1e-6f);
+
+	q = closestpointtriangle(fvec3(1.0f, 1.0f, 1.0f), b, b, b, bary);
+	EXPECT_EQ(q, b);
+	EXPECT_NEAR(bary.x + bary.y + bary.z, 1.0f, 1e-6f);
+
+	// Random triangles against the projection and edge reference, weights reproduce the point
+	std::mt19937 rng(71);
+	std::uniform_real_distribution<f32> unit(-1.0f, 1.0f);
+
+	for (s32 i = 0; i < 500; i++)
+	{
+		fvec3 p(unit(rng) * 2.0f, unit(rng) * 2.0f, unit(rng) * 2.0f);
+		fvec3 ta(unit(rng), unit(rng), unit(rng)), tb(unit(rng), unit(rng), unit(rng)), tc(unit(rng), unit(rng), unit(rng));
+
+		q = closestpointtriangle(p, ta, tb, tc, bary);
+
+		EXPECT_NEAR((q - referencetriangle(p, ta, tb, tc)).length(), 0.0f, 1e-4f);
+		EXPECT_NEAR((ta * bary.x + tb * bary.y + tc * bary.z - q).length(), 0.0f, 1e-5f);
+		EXPECT_GE(std::min(bary.x, std::min(bary.y, bary.z)), -1e-6f);
+	}
+
+	dvec3 baryd;
+	dvec3 qd = closestpointtriangle(dvec3(0.5, 0.5, -2.0), dvec3(0.0), dvec3(2.0, 0.0, 0.0), dvec3(0.0, 2.0, 0.0), baryd);
+	EXPECT_DOUBLE_EQ(qd.z, 0.0);
+	EXPECT_DOUBLE_EQ(baryd.y, 0.25);
+}
+
+TEST(closest, Batched)
+{
+	std::mt19937 rng(72);
+	std::uniform_real_distribution<f32> unit(-1.0f, 1.0f);
+
+	for (s32 batch = 0; batch < 100; batch++)
+	{
+		fvec3 p[8], a[8], b[8], c[8], d[8];
+
+		for (s32 i = 0; i < 8; i++)
+		{
+			p[i] = fvec3(unit(rng), unit(rng), unit(rng)) * 2.0f;
+			a[i] = fvec3(unit(rng), unit(rng), unit(rng));
+			b[i] = fvec3(unit(rng), unit(rng), unit(rng));
+			c[i] = fvec3(unit(rng), unit(rng), unit(rng));
+			d[i] = fvec3(unit(rng), unit(rng), unit(rng));
+		}
+
+		// Degenerate lanes mixed with regular ones
+		b[1] = a[1];
+		c[2] = a[2] + (b[2] - a[2]) * 0.3f;
+		c[3] = b[3] = a[3];
+		d[4] = c[4];
+
+		vec3x8 pv(p), av(a), bv(b), cv(c), dv(d);
+
+		__m256 t8;
+		vec3x8 onsegment = closestpointsegment(pv, av, bv, t8);
+
+		__m256 s8, u8;
+		vec3x8 c1, c2;
+		__m256 distance8 = closestsegmentsegment(av, bv, cv, dv, s8, u8, c1, c2);
+
+		vec3x8 bary8;
+		vec3x8 ontriangle = closestpointtriangle(pv, av, bv, cv, bary8);
+
+		alignas(32) f32 ts[8], ss[8], us[8], distances[8];
+		_mm256_store_ps(ts, t8);
+		_mm256_store_ps(ss, s8);
+		_mm256_store_ps(us, u8);
+		_mm256_store_ps(distances, distance8);
+
+		for (s32 i = 0; i < 8; i++)
+		{
+			f32 t, s, u;
+			fvec3 e1, e2, bary;
+
+			fvec3 q = closestpointsegment(p[i], a[i], b[i], t);
+			EXPECT_NEAR(ts[i], t, 1e-5f);
+			EXPECT_NEAR((onsegment.lane(i) - q).length(), 0.0f, 1e-5f);
+
+			f32 distance = closestsegmentsegment(a[i], b[i], c[i], d[i], s, u, e1, e2);
+			EXPECT_NEAR(distances[i], distance, 1e-5f);
+			EXPECT_NEAR((c1.lane(i) - e1).length(), 0.0f, 1e-4f);
+			EXPECT_NEAR((c2.lane(i) - e2).length(), 0.0f, 1e-4f);
+
+			q = closestpointtriangle(p[i], a[i], b[i], c[i], bary);
+			EXPECT_NEAR((ontriangle.lane(i) - q).length(), 0.0f, 1e-4f);
+			EXPECT_NEAR((bary8.lane(i) - bary).length(), 0.0f, 1e-4f);
+		}
+	}
+}
+
+// CONTACT TESTS
+
+struct contactscene
+{
+	std::vector<fvec3> positions;
+	std::vector<fquat> orientations;
+	std::vector<f32> radii;
+	std::vector<f32> halfheights;
+	std::vector<fvec3> halfextents;
+
+	contactbodies bodies() const
+	{
+		contactbodies res;
+		res.positions = positions.data();
+		res.orientations = orientations.data();
+		res.radii = radii.data();
+		res.halfheights = halfheights.data();
+		res.halfextents = halfextents.data();
+
+		return res;
+	}
+};
+
+static contactscene randomshapes(size_t count, u32 seed, f32 spread)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<f32> unit(-1.0f, 1.0f);
+
+	contactscene res;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		res.positions.push_back(fvec3(unit(rng), unit(rng), unit(rng)) * spread);
+		res.orientations.push_back(fquat::axisangle(fvec3::normalize(fvec3(unit(rng), unit(rng), unit(rng))), unit(rng) * 3.0f));
+		res.radii.push_back(unit(rng) * 0.25f + 0.5f);
+		res.halfheights.push_back(unit(rng) * 0.25f + 0.5f);
+		res.halfextents.push_back(fvec3(unit(rng) * 0.25f + 0.75f, unit(rng) * 0.25f + 0.75f, unit(rng) * 0.25f + 0.75f));
+	}
+
+	return res;
+}
+
+static convexsphere sphereshape(const contactscene& scene, u32 i, const fvec3& offset)
+{
+	return convexsphere(scene.positions[i] + offset, scene.radii[i]);
+}
+
+static convexcapsule capsuleshape(const contactscene& scene, u32 i, const fvec3& offset)
+{
+	fvec3 axis = scene.orientations[i] * fvec3(0.0f, scene.halfheights[i], 0.0f);
+
+	return convexcapsule(scene.positions[i] + offset - axis, scene.positions[i] + offset + axis, scene.radii[i]);
+}
+
+static convexbox boxshape(const contactscene& scene, u32 i, const fvec3& offset)
+{
+	return convexbox(scene.positions[i] + offset, scene.halfextents[i], scene.orientations[i]);
+}
+
+static std::vector<overlappair> allpairs(u32 count)
+{
+	std::vector<overlappair> res;
+
+	for (u32 a = 0; a < count; a++)
+	{
+		for (u32 b = 0; b < count; b++)
+		{
+			if (a != b)
+				res.push_back({ a, b });
+		}
+	}
+
+	return res;
+}
+
+// Runs a kernel with an unlimited margin and checks every contact against EPA on the same shapes.
+// Depths may exceed the reference by the relative bias of kernels that prefer face axes.
+template<typename K, typename A, typename B>
+static void checkcontacts(K kernel, const contactscene& scene, A shapea, B shapeb, f32 tolerance, f32 bias)
+{
+	std::vector<overlappair> pairs = allpairs(static_cast<u32>(scene.positions.size()));
+	std::vector<contact> contacts(pairs.size());
+
+	size_t count = kernel(scene.bodies(), scene.bodies(), pairs.data(), pairs.size(), contacts.data(), 1e30f);
+	ASSERT_EQ(count, pairs.size());
+
+	size_t overlapping = 0;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const contact& c = contacts[i];
+		const overlappair& p = pairs[c.pair];
+
+		ASSERT_EQ(c.pair, i);
+		EXPECT_NEAR(c.normal.length(), 1.0f, 1e-4f);
+
+		auto a = shapea(scene, p.a, fvec3(0.0f));
+		gjkresult reference = epa(a, shapeb(scene, p.b, fvec3(0.0f)));
+
+		if (reference.distance > 0.0f)
+		{
+			EXPECT_LE(c.depth, tolerance);
+
+			if (bias == 0.0f)
+			{
+				EXPECT_NEAR(c.depth, -reference.distance, tolerance);
+			}
+
+			continue;
+		}
+
+		overlapping++;
+
+		EXPECT_GE(c.depth, -reference.distance - tolerance);
+		EXPECT_LE(c.depth, -reference.distance * (1.0f + bias) + tolerance);
+
+		// The point lies within half the depth of both surfaces
+		convexsphere around(c.point, 0.5f * c.depth + tolerance + bias);
+		EXPECT_LE(gjk(a, around).distance, 0.0f);
+		EXPECT_LE(gjk(around, shapeb(scene, p.b, fvec3(0.0f))).distance, 0.0f);
+
+		// Moving b out along the normal by the depth separates the shapes, and leaves them touching
+		// when the normal is the one of least penetration
+		gjkresult moved = gjk(a, shapeb(scene, p.b, c.normal * (c.depth + tolerance)));
+		EXPECT_GE(moved.distance, -tolerance);
+
+		if (bias == 0.0f)
+		{
+			EXPECT_LT(moved.distance, 4.0f * tolerance);
+		}
+	}
+
+	EXPECT_GT(overlapping, count / 10);
+}
+
+TEST(contacts, Spheres)
+{
+	contactscene scene = randomshapes(37, 60, 1.5f);
+
+	checkcontacts(spherespherecontacts, scene, sphereshape, sphereshape, 1e-4f, 0.0f);
+	checkcontacts(spherecapsulecontacts, scene, sphereshape, capsuleshape, 1e-4f, 0.0f);
+	checkcontacts(capsulecapsulecontacts, scene, capsuleshape, capsuleshape, 1e-4f, 0.0f);
+
+	// Pairs beyond the margin are dropped, the rest keep their pair index
+	std::vector<overlappair> pairs = allpairs(static_cast<u32>(scene.positions.size()));
+	std::vector<contact> contacts(pairs.size());
+
+	size_t count = spherespherecontacts(scene.bodies(), scene.bodies(), pairs.data(), pairs.size(), contacts.data(), 0.1f);
+	size_t expected = 0;
+
+	for (const overlappair& p : pairs)
+	{
+		if ((scene.positions[p.b] - scene.positions[p.a]).length() < scene.radii[p.a] + scene.radii[p.b] + 0.1f)
+			expected++;
+	}
+
+	EXPECT_EQ(count, expected);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		EXPECT_GT(contacts[i].depth, -0.1f);
+		EXPECT_TRUE(i == 0 || contacts[i].pair > contacts[i - 1].pair);
+	}
+
+	// Coincident spheres still get a unit normal
+	contactscene same = randomshapes(2, 61, 0.0f);
+	same.positions[1] = same.positions[0];
+
+	overlappair pair = { 0, 1 };
+	contact c;
+
+	ASSERT_EQ(spherespherecontacts(same.bodies(), same.bodies(), &pair, 1, &c), 1u);
+	EXPECT_NEAR(c.normal.length(), 1.0f, 1e-6f);
+	EXPECT_NEAR(c.depth, same.radii[0] + same.radii[1], 1e-6f);
+}
+
+TEST(contacts, Boxes)
+{
+	contactscene scene = randomshapes(37, 62, 2.0f);
+
+	checkcontacts(sphereboxcontacts, scene, sphereshape, boxshape, 1e-3f, 0.0f);
+	checkcontacts(capsuleboxcontacts, scene, capsuleshape, boxshape, 1e-3f, 0.0f);
+	checkcontacts(boxboxcontacts, scene, boxshape, boxshape, 2e-3f, 0.05f);
+
+	// Resting box gets a face contact on the ground box
+	contactscene stack = randomshapes(2, 63, 0.0f);
+	stack.positions = { fvec3(0.0f), fvec3(0.2f, 1.95f, -0.1f) };
+	stack.orientations = { fquat::identity(), fquat::axisangle(fvec3(0.0f, 1.0f, 0.0f), 0.3f) };
+	stack.halfextents = { fvec3(4.0f, 1.0f, 4.0f), fvec3(1.0f) };
+
+	overlappair pair = { 0, 1 };
+	contact c;
+
+	ASSERT_EQ(boxboxcontacts(stack.bodies(), stack.bodies(), &pair, 1, &c), 1u);
+	EXPECT_NEAR(c.depth, 0.05f, 1e-5f);
+	EXPECT_NEAR(c.normal.y, 1.0f, 1e-5f);
+	EXPECT_NEAR(c.point.y, 0.975f, 1e-5f);
+}
@@ -0,0 +1,1137 @@
+#include <aabb.h>
+#include <frustum.h>
+#include <gjk.h>
+#include <obb.h>
+#include <ray.h>
+#include <sphere.h>
+#include <triangle.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace sml;
+
+// AABB TESTS
+
+template<typename T>
+static aabb<T> bruteforcetransform(const aabb<T>& box, const mat4<T>& transform)
+{
+	aabb<T> res;
+
+	for (s32 corner = 0; corner < 8; corner++)
+	{
+		vec4<T> p((corner & 1) ? box.max.x : box.min.x, (corner & 2) ? box.max.y : box.min.y, (corner & 4) ? box.max.z : box.min.z, 1);
+		vec4<T> r = transform * p;
+
+		res.expand(vec3<T>(r.x, r.y, r.z));
+	}
+
+	return res;
+}
+
+template<typename T>
+static void expectnear(const aabb<T>& a, const aabb<T>& b, T tolerance)
+{
+	for (s32 i = 0; i < 3; i++)
+	{
+		EXPECT_NEAR(a.min.v[i], b.min.v[i], tolerance);
+		EXPECT_NEAR(a.max.v[i], b.max.v[i], tolerance);
+	}
+
+	EXPECT_EQ(a.min.v[3], 0);
+	EXPECT_EQ(a.max.v[3], 0);
+}
+
+TEST(faabb, DefaultIsEmpty)
+{
+	faabb box;
+
+	EXPECT_TRUE(box.empty());
+	EXPECT_EQ(box.surfacearea(), 0);
+	EXPECT_FALSE(box.overlaps(faabb(fvec3(-1), fvec3(1))));
+
+	box.expand(fvec3(1, 2, 3));
+
+	EXPECT_FALSE(box.empty());
+	EXPECT_EQ(box.min, fvec3(1, 2, 3));
+	EXPECT_EQ(box.max, fvec3(1, 2, 3));
+}
+
+TEST(faabb, ExpandMerge)
+{
+	faabb box(fvec3(0, 0, 0), fvec3(1, 1, 1));
+	box.expand(fvec3(-1, 2, 0.5f));
+
+	EXPECT_EQ(box.min, fvec3(-1, 0, 0));
+	EXPECT_EQ(box.max, fvec3(1, 2, 1));
+
+	faabb merged = faabb::merge(box, faabb(fvec3(5, -5, 5), fvec3(6, -4, 6)));
+
+	EXPECT_EQ(merged.min, fvec3(-1, -5, 0));
+	EXPECT_EQ(merged.max, fvec3(6, 2, 6));
+	EXPECT_EQ(merged.center(), fvec3(2.5f, -1.5f, 3));
+	EXPECT_EQ(merged.extents(), fvec3(3.5f, 3.5f, 3));
+
+	merged.inflate(1);
+
+	EXPECT_EQ(merged.min, fvec3(-2, -6, -1));
+}
+
+TEST(faabb, OverlapsContains)
+{
+	faabb a(fvec3(0, 0, 0), fvec3(2, 2, 2));
+
+	EXPECT_TRUE(a.overlaps(faabb(fvec3(1, 1, 1), fvec3(3, 3, 3))));
+	EXPECT_TRUE(a.overlaps(faabb(fvec3(2, 2, 2), fvec3(3, 3, 3))));
+	EXPECT_FALSE(a.overlaps(faabb(fvec3(2.5f, 0, 0), fvec3(3, 1, 1))));
+	EXPECT_FALSE(a.overlaps(faabb(fvec3(0, 0, -3), fvec3(1, 1, -1))));
+
+	EXPECT_TRUE(a.contains(fvec3(1, 2, 0)));
+	EXPECT_FALSE(a.contains(fvec3(1, 2.1f, 0)));
+	EXPECT_TRUE(a.contains(faabb(fvec3(0.5f), fvec3(1.5f))));
+	EXPECT_FALSE(a.contains(faabb(fvec3(0.5f), fvec3(2.5f))));
+}
+
+TEST(faabb, SurfaceArea)
+{
+	faabb box(fvec3(0, 0, 0), fvec3(1, 2, 3));
+
+	EXPECT_EQ(box.surfacearea(), 22);
+	EXPECT_EQ(box.volume(), 6);
+}
+
+TEST(faabb, Transform)
+{
+	faabb box(fvec3(-1, 0, 2), fvec3(3, 1, 4));
+	fmat4 transform = fmat4::translate(fvec3(5, -2, 1)) * fmat4::rotate(fvec3(1, 2, 3), 0.7f) * fmat4::scale(fvec3(2, 1, 0.5f));
+
+	expectnear(box.transformed(transform), bruteforcetransform(box, transform), 1e-4f);
+	EXPECT_TRUE(faabb().transformed(transform).empty());
+}
+
+TEST(faabb, Bounds)
+{
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<f32> dist(-10, 10);
+
+	fvec3 points[23];
+	faabb expected;
+	for (fvec3& p : points)
+	{
+		p.set(dist(rng), dist(rng), dist(rng));
+		expected.expand(p);
+	}
+
+	for (size_t count : { 0, 1, 3, 4, 23 })
+	{
+		faabb reference;
+		for (size_t i = 0; i < count; i++)
+		{
+			reference.expand(points[i]);
+		}
+
+		faabb box = bounds(points, count);
+
+		EXPECT_EQ(box.empty(), count == 0);
+		if (count > 0)
+			expectnear(box, reference, 0.0f);
+	}
+
+	// Positions of an interleaved vertex buffer
+	f32 vertices[23][5];
+	for (s32 i = 0; i < 23; i++)
+	{
+		vertices[i][0] = points[i].x;
+		vertices[i][1] = points[i].y;
+		vertices[i][2] = points[i].z;
+		vertices[i][3] = 100.0f;
+		vertices[i][4] = -100.0f;
+	}
+
+	expectnear(bounds(strided_span<fvec3>(vertices, 23, sizeof(vertices[0]))), expected, 0.0f);
+}
+
+TEST(faabb, TransformBoxes)
+{
+	std::mt19937 rng(2);
+	std::uniform_real_distribution<f32> dist(-10, 10);
+	fmat4 transform = fmat4::translate(fvec3(1, 2, 3)) * fmat4::rotate(fvec3(0, 1, 1), 1.3f);
+
+	faabb boxes[9];
+	for (faabb& box : boxes)
+	{
+		box = faabb(fvec3(dist(rng), dist(rng), dist(rng)));
+		box.expand(fvec3(dist(rng), dist(rng), dist(rng)));
+	}
+	boxes[4] = faabb();
+
+	faabb res[9];
+	transformboxes(boxes, res, 9, transform);
+
+	for (s32 i = 0; i < 9; i++)
+	{
+		if (i == 4)
+		{
+			EXPECT_TRUE(res[i].empty());
+			continue;
+		}
+
+		expectnear(res[i], bruteforcetransform(boxes[i], transform), 1e-4f);
+	}
+}
+
+TEST(daabb, OverlapsContains)
+{
+	daabb a(dvec3(0, 0, 0), dvec3(2, 2, 2));
+
+	EXPECT_TRUE(a.overlaps(daabb(dvec3(1, 1, 1), dvec3(3, 3, 3))));
+	EXPECT_FALSE(a.overlaps(daabb(dvec3(0, 0, -3), dvec3(1, 1, -1))));
+	EXPECT_TRUE(a.contains(dvec3(1, 2, 0)));
+	EXPECT_FALSE(a.contains(daabb(dvec3(0.5), dvec3(2.5))));
+	EXPECT_EQ(a.surfacearea(), 24);
+}
+
+TEST(daabb, Transform)
+{
+	daabb box(dvec3(-1, 0, 2), dvec3(3, 1, 4));
+	dmat4 transform = dmat4::translate(dvec3(5, -2, 1)) * dmat4::rotate(dvec3(1, 2, 3), 0.7) * dmat4::scale(dvec3(2, 1, 0.5));
+
+	expectnear(box.transformed(transform), bruteforcetransform(box, transform), 1e-10);
+
+	daabb boxes[3] = { box, daabb(), box };
+	transformboxes(boxes, boxes, 3, transform);
+
+	expectnear(boxes[2], bruteforcetransform(box, transform), 1e-10);
+	EXPECT_TRUE(boxes[1].empty());
+
+	dvec3 points[5] = { dvec3(1, 2, 3), dvec3(-1, 5, 0), dvec3(0, 0, 9), dvec3(2, -2, 2), dvec3(0, 0, 0) };
+	daabb b = bounds(points, 5);
+
+	EXPECT_EQ(b.min, dvec3(-1, -2, 0));
+	EXPECT_EQ(b.max, dvec3(2, 5, 9));
+}
+
+// SPHERE TESTS
+
+static std::vector<fvec3> spherecloud(std::mt19937& rng, s32 kind, size_t count)
+{
+	std::uniform_real_distribution<f32> unit(-1.0f, 1.0f);
+	std::normal_distribution<f32> normal(0.0f, 1.0f);
+	std::vector<fvec3> points(count);
+
+	for (fvec3& p : points)
+	{
+		if (kind == 0)
+			p = fvec3(unit(rng), unit(rng) * 0.5f, unit(rng) * 0.2f) + fvec3(3, -1, 2);
+		else if (kind == 1)
+			p = fvec3(normal(rng), normal(rng), normal(rng));
+		else
+			p = fvec3::normalize(fvec3(normal(rng), normal(rng), normal(rng))) * fvec3(3, 1, 0.5f);
+	}
+
+	return points;
+}
+
+static f32 farthestdistance(const std::vector<fvec3>& points, const fvec3& center)
+{
+	f32 res = 0.0f;
+	for (const fvec3& p : points)
+	{
+		res = std::max(res, (p - center).length());
+	}
+
+	return res;
+}
+
+TEST(fsphere, ExpandMerge)
+{
+	fsphere s;
+	s.expand(fvec3(1, 2, 3));
+	EXPECT_EQ(s, fsphere(fvec3(1, 2, 3), 0));
+
+	s.expand(fvec3(3, 2, 3));
+	EXPECT_EQ(s, fsphere(fvec3(2, 2, 3), 1));
+
+	s.expand(fvec3(2, 2.5f, 3));
+	EXPECT_EQ(s, fsphere(fvec3(2, 2, 3), 1));
+
+	// The grown sphere still holds the old one
+	fsphere old = s;
+	s.expand(fvec3(2, 6, 3));
+	EXPECT_FLOAT_EQ(s.radius, 2.5f);
+	EXPECT_TRUE(s.contains(fvec3(2, 1, 3)));
+	EXPECT_LE((old.center() - s.center()).length() + old.radius, s.radius + 1e-6f);
+
+	fsphere a(fvec3(0, 0, 0), 1), b(fvec3(4, 0, 0), 2);
+	fsphere merged = fsphere::merge(a, b);
+	EXPECT_EQ(merged, fsphere(fvec3(2.5f, 0, 0), 3.5f));
+	EXPECT_EQ(fsphere::merge(merged, a), merged);
+	EXPECT_EQ(fsphere::merge(a, merged), merged);
+	EXPECT_EQ(fsphere::merge(fsphere(), a), a);
+	EXPECT_EQ(fsphere::merge(a, fsphere()), a);
+}
+
+TEST(fsphere, BoundingSphere)
+{
+	std::mt19937 rng(41);
+
+	for (s32 kind = 0; kind < 3; kind++)
+	{
+		std::vector<fvec3> points = spherecloud(rng, kind, 20001);
+
+		fsphere exact = minimalsphere(points.data(), points.size());
+		fsphere single = minimalsphere(points.data(), points.size(), 1);
+		fsphere approximate = boundingsphere(points.data(), points.size());
+		fsphere ritter = boundingsphere(points.data(), points.size(), 0);
+
+		EXPECT_LE(farthestdistance(points, exact.center()), exact.radius * 1.00001f);
+		EXPECT_LE(farthestdistance(points, approximate.center()), approximate.radius * 1.00001f);
+		EXPECT_LE(farthestdistance(points, ritter.center()), ritter.radius * 1.00001f);
+
+		EXPECT_NEAR(single.radius, exact.radius, exact.radius * 1e-5f);
+		EXPECT_LE(exact.radius, approximate.radius * 1.00001f);
+		EXPECT_LE(approximate.radius, ritter.radius);
+		EXPECT_LT(approximate.radius, exact.radius * 1.05f);
+		EXPECT_LT(ritter.radius, exact.radius * 1.2f);
+
+		// Moving the center anywhere cannot shrink the farthest distance of the minimal sphere
+		std::uniform_real_distribution<f32> unit(-1.0f, 1.0f);
+		for (s32 i = 0; i < 100; i++)
+		{
+			fvec3 offset = fvec3::normalize(fvec3(unit(rng), unit(rng), unit(rng))) * (exact.radius * 1e-3f);
+
+			EXPECT_GE(farthestdistance(points, exact.center() + offset), exact.radius * 0.99999f);
+		}
+	}
+
+	EXPECT_TRUE(boundingsphere<f32>(nullptr, 0).empty());
+	EXPECT_TRUE(minimalsphere<f32>(nullptr, 0).empty());
+}
+
+TEST(fsphere, MinimalSphereDegenerate)
+{
+	// Regular tetrahedron with points inside, the circumsphere is the answer
+	std::vector<fvec3> points = { fvec3(1, 1, 1), fvec3(1, -1, -1), fvec3(-1, 1, -1), fvec3(-1, -1, 1) };
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<f32> unit(-0.5f, 0.5f);
+
+	for (s32 i = 0; i < 100; i++)
+	{
+		points.push_back(fvec3(unit(rng), unit(rng), unit(rng)));
+	}
+
+	fsphere s = minimalsphere(points.data(), points.size());
+	EXPECT_LT(s.center().length(), 1e-5f);
+	EXPECT_NEAR(s.radius, std::sqrt(3.0f), 1e-5f);
+
+	// Coplanar points on a circle, collinear points and repeated points
+	std::vector<fvec3> circle;
+	for (s32 i = 0; i < 37; i++)
+	{
+		f32 angle = static_cast<f32>(i) * 0.1745329f;
+		circle.push_back(fvec3(std::cos(angle) * 2.0f, 1.0f, std::sin(angle) * 2.0f));
+	}
+
+	s = minimalsphere(circle.data(), circle.size());
+	EXPECT_NEAR(s.radius, 2.0f, 1e-5f);
+	EXPECT_NEAR(s.y, 1.0f, 1e-5f);
+
+	std::vector<fvec3> line = { fvec3(0, 0, 0), fvec3(1, 1, 1), fvec3(-3, -3, -3), fvec3(0.5f, 0.5f, 0.5f) };
+	s = minimalsphere(line.data(), line.size());
+	EXPECT_NEAR(s.radius, std::sqrt(3.0f) * 2.0f, 1e-5f);
+
+	std::vector<fvec3> repeated(50, fvec3(1, 2, 3));
+	s = minimalsphere(repeated.data(), repeated.size());
+	EXPECT_EQ(s, fsphere(fvec3(1, 2, 3), 0));
+	EXPECT_EQ(boundingsphere(repeated.data(), repeated.size()), fsphere(fvec3(1, 2, 3), 0));
+}
+
+TEST(dsphere, MinimalSphere)
+{
+	std::vector<dvec3> points = { dvec3(1, 1, 1), dvec3(1, -1, -1), dvec3(-1, 1, -1), dvec3(-1, -1, 1), dvec3(0.2, 0.1, -0.3) };
+
+	dsphere s = minimalsphere(points.data(), points.size());
+	EXPECT_NEAR(s.radius, std::sqrt(3.0), 1e-12);
+	EXPECT_LE(boundingsphere(points.data(), points.size()).radius, std::sqrt(3.0) * 1.2);
+}
+
+// FRUSTUM TESTS
+
+static ffrustum testfrustum()
+{
+	// Camera at the origin looking down -z with a 90 degree field of view
+	fmat4 view = fmat4::view(fvec3(0, 0, 0), fvec3(0, 0, -1), fvec3(0, 1, 0));
+	fmat4 projection = fmat4::perspective(constants::half_pi, 1.0f, 1.0f, 10.0f);
+
+	return ffrustum(projection * view);
+}
+
+TEST(ffrustum, Extraction)
+{
+	ffrustum f = testfrustum();
+
+	for (const fvec4& plane : f.planes)
+	{
+		EXPECT_NEAR(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z, 1.0f, 1e-5f);
+	}
+
+	EXPECT_NEAR(f.distance(ffrustum::nearplane, fvec3(0, 0, -3)), 2.0f, 1e-5f);
+	EXPECT_NEAR(f.distance(ffrustum::farplane, fvec3(0, 0, -3)), 7.0f, 1e-5f);
+
+	EXPECT_TRUE(f.contains(fvec3(0, 0, -5)));
+	EXPECT_TRUE(f.contains(fvec3(4.9f, -4.9f, -5)));
+	EXPECT_FALSE(f.contains(fvec3(5.1f, 0, -5)));
+	EXPECT_FALSE(f.contains(fvec3(0, 5.1f, -5)));
+	EXPECT_FALSE(f.contains(fvec3(0, 0, 5)));
+	EXPECT_FALSE(f.contains(fvec3(0, 0, -0.5f)));
+	EXPECT_FALSE(f.contains(fvec3(0, 0, -10.5f)));
+}
+
+TEST(ffrustum, NegativeOneToOne)
+{
+	// Right handed projection with depth in [-1, 1], near 1 and far 10
+	fmat4 projection(1);
+	projection.m22 = -11.0f / 9.0f;
+	projection.m32 = -20.0f / 9.0f;
+	projection.m23 = -1;
+	projection.m33 = 0;
+
+	ffrustum f(projection, false);
+
+	EXPECT_NEAR(f.distance(ffrustum::nearplane, fvec3(0, 0, -3)), 2.0f, 1e-5f);
+	EXPECT_NEAR(f.distance(ffrustum::farplane, fvec3(0, 0, -3)), 7.0f, 1e-5f);
+}
+
+TEST(ffrustum, Intersects)
+{
+	ffrustum f = testfrustum();
+
+	EXPECT_TRUE(f.intersects(fsphere(fvec3(6, 0, -5), 1.0f)));
+	EXPECT_FALSE(f.intersects(fsphere(fvec3(6, 0, -5), 0.5f)));
+	EXPECT_TRUE(f.intersects(fsphere(fvec3(0, 0, 0), 1.5f)));
+	EXPECT_FALSE(f.intersects(fsphere()));
+
+	EXPECT_TRUE(f.intersects(faabb(fvec3(5.5f, -1, -6), fvec3(6, 1, -5.8f))));
+	EXPECT_FALSE(f.intersects(faabb(fvec3(5.5f, -1, -5), fvec3(6, 1, -4))));
+	EXPECT_TRUE(f.intersects(faabb(fvec3(-100), fvec3(100))));
+	EXPECT_FALSE(f.intersects(faabb()));
+}
+
+template<typename T>
+static void expectculling(const frustum<T>& f, const std::vector<sphere<T>>& spheres, const std::vector<aabb<T>>& boxes)
+{
+	size_t count = spheres.size();
+	std::vector<u32> mask((count + 31) / 32, 0xDEADBEEF);
+	std::vector<u32> indices(count);
+
+	size_t visible = visibilitymask(f, spheres.data(), count, mask.data());
+	size_t compacted = visibleindices(f, spheres.data(), count, indices.data());
+
+	size_t expected = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		bool v = f.intersects(spheres[i]);
+
+		EXPECT_EQ(((mask[i >> 5] >> (i & 31)) & 1) != 0, v);
+		if (v)
+		{
+			EXPECT_EQ(indices[expected++], i);
+		}
+	}
+
+	EXPECT_EQ(visible, expected);
+	EXPECT_EQ(compacted, expected);
+
+	if (count % 32 != 0)
+	{
+		EXPECT_EQ(mask.back() >> (count % 32), 0u);
+	}
+
+	visible = visibilitymask(f, boxes.data(), count, mask.data());
+	compacted = visibleindices(f, boxes.data(), count, indices.data());
+
+	expected = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		bool v = f.intersects(boxes[i]);
+
+		EXPECT_EQ(((mask[i >> 5] >> (i & 31)) & 1) != 0, v);
+		if (v)
+		{
+			EXPECT_EQ(indices[expected++], i);
+		}
+	}
+
+	EXPECT_EQ(visible, expected);
+	EXPECT_EQ(compacted, expected);
+}
+
+TEST(ffrustum, Culling)
+{
+	std::mt19937 rng(3);
+	std::uniform_real_distribution<f32> position(-15, 15);
+	std::uniform_real_distribution<f32> radius(0, 2);
+
+	ffrustum f = testfrustum();
+
+	for (size_t count : { 5, 8, 32, 45, 1003 })
+	{
+		std::vector<fsphere> spheres(count);
+		std::vector<faabb> boxes(count);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			fvec3 c(position(rng), position(rng), position(rng));
+
+			spheres[i] = fsphere(c, radius(rng));
+			boxes[i] = faabb(c - fvec3(radius(rng)), c + fvec3(radius(rng)));
+		}
+
+		spheres[count / 2] = fsphere();
+		boxes[count / 2] = faabb();
+
+		expectculling(f, spheres, boxes);
+	}
+}
+
+TEST(dfrustum, Culling)
+{
+	std::mt19937 rng(4);
+	std::uniform_real_distribution<f64> position(-15, 15);
+
+	dfrustum f(dmat4::perspective(1.2, 1.5, 0.5, 20.0));
+
+	std::vector<dsphere> spheres(37);
+	std::vector<daabb> boxes(37);
+
+	for (size_t i = 0; i < spheres.size(); i++)
+	{
+		dvec3 c(position(rng), position(rng), position(rng));
+
+		spheres[i] = dsphere(c, 1.0);
+		boxes[i] = daabb(c - dvec3(1.0), c + dvec3(1.0));
+	}
+
+	expectculling(f, spheres, boxes);
+}
+
+// RAY TESTS
+
+// Reference slab test, axis parallel rays are resolved by an explicit containment check
+template<typename T>
+static bool referenceslab(const vec3<T>& origin, const vec3<T>& direction, const aabb<T>& box, T& entry, T& exit)
+{
+	entry = 0;
+	exit = std::numeric_limits<T>::infinity();
+
+	for (s32 i = 0; i < 3; i++)
+	{
+		if (direction.v[i] == 0)
+		{
+			if (origin.v[i] < box.min.v[i] || origin.v[i] > box.max.v[i])
+				return false;
+
+			continue;
+		}
+
+		T t1 = (box.min.v[i] - origin.v[i]) / direction.v[i];
+		T t2 = (box.max.v[i] - origin.v[i]) / direction.v[i];
+
+		entry = std::max(entry, std::min(t1, t2));
+		exit = std::min(exit, std::max(t1, t2));
+	}
+
+	return entry <= exit;
+}
+
+TEST(fray, Slab)
+{
+	faabb box(fvec3(1, -1, -1), fvec3(3, 1, 1));
+	f32 entry, exit;
+
+	EXPECT_TRUE(fray(fvec3(0, 0, 0), fvec3(1, 0, 0)).intersects(box, 0, 100, entry, exit));
+	EXPECT_FLOAT_EQ(entry, 1);
+	EXPECT_FLOAT_EQ(exit, 3);
+
+	EXPECT_TRUE(fray(fvec3(5, 0.5f, 0), fvec3(-2, 0, 0)).intersects(box, 0, 100, entry, exit));
+	EXPECT_FLOAT_EQ(entry, 1);
+	EXPECT_FLOAT_EQ(exit, 2);
+
+	// Starting inside clips the entry to tmin, tmax clips the exit
+	EXPECT_TRUE(fray(fvec3(2, 0, 0), fvec3(0, 0, 1)).intersects(box, 0, 0.5f, entry, exit));
+	EXPECT_FLOAT_EQ(entry, 0);
+	EXPECT_FLOAT_EQ(exit, 0.5f);
+
+	EXPECT_FALSE(fray(fvec3(0, 0, 0), fvec3(-1, 0, 0)).intersects(box));
+	EXPECT_FALSE(fray(fvec3(0, 0, 0), fvec3(1, 0, 0)).intersects(box, 0, 0.5f, entry, exit));
+	EXPECT_FALSE(fray(fvec3(0, 2, 0), fvec3(1, 0, 0)).intersects(box));
+	EXPECT_FALSE(fray(fvec3(0, 0, 0), fvec3(1, 0, 0)).intersects(faabb()));
+	EXPECT_EQ(fray(fvec3(1, 2, 3), fvec3(2, 4, 6)).at(0.5f), fvec3(2, 4, 6));
+}
+
+TEST(fray, AxisParallelOnFace)
+{
+	faabb box(fvec3(1, 0, -1), fvec3(2, 1, 1));
+	f32 entry, exit;
+
+	// The ray runs inside the y = min and y = max face planes, 0 * inf must not poison the result
+	EXPECT_TRUE(fray(fvec3(0, 0, 0), fvec3(1, 0, 0)).intersects(box, 0, 100, entry, exit));
+	EXPECT_FLOAT_EQ(entry, 1);
+	EXPECT_FLOAT_EQ(exit, 2);
+
+	EXPECT_TRUE(fray(fvec3(0, 1, 0), fvec3(1, -0.0f, 0)).intersects(box, 0, 100, entry, exit));
+	EXPECT_FLOAT_EQ(entry, 1);
+	EXPECT_FLOAT_EQ(exit, 2);
+
+	EXPECT_TRUE(fray(fvec3(3, 1, 1), fvec3(-1, 0, -0.0f)).intersects(box, 0, 100, entry, exit));
+	EXPECT_FLOAT_EQ(entry, 1);
+	EXPECT_FLOAT_EQ(exit, 2);
+
+	EXPECT_FALSE(fray(fvec3(0, 1.001f, 0), fvec3(1, 0, 0)).intersects(box));
+	EXPECT_FALSE(fray(fvec3(0, -0.001f, 0), fvec3(1, 0, 0)).intersects(box));
+}
+
+TEST(fray, Packets)
+{
+	std::mt19937 rng(5);
+	std::uniform_real_distribution<f32> dist(-4, 4);
+	std::uniform_int_distribution<s32> axis(0, 5);
+
+	for (s32 iteration = 0; iteration < 200; iteration++)
+	{
+		fray rays[8];
+		aabb8 boxes;
+		faabb box[8];
+
+		for (s32 i = 0; i < 8; i++)
+		{
+			fvec3 a(dist(rng), dist(rng), dist(rng)), b(dist(rng), dist(rng), dist(rng));
+			box[i] = faabb(fvec3::min(a, b), fvec3::max(a, b));
+
+			fvec3 direction(dist(rng), dist(rng), dist(rng));
+			fvec3 origin(dist(rng) * 2, dist(rng) * 2, dist(rng) * 2);
+
+			// Make some rays axis parallel and start them on a face plane of box 0
+			s32 a0 = axis(rng);
+			if (a0 < 3)
+			{
+				direction.v[a0] = 0;
+				origin.v[a0] = box[0].min.v[a0];
+			}
+
+			rays[i] = fray(origin, direction);
+			boxes.set(i, box[i]);
+		}
+
+		if (iteration % 10 == 0)
+		{
+			box[3] = faabb();
+			boxes.set(3, box[3]);
+		}
+
+		// One ray against eight boxes
+		__m256 entry8, exit8;
+		u32 mask = intersects(rays[0], boxes, 0.0f, 1000.0f, entry8, exit8);
+
+		alignas(32) f32 entry[8], exit[8];
+		_mm256_store_ps(entry, entry8);
+		_mm256_store_ps(exit, exit8);
+
+		for (s32 i = 0; i < 8; i++)
+		{
+			f32 e, x;
+			bool hit = rays[0].intersects(box[i], 0.0f, 1000.0f, e, x);
+
+			ASSERT_EQ(((mask >> i) & 1) != 0, hit);
+			EXPECT_EQ(boxes.get(i), box[i]);
+
+			if (hit)
+			{
+				EXPECT_EQ(entry[i], e);
+				EXPECT_EQ(exit[i], x);
+			}
+		}
+
+		// Eight rays against one box
+		mask = intersects(ray8(rays), box[0], _mm256_set1_ps(0.0f), _mm256_set1_ps(1000.0f), entry8, exit8);
+
+		_mm256_store_ps(entry, entry8);
+		_mm256_store_ps(exit, exit8);
+
+		for (s32 i = 0; i < 8; i++)
+		{
+			f32 e, x;
+			bool hit = rays[i].intersects(box[0], 0.0f, 1000.0f, e, x);
+
+			f32 re, rx;
+			bool reference = referenceslab(rays[i].origin, rays[i].direction, box[0], re, rx);
+
+			ASSERT_EQ(((mask >> i) & 1) != 0, hit);
+			ASSERT_EQ(hit, reference);
+
+			if (hit)
+			{
+				EXPECT_EQ(entry[i], e);
+				EXPECT_EQ(exit[i], x);
+				EXPECT_NEAR(e, re, 1e-4f * (1 + re));
+			}
+		}
+	}
+}
+
+TEST(dray, Slab)
+{
+	std::mt19937 rng(6);
+	std::uniform_real_distribution<f64> dist(-4, 4);
+
+	for (s32 iteration = 0; iteration < 500; iteration++)
+	{
+		dvec3 a(dist(rng), dist(rng), dist(rng)), b(dist(rng), dist(rng), dist(rng));
+		daabb box(dvec3::min(a, b), dvec3::max(a, b));
+
+		dvec3 direction(dist(rng), dist(rng), dist(rng));
+		dvec3 origin(dist(rng) * 2, dist(rng) * 2, dist(rng) * 2);
+
+		if (iteration % 4 == 0)
+		{
+			direction.v[iteration % 3] = 0;
+			origin.v[iteration % 3] = box.max.v[iteration % 3];
+		}
+
+		f64 e, x, re, rx;
+		bool hit = dray(origin, direction).intersects(box, 0, std::numeric_limits<f64>::infinity(), e, x);
+
+		ASSERT_EQ(hit, referenceslab(origin, direction, box, re, rx));
+
+		if (hit)
+		{
+			EXPECT_NEAR(e, re, 1e-9);
+			EXPECT_NEAR(x, rx, 1e-9);
+		}
+	}
+}
+
+// TRIANGLE TESTS
+
+TEST(triangle, Scalar)
+{
+	fvec3 v0(0, 0, 0), v1(1, 0, 0), v2(0, 1, 0);
+	f32 t, u, v;
+
+	fray r(fvec3(0.25f, 0.5f, 1), fvec3(0, 0, -1));
+
+	EXPECT_TRUE(intersects(r, v0, v1, v2, 10.0f, t, u, v));
+	EXPECT_FLOAT_EQ(t, 1);
+	EXPECT_FLOAT_EQ(u, 0.25f);
+	EXPECT_FLOAT_EQ(v, 0.5f);
+
+	EXPECT_TRUE(intersectswatertight(r, v0, v1, v2, 10.0f, t, u, v));
+	EXPECT_FLOAT_EQ(t, 1);
+	EXPECT_FLOAT_EQ(u, 0.25f);
+	EXPECT_FLOAT_EQ(v, 0.5f);
+
+	// Back faces are hit as well
+	fray back(fvec3(0.25f, 0.25f, -2), fvec3(0, 0, 1));
+
+	EXPECT_TRUE(intersects(back, v0, v1, v2, 10.0f, t, u, v));
+	EXPECT_FLOAT_EQ(t, 2);
+	EXPECT_TRUE(intersectswatertight(back, v0, v1, v2, 10.0f, t, u, v));
+	EXPECT_FLOAT_EQ(t, 2);
+
+	EXPECT_FALSE(intersects(r, v0, v1, v2, 0.5f, t, u, v));
+	EXPECT_FALSE(intersectswatertight(r, v0, v1, v2, 0.5f, t, u, v));
+
+	fray outside(fvec3(0.75f, 0.5f, 1), fvec3(0, 0, -1));
+
+	EXPECT_FALSE(intersects(outside, v0, v1, v2, 10.0f, t, u, v));
+	EXPECT_FALSE(intersectswatertight(outside, v0, v1, v2, 10.0f, t, u, v));
+
+	fray away(fvec3(0.25f, 0.25f, 1), fvec3(0, 0, 1));
+
+	EXPECT_FALSE(intersects(away, v0, v1, v2, 10.0f, t, u, v));
+	EXPECT_FALSE(intersectswatertight(away, v0, v1, v2, 10.0f, t, u, v));
+
+	dray d(dvec3(0.25, 0.5, 1), dvec3(0, 0, -1));
+	f64 dt, du, dv;
+
+	EXPECT_TRUE(intersectswatertight(d, dvec3(0, 0, 0), dvec3(1, 0, 0), dvec3(0, 1, 0), 10.0, dt, du, dv));
+	EXPECT_DOUBLE_EQ(dt, 1);
+	EXPECT_DOUBLE_EQ(du, 0.25);
+}
+
+TEST(triangle, Blocks)
+{
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<f32> dist(-5, 5);
+
+	const size_t count = 37;
+	std::vector<fvec3> soup(count * 3);
+	for (fvec3& p : soup)
+	{
+		p.set(dist(rng), dist(rng), dist(rng) * 0.2f);
+	}
+
+	// The same triangles through an index buffer with the vertices in reverse order
+	std::vector<fvec3> vertices(soup.rbegin(), soup.rend());
+	std::vector<u32> indices(count * 3);
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		indices[i] = static_cast<u32>(soup.size() - 1 - i);
+	}
+
+	std::vector<triangle8> blocks((count + 7) / 8), indexed((count + 7) / 8);
+
+	EXPECT_EQ(packtriangles(soup.data(), count, blocks.data()), blocks.size());
+	EXPECT_EQ(packtriangles(vertices.data(), indices.data(), count, indexed.data()), indexed.size());
+	EXPECT_EQ(blocks.back().index[7], ~0u);
+	EXPECT_EQ(blocks.back().index[4], 36u);
+	EXPECT_EQ(std::memcmp(blocks.data(), indexed.data(), blocks.size() * sizeof(triangle8)), 0);
+
+	s32 hits = 0;
+
+	for (s32 i = 0; i < 500; i++)
+	{
+		fvec3 origin(dist(rng), dist(rng), 10);
+		fvec3 target(dist(rng), dist(rng), dist(rng) * 0.2f);
+		fray r(origin, target - origin);
+
+		// Brute force over the scalar routines
+		trianglehit reference, referencewatertight;
+
+		for (size_t k = 0; k < count; k++)
+		{
+			f32 t, u, v;
+
+			if (intersects(r, soup[k * 3], soup[k * 3 + 1], soup[k * 3 + 2], reference.t, t, u, v))
+			{
+				reference.t = t;
+				reference.u = u;
+				reference.v = v;
+				reference.triangle = static_cast<u32>(k);
+			}
+
+			if (intersectswatertight(r, soup[k * 3], soup[k * 3 + 1], soup[k * 3 + 2], referencewatertight.t, t, u, v))
+			{
+				referencewatertight.t = t;
+				referencewatertight.triangle = static_cast<u32>(k);
+			}
+		}
+
+		trianglehit hit, hitwatertight;
+
+		EXPECT_EQ(intersects(r, blocks.data(), blocks.size(), hit), reference.triangle != ~0u);
+		EXPECT_EQ(intersectswatertight(r, blocks.data(), blocks.size(), hitwatertight), referencewatertight.triangle != ~0u);
+		EXPECT_EQ(occluded(r, blocks.data(), blocks.size(), 1.0f), referencewatertight.t < 1.0f);
+
+		EXPECT_EQ(hit.triangle, reference.triangle);
+		EXPECT_EQ(hitwatertight.triangle, referencewatertight.triangle);
+
+		if (reference.triangle != ~0u)
+		{
+			hits++;
+
+			EXPECT_NEAR(hit.t, reference.t, 1e-5f);
+			EXPECT_NEAR(hit.u, reference.u, 1e-4f);
+			EXPECT_NEAR(hit.v, reference.v, 1e-4f);
+			EXPECT_NEAR(hitwatertight.t, reference.t, 1e-4f);
+			EXPECT_NEAR(hitwatertight.u, reference.u, 1e-3f);
+			EXPECT_NEAR(hitwatertight.v, reference.v, 1e-3f);
+		}
+	}
+
+	EXPECT_GT(hits, 50);
+}
+
+TEST(triangle, Watertight)
+{
+	// 4x4 grid of quads split along the diagonal, rays aimed exactly at shared vertices and edges
+	std::vector<fvec3> vertices;
+	std::vector<u32> indices;
+
+	for (s32 y = 0; y <= 4; y++)
+	{
+		for (s32 x = 0; x <= 4; x++)
+		{
+			vertices.push_back(fvec3(static_cast<f32>(x) * 0.3f, static_cast<f32>(y) * 0.7f, static_cast<f32>(x + y) * 0.1f));
+		}
+	}
+
+	for (u32 y = 0; y < 4; y++)
+	{
+		for (u32 x = 0; x < 4; x++)
+		{
+			u32 i = y * 5 + x;
+			u32 quad[6] = { i, i + 1, i + 6, i, i + 6, i + 5 };
+
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+	}
+
+	std::vector<triangle8> blocks(4);
+	packtriangles(vertices.data(), indices.data(), 32, blocks.data());
+
+	fvec3 origins[3] = { fvec3(0.5f, 1.3f, 5), fvec3(-3, 7, 2), fvec3(0.61f, 1.4f, -4) };
+
+	for (const fvec3& origin : origins)
+	{
+		for (s32 y = 1; y < 4; y++)
+		{
+			for (s32 x = 1; x < 4; x++)
+			{
+				fvec3 vertex = vertices[y * 5 + x];
+				fvec3 right = (vertex + vertices[y * 5 + x + 1]) * 0.5f;
+				fvec3 diagonal = (vertex + vertices[y * 5 + x + 6]) * 0.5f;
+
+				for (const fvec3& target : { vertex, right, diagonal })
+				{
+					trianglehit hit;
+
+					EXPECT_TRUE(intersectswatertight(fray(origin, target - origin), blocks.data(), blocks.size(), hit));
+					EXPECT_NEAR(hit.t, 1.0f, 1e-5f);
+				}
+			}
+		}
+	}
+}
+
+// OBB TESTS
+
+template<typename T>
+static void obbcorners(const obb<T>& box, vec3<T> corners[8])
+{
+	for (s32 corner = 0; corner < 8; corner++)
+	{
+		vec3<T> local((corner & 1) ? box.halfextents.x : -box.halfextents.x, (corner & 2) ? box.halfextents.y : -box.halfextents.y, (corner & 4) ? box.halfextents.z : -box.halfextents.z);
+		corners[corner] = box.toworld(local);
+	}
+}
+
+static fobb randomobb(std::mt19937& rng, f32 spread)
+{
+	std::uniform_real_distribution<f32> unit(-1.0f, 1.0f);
+
+	fvec3 center = fvec3(unit(rng), unit(rng), unit(rng)) * spread;
+	fvec3 halfextents(0.6f + unit(rng) * 0.5f, 0.6f + unit(rng) * 0.5f, 0.6f + unit(rng) * 0.5f);
+	fquat rotation = fquat::axisangle(fvec3::normalize(fvec3(unit(rng), unit(rng), unit(rng))), unit(rng) * 3.0f);
+
+	return fobb(center, halfextents, rotation);
+}
+
+TEST(fobb, ContainsClosestBounds)
+{
+	fobb box(fvec3(1, 2, 3), fvec3(2, 1, 0.5f), fquat::axisangle(fvec3(0, 0, 1), 0.5f * 3.14159265f));
+
+	// A quarter turn around z swaps the x and y extents
+	EXPECT_TRUE(box.contains(fvec3(1.9f, 3.9f, 3.4f)));
+	EXPECT_FALSE(box.contains(fvec3(2.1f, 2, 3)));
+	EXPECT_NEAR(box.closestpoint(fvec3(5, 2, 3)).x, 2.0f, 1e-5f);
+	EXPECT_LT((box.closestpoint(fvec3(1.5f, 2.5f, 3)) - fvec3(1.5f, 2.5f, 3)).length(), 1e-5f);
+	EXPECT_FLOAT_EQ(box.volume(), 8.0f);
+
+	faabb bounds = box.bounds();
+	EXPECT_NEAR(bounds.min.x, 0.0f, 1e-5f);
+	EXPECT_NEAR(bounds.max.y, 4.0f, 1e-5f);
+	EXPECT_NEAR(bounds.max.z, 3.5f, 1e-5f);
+
+	std::mt19937 rng(31);
+	for (s32 i = 0; i < 100; i++)
+	{
+		fobb b = randomobb(rng, 3.0f);
+		fvec3 corners[8];
+		obbcorners(b, corners);
+
+		faabb reference;
+		for (const fvec3& c : corners)
+		{
+			reference.expand(c);
+		}
+
+		expectnear(b.bounds(), reference, 1e-4f);
+	}
+}
+
+TEST(fobb, OverlapsMatchesGjk)
+{
+	std::mt19937 rng(32);
+	s32 overlapping = 0;
+
+	for (s32 i = 0; i < 2000; i++)
+	{
+		fobb a = randomobb(rng, 1.5f), b = randomobb(rng, 1.5f);
+
+		convexbox ca(a.center, a.halfextents, a.rotation()), cb(b.center, b.halfextents, b.rotation());
+		gjkresult distance = gjk(ca, cb);
+
+		// Leave the touching cases to rounding
+		if (distance.intersecting)
+		{
+			if (-epa(ca, cb).distance < 1e-3f)
+				continue;
+		}
+		else if (distance.distance < 1e-3f)
+			continue;
+
+		EXPECT_EQ(a.overlaps(b), distance.intersecting);
+		EXPECT_EQ(b.overlaps(a), distance.intersecting);
+		overlapping += distance.intersecting ? 1 : 0;
+	}
+
+	EXPECT_GT(overlapping, 200);
+
+	// Parallel edges, where every cross product axis degenerates
+	fobb a(fvec3(0.0f), fvec3(1), fquat::identity());
+	EXPECT_TRUE(a.overlaps(fobb(fvec3(1.9f, 1.9f, 0), fvec3(1), fquat::identity())));
+	EXPECT_FALSE(a.overlaps(fobb(fvec3(2.1f, 0, 0), fvec3(1), fquat::identity())));
+	EXPECT_FALSE(a.overlaps(fobb(fvec3(2.5f, 0, 0), fvec3(1), fquat::axisangle(fvec3(0, 1, 0), 0.25f * 3.14159265f))));
+	EXPECT_TRUE(a.overlaps(fobb(fvec3(2.3f, 0, 0), fvec3(1), fquat::axisangle(fvec3(0, 1, 0), 0.25f * 3.14159265f))));
+}
+
+TEST(fobb, Ray)
+{
+	fobb box(fvec3(2, 0, 0), fvec3(1, 0.5f, 0.5f), fquat::axisangle(fvec3(0, 0, 1), 0.5f * 3.14159265f));
+	f32 entry, exit;
+
+	// Rotated a quarter turn the long side lies along y
+	EXPECT_TRUE(box.intersects(fray(fvec3(2, -5, 0), fvec3(0, 1, 0)), 0, 100, entry, exit));
+	EXPECT_NEAR(entry, 4.0f, 1e-5f);
+	EXPECT_NEAR(exit, 6.0f, 1e-5f);
+	EXPECT_FALSE(box.intersects(fray(fvec3(0, 1.2f, 0), fvec3(1, 0, 0))));
+
+	std::mt19937 rng(33);
+	std::uniform_real_distribution<f32> unit(-1.0f, 1.0f);
+	s32 hits = 0;
+
+	for (s32 i = 0; i < 500; i++)
+	{
+		fobb b = randomobb(rng, 1.0f);
+		fvec3 origin = fvec3(unit(rng), unit(rng), unit(rng)) * 4.0f;
+		fray r(origin, fvec3::normalize(b.center + fvec3(unit(rng), unit(rng), unit(rng)) * 1.5f - origin));
+
+		if (b.intersects(r, 0, 100, entry, exit))
+		{
+			hits++;
+
+			EXPECT_TRUE(b.contains(r.at((entry + exit) * 0.5f)));
+			EXPECT_LT((b.closestpoint(r.at(entry)) - r.at(entry)).length(), 1e-4f);
+			EXPECT_LT((b.closestpoint(r.at(exit)) - r.at(exit)).length(), 1e-4f);
+			EXPECT_FALSE(b.contains(r.at(exit + 1e-3f)));
+
+			if (entry > 0)
+			{
+				EXPECT_FALSE(b.contains(r.at(entry - 1e-3f)));
+			}
+		}
+		else
+		{
+			for (s32 s = 0; s <= 400; s++)
+			{
+				EXPECT_FALSE(b.contains(r.at(static_cast<f32>(s) * 0.025f)));
+			}
+		}
+	}
+
+	EXPECT_GT(hits, 150);
+}
+
+TEST(fobb, Transform)
+{
+	fobb box(fvec3(1, -1, 0.5f), fvec3(2, 1, 0.5f), fquat::axisangle(fvec3::normalize(fvec3(1, 2, 3)), 0.7f));
+	fvec3 corners[8];
+	obbcorners(box, corners);
+
+	// Rigid transforms and uniform scale map the box onto the image of its corners
+	fmat4 rigid = fmat4::translate(fvec3(5, -2, 1)) * fmat4::rotate(fvec3(0, 1, 0), 1.3f) * fmat4::scale(fvec3(2));
+	fobb moved = box.transformed(rigid);
+
+	EXPECT_NEAR(moved.volume(), box.volume() * 8.0f, 1e-3f);
+	EXPECT_NEAR(moved.axes.determinant(), 1.0f, 1e-5f);
+
+	for (const fvec3& c : corners)
+	{
+		fvec4 p = rigid * fvec4(c.x, c.y, c.z, 1);
+		fvec3 local = moved.tolocal(fvec3(p.x, p.y, p.z));
+
+		for (s32 i = 0; i < 3; i++)
+		{
+			EXPECT_NEAR(sml::abs(local.v[i]), moved.halfextents.v[i], 1e-4f);
+		}
+	}
+
+	// Non uniform scale shears the box, the result still encloses it
+	fmat4 shear = fmat4::rotate(fvec3(1, 0, 0), 0.4f) * fmat4::scale(fvec3(3, 1, 0.5f));
+	fobb sheared = box.transformed(shear);
+
+	EXPECT_NEAR(sheared.axes.determinant(), 1.0f, 1e-5f);
+
+	for (const fvec3& c : corners)
+	{
+		fvec4 p = shear * fvec4(c.x, c.y, c.z, 1);
+		fvec3 local = sheared.tolocal(fvec3(p.x, p.y, p.z));
+
+		for (s32 i = 0; i < 3; i++)
+		{
+			EXPECT_LE(sml::abs(local.v[i]), sheared.halfextents.v[i] + 1e-4f);
+		}
+	}
+}
+
+TEST(fobb, Fit)
+{
+	std::mt19937 rng(34);
+	std::uniform_real_distribution<f32> unit(-1.0f, 1.0f);
+
+	fobb box(fvec3(3, -2, 1), fvec3(3, 1.5f, 0.5f), fquat::axisangle(fvec3::normalize(fvec3(1, 2, 3)), 0.9f));
+
+	std::vector<fvec3> points(8);
+	obbcorners(box, points.data());
+
+	for (s32 i = 0; i < 2000; i++)
+	{
+		points.push_back(box.toworld(fvec3(unit(rng), unit(rng), unit(rng)) * box.halfextents));
+	}
+
+	fobb fit = fobb::fit(points.data(), points.size());
+
+	EXPECT_NEAR(fit.volume(), box.volume(), box.volume() * 0.1f);
+	EXPECT_LT(fit.volume(), faabb(bounds(points.data(), points.size())).volume() * 0.5f);
+	EXPECT_NEAR(fit.axes.determinant(), 1.0f, 1e-5f);
+	EXPECT_NEAR(sml::abs(fit.axes.col0.dot(box.axes.col0)), 1.0f, 1e-2f);
+
+	for (const fvec3& p : points)
+	{
+		fvec3 local = fit.tolocal(p);
+
+		for (s32 i = 0; i < 3; i++)
+		{
+			EXPECT_LE(sml::abs(local.v[i]), fit.halfextents.v[i] + 1e-4f);
+		}
+	}
+
+	// Axis aligned input keeps the axis aligned box, degenerate input stays finite
+	fvec3 cube[8];
+	obbcorners(fobb(faabb(fvec3(-1, 0, 2), fvec3(3, 1, 4))), cube);
+	EXPECT_NEAR(fobb::fit(cube, 8).volume(), 8.0f, 1e-4f);
+
+	fvec3 single(1, 2, 3);
+	fobb point = fobb::fit(&single, 1);
+	EXPECT_EQ(point.center, single);
+	EXPECT_EQ(point.volume(), 0.0f);
+	EXPECT_EQ(fobb::fit(nullptr, 0).volume(), 0.0f);
+}
+
+TEST(dobb, OverlapsContains)
+{
+	dobb a(dvec3(0.0), dvec3(1, 2, 3), dquat::axisangle(dvec3(0, 0, 1), 0.3));
+	dobb b(dvec3(2.2, 0, 0), dvec3(1), dquat::axisangle(dvec3(1, 0, 0), 0.6));
+
+	EXPECT_TRUE(a.contains(dvec3(0.5, 1.5, 2.5)));
+	EXPECT_FALSE(a.contains(dvec3(0, 0, 3.1)));
+	EXPECT_TRUE(a.overlaps(b));
+	EXPECT_FALSE(a.overlaps(dobb(dvec3(5, 0, 0), dvec3(1), dquat::identity())));
+	EXPECT_TRUE(a.intersects(dray(dvec3(-5, 0, 0), dvec3(1, 0, 0))));
+}
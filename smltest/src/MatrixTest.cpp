@@ -760,6 +760,37 @@ TEST(fmat3, Determinant)
 	EXPECT_EQ(d, 0);
 }
 
+TEST(fmat3, EigenSymmetric)
+{
+	fmat3 m(4, 1, -2, 1, 2, 0.5f, -2, 0.5f, 3);
+	fmat3 vectors;
+	fvec3 values;
+
+	eigensymmetric(m, vectors, values);
+
+	EXPECT_GE(values.x, values.y);
+	EXPECT_GE(values.y, values.z);
+	EXPECT_NEAR(values.x + values.y + values.z, 9.0f, 1e-5f);
+
+	for (s32 i = 0; i < 3; i++)
+	{
+		fvec3 mv = m * vectors.col[i];
+
+		EXPECT_NEAR(vectors.col[i].length(), 1.0f, 1e-5f);
+		EXPECT_NEAR(vectors.col[i].dot(vectors.col[(i + 1) % 3]), 0.0f, 1e-5f);
+
+		for (s32 j = 0; j < 3; j++)
+		{
+			EXPECT_NEAR(mv.v[j], vectors.col[i].v[j] * values.v[i], 1e-4f);
+		}
+	}
+
+	// Diagonal input needs no rotation
+	eigensymmetric(fmat3(1, 0, 0, 0, 3, 0, 0, 0, 2), vectors, values);
+	EXPECT_EQ(values, fvec3(3, 2, 1));
+	EXPECT_EQ(vectors.col0, fvec3(0, 1, 0));
+}
+
 // DMAT3 Tests
 
 TEST(dmat3, DefaultConstructor)
@@ -1491,6 +1522,35 @@ TEST(fmat4, Determinant)
 	EXPECT_EQ(d, -36);
 }
 
+
+TEST(fmat4, Perspective)
+{
+	fmat4 m = fmat4::perspective(constants::half_pi, 2.0f, 1.0f, 10.0f);
+
+	fvec4 a = m * fvec4(2, 1, -1, 1);
+	fvec4 b = m * fvec4(0, 0, -10, 1);
+
+	EXPECT_FLOAT_EQ(a.x / a.w, 1);
+	EXPECT_FLOAT_EQ(a.y / a.w, 1);
+	EXPECT_NEAR(a.z / a.w, 0, 1e-6f);
+	EXPECT_FLOAT_EQ(b.z / b.w, 1);
+}
+
+TEST(fmat4, Ortho)
+{
+	fmat4 m = fmat4::ortho(4.0f, 2.0f, 1.0f, 10.0f);
+
+	fvec4 a = m * fvec4(2, 1, -1, 1);
+	fvec4 b = m * fvec4(-2, -1, -10, 1);
+
+	EXPECT_FLOAT_EQ(a.x, 1);
+	EXPECT_FLOAT_EQ(a.y, 1);
+	EXPECT_NEAR(a.z, 0, 1e-6f);
+	EXPECT_FLOAT_EQ(b.x, -1);
+	EXPECT_FLOAT_EQ(b.z, 1);
+	EXPECT_FLOAT_EQ(b.w, 1);
+}
+
 // DMAT4 Tests
 
 TEST(dmat4, DefaultConstructor)
@@ -1914,4 +1974,460 @@ TEST(dmat4, Determinant)
 	f64 d = m.determinant();
 
 	EXPECT_EQ(d, -36);
-}
\ No newline at end of file
+}
+
+#include <mat.h>
+
+#include <random>
+#include <vector>
+
+// MAT Tests
+
+template<size_t R, size_t C, typename T>
+static mat<R, C, T> randommat(std::mt19937& rng)
+{
+	std::uniform_real_distribution<T> unit(-1, 1);
+	mat<R, C, T> m;
+
+	for (size_t c = 0; c < C; c++)
+	{
+		for (size_t r = 0; r < R; r++)
+		{
+			m(r, c) = unit(rng);
+		}
+	}
+
+	return m;
+}
+
+template<size_t R, size_t K, size_t C, typename T>
+static void expectproduct(const mat<R, K, T>& a, const mat<K, C, T>& b, T tolerance)
+{
+	mat<R, C, T> p = a * b;
+
+	for (size_t r = 0; r < R; r++)
+	{
+		for (size_t c = 0; c < C; c++)
+		{
+			T sum = 0;
+			for (size_t k = 0; k < K; k++)
+			{
+				sum += a(r, k) * b(k, c);
+			}
+
+			EXPECT_NEAR(p(r, c), sum, tolerance);
+		}
+	}
+
+	for (size_t c = 0; c < C; c++)
+	{
+		for (size_t r = R; r < mat<R, C, T>::stride; r++)
+		{
+			EXPECT_EQ(p.column(c)[r], 0);
+		}
+	}
+}
+
+TEST(fmat, Layout)
+{
+	fmat34 m;
+
+	EXPECT_EQ(fmat34::stride, 4u);
+	EXPECT_EQ(fmat66::stride, 8u);
+	EXPECT_EQ(alignof(fmat88), 32u);
+	EXPECT_EQ(m(0, 0), 1);
+	EXPECT_EQ(m(2, 2), 1);
+	EXPECT_EQ(m(2, 3), 0);
+	EXPECT_EQ(m.v[3], 0);
+
+	f32 values[12] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
+	m = fmat34(values);
+	EXPECT_EQ(m(1, 0), 2);
+	EXPECT_EQ(m(0, 3), 10);
+	EXPECT_EQ(m(2, 3), 12);
+	EXPECT_EQ(m.column(1)[3], 0);
+
+	fmat3 m3(1, 2, 3, 4, 5, 6, 7, 8, 10);
+	mat<3, 3, f32> g3(m3);
+	EXPECT_EQ(g3(1, 0), 2);
+	EXPECT_EQ(g3(0, 2), 7);
+	EXPECT_EQ(g3.tomat3(), m3);
+	EXPECT_NEAR(g3.determinant(), m3.determinant(), 1e-5f);
+
+	fmat4 m4 = fmat4::translate(fvec3(1, 2, 3)) * fmat4::rotate(fvec3(0, 1, 0), 0.5f);
+	mat<4, 4, f32> g4(m4);
+	EXPECT_EQ(g4(0, 3), 1);
+	EXPECT_EQ(g4.tomat4(), m4);
+	EXPECT_EQ((g4 * g4).tomat4(), m4 * m4);
+
+	fmat2 m2(1, 2, 3, 4);
+	mat<2, 2, f32> g2(m2);
+	mat<3, 1, f32> g31(fvec3(1, 2, 3));
+	EXPECT_EQ(g2.tomat2(), m2);
+	EXPECT_EQ(g31.tovec3(), fvec3(1, 2, 3));
+	EXPECT_EQ((g4 * mat<4, 1, f32>(fvec4(0, 0, 0, 1))).tovec4(), fvec4(1, 2, 3, 1));
+
+	EXPECT_EQ(fmat34::zero()(0, 0), 0);
+	EXPECT_EQ((m + m)(2, 3), 24);
+	EXPECT_EQ((m - m), fmat34::zero());
+	EXPECT_EQ((2.0f * m)(1, 1), 10);
+	EXPECT_EQ((-m)(1, 1), -5);
+}
+
+TEST(fmat, Multiply)
+{
+	std::mt19937 rng(51);
+
+	expectproduct(randommat<3, 4, f32>(rng), randommat<4, 3, f32>(rng), 1e-5f);
+	expectproduct(randommat<4, 3, f32>(rng), randommat<3, 4, f32>(rng), 1e-5f);
+	expectproduct(randommat<6, 6, f32>(rng), randommat<6, 6, f32>(rng), 1e-5f);
+	expectproduct(randommat<8, 8, f32>(rng), randommat<8, 8, f32>(rng), 1e-5f);
+	expectproduct(randommat<2, 5, f32>(rng), randommat<5, 1, f32>(rng), 1e-5f);
+	expectproduct(randommat<6, 6, f64>(rng), randommat<6, 6, f64>(rng), 1e-12);
+	expectproduct(randommat<8, 3, f64>(rng), randommat<3, 2, f64>(rng), 1e-12);
+
+	fmat66 a = randommat<6, 6, f32>(rng), b = randommat<6, 6, f32>(rng);
+	fmat66 product = a * b;
+	a *= b;
+	EXPECT_EQ(a, product);
+}
+
+TEST(fmat, Transpose)
+{
+	std::mt19937 rng(52);
+	fmat34 m = randommat<3, 4, f32>(rng);
+	fmat43 t = m.transposed();
+
+	for (size_t r = 0; r < 3; r++)
+	{
+		for (size_t c = 0; c < 4; c++)
+		{
+			EXPECT_EQ(t(c, r), m(r, c));
+		}
+	}
+
+	EXPECT_EQ(t.transposed(), m);
+
+	fmat66 s = randommat<6, 6, f32>(rng);
+	fmat66 st = s;
+	st.transpose();
+	EXPECT_EQ(st, s.transposed());
+}
+
+TEST(fmat, Solve)
+{
+	std::mt19937 rng(53);
+
+	fmat66 b = randommat<6, 6, f32>(rng);
+	fmat66 spd = b * b.transposed() + fmat66(6.0f);
+	mat<6, 2, f32> rhs = randommat<6, 2, f32>(rng);
+
+	mat<6, 2, f32> x;
+	ASSERT_TRUE(solve(spd, rhs, x));
+
+	fmat66 l = spd;
+	ASSERT_TRUE(choleskydecompose(l));
+	EXPECT_EQ(l(0, 5), 0);
+
+	mat<6, 2, f32> y = choleskysolve(l, rhs);
+	mat<6, 2, f32> residual = spd * x - rhs;
+	mat<6, 2, f32> choleskyresidual = spd * y - rhs;
+
+	for (size_t c = 0; c < 2; c++)
+	{
+		for (size_t r = 0; r < 6; r++)
+		{
+			EXPECT_NEAR(residual(r, c), 0.0f, 1e-5f);
+			EXPECT_NEAR(choleskyresidual(r, c), 0.0f, 1e-5f);
+		}
+	}
+
+	fmat66 reconstructed = l * l.transposed() - spd;
+	for (size_t i = 0; i < 36; i++)
+	{
+		EXPECT_NEAR(reconstructed(i % 6, i / 6), 0.0f, 1e-5f);
+	}
+
+	// Inverse and determinant against the fixed size matrices
+	fmat4 m4(0, 3, 0, 0, 2, 7, 0, 1, 8, 1, 1, 0, 6, 0, 2, 1);
+	mat<4, 4, f32> g4(m4);
+	EXPECT_NEAR(g4.determinant(), -36.0f, 1e-4f);
+
+	mat<4, 4, f32> identity = g4 * g4.inverted();
+	for (size_t i = 0; i < 16; i++)
+	{
+		EXPECT_NEAR(identity(i % 4, i / 4), (i % 5 == 0) ? 1.0f : 0.0f, 1e-5f);
+	}
+
+	// Singular and indefinite matrices are reported
+	f32 singular[9] = { 1, 2, 3, 2, 4, 6, 0, 1, 1 };
+	mat<3, 3, f32> s(singular);
+	mat<3, 1, f32> sx;
+	EXPECT_FALSE(solve(s, mat<3, 1, f32>(fvec3(1, 2, 3)), sx));
+	EXPECT_EQ(s.determinant(), 0);
+	EXPECT_EQ(s.inverted(), s);
+
+	fmat66 indefinite = spd;
+	indefinite(3, 3) = -1.0f;
+	EXPECT_FALSE(choleskydecompose(indefinite));
+}
+
+TEST(dmat, Solve)
+{
+	std::mt19937 rng(54);
+
+	dmat88 a = randommat<8, 8, f64>(rng) + dmat88(4.0);
+	mat<8, 1, f64> rhs = randommat<8, 1, f64>(rng);
+	mat<8, 1, f64> x;
+
+	ASSERT_TRUE(solve(a, rhs, x));
+
+	mat<8, 1, f64> residual = a * x - rhs;
+	for (size_t r = 0; r < 8; r++)
+	{
+		EXPECT_NEAR(residual(r, 0), 0.0, 1e-12);
+	}
+
+	dmat88 product = a * a.inverted();
+	for (size_t i = 0; i < 64; i++)
+	{
+		EXPECT_NEAR(product(i % 8, i / 8), (i % 9 == 0) ? 1.0 : 0.0, 1e-12);
+	}
+
+	dmat34 affine;
+	affine(0, 3) = 5.0;
+	EXPECT_EQ((affine * mat<4, 1, f64>(dvec4(1, 2, 3, 1)))(0, 0), 6.0);
+}
+
+#include <svd.h>
+
+// SVD Tests
+
+// Random, singular, reflecting and degenerate 3x3 matrices
+template<typename T>
+static std::vector<mat3<T>> svdinputs(std::mt19937& rng)
+{
+	std::uniform_real_distribution<T> unit(-1, 1);
+	std::vector<mat3<T>> res;
+
+	for (s32 i = 0; i < 256; i++)
+	{
+		mat3<T> m(unit(rng), unit(rng), unit(rng), unit(rng), unit(rng), unit(rng), unit(rng), unit(rng), unit(rng));
+
+		switch (i % 6)
+		{
+			case 1: m.col2 = m.col0 * static_cast<T>(0.5) + m.col1 * static_cast<T>(2); break;
+			case 2: m.col1 = m.col0 * unit(rng); m.col2 = m.col0 * unit(rng); break;
+			case 3: m.col0 = -m.col0; break;
+			case 4: m = mat3<T>(unit(rng)); break;
+			case 5: m = mat3<T>(static_cast<T>(0)); break;
+		}
+
+		res.push_back(m);
+	}
+
+	return res;
+}
+
+template<typename T>
+static void expectsvd(const mat3<T>& a, const mat3<T>& u, const vec3<T>& sigma, const mat3<T>& v, T tolerance)
+{
+	mat3<T> scaled = u;
+	scaled.col0 *= sigma.x;
+	scaled.col1 *= sigma.y;
+	scaled.col2 *= sigma.z;
+
+	mat3<T> product = scaled * v.transposed(), uu = u * u.transposed(), vv = v * v.transposed(), identity;
+
+	for (s32 i = 0; i < 3; i++)
+	{
+		for (s32 j = 0; j < 3; j++)
+		{
+			EXPECT_NEAR(product.col[i].v[j], a.col[i].v[j], tolerance);
+			EXPECT_NEAR(uu.col[i].v[j], identity.col[i].v[j], tolerance);
+			EXPECT_NEAR(vv.col[i].v[j], identity.col[i].v[j], tolerance);
+		}
+	}
+
+	EXPECT_NEAR(u.determinant(), static_cast<T>(1), tolerance);
+	EXPECT_NEAR(v.determinant(), static_cast<T>(1), tolerance);
+	EXPECT_GE(sigma.x, sigma.y - tolerance);
+	EXPECT_GE(sigma.y, sml::abs(sigma.z) - tolerance);
+	EXPECT_GE(sigma.y, -tolerance);
+}
+
+TEST(fmat3, SVD)
+{
+	std::mt19937 rng(55);
+
+	for (const fmat3& a : svdinputs<f32>(rng))
+	{
+		fmat3 u, v;
+		fvec3 sigma;
+		svd(a, u, sigma, v);
+
+		expectsvd(a, u, sigma, v, 2e-5f);
+		EXPECT_GE(sigma.z * a.determinant(), -1e-6f);
+	}
+
+	// Already diagonal, the values come out sorted
+	fmat3 u, v;
+	fvec3 sigma;
+	svd(fmat3(1, 0, 0, 0, -3, 0, 0, 0, 2), u, sigma, v);
+
+	EXPECT_NEAR(sigma.x, 3.0f, 1e-6f);
+	EXPECT_NEAR(sigma.y, 2.0f, 1e-6f);
+	EXPECT_NEAR(sigma.z, -1.0f, 1e-6f);
+}
+
+TEST(dmat3, SVD)
+{
+	std::mt19937 rng(56);
+
+	for (const dmat3& a : svdinputs<f64>(rng))
+	{
+		dmat3 u, v;
+		dvec3 sigma;
+		svd(a, u, sigma, v);
+
+		expectsvd(a, u, sigma, v, 1e-12);
+	}
+}
+
+TEST(fmat3, SVDQuaternion)
+{
+	std::mt19937 rng(57);
+
+	for (const fmat3& a : svdinputs<f32>(rng))
+	{
+		fmat3 mu, mv;
+		fquat qu, qv;
+		fvec3 sigma, qsigma;
+		svd(a, mu, sigma, mv);
+		svd(a, qu, qsigma, qv);
+
+		EXPECT_EQ(sigma, qsigma);
+
+		fvec3 p(0.3f, -0.7f, 0.2f);
+		fvec3 pu = qu * p, pv = qv * p, mpu = mu * p, mpv = mv * p;
+
+		for (s32 j = 0; j < 3; j++)
+		{
+			EXPECT_NEAR(pu.v[j], mpu.v[j], 1e-5f);
+			EXPECT_NEAR(pv.v[j], mpv.v[j], 1e-5f);
+		}
+	}
+}
+
+TEST(fmat3, Polar)
+{
+	std::mt19937 rng(58);
+	fmat3 identity;
+
+	for (const fmat3& a : svdinputs<f32>(rng))
+	{
+		fmat3 r, s;
+		polar(a, r, s);
+
+		fmat3 product = r * s, rr = r * r.transposed();
+
+		EXPECT_NEAR(r.determinant(), 1.0f, 2e-5f);
+
+		for (s32 i = 0; i < 3; i++)
+		{
+			for (s32 j = 0; j < 3; j++)
+			{
+				EXPECT_NEAR(product.col[i].v[j], a.col[i].v[j], 2e-5f);
+				EXPECT_NEAR(rr.col[i].v[j], identity.col[i].v[j], 2e-5f);
+				EXPECT_NEAR(s.col[i].v[j], s.col[j].v[i], 2e-5f);
+			}
+		}
+	}
+
+	// A pure rotation is its own rotation factor
+	fquat q = fquat::axisangle(fvec3::normalize(fvec3(1, 2, 3)), 0.7f);
+	fmat3 rotation, scaled, r, s;
+
+	for (s32 i = 0; i < 3; i++)
+	{
+		rotation.col[i] = q * identity.col[i];
+		scaled.col[i] = rotation.col[i] * 2.0f;
+	}
+
+	polar(scaled, r, s);
+
+	for (s32 i = 0; i < 3; i++)
+	{
+		for (s32 j = 0; j < 3; j++)
+		{
+			EXPECT_NEAR(r.col[i].v[j], rotation.col[i].v[j], 1e-5f);
+			EXPECT_NEAR(s.col[i].v[j], i == j ? 2.0f : 0.0f, 1e-5f);
+		}
+	}
+}
+
+TEST(mat3x8, LoadStore)
+{
+	std::mt19937 rng(59);
+
+	std::vector<fmat3> m = svdinputs<f32>(rng), out(16);
+	u32 indices[8] = { 7, 0, 12, 3, 3, 40, 9, 1 };
+	u32 scatter[8] = { 15, 2, 9, 4, 11, 0, 6, 13 };
+
+	mat3x8 consecutive(m.data()), gathered(m.data(), indices);
+	consecutive.store(out.data());
+	gathered.store(out.data() + 8);
+
+	for (s32 i = 0; i < 8; i++)
+	{
+		EXPECT_EQ(consecutive.lane(i), m[i]);
+		EXPECT_EQ(gathered.lane(i), m[indices[i]]);
+		EXPECT_EQ(out[i], m[i]);
+		EXPECT_EQ(out[8 + i], m[indices[i]]);
+	}
+
+	gathered.transposed().store(out.data(), scatter);
+
+	for (s32 i = 0; i < 8; i++)
+	{
+		EXPECT_EQ(out[scatter[i]], m[indices[i]].transposed());
+	}
+}
+
+TEST(mat3x8, SVD)
+{
+	std::mt19937 rng(60);
+
+	std::vector<fmat3> m = svdinputs<f32>(rng);
+
+	for (size_t k = 0; k + 8 <= m.size(); k += 8)
+	{
+		mat3x8 a(&m[k]), u, v, r, s;
+		vec3x8 sigma;
+		svd(a, u, sigma, v);
+		polar(a, r, s);
+
+		for (s32 i = 0; i < 8; i++)
+		{
+			fmat3 su, sv, sr, ss;
+			fvec3 ssigma;
+			svd(m[k + i], su, ssigma, sv);
+			polar(m[k + i], sr, ss);
+
+			expectsvd(m[k + i], u.lane(i), sigma.lane(i), v.lane(i), 2e-5f);
+
+			fvec3 lane = sigma.lane(i);
+			fmat3 product = r.lane(i) * s.lane(i);
+
+			for (s32 j = 0; j < 3; j++)
+			{
+				EXPECT_NEAR(lane.v[j], ssigma.v[j], 1e-5f);
+
+				for (s32 c = 0; c < 3; c++)
+				{
+					EXPECT_NEAR(product.col[c].v[j], m[k + i].col[c].v[j], 2e-5f);
+				}
+			}
+		}
+	}
+}
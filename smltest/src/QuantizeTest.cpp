@@ -0,0 +1,333 @@
+#include <quantize.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+
+using namespace sml;
+
+static fvec3 randomunit(std::mt19937& rng)
+{
+	std::uniform_real_distribution<f32> dist(-1.0f, 1.0f);
+
+	while (true)
+	{
+		fvec3 v(dist(rng), dist(rng), dist(rng));
+		f32 l = v.length();
+
+		if (l > 0.1f && l <= 1.0f)
+			return v / l;
+	}
+}
+
+static f32 angle(const fvec3& a, const fvec3& b)
+{
+	return std::atan2(fvec3::cross(a, b).length(), a.dot(b));
+}
+
+// SNORM / UNORM TESTS
+
+TEST(quantize, Scalar)
+{
+	EXPECT_EQ(quantize<s16>(1.0f), 32767);
+	EXPECT_EQ(quantize<s16>(-1.0f), -32767);
+	EXPECT_EQ(quantize<s16>(-2.0f), -32767);
+	EXPECT_EQ(quantize<s16>(0.0f), 0);
+	EXPECT_EQ(quantize<s8>(0.5f), 64);
+	EXPECT_EQ(quantize<u8>(1.0f), 255);
+	EXPECT_EQ(quantize<u8>(-1.0f), 0);
+	EXPECT_EQ(quantize<u8>(0.5f), 128);
+	EXPECT_EQ(quantize<u16>(2.0f), 65535);
+
+	EXPECT_EQ(dequantize<s16>(32767), 1.0f);
+	EXPECT_EQ(dequantize<s16>(-32768), -1.0f);
+	EXPECT_EQ(dequantize<s8>(-128), -1.0f);
+	EXPECT_EQ(dequantize<u8>(255), 1.0f);
+	EXPECT_EQ(dequantize<u8>(0), 0.0f);
+}
+
+template<typename V, typename S>
+static void testbulk(u32 components)
+{
+	constexpr size_t count = 13;
+	constexpr f32 step = 0.5f / static_cast<f32>(std::numeric_limits<S>::max());
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<f32> dist(-1.2f, 1.2f);
+
+	V src[count];
+	for (size_t i = 0; i < count; i++)
+	{
+		for (u32 c = 0; c < components; c++)
+		{
+			src[i].v[c] = dist(rng);
+		}
+	}
+
+	S packed[count * 4 + 1];
+	packed[count * components] = 0x5A;
+	quantize(src, packed, count);
+
+	// Nothing past the last vector is touched
+	EXPECT_EQ(packed[count * components], 0x5A);
+
+	V dst[count];
+	dequantize(packed, dst, count);
+
+	f32 lower = std::is_signed<S>::value ? -1.0f : 0.0f;
+	for (size_t i = 0; i < count; i++)
+	{
+		for (u32 c = 0; c < components; c++)
+		{
+			EXPECT_EQ(packed[i * components + c], quantize<S>(src[i].v[c]));
+			EXPECT_NEAR(dst[i].v[c], clamp(src[i].v[c], lower, 1.0f), step * 1.001f);
+		}
+
+		for (u32 c = components; c < 4; c++)
+		{
+			EXPECT_EQ(dst[i].v[c], 0);
+		}
+	}
+}
+
+TEST(quantize, Bulk)
+{
+	testbulk<fvec2, s8>(2);
+	testbulk<fvec2, u8>(2);
+	testbulk<fvec2, s16>(2);
+	testbulk<fvec2, u16>(2);
+	testbulk<fvec3, s8>(3);
+	testbulk<fvec3, u8>(3);
+	testbulk<fvec3, s16>(3);
+	testbulk<fvec3, u16>(3);
+	testbulk<fvec4, s8>(4);
+	testbulk<fvec4, u8>(4);
+	testbulk<fvec4, s16>(4);
+	testbulk<fvec4, u16>(4);
+}
+
+// OCTAHEDRAL TESTS
+
+TEST(octahedral, Scalar)
+{
+	fvec3 axes[] = { fvec3(1, 0, 0), fvec3(-1, 0, 0), fvec3(0, 1, 0), fvec3(0, -1, 0), fvec3(0, 0, 1), fvec3(0, 0, -1) };
+
+	for (const fvec3& axis : axes)
+	{
+		fvec2 e = octencode(axis);
+
+		EXPECT_LE(std::abs(e.x), 1.0f);
+		EXPECT_LE(std::abs(e.y), 1.0f);
+		EXPECT_LT(angle(octdecode(e), axis), 1e-6f);
+	}
+
+	std::mt19937 rng(1);
+	for (s32 i = 0; i < 1000; i++)
+	{
+		fvec3 n = randomunit(rng);
+
+		EXPECT_LT(angle(octdecode(octencode(n)), n), 1e-3f);
+	}
+}
+
+TEST(octahedral, Snorm16)
+{
+	constexpr size_t count = 1003;
+	std::mt19937 rng(2);
+
+	std::vector<fvec3> src(count), dst(count);
+	for (fvec3& n : src)
+	{
+		n = randomunit(rng);
+	}
+
+	std::vector<s16> packed(count * 2);
+	octencode(src.data(), packed.data(), count);
+	octdecode(packed.data(), dst.data(), count);
+
+	f32 maxerror = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		maxerror = std::max(maxerror, angle(src[i], dst[i]));
+
+		EXPECT_NEAR(dst[i].length(), 1.0f, 1e-5f);
+		EXPECT_EQ(dst[i].v[3], 0);
+	}
+
+	// 16 bit octahedral normals are accurate to roughly 0.004 degrees
+	EXPECT_LT(maxerror, 1.5e-4f);
+}
+
+TEST(octahedral, Unorm8)
+{
+	constexpr size_t count = 1003;
+	std::mt19937 rng(3);
+
+	std::vector<fvec3> src(count), dst(count);
+	for (fvec3& n : src)
+	{
+		n = randomunit(rng);
+	}
+
+	std::vector<u8> packed(count * 2);
+	octencode(src.data(), packed.data(), count);
+	octdecode(packed.data(), dst.data(), count);
+
+	f32 maxerror = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		maxerror = std::max(maxerror, angle(src[i], dst[i]));
+	}
+
+	EXPECT_LT(maxerror, 0.025f);
+}
+
+// QTANGENT TESTS
+
+TEST(qtangent, Frame)
+{
+	fquat frame = tangentframe(fvec3(0, 0, 1), fvec3(1, 0, 0));
+
+	EXPECT_NEAR(std::abs(frame.w), 1.0f, 1e-6f);
+
+	fvec3 normal;
+	fvec4 tangent;
+	qtangentdecode(qtangent(frame, -1.0f), normal, tangent);
+
+	EXPECT_NEAR(normal.z, 1.0f, 1e-6f);
+	EXPECT_NEAR(tangent.x, 1.0f, 1e-6f);
+	EXPECT_EQ(tangent.w, -1.0f);
+
+	// A half turn about x has w = 0, the bias keeps the reflection sign
+	fquat flipped = qtangent(fquat(1, 0, 0, 0), -1.0f);
+
+	EXPECT_LT(flipped.w, 0.0f);
+	EXPECT_LT(quantize<s16>(flipped.w), 0);
+}
+
+TEST(qtangent, Bulk)
+{
+	constexpr size_t count = 21;
+	std::mt19937 rng(4);
+
+	fvec3 normals[count];
+	fvec4 tangents[count];
+	fquat frames[count];
+	f32 handedness[count];
+
+	for (size_t i = 0; i < count; i++)
+	{
+		normals[i] = randomunit(rng);
+		fvec3 t = randomunit(rng);
+		handedness[i] = (i % 3) == 0 ? -1.0f : 1.0f;
+		frames[i] = tangentframe(normals[i], t);
+
+		t = (t - normals[i] * normals[i].dot(t)).normalized();
+		tangents[i].set(t.x, t.y, t.z, handedness[i]);
+	}
+
+	// Includes frames with w near zero
+	frames[5] = fquat(0.6f, 0.8f, 0, 0);
+	frames[6] = fquat(0, 0.6f, 0.8f, -0.00001f);
+
+	for (size_t i = 5; i < 7; i++)
+	{
+		qtangentdecode(frames[i], normals[i], tangents[i]);
+		tangents[i].w = handedness[i];
+	}
+
+	s16 packed[count * 4];
+	qtangentencode(frames, handedness, packed, count);
+
+	fvec3 decodednormals[count];
+	fvec4 decodedtangents[count];
+	qtangentdecode(packed, decodednormals, decodedtangents, count);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		fquat q = qtangent(frames[i], handedness[i]);
+
+		EXPECT_EQ(packed[4 * i + 0], quantize<s16>(q.x));
+		EXPECT_EQ(packed[4 * i + 3], quantize<s16>(q.w));
+
+		fvec3 tangent(decodedtangents[i].x, decodedtangents[i].y, decodedtangents[i].z);
+
+		EXPECT_LT(angle(decodednormals[i], normals[i]), 1e-3f);
+		EXPECT_LT(angle(tangent, fvec3(tangents[i].x, tangents[i].y, tangents[i].z)), 1e-3f);
+		EXPECT_EQ(decodedtangents[i].w, handedness[i]);
+		EXPECT_EQ(decodednormals[i].v[3], 0);
+	}
+}
+
+// SMALLEST THREE TESTS
+
+// Rotation angle between two quaternions, evaluated in double so it resolves small errors
+template<typename T>
+static f64 rotationangle(const quat<T>& a, const quat<T>& b)
+{
+	f64 ax = a.x, ay = a.y, az = a.z, aw = a.w;
+	f64 bx = b.x, by = b.y, bz = b.z, bw = b.w;
+
+	f64 rw = aw * bw + ax * bx + ay * by + az * bz;
+	f64 rx = aw * bx - bw * ax - (ay * bz - az * by);
+	f64 ry = aw * by - bw * ay - (az * bx - ax * bz);
+	f64 rz = aw * bz - bw * az - (ax * by - ay * bx);
+
+	return 2.0 * std::atan2(std::sqrt(rx * rx + ry * ry + rz * rz), std::abs(rw));
+}
+
+template<typename P, typename T>
+static f64 testsmallestthree(size_t count)
+{
+	std::mt19937 rng(6);
+	std::normal_distribution<T> dist;
+
+	std::vector<quat<T>> src(count), dst(count);
+	for (quat<T>& q : src)
+	{
+		q = quat<T>(dist(rng), dist(rng), dist(rng), dist(rng)).normalized();
+	}
+
+	// Axis aligned, negative and tied components
+	src[0] = quat<T>::identity();
+	src[1] = quat<T>(0, 0, 0, -1);
+	src[2] = quat<T>(0, -1, 0, 0);
+	src[3] = quat<T>(0.5, -0.5, 0.5, -0.5);
+
+	std::vector<P> packed(count);
+	pack(src.data(), packed.data(), count);
+	unpack(packed.data(), dst.data(), count);
+
+	f64 maxerror = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		maxerror = std::max(maxerror, rotationangle(src[i], dst[i]));
+
+		// Matches the scalar conversion
+		quat<T> single = P(src[i]);
+		EXPECT_LT(rotationangle(single, dst[i]), 1e-3);
+	}
+
+	EXPECT_LT(rotationangle(dst[0], quat<T>::identity()), 1e-6);
+	EXPECT_LT(rotationangle(dst[1], quat<T>::identity()), 1e-6);
+
+	return maxerror;
+}
+
+TEST(quat32, SmallestThree)
+{
+	EXPECT_EQ(sizeof(quat32), 4u);
+
+	// 10 bits per component, the bound is 2 * sqrt(3) steps or about 0.27 degrees
+	EXPECT_LT((testsmallestthree<quat32, f32>(1003)), 0.0048);
+	EXPECT_LT((testsmallestthree<quat32, f64>(101)), 0.0048);
+}
+
+TEST(quat48, SmallestThree)
+{
+	EXPECT_EQ(sizeof(quat48), 6u);
+
+	// 15 bits per component, the bound is about 0.009 degrees
+	EXPECT_LT((testsmallestthree<quat48, f32>(1003)), 1.5e-4);
+	EXPECT_LT((testsmallestthree<quat48, f64>(101)), 1.5e-4);
+}
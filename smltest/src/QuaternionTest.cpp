@@ -340,6 +340,28 @@ TEST(fquat, Identity)
 	EXPECT_EQ(q.w, 1);
 }
 
+TEST(fquat, FromMatrix3)
+{
+	// One rotation per branch: positive trace, then x, y or z dominant diagonal
+	fquat rotations[] = {
+		fquat::axisangle(fvec3(1, 2, 3), 0.5),
+		fquat::axisangle(fvec3(1, 0.1, 0.2), 3),
+		fquat::axisangle(fvec3(0.1, 1, 0.2), 3),
+		fquat::axisangle(fvec3(0.1, 0.2, 1), 3)
+	};
+
+	for (const fquat& q : rotations)
+	{
+		fvec3 x = q * fvec3(1, 0, 0);
+		fvec3 y = q * fvec3(0, 1, 0);
+		fvec3 z = q * fvec3(0, 0, 1);
+
+		fquat res = fquat::frommatrix3(fmat3(x.x, x.y, x.z, y.x, y.y, y.z, z.x, z.y, z.z));
+
+		EXPECT_NEAR(std::abs(res.dot(q)), 1, 1e-5);
+	}
+}
+
 // DQUAT Tests
 
 TEST(dquat, DefaultConstructor)
@@ -676,3 +698,25 @@ TEST(dquat, Identity)
 	EXPECT_EQ(q.w, 1);
 }
 
+TEST(dquat, FromMatrix3)
+{
+	// One rotation per branch: positive trace, then x, y or z dominant diagonal
+	dquat rotations[] = {
+		dquat::axisangle(dvec3(1, 2, 3), 0.5),
+		dquat::axisangle(dvec3(1, 0.1, 0.2), 3),
+		dquat::axisangle(dvec3(0.1, 1, 0.2), 3),
+		dquat::axisangle(dvec3(0.1, 0.2, 1), 3)
+	};
+
+	for (const dquat& q : rotations)
+	{
+		dvec3 x = q * dvec3(1, 0, 0);
+		dvec3 y = q * dvec3(0, 1, 0);
+		dvec3 z = q * dvec3(0, 0, 1);
+
+		dquat res = dquat::frommatrix3(dmat3(x.x, x.y, x.z, y.x, y.y, y.z, z.x, z.y, z.z));
+
+		EXPECT_NEAR(std::abs(res.dot(q)), 1, 1e-5);
+	}
+}
+
@@ -0,0 +1,1143 @@
+#include <bvh.h>
+#include <hashgrid.h>
+#include <kdtree.h>
+#include <octree.h>
+#include <morton.h>
+#include <triangle.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace sml;
+
+// BVH TESTS
+
+static std::vector<faabb> randomboxes(size_t count, u32 seed, f32 range = 100.0f, f32 size = 2.0f)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<f32> position(-range, range);
+	std::uniform_real_distribution<f32> extent(0.0f, size);
+
+	std::vector<faabb> boxes(count);
+	for (faabb& box : boxes)
+	{
+		fvec3 c(position(rng), position(rng), position(rng));
+		box = faabb(c, c + fvec3(extent(rng), extent(rng), extent(rng)));
+	}
+
+	return boxes;
+}
+
+// Every primitive is referenced once and every slot bounds what is below it
+static void validate(const bvh& tree, const std::vector<faabb>& boxes)
+{
+	std::vector<u32> seen(boxes.size(), 0);
+
+	for (const bvhnode8& node : tree.nodes)
+	{
+		for (s32 i = 0; i < 8; i++)
+		{
+			if (node.child[i] == ~0u)
+				continue;
+
+			faabb slot = node.bounds.get(i);
+
+			if (node.count[i] > 0)
+			{
+				for (u32 k = node.child[i]; k < node.child[i] + node.count[i]; k++)
+				{
+					seen[tree.indices[k]]++;
+					EXPECT_TRUE(slot.contains(boxes[tree.indices[k]]));
+				}
+			}
+			else
+			{
+				const bvhnode8& child = tree.nodes[node.child[i]];
+
+				for (s32 k = 0; k < 8; k++)
+				{
+					if (child.child[k] != ~0u)
+					{
+						EXPECT_TRUE(slot.contains(child.bounds.get(k)));
+					}
+				}
+			}
+		}
+	}
+
+	for (u32 count : seen)
+	{
+		EXPECT_EQ(count, 1u);
+	}
+}
+
+TEST(bvh, Structure)
+{
+	for (size_t count : { 0, 1, 3, 9, 100, 5000 })
+	{
+		std::vector<faabb> boxes = randomboxes(count, static_cast<u32>(count));
+		bvh tree(boxes.data(), count);
+
+		EXPECT_EQ(tree.indices.size(), count);
+		EXPECT_FALSE(tree.nodes.empty());
+		validate(tree, boxes);
+	}
+
+	// Coincident centroids still split down to small leaves
+	std::vector<faabb> same(100, faabb(fvec3(1, 2, 3), fvec3(2, 3, 4)));
+	bvh tree(same.data(), same.size());
+
+	validate(tree, same);
+
+	for (const bvhnode8& node : tree.nodes)
+	{
+		for (s32 i = 0; i < 8; i++)
+		{
+			EXPECT_LE(node.count[i], 4u);
+		}
+	}
+}
+
+TEST(bvh, DeterministicAcrossThreads)
+{
+	std::vector<faabb> boxes = randomboxes(70000, 11);
+
+	bvhsettings single;
+	single.threads = 1;
+
+	bvhsettings multi;
+	multi.threads = 4;
+
+	bvh a(boxes.data(), boxes.size(), single);
+	bvh b(boxes.data(), boxes.size(), multi);
+
+	ASSERT_EQ(a.nodes.size(), b.nodes.size());
+	EXPECT_EQ(std::memcmp(a.nodes.data(), b.nodes.data(), a.nodes.size() * sizeof(bvhnode8)), 0);
+	EXPECT_EQ(a.indices, b.indices);
+	validate(b, boxes);
+}
+
+TEST(bvh, Rays)
+{
+	std::mt19937 rng(12);
+	std::uniform_real_distribution<f32> dist(-50, 50);
+	std::uniform_real_distribution<f32> small(-2, 2);
+
+	const size_t count = 3000;
+	std::vector<fvec3> vertices(count * 3);
+	std::vector<faabb> boxes(count);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		fvec3 c(dist(rng), dist(rng), dist(rng));
+
+		for (s32 k = 0; k < 3; k++)
+		{
+			vertices[i * 3 + k] = c + fvec3(small(rng), small(rng), small(rng));
+			boxes[i].expand(vertices[i * 3 + k]);
+		}
+	}
+
+	bvh tree(boxes.data(), count);
+
+	for (s32 i = 0; i < 300; i++)
+	{
+		fvec3 origin(dist(rng), dist(rng), dist(rng));
+		fray r(origin, fvec3(dist(rng), dist(rng), dist(rng)));
+
+		auto test = [&](u32 primitive, f32 tmax, f32& t)
+		{
+			f32 u, v;
+
+			return intersectswatertight(r, vertices[primitive * 3], vertices[primitive * 3 + 1], vertices[primitive * 3 + 2], tmax, t, u, v);
+		};
+
+		f32 reference = std::numeric_limits<f32>::infinity();
+		u32 referenceprimitive = ~0u;
+
+		for (u32 p = 0; p < count; p++)
+		{
+			f32 t;
+
+			if (test(p, reference, t))
+			{
+				reference = t;
+				referenceprimitive = p;
+			}
+		}
+
+		f32 tmax = std::numeric_limits<f32>::infinity();
+		u32 primitive = ~0u;
+
+		bool hit = tree.closesthit(r, tmax, [&](u32 p, f32& limit)
+		{
+			f32 t;
+
+			if (!test(p, limit, t))
+				return false;
+
+			limit = t;
+			primitive = p;
+
+			return true;
+		});
+
+		EXPECT_EQ(hit, referenceprimitive != ~0u);
+		EXPECT_EQ(primitive, referenceprimitive);
+		EXPECT_EQ(tmax, reference);
+
+		bool any = tree.anyhit(r, std::numeric_limits<f32>::infinity(), [&](u32 p, f32 limit)
+		{
+			f32 t;
+
+			return test(p, limit, t);
+		});
+
+		EXPECT_EQ(any, hit);
+	}
+}
+
+TEST(bvh, OverlapNearest)
+{
+	std::vector<faabb> boxes = randomboxes(4000, 13, 50.0f, 4.0f);
+	bvh tree(boxes.data(), boxes.size());
+
+	std::mt19937 rng(14);
+	std::uniform_real_distribution<f32> dist(-60, 60);
+
+	for (s32 i = 0; i < 200; i++)
+	{
+		fvec3 c(dist(rng), dist(rng), dist(rng));
+		faabb query(c, c + fvec3(5, 3, 8));
+
+		std::vector<u32> found;
+		tree.overlaps(query, [&](u32 p)
+		{
+			if (boxes[p].overlaps(query))
+				found.push_back(p);
+		});
+
+		std::vector<u32> expected;
+		for (u32 p = 0; p < boxes.size(); p++)
+		{
+			if (boxes[p].overlaps(query))
+				expected.push_back(p);
+		}
+
+		std::sort(found.begin(), found.end());
+		EXPECT_EQ(found, expected);
+
+		// Nearest box to a point
+		auto distance = [&](u32 p)
+		{
+			fvec3 d = fvec3::max(fvec3::max(boxes[p].min - c, c - boxes[p].max), fvec3(0.0f));
+
+			return d.lengthsquared();
+		};
+
+		f32 best = std::numeric_limits<f32>::infinity();
+		for (u32 p = 0; p < boxes.size(); p++)
+		{
+			best = std::min(best, distance(p));
+		}
+
+		f32 distancesq = std::numeric_limits<f32>::infinity();
+		u32 nearest = tree.nearest(c, distancesq, distance);
+
+		ASSERT_NE(nearest, ~0u);
+		EXPECT_EQ(distancesq, best);
+		EXPECT_EQ(distance(nearest), best);
+	}
+
+	bvh empty;
+	f32 distancesq = 1.0f;
+
+	EXPECT_FALSE(empty.closesthit(fray(), distancesq, [](u32, f32&) { return true; }));
+	EXPECT_EQ(empty.nearest(fvec3(0.0f), distancesq, [](u32) { return 0.0f; }), ~0u);
+}
+
+// Boxes converging on a point make the SAH peel one box per level, the build has to stay shallow
+// enough for the fixed traversal stack
+TEST(bvh, DegenerateDepth)
+{
+	std::vector<faabb> boxes;
+	for (s32 i = 0; i < 1000; i++)
+	{
+		f32 x = -std::pow(0.92f, static_cast<f32>(i)), h = -x * 0.01f;
+		boxes.push_back(faabb(fvec3(x - h, -h, -h), fvec3(x + h, h, h)));
+	}
+
+	bvh tree(boxes.data(), boxes.size());
+	EXPECT_LE(tree.height, bvh::maxsahdepth + 32);
+
+	fray r(fvec3(-2.0f, 0.0f, 0.0f), fvec3(1.0f, 0.0f, 0.0f));
+	std::vector<u32> hits;
+
+	f32 tmax = std::numeric_limits<f32>::infinity();
+	tree.closesthit(r, tmax, [&](u32 p, f32&)
+	{
+		hits.push_back(p);
+
+		return false;
+	});
+
+	std::vector<u32> found;
+	tree.overlaps(faabb(fvec3(-1.0f), fvec3(1.0f)), [&](u32 p) { found.push_back(p); });
+
+	fvec3 c(-0.5f, 0.0f, 0.0f);
+	auto distance = [&](u32 p)
+	{
+		fvec3 d = fvec3::max(fvec3::max(boxes[p].min - c, c - boxes[p].max), fvec3(0.0f));
+
+		return d.lengthsquared();
+	};
+
+	f32 best = std::numeric_limits<f32>::infinity();
+	for (u32 p = 0; p < boxes.size(); p++)
+	{
+		best = std::min(best, distance(p));
+	}
+
+	f32 distancesq = std::numeric_limits<f32>::infinity();
+	u32 nearest = tree.nearest(c, distancesq, distance);
+
+	EXPECT_EQ(hits.size(), boxes.size());
+	EXPECT_EQ(found.size(), boxes.size());
+	ASSERT_NE(nearest, ~0u);
+	EXPECT_EQ(distancesq, best);
+}
+
+TEST(bvh, Linear)
+{
+	for (size_t count : { 0, 1, 3, 9, 100, 5000 })
+	{
+		std::vector<faabb> boxes = randomboxes(count, static_cast<u32>(count) + 100);
+		bvh tree;
+		tree.buildlinear(boxes.data(), count);
+
+		EXPECT_EQ(tree.indices.size(), count);
+		EXPECT_FALSE(tree.nodes.empty());
+		validate(tree, boxes);
+	}
+
+	std::vector<faabb> same(100, faabb(fvec3(1, 2, 3), fvec3(2, 3, 4)));
+	bvh tree;
+	tree.buildlinear(same.data(), same.size());
+
+	validate(tree, same);
+
+	std::vector<faabb> boxes = randomboxes(70000, 14);
+
+	bvhsettings single;
+	single.threads = 1;
+
+	bvhsettings multi;
+	multi.threads = 4;
+
+	bvh a, b;
+	a.buildlinear(boxes.data(), boxes.size(), single);
+	b.buildlinear(boxes.data(), boxes.size(), multi);
+
+	ASSERT_EQ(a.nodes.size(), b.nodes.size());
+	EXPECT_EQ(std::memcmp(a.nodes.data(), b.nodes.data(), a.nodes.size() * sizeof(bvhnode8)), 0);
+	EXPECT_EQ(a.indices, b.indices);
+	validate(b, boxes);
+
+	// Linear and SAH trees answer queries identically
+	bvh sah(boxes.data(), boxes.size());
+	std::mt19937 rng(15);
+	std::uniform_real_distribution<f32> dist(-100, 100);
+
+	for (s32 i = 0; i < 100; i++)
+	{
+		fvec3 c(dist(rng), dist(rng), dist(rng));
+		faabb region(c, c + fvec3(5.0f));
+
+		std::vector<u32> linear, reference;
+		b.overlaps(region, [&](u32 p) { if (boxes[p].overlaps(region)) linear.push_back(p); });
+		sah.overlaps(region, [&](u32 p) { if (boxes[p].overlaps(region)) reference.push_back(p); });
+
+		std::sort(linear.begin(), linear.end());
+		std::sort(reference.begin(), reference.end());
+
+		EXPECT_EQ(linear, reference);
+	}
+}
+
+// MORTON TESTS
+
+TEST(morton, Encode)
+{
+	EXPECT_EQ(morton30(1, 0, 0), 1u);
+	EXPECT_EQ(morton30(0, 1, 0), 2u);
+	EXPECT_EQ(morton30(0, 0, 1), 4u);
+	EXPECT_EQ(morton30(3, 0, 0), 9u);
+	EXPECT_EQ(morton30(1023, 1023, 1023), 0x3FFFFFFFu);
+	EXPECT_EQ(morton30(1024, 0, 0), 0u);
+	EXPECT_EQ(morton63(0x1FFFFF, 0x1FFFFF, 0x1FFFFF), 0x7FFFFFFFFFFFFFFFull);
+	EXPECT_EQ(morton63(0, 0, 0x100000), 1ull << 62);
+
+	std::mt19937 rng(16);
+
+	for (s32 i = 0; i < 1000; i++)
+	{
+		u32 x = rng() & 0x3FF, y = rng() & 0x3FF, z = rng() & 0x3FF;
+		u32 dx, dy, dz;
+
+		mortondecode30(morton30(x, y, z), dx, dy, dz);
+
+		EXPECT_EQ(dx, x);
+		EXPECT_EQ(dy, y);
+		EXPECT_EQ(dz, z);
+
+		u64 lx = rng() & 0x1FFFFF, ly = rng() & 0x1FFFFF, lz = rng() & 0x1FFFFF;
+		u64 ex, ey, ez;
+
+		mortondecode63(morton63(lx, ly, lz), ex, ey, ez);
+
+		EXPECT_EQ(ex, lx);
+		EXPECT_EQ(ey, ly);
+		EXPECT_EQ(ez, lz);
+	}
+}
+
+TEST(morton, Quantize)
+{
+	faabb bounds(fvec3(-1, 0, 10), fvec3(1, 4, 10));
+
+	EXPECT_EQ(morton30(fvec3(-1, 0, 10), bounds), 0u);
+	EXPECT_EQ(morton30(fvec3(1, 4, 10), bounds), morton30(1023, 1023, 0));
+	EXPECT_EQ(morton30(fvec3(0, 2, 10), bounds), morton30(512, 512, 0));
+	EXPECT_EQ(morton30(fvec3(-5, 100, 3), bounds), morton30(0, 1023, 0));
+	EXPECT_EQ(morton63(fvec3(1, 4, 10), bounds), morton63(0x1FFFFF, 0x1FFFFF, 0));
+
+	daabb dbounds(dvec3(-1, 0, 10), dvec3(1, 4, 10));
+
+	EXPECT_EQ(morton30(dvec3(0, 2, 10), dbounds), morton30(512, 512, 0));
+	EXPECT_EQ(morton63(dvec3(-5, 100, 3), dbounds), morton63(0, 0x1FFFFF, 0));
+}
+
+TEST(morton, RadixSort)
+{
+	std::mt19937_64 rng(17);
+
+	for (size_t count : { 0, 1, 2, 1000, 300000 })
+	{
+		std::vector<u32> keys(count), values(count);
+		std::vector<u64> widekeys(count);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			// Few distinct low digits so stability is visible
+			keys[i] = static_cast<u32>(rng() & 0x3F00FF0F);
+			widekeys[i] = rng();
+			values[i] = static_cast<u32>(i);
+		}
+
+		std::vector<u32> order(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			order[i] = static_cast<u32>(i);
+		}
+
+		std::stable_sort(order.begin(), order.end(), [&](u32 a, u32 b) { return keys[a] < keys[b]; });
+
+		std::vector<u32> sorted = keys, sortedvalues = values;
+		radixsort(sorted.data(), sortedvalues.data(), count, 4);
+
+		EXPECT_EQ(sortedvalues, order);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			order[i] = static_cast<u32>(i);
+		}
+
+		std::stable_sort(order.begin(), order.end(), [&](u32 a, u32 b) { return widekeys[a] < widekeys[b]; });
+
+		std::vector<u64> widesorted = widekeys;
+		std::vector<u32> widevalues = values;
+		radixsort(widesorted.data(), widevalues.data(), count, 3);
+
+		EXPECT_EQ(widevalues, order);
+		EXPECT_TRUE(std::is_sorted(widesorted.begin(), widesorted.end()));
+	}
+}
+
+TEST(bvh, Refit)
+{
+	std::vector<faabb> boxes = randomboxes(20000, 18);
+	bvh tree(boxes.data(), boxes.size());
+
+	std::mt19937 rng(19);
+	std::uniform_real_distribution<f32> step(-3.0f, 3.0f);
+	std::vector<u32> changed;
+
+	for (u32 p = 0; p < boxes.size(); p += 10)
+	{
+		fvec3 d(step(rng), step(rng), step(rng));
+		boxes[p] = faabb(boxes[p].min + d, boxes[p].max + d);
+		changed.push_back(p);
+	}
+
+	bvh full = tree;
+	full.refit(boxes.data());
+
+	bvhsettings multi;
+	multi.threads = 4;
+
+	tree.refit(boxes.data(), changed.data(), changed.size(), multi.threads);
+
+	validate(tree, boxes);
+	ASSERT_EQ(tree.nodes.size(), full.nodes.size());
+	EXPECT_EQ(std::memcmp(tree.nodes.data(), full.nodes.data(), tree.nodes.size() * sizeof(bvhnode8)), 0);
+
+	// Slots are tight after a refit
+	faabb root = tree.nodes[0].bounds.bounds();
+	faabb all;
+
+	for (const faabb& box : boxes)
+	{
+		all.expand(box);
+	}
+
+	EXPECT_EQ(root.min, all.min);
+	EXPECT_EQ(root.max, all.max);
+}
+
+TEST(bvh, Update)
+{
+	std::vector<faabb> boxes = randomboxes(20000, 20);
+	bvh tree(boxes.data(), boxes.size());
+
+	f32 initial = tree.sahcost();
+	EXPECT_GT(initial, 0.0f);
+
+	// Scatter a tenth of the boxes across the scene every frame, which ruins the SAH quickly
+	std::mt19937 rng(21);
+	std::uniform_real_distribution<f32> position(-100.0f, 100.0f);
+	std::uniform_int_distribution<u32> pick(0, static_cast<u32>(boxes.size() - 1));
+	u32 rebuilt = 0;
+
+	for (s32 frame = 0; frame < 5; frame++)
+	{
+		std::vector<u32> changed;
+
+		for (s32 k = 0; k < 2000; k++)
+		{
+			u32 p = pick(rng);
+			fvec3 c(position(rng), position(rng), position(rng));
+
+			boxes[p] = faabb(c, c + boxes[p].max - boxes[p].min);
+			changed.push_back(p);
+		}
+
+		rebuilt += tree.update(boxes.data(), changed.data(), changed.size());
+
+		validate(tree, boxes);
+
+		for (u32 p = 0; p < boxes.size(); p++)
+		{
+			u32 slot = tree.leafslots[p];
+			const bvhnode8& node = tree.nodes[slot >> 3];
+
+			EXPECT_TRUE(node.bounds.get(static_cast<s32>(slot & 7)).contains(boxes[p]));
+		}
+
+		for (u32 n = 1; n < tree.nodes.size(); n++)
+		{
+			u32 parent = tree.parents[n];
+
+			EXPECT_EQ(tree.nodes[parent >> 3].child[parent & 7], n);
+		}
+	}
+
+	EXPECT_GT(rebuilt, 0u);
+	EXPECT_LT(tree.sahcost(), initial * 1.5f);
+
+	// Shuffling boxes inside one subtree keeps its bounds, so only that subtree is rebuilt
+	tree.build(boxes.data(), boxes.size());
+
+	std::vector<u32> inside;
+	std::vector<u32> stack = { tree.subtrees[0] };
+
+	while (!stack.empty())
+	{
+		const bvhnode8& node = tree.nodes[stack.back()];
+		stack.pop_back();
+
+		for (s32 i = 0; i < 8; i++)
+		{
+			if (node.child[i] == ~0u)
+				continue;
+
+			if (node.count[i] == 0)
+				stack.push_back(node.child[i]);
+			else
+				inside.insert(inside.end(), tree.indices.begin() + node.child[i], tree.indices.begin() + node.child[i] + node.count[i]);
+		}
+	}
+
+	f32 built = tree.sahcost();
+	std::vector<faabb> shuffled;
+
+	for (u32 p : inside)
+	{
+		shuffled.push_back(boxes[p]);
+	}
+
+	std::shuffle(shuffled.begin(), shuffled.end(), rng);
+
+	for (size_t k = 0; k < inside.size(); k++)
+	{
+		boxes[inside[k]] = shuffled[k];
+	}
+
+	EXPECT_EQ(tree.update(boxes.data(), inside.data(), inside.size()), 1u);
+	EXPECT_LE(tree.sahcost(), built * 1.01f);
+	validate(tree, boxes);
+
+	// Queries still find exactly the overlapping boxes
+	for (s32 i = 0; i < 50; i++)
+	{
+		fvec3 c(position(rng), position(rng), position(rng));
+		faabb region(c, c + fvec3(10.0f));
+
+		std::vector<u32> found, reference;
+		tree.overlaps(region, [&](u32 p) { if (boxes[p].overlaps(region)) found.push_back(p); });
+
+		for (u32 p = 0; p < boxes.size(); p++)
+		{
+			if (boxes[p].overlaps(region))
+				reference.push_back(p);
+		}
+
+		std::sort(found.begin(), found.end());
+
+		EXPECT_EQ(found, reference);
+	}
+}
+
+// HASH GRID TESTS
+
+static std::vector<fvec3> randompoints(size_t count, u32 seed, f32 range)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<f32> position(-range, range);
+
+	std::vector<fvec3> points(count);
+	for (fvec3& p : points)
+	{
+		p = fvec3(position(rng), position(rng), position(rng));
+	}
+
+	return points;
+}
+
+TEST(hashgrid, Radius)
+{
+	std::vector<fvec3> points = randompoints(5000, 22, 20.0f);
+
+	hashgrid grid(1.5f);
+	grid.build(points.data(), points.size(), 4);
+
+	EXPECT_EQ(grid.size(), points.size());
+
+	std::mt19937 rng(23);
+	std::uniform_real_distribution<f32> position(-25.0f, 25.0f);
+
+	for (s32 i = 0; i < 200; i++)
+	{
+		fvec3 p(position(rng), position(rng), position(rng));
+		f32 radius = i < 100 ? 1.0f : 4.0f;
+
+		std::vector<u32> found, reference;
+		grid.withinradius(p, radius, [&](u32 index, f32 distancesq)
+		{
+			EXPECT_FLOAT_EQ(distancesq, (points[index] - p).lengthsquared());
+			found.push_back(index);
+		});
+
+		for (u32 k = 0; k < points.size(); k++)
+		{
+			if ((points[k] - p).lengthsquared() <= radius * radius)
+				reference.push_back(k);
+		}
+
+		std::sort(found.begin(), found.end());
+
+		EXPECT_EQ(found, reference);
+	}
+}
+
+TEST(hashgrid, Nearest)
+{
+	std::vector<fvec3> points = randompoints(4000, 24, 20.0f);
+
+	hashgrid grid(2.0f);
+	grid.build(points.data(), points.size());
+
+	std::mt19937 rng(25);
+	std::uniform_real_distribution<f32> position(-30.0f, 30.0f);
+
+	for (s32 i = 0; i < 100; i++)
+	{
+		fvec3 p(position(rng), position(rng), position(rng));
+
+		std::vector<f32> reference;
+		for (const fvec3& q : points)
+		{
+			reference.push_back((q - p).lengthsquared());
+		}
+
+		std::sort(reference.begin(), reference.end());
+
+		u32 result[8];
+		f32 distancesq[8];
+
+		ASSERT_EQ(grid.nearest(p, 8, result, distancesq), 8u);
+
+		for (s32 k = 0; k < 8; k++)
+		{
+			EXPECT_EQ(distancesq[k], reference[k]);
+			EXPECT_EQ(distancesq[k], (points[result[k]] - p).lengthsquared());
+		}
+
+		// A distance limit cuts the result short
+		u32 limited = grid.nearest(p, 8, result, distancesq, std::sqrt(reference[2]) + 1e-4f);
+		EXPECT_GE(limited, 3u);
+		EXPECT_LT(limited, 8u);
+	}
+
+	// Asking for more points than exist returns all of them
+	hashgrid small(1.0f);
+	small.build(points.data(), 5);
+
+	u32 result[8];
+	f32 distancesq[8];
+
+	EXPECT_EQ(small.nearest(fvec3(100.0f), 8, result, distancesq), 5u);
+
+	// Far queries start at the occupied cells instead of walking out to them, even past the range of the cell type
+	for (fvec3 p : { fvec3(1e9f, 5.0f, -3.0f), fvec3(-4e9f, 2e9f, 0.0f), fvec3(0.0f, 0.0f, 1e15f) })
+	{
+		f32 closest = std::numeric_limits<f32>::infinity();
+		for (const fvec3& q : points)
+		{
+			closest = std::min(closest, (q - p).lengthsquared());
+		}
+
+		ASSERT_EQ(grid.nearest(p, 1, result, distancesq), 1u);
+		EXPECT_EQ(distancesq[0], closest);
+	}
+}
+
+TEST(hashgrid, Pairs)
+{
+	std::vector<fvec3> points = randompoints(3000, 26, 10.0f);
+
+	hashgrid grid(0.75f);
+	grid.build(points.data(), points.size());
+
+	std::vector<u64> reference;
+
+	for (u32 a = 0; a < points.size(); a++)
+	{
+		for (u32 b = a + 1; b < points.size(); b++)
+		{
+			if ((points[a] - points[b]).lengthsquared() <= 0.75f * 0.75f)
+				reference.push_back((static_cast<u64>(a) << 32) | b);
+		}
+	}
+
+	for (u32 threads : { 1u, 4u })
+	{
+		std::vector<std::vector<u64>> found(threads);
+
+		grid.pairswithin(0.75f, [&](u32 a, u32 b, f32, u32 thread)
+		{
+			found[thread].push_back(a < b ? (static_cast<u64>(a) << 32) | b : (static_cast<u64>(b) << 32) | a);
+		}, threads);
+
+		std::vector<u64> all;
+		for (const std::vector<u64>& f : found)
+		{
+			all.insert(all.end(), f.begin(), f.end());
+		}
+
+		std::sort(all.begin(), all.end());
+
+		EXPECT_EQ(all, reference);
+	}
+
+	// Rebuilding after the points moved sees the new positions
+	for (fvec3& p : points)
+	{
+		p += fvec3(0.1f, -0.2f, 0.05f);
+	}
+
+	grid.build(points.data(), points.size());
+
+	std::vector<u32> found, expected;
+	grid.withinradius(points[0], 1.0f, [&](u32 index, f32) { found.push_back(index); });
+
+	for (u32 k = 0; k < points.size(); k++)
+	{
+		if ((points[k] - points[0]).lengthsquared() <= 1.0f)
+			expected.push_back(k);
+	}
+
+	std::sort(found.begin(), found.end());
+
+	EXPECT_EQ(found, expected);
+}
+
+// KD TREE TESTS
+
+TEST(kdtree, Nearest)
+{
+	std::vector<fvec3> points = randompoints(20000, 30, 50.0f);
+
+	for (u32 threads : { 1u, 4u })
+	{
+		fkdtree tree(12);
+		tree.build(points.data(), points.size(), threads);
+
+		EXPECT_EQ(tree.size(), points.size());
+
+		std::mt19937 rng(31);
+		std::uniform_real_distribution<f32> position(-60.0f, 60.0f);
+
+		for (s32 i = 0; i < 100; i++)
+		{
+			fvec3 p(position(rng), position(rng), position(rng));
+
+			std::vector<f32> reference;
+			for (const fvec3& q : points)
+			{
+				reference.push_back((q - p).lengthsquared());
+			}
+
+			std::sort(reference.begin(), reference.end());
+
+			u32 result[10];
+			f32 distancesq[10];
+
+			ASSERT_EQ(tree.nearest(p, 10, result, distancesq), 10u);
+
+			for (s32 k = 0; k < 10; k++)
+			{
+				EXPECT_EQ(distancesq[k], reference[k]);
+				EXPECT_EQ(distancesq[k], (points[result[k]] - p).lengthsquared());
+			}
+
+			u32 limited = tree.nearest(p, 10, result, distancesq, std::sqrt(reference[4]) + 1e-3f);
+			EXPECT_GE(limited, 5u);
+			EXPECT_LT(limited, 10u);
+		}
+	}
+
+	// Trees smaller than a leaf and empty trees
+	fkdtree small;
+	small.build(points.data(), 3);
+
+	u32 result[8];
+	f32 distancesq[8];
+
+	EXPECT_EQ(small.nearest(fvec3(0.0f), 8, result, distancesq), 3u);
+
+	small.build(points.data(), 0);
+
+	EXPECT_TRUE(small.empty());
+	EXPECT_EQ(small.nearest(fvec3(0.0f), 8, result, distancesq), 0u);
+}
+
+TEST(kdtree, Radius)
+{
+	std::mt19937_64 rng(32);
+	std::uniform_real_distribution<f64> position(-1000.0, 1000.0);
+
+	// Coordinates that f32 cannot tell apart
+	std::vector<dvec3> points(8000);
+	for (dvec3& p : points)
+	{
+		p = dvec3(position(rng), position(rng), position(rng) * 1e-3 + 1e7);
+	}
+
+	dkdtree tree;
+	tree.build(points.data(), points.size());
+
+	EXPECT_GT(tree.memory(), points.size() * 3 * sizeof(f64));
+
+	for (s32 i = 0; i < 100; i++)
+	{
+		dvec3 p(position(rng), position(rng), 1e7 + 0.25);
+		f64 radius = i < 50 ? 40.0 : 150.0;
+
+		std::vector<u32> found, reference;
+		tree.withinradius(p, radius, [&](u32 index, f64 distancesq)
+		{
+			EXPECT_DOUBLE_EQ(distancesq, (points[index] - p).lengthsquared());
+			found.push_back(index);
+		});
+
+		for (u32 k = 0; k < points.size(); k++)
+		{
+			if ((points[k] - p).lengthsquared() <= radius * radius)
+				reference.push_back(k);
+		}
+
+		std::sort(found.begin(), found.end());
+
+		EXPECT_EQ(found, reference);
+	}
+}
+
+TEST(kdtree, Batched)
+{
+	std::mt19937_64 rng(33);
+	std::uniform_real_distribution<f64> position(-10.0, 10.0);
+
+	std::vector<dvec3> points(5000), queries(300);
+	for (dvec3& p : points)
+	{
+		p = dvec3(position(rng), position(rng), position(rng));
+	}
+
+	for (dvec3& q : queries)
+	{
+		q = dvec3(position(rng), position(rng), position(rng));
+	}
+
+	dkdtree tree(8);
+	tree.build(points.data(), points.size(), 3);
+
+	const u32 k = 6;
+	std::vector<u32> result(queries.size() * k), found(queries.size());
+	std::vector<f64> distancesq(queries.size() * k);
+
+	tree.nearest(queries.data(), queries.size(), k, result.data(), distancesq.data(), found.data(), std::numeric_limits<f64>::infinity(), 4);
+
+	std::vector<size_t> counts(queries.size(), 0);
+
+	tree.withinradius(queries.data(), queries.size(), 1.5, [&](u32 query, u32, f64, u32)
+	{
+		counts[query]++;
+	}, 4);
+
+	for (size_t i = 0; i < queries.size(); i++)
+	{
+		u32 single[k];
+		f64 singledistancesq[k];
+
+		ASSERT_EQ(found[i], tree.nearest(queries[i], k, single, singledistancesq));
+
+		for (u32 j = 0; j < k; j++)
+		{
+			EXPECT_EQ(result[i * k + j], single[j]);
+			EXPECT_EQ(distancesq[i * k + j], singledistancesq[j]);
+		}
+
+		size_t expected = 0;
+		tree.withinradius(queries[i], 1.5, [&](u32, f64) { expected++; });
+
+		EXPECT_EQ(counts[i], expected);
+	}
+}
+
+// OCTREE TESTS
+
+TEST(octree, Build)
+{
+	std::vector<fvec3> points = randompoints(30000, 40, 50.0f);
+
+	// A few duplicates and points outside the world
+	points[10] = points[11];
+	points[12] = fvec3(80.0f, 0.0f, 0.0f);
+
+	for (u32 threads : { 1u, 4u })
+	{
+		foctree tree(faabb(fvec3(-50.0f), fvec3(50.0f)), 8);
+		tree.build(points.data(), points.size(), threads);
+
+		EXPECT_EQ(tree.count(), points.size());
+
+		std::mt19937 rng(41);
+		std::uniform_real_distribution<f32> position(-60.0f, 60.0f);
+
+		for (s32 i = 0; i < 50; i++)
+		{
+			fvec3 c(position(rng), position(rng), position(rng));
+			faabb region(c - fvec3(6.0f), c + fvec3(9.0f));
+
+			std::vector<u32> found, reference;
+			tree.overlapping(region, [&](u32 handle, const faabb& box)
+			{
+				EXPECT_EQ(box, faabb(points[handle]));
+				found.push_back(handle);
+			});
+
+			for (u32 k = 0; k < points.size(); k++)
+			{
+				if (region.contains(points[k]))
+					reference.push_back(k);
+			}
+
+			std::sort(found.begin(), found.end());
+
+			EXPECT_EQ(found, reference);
+		}
+
+		// Removing every point leaves the root alone
+		for (u32 k = 0; k < points.size(); k++)
+		{
+			tree.remove(k);
+		}
+
+		EXPECT_TRUE(tree.empty());
+		EXPECT_EQ(tree.nodecount(), 1u);
+	}
+}
+
+TEST(octree, InsertRemoveUpdate)
+{
+	std::vector<faabb> boxes = randomboxes(5000, 42, 100.0f, 12.0f);
+	std::vector<bool> alive(boxes.size(), true);
+
+	foctree tree(faabb(fvec3(-100.0f), fvec3(100.0f)));
+
+	std::vector<u32> handles;
+	for (const faabb& box : boxes)
+	{
+		handles.push_back(tree.insert(box));
+	}
+
+	std::mt19937 rng(43);
+	std::uniform_int_distribution<u32> pick(0, static_cast<u32>(boxes.size() - 1));
+	std::uniform_real_distribution<f32> offset(-20.0f, 20.0f);
+
+	for (s32 step = 0; step < 2000; step++)
+	{
+		u32 k = pick(rng);
+
+		if (!alive[k])
+		{
+			handles[k] = tree.insert(boxes[k]);
+			alive[k] = true;
+		}
+		else if (step % 3 == 0)
+		{
+			tree.remove(handles[k]);
+			alive[k] = false;
+		}
+		else
+		{
+			fvec3 d(offset(rng), offset(rng), offset(rng));
+
+			boxes[k] = faabb(boxes[k].min + d, boxes[k].max + d);
+			tree.update(handles[k], boxes[k]);
+		}
+	}
+
+	std::vector<std::pair<u32, u32>> owners;
+	for (u32 k = 0; k < boxes.size(); k++)
+	{
+		if (alive[k])
+			owners.emplace_back(handles[k], k);
+	}
+
+	EXPECT_EQ(tree.count(), owners.size());
+
+	std::sort(owners.begin(), owners.end());
+
+	for (s32 i = 0; i < 50; i++)
+	{
+		fvec3 c(offset(rng) * 5.0f, offset(rng) * 5.0f, offset(rng) * 5.0f);
+		faabb region(c - fvec3(15.0f), c + fvec3(15.0f));
+
+		std::vector<u32> found, reference;
+		tree.overlapping(region, [&](u32 handle, const faabb&)
+		{
+			found.push_back(std::lower_bound(owners.begin(), owners.end(), std::make_pair(handle, 0u))->second);
+		});
+
+		for (u32 k = 0; k < boxes.size(); k++)
+		{
+			if (alive[k] && boxes[k].overlaps(region))
+				reference.push_back(k);
+		}
+
+		std::sort(found.begin(), found.end());
+
+		EXPECT_EQ(found, reference);
+	}
+}
+
+TEST(octree, Visible)
+{
+	std::vector<faabb> boxes = randomboxes(4000, 44, 100.0f, 3.0f);
+
+	foctree tree(faabb(fvec3(-100.0f), fvec3(100.0f)));
+
+	for (const faabb& box : boxes)
+	{
+		tree.insert(box);
+	}
+
+	fvec3 eye(0.0f, 0.0f, 60.0f);
+	fmat4 projection = fmat4::perspective(constants::half_pi, 1.0f, 1.0f, 500.0f);
+	ffrustum f(projection * fmat4::view(eye, fvec3(0.0f, 0.0f, 0.0f), fvec3(0.0f, 1.0f, 0.0f)));
+	f32 scale = projectionscale(projection, 1080.0f);
+
+	EXPECT_NEAR(scale, 540.0f, 1e-3f);
+
+	std::vector<u32> all, reference;
+
+	tree.visible(f, eye, scale, 0.0f, [&](u32 handle, const faabb&) { all.push_back(handle); });
+
+	for (u32 k = 0; k < boxes.size(); k++)
+	{
+		if (f.intersects(boxes[k]))
+			reference.push_back(k);
+	}
+
+	std::vector<u32> sorted = all;
+	std::sort(sorted.begin(), sorted.end());
+
+	EXPECT_EQ(sorted, reference);
+
+	// Children are visited near side first, objects of coarser nodes come before those of their
+	// descendants, so only the overall trend is front to back
+	f32 nearhalf = 0.0f, farhalf = 0.0f;
+
+	for (size_t i = 0; i < all.size(); i++)
+	{
+		f32 d = (boxes[all[i]].center() - eye).length();
+
+		(i < all.size() / 2 ? nearhalf : farhalf) += d;
+	}
+
+	EXPECT_LT(nearhalf, farhalf);
+
+	// A large cutoff keeps the close objects and drops distant ones
+	std::vector<u32> coarse;
+	tree.visible(f, eye, scale, 40.0f, [&](u32 handle, const faabb&) { coarse.push_back(handle); });
+
+	EXPECT_LT(coarse.size(), all.size());
+
+	for (u32 k : reference)
+	{
+		f32 d = (boxes[k].center() - eye).length();
+		f32 s = boxes[k].size().x;
+
+		if (d < 20.0f && s > 1.0f)
+		{
+			EXPECT_NE(std::find(coarse.begin(), coarse.end(), k), coarse.end());
+		}
+	}
+}
@@ -0,0 +1,501 @@
+#include <packed.h>
+#include <half.h>
+#include <unaligned.h>
+#include <strided.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+
+using namespace sml;
+
+// PACKED TESTS
+
+TEST(packed_fvec2, Size)
+{
+	EXPECT_EQ(sizeof(packed_fvec2), 8u);
+	EXPECT_EQ(sizeof(packed_dvec2), 16u);
+}
+
+TEST(packed_fvec2, Conversion)
+{
+	packed_fvec2 p(fvec2(1, 2));
+
+	EXPECT_EQ(p.x, 1);
+	EXPECT_EQ(p.y, 2);
+
+	fvec2 v = p;
+
+	EXPECT_EQ(v, fvec2(1, 2));
+	EXPECT_EQ(v.v[2], 0);
+	EXPECT_EQ(v.v[3], 0);
+}
+
+TEST(packed_fvec2, Bulk)
+{
+	fvec2 src[7];
+	for (s32 i = 0; i < 7; i++)
+	{
+		src[i].set(static_cast<f32>(i), static_cast<f32>(i * 10));
+	}
+
+	packed_fvec2 packed[7];
+	pack(src, packed, 7);
+
+	for (s32 i = 0; i < 7; i++)
+	{
+		EXPECT_EQ(packed[i].x, i);
+		EXPECT_EQ(packed[i].y, i * 10);
+	}
+
+	fvec2 dst[7];
+	unpack(packed, dst, 7);
+
+	for (s32 i = 0; i < 7; i++)
+	{
+		EXPECT_EQ(dst[i], src[i]);
+		EXPECT_EQ(dst[i].v[2], 0);
+		EXPECT_EQ(dst[i].v[3], 0);
+	}
+}
+
+TEST(packed_dvec2, Bulk)
+{
+	dvec2 src[5];
+	for (s32 i = 0; i < 5; i++)
+	{
+		src[i].set(static_cast<f64>(i), static_cast<f64>(-i));
+	}
+
+	packed_dvec2 packed[5];
+	pack(src, packed, 5);
+
+	dvec2 dst[5];
+	unpack(packed, dst, 5);
+
+	for (s32 i = 0; i < 5; i++)
+	{
+		EXPECT_EQ(packed[i].x, i);
+		EXPECT_EQ(packed[i].y, -i);
+		EXPECT_EQ(dst[i], src[i]);
+	}
+}
+
+TEST(packed_fvec3, Size)
+{
+	EXPECT_EQ(sizeof(packed_fvec3), 12u);
+	EXPECT_EQ(sizeof(packed_dvec3), 24u);
+}
+
+TEST(packed_fvec3, Conversion)
+{
+	packed_fvec3 p(fvec3(1, 2, 3));
+
+	EXPECT_EQ(p.x, 1);
+	EXPECT_EQ(p.y, 2);
+	EXPECT_EQ(p.z, 3);
+
+	fvec3 v = p;
+
+	EXPECT_EQ(v, fvec3(1, 2, 3));
+	EXPECT_EQ(v.v[3], 0);
+}
+
+TEST(packed_fvec3, Bulk)
+{
+	fvec3 src[11];
+	for (s32 i = 0; i < 11; i++)
+	{
+		src[i].set(static_cast<f32>(i), static_cast<f32>(i * 10), static_cast<f32>(i * 100));
+	}
+
+	packed_fvec3 packed[11];
+	pack(src, packed, 11);
+
+	for (s32 i = 0; i < 11; i++)
+	{
+		EXPECT_EQ(packed[i].x, i);
+		EXPECT_EQ(packed[i].y, i * 10);
+		EXPECT_EQ(packed[i].z, i * 100);
+	}
+
+	fvec3 dst[11];
+	unpack(packed, dst, 11);
+
+	for (s32 i = 0; i < 11; i++)
+	{
+		EXPECT_EQ(dst[i], src[i]);
+		EXPECT_EQ(dst[i].v[3], 0);
+	}
+}
+
+TEST(packed_dvec3, Bulk)
+{
+	dvec3 src[6];
+	for (s32 i = 0; i < 6; i++)
+	{
+		src[i].set(static_cast<f64>(i), static_cast<f64>(i + 1), static_cast<f64>(i + 2));
+	}
+
+	packed_dvec3 packed[6];
+	pack(src, packed, 6);
+
+	dvec3 dst[6];
+	unpack(packed, dst, 6);
+
+	for (s32 i = 0; i < 6; i++)
+	{
+		EXPECT_EQ(packed[i].z, i + 2);
+		EXPECT_EQ(dst[i], src[i]);
+		EXPECT_EQ(dst[i].v[3], 0);
+	}
+}
+
+// HALF TESTS
+
+TEST(half, Conversion)
+{
+	EXPECT_EQ(half(0.0f).bits, 0x0000);
+	EXPECT_EQ(half(-0.0f).bits, 0x8000);
+	EXPECT_EQ(half(1.0f).bits, 0x3C00);
+	EXPECT_EQ(half(-2.0f).bits, 0xC000);
+	EXPECT_EQ(half(0.1f).bits, 0x2E66);
+	EXPECT_EQ(half(65504.0f).bits, 0x7BFF);
+	EXPECT_EQ(half(65520.0f).bits, 0x7C00);
+	EXPECT_EQ(half(std::numeric_limits<f32>::infinity()).bits, 0x7C00);
+	EXPECT_EQ(half(std::ldexp(1.0f, -14)).bits, 0x0400);
+	EXPECT_EQ(half(std::ldexp(1.0f, -24)).bits, 0x0001);
+	EXPECT_EQ(half(std::ldexp(1.0f, -25)).bits, 0x0000);
+	EXPECT_EQ(half(std::ldexp(3.0f, -26)).bits, 0x0001);
+	EXPECT_EQ((half(std::numeric_limits<f32>::quiet_NaN()).bits & 0x7E00), 0x7E00);
+
+	// Ties round to even
+	EXPECT_EQ(half(1.0f + std::ldexp(1.0f, -11)).bits, 0x3C00);
+	EXPECT_EQ(half(1.0f + std::ldexp(3.0f, -11)).bits, 0x3C02);
+
+	EXPECT_EQ(static_cast<f32>(half::frombits(0x3C00)), 1.0f);
+	EXPECT_EQ(static_cast<f32>(half::frombits(0x7BFF)), 65504.0f);
+	EXPECT_EQ(static_cast<f32>(half::frombits(0x0001)), std::ldexp(1.0f, -24));
+	EXPECT_EQ(static_cast<f32>(half::frombits(0x83FF)), -std::ldexp(1023.0f, -24));
+	EXPECT_TRUE(std::isinf(static_cast<f32>(half::frombits(0xFC00))));
+	EXPECT_TRUE(std::isnan(static_cast<f32>(half::frombits(0x7E00))));
+}
+
+TEST(half, RoundTrip)
+{
+	// Every finite half converts to f32 and back unchanged
+	for (u32 bits = 0; bits < 0x10000; bits++)
+	{
+		if ((bits & 0x7C00) == 0x7C00)
+			continue;
+
+		half h = half::frombits(static_cast<u16>(bits));
+
+		EXPECT_EQ(half(static_cast<f32>(h)).bits, bits);
+	}
+}
+
+TEST(hvec2, Bulk)
+{
+	fvec2 src[11];
+	for (s32 i = 0; i < 11; i++)
+	{
+		src[i].set(i * 0.5f, -i * 0.25f);
+	}
+
+	hvec2 packed[11];
+	pack(src, packed, 11);
+
+	EXPECT_EQ(sizeof(hvec2), 4u);
+	for (s32 i = 0; i < 11; i++)
+	{
+		EXPECT_EQ(packed[i].x, half(i * 0.5f));
+		EXPECT_EQ(packed[i].y, half(-i * 0.25f));
+	}
+
+	fvec2 dst[11];
+	unpack(packed, dst, 11);
+
+	for (s32 i = 0; i < 11; i++)
+	{
+		EXPECT_EQ(dst[i], src[i]);
+		EXPECT_EQ(dst[i].v[2], 0);
+		EXPECT_EQ(dst[i].v[3], 0);
+	}
+}
+
+TEST(hvec3, Bulk)
+{
+	fvec3 src[19];
+	for (s32 i = 0; i < 19; i++)
+	{
+		src[i].set(i * 0.5f, -i * 0.25f, i * 2.0f);
+	}
+
+	hvec3 packed[19];
+	pack(src, packed, 19);
+
+	for (s32 i = 0; i < 19; i++)
+	{
+		EXPECT_EQ(packed[i].x, half(i * 0.5f));
+		EXPECT_EQ(packed[i].y, half(-i * 0.25f));
+		EXPECT_EQ(packed[i].z, half(i * 2.0f));
+	}
+
+	fvec3 dst[19];
+	unpack(packed, dst, 19);
+
+	for (s32 i = 0; i < 19; i++)
+	{
+		EXPECT_EQ(dst[i], src[i]);
+		EXPECT_EQ(dst[i].v[3], 0);
+	}
+
+	// Values that need rounding match the scalar conversion
+	fvec3 rounded(0.1f, 1.0f / 3.0f, 1000.7f);
+	hvec3 h = rounded;
+
+	EXPECT_EQ(h.x.bits, 0x2E66);
+	EXPECT_EQ(static_cast<fvec3>(h), fvec3(half(0.1f), half(1.0f / 3.0f), half(1000.7f)));
+}
+
+TEST(hvec4, Bulk)
+{
+	fvec4 src[5];
+	for (s32 i = 0; i < 5; i++)
+	{
+		src[i].set(i * 0.5f, -i * 0.25f, i * 2.0f, 1.0f);
+	}
+
+	hvec4 packed[5];
+	pack(src, packed, 5);
+
+	EXPECT_EQ(sizeof(hvec4), 8u);
+	for (s32 i = 0; i < 5; i++)
+	{
+		EXPECT_EQ(packed[i].w, half(1.0f));
+	}
+
+	fvec4 dst[5];
+	unpack(packed, dst, 5);
+
+	for (s32 i = 0; i < 5; i++)
+	{
+		EXPECT_EQ(dst[i], src[i]);
+	}
+}
+
+// UNALIGNED TESTS
+
+TEST(unaligned, Vec2)
+{
+	alignas(32) f32 buffer[8] = { 0, 1, 2, 0, 0, 0, 0, 0 };
+	unaligned<fvec2> view(buffer + 1);
+
+	fvec2 v = view;
+	EXPECT_EQ(v, fvec2(1, 2));
+	EXPECT_EQ(v.v[2], 0);
+
+	view = fvec2(5, 6);
+	EXPECT_EQ(buffer[0], 0);
+	EXPECT_EQ(buffer[1], 5);
+	EXPECT_EQ(buffer[2], 6);
+	EXPECT_EQ(buffer[3], 0);
+}
+
+TEST(unaligned, Vec3)
+{
+	alignas(32) f32 buffer[8] = { 0, 1, 2, 3, 9, 9, 9, 9 };
+	unaligned<fvec3> view(buffer + 1);
+
+	fvec3 v = view.load();
+	EXPECT_EQ(v, fvec3(1, 2, 3));
+	EXPECT_EQ(v.v[3], 0);
+
+	view.store(fvec3(4, 5, 6));
+	EXPECT_EQ(buffer[0], 0);
+	EXPECT_EQ(buffer[3], 6);
+	EXPECT_EQ(buffer[4], 9);
+
+	alignas(32) f64 dbuffer[8] = { 0, 1, 2, 3, 9, 9, 9, 9 };
+	dvec3 d = loadu<dvec3>(dbuffer + 1);
+	EXPECT_EQ(d, dvec3(1, 2, 3));
+	EXPECT_EQ(d.v[3], 0);
+
+	storeu(dbuffer + 1, dvec3(4, 5, 6));
+	EXPECT_EQ(dbuffer[3], 6);
+	EXPECT_EQ(dbuffer[4], 9);
+}
+
+TEST(unaligned, Vec4)
+{
+	u8 bytes[64] = {};
+	unaligned<fvec4> view(bytes + 3);
+
+	view = fvec4(1, 2, 3, 4);
+	fvec4 v = view;
+	EXPECT_EQ(v, fvec4(1, 2, 3, 4));
+
+	unaligned<dvec4> dview(bytes + 5);
+	dview = dvec4(1, 2, 3, 4);
+	EXPECT_EQ(dview.load(), dvec4(1, 2, 3, 4));
+}
+
+TEST(unaligned, Mat3)
+{
+	f32 buffer[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+	fmat3 m = loadu<fmat3>(buffer + 1);
+	EXPECT_EQ(m, fmat3(1, 2, 3, 4, 5, 6, 7, 8, 9));
+
+	f32 out[10] = {};
+	storeu(out + 1, m);
+	for (s32 i = 1; i < 10; i++)
+	{
+		EXPECT_EQ(out[i], buffer[i]);
+	}
+}
+
+TEST(unaligned, Mat4)
+{
+	u8 bytes[160] = {};
+	unaligned<dmat4> view(bytes + 4);
+
+	dmat4 m(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16);
+	view = m;
+
+	dmat4 r = view;
+	EXPECT_EQ(r, m);
+}
+
+#ifdef SML_DEBUG
+TEST(unaligned, DebugAlignmentAssert)
+{
+	alignas(32) f32 buffer[8] = {};
+
+	EXPECT_DEATH(simd::load(buffer + 1), "");
+}
+#endif
+
+// STRIDED TESTS
+
+struct vertex
+{
+	f32 position[3];
+	f32 normal[3];
+	f32 uv[2];
+};
+
+static void fillvertices(vertex* vertices, s32 count)
+{
+	for (s32 i = 0; i < count; i++)
+	{
+		vertices[i].position[0] = static_cast<f32>(i);
+		vertices[i].position[1] = static_cast<f32>(i * 2);
+		vertices[i].position[2] = static_cast<f32>(-i);
+		vertices[i].normal[0] = static_cast<f32>(i % 3);
+		vertices[i].normal[1] = 1.0f;
+		vertices[i].normal[2] = static_cast<f32>(i % 5);
+		vertices[i].uv[0] = 0.25f;
+		vertices[i].uv[1] = 0.75f;
+	}
+}
+
+TEST(strided_span, Element)
+{
+	vertex vertices[3];
+	fillvertices(vertices, 3);
+
+	strided_span<fvec3> positions(&vertices[0].position, 3, sizeof(vertex));
+	strided_span<fvec2> uvs(&vertices[0].uv, 3, sizeof(vertex));
+
+	EXPECT_EQ(positions.size(), 3u);
+	EXPECT_EQ(positions[2].load(), fvec3(2, 4, -2));
+	EXPECT_EQ(uvs[1].load(), fvec2(0.25f, 0.75f));
+
+	positions[1] = fvec3(7, 8, 9);
+	EXPECT_EQ(vertices[1].position[2], 9);
+	EXPECT_EQ(vertices[1].normal[0], 1);
+}
+
+TEST(strided_span, TransformPositions)
+{
+	const s32 count = 21;
+	vertex vertices[count];
+	fillvertices(vertices, count);
+
+	fmat4 transform = fmat4::translate(fvec3(1, 2, 3)) * fmat4::scale(fvec3(2, 3, 4));
+	transformpositions(strided_span<fvec3>(&vertices[0].position, count, sizeof(vertex)), transform);
+
+	for (s32 i = 0; i < count; i++)
+	{
+		EXPECT_FLOAT_EQ(vertices[i].position[0], i * 2.0f + 1.0f);
+		EXPECT_FLOAT_EQ(vertices[i].position[1], i * 6.0f + 2.0f);
+		EXPECT_FLOAT_EQ(vertices[i].position[2], -i * 4.0f + 3.0f);
+		EXPECT_EQ(vertices[i].normal[1], 1.0f);
+		EXPECT_EQ(vertices[i].uv[0], 0.25f);
+	}
+}
+
+TEST(strided_span, TransformNormals)
+{
+	const s32 count = 19;
+	vertex vertices[count];
+	fillvertices(vertices, count);
+
+	fmat4 transform = fmat4::scale(fvec3(2, 1, 1));
+	transformnormals(strided_span<fvec3>(&vertices[0].normal, count, sizeof(vertex)), transform);
+
+	for (s32 i = 0; i < count; i++)
+	{
+		// Inverse transpose of a non uniform scale divides by the scale
+		fvec3 expected(static_cast<f32>(i % 3) * 0.5f, 1.0f, static_cast<f32>(i % 5));
+		expected.normalize();
+
+		EXPECT_NEAR(vertices[i].normal[0], expected.x, 1e-6f);
+		EXPECT_NEAR(vertices[i].normal[1], expected.y, 1e-6f);
+		EXPECT_NEAR(vertices[i].normal[2], expected.z, 1e-6f);
+		EXPECT_EQ(vertices[i].position[0], i);
+		EXPECT_EQ(vertices[i].uv[0], 0.25f);
+	}
+}
+
+TEST(strided_span, Renormalize)
+{
+	const s32 count = 17;
+	f32 normals[count * 4];
+
+	for (s32 i = 0; i < count; i++)
+	{
+		normals[i * 4 + 0] = static_cast<f32>(i % 16);
+		normals[i * 4 + 1] = 0.0f;
+		normals[i * 4 + 2] = 0.0f;
+		normals[i * 4 + 3] = 42.0f;
+	}
+
+	renormalize(strided_span<fvec3>(normals, count, sizeof(f32) * 4));
+
+	// Zero vectors stay zero in the 8-wide part and in the scalar tail
+	for (s32 i = 0; i < count; i++)
+	{
+		EXPECT_FLOAT_EQ(normals[i * 4 + 0], i % 16 == 0 ? 0.0f : 1.0f);
+		EXPECT_EQ(normals[i * 4 + 3], 42.0f);
+	}
+}
+
+TEST(strided_span, TransformPositionsDouble)
+{
+	f64 positions[5 * 3];
+	for (s32 i = 0; i < 15; i++)
+	{
+		positions[i] = static_cast<f64>(i);
+	}
+
+	transformpositions(strided_span<dvec3>(positions, 5, sizeof(f64) * 3), dmat4::translate(dvec3(1, 1, 1)));
+
+	for (s32 i = 0; i < 15; i++)
+	{
+		EXPECT_EQ(positions[i], i + 1);
+	}
+}
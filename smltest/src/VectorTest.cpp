@@ -371,6 +371,21 @@ TEST(fvec2, NegateOperator)
 	EXPECT_EQ(v.y, -5);
 }
 
+TEST(fvec2, Swizzle)
+{
+	fvec2 v(1, 2);
+	fvec2 r = v.swizzle<1, 0>();
+
+	EXPECT_EQ(r.x, 2);
+	EXPECT_EQ(r.y, 1);
+	EXPECT_EQ(r.v[2], 0);
+	EXPECT_EQ(r.v[3], 0);
+
+	EXPECT_EQ(v.yx(), fvec2(2, 1));
+	EXPECT_EQ(v.xx(), fvec2(1, 1));
+	EXPECT_EQ(v.yy(), fvec2(2, 2));
+}
+
 // DVEC2 TESTS
 
 TEST(dvec2, DefaultConstructor)
@@ -738,6 +753,21 @@ TEST(dvec2, NegateOperator)
 	EXPECT_EQ(v.y, -5);
 }
 
+TEST(dvec2, Swizzle)
+{
+	dvec2 v(1, 2);
+	dvec2 r = v.swizzle<1, 0>();
+
+	EXPECT_EQ(r.x, 2);
+	EXPECT_EQ(r.y, 1);
+	EXPECT_EQ(r.v[2], 0);
+	EXPECT_EQ(r.v[3], 0);
+
+	EXPECT_EQ(v.yx(), dvec2(2, 1));
+	EXPECT_EQ(v.xx(), dvec2(1, 1));
+	EXPECT_EQ(v.yy(), dvec2(2, 2));
+}
+
 #include "vec3.h"
 
 // FVEC3 TESTS
@@ -1137,6 +1167,36 @@ TEST(fvec3, NegateOperator)
 	EXPECT_EQ(v.z, -2);
 }
 
+TEST(fvec3, Swizzle)
+{
+	fvec3 v(1, 2, 3);
+	fvec3 r = v.swizzle<2, 0, 1>();
+
+	EXPECT_EQ(r.x, 3);
+	EXPECT_EQ(r.y, 1);
+	EXPECT_EQ(r.z, 2);
+	EXPECT_EQ(r.v[3], 0);
+
+	EXPECT_EQ(v.zyx(), fvec3(3, 2, 1));
+	EXPECT_EQ(v.yzx(), fvec3(2, 3, 1));
+	EXPECT_EQ(v.xzy(), fvec3(1, 3, 2));
+	EXPECT_EQ(v.yyy(), fvec3(2, 2, 2));
+}
+
+TEST(fvec3, Cross)
+{
+	fvec3 a(1, 2, 3);
+	fvec3 b(4, 5, 6);
+	fvec3 c = fvec3::cross(a, b);
+
+	EXPECT_EQ(c.x, -3);
+	EXPECT_EQ(c.y, 6);
+	EXPECT_EQ(c.z, -3);
+	EXPECT_EQ(c.v[3], 0);
+
+	EXPECT_EQ(fvec3::cross(fvec3(1, 0, 0), fvec3(0, 1, 0)), fvec3(0, 0, 1));
+}
+
 // DVEC3 TESTS
 
 TEST(dvec3, DefaultConstructor)
@@ -1534,6 +1594,36 @@ TEST(dvec3, NegateOperator)
 	EXPECT_EQ(v.z, -2);
 }
 
+TEST(dvec3, Swizzle)
+{
+	dvec3 v(1, 2, 3);
+	dvec3 r = v.swizzle<2, 0, 1>();
+
+	EXPECT_EQ(r.x, 3);
+	EXPECT_EQ(r.y, 1);
+	EXPECT_EQ(r.z, 2);
+	EXPECT_EQ(r.v[3], 0);
+
+	EXPECT_EQ(v.zyx(), dvec3(3, 2, 1));
+	EXPECT_EQ(v.yzx(), dvec3(2, 3, 1));
+	EXPECT_EQ(v.xzy(), dvec3(1, 3, 2));
+	EXPECT_EQ(v.yyy(), dvec3(2, 2, 2));
+}
+
+TEST(dvec3, Cross)
+{
+	dvec3 a(1, 2, 3);
+	dvec3 b(4, 5, 6);
+	dvec3 c = dvec3::cross(a, b);
+
+	EXPECT_EQ(c.x, -3);
+	EXPECT_EQ(c.y, 6);
+	EXPECT_EQ(c.z, -3);
+	EXPECT_EQ(c.v[3], 0);
+
+	EXPECT_EQ(dvec3::cross(dvec3(1, 0, 0), dvec3(0, 1, 0)), dvec3(0, 0, 1));
+}
+
 #include "vec4.h"
 
 // FVEC4 TESTS
@@ -1963,6 +2053,21 @@ TEST(fvec4, NegateOperator)
 	EXPECT_EQ(v.w, -1);
 }
 
+TEST(fvec4, Swizzle)
+{
+	fvec4 v(1, 2, 3, 4);
+	fvec4 r = v.swizzle<3, 1, 2, 0>();
+
+	EXPECT_EQ(r.x, 4);
+	EXPECT_EQ(r.y, 2);
+	EXPECT_EQ(r.z, 3);
+	EXPECT_EQ(r.w, 1);
+
+	EXPECT_EQ(v.wzyx(), fvec4(4, 3, 2, 1));
+	EXPECT_EQ(v.yzxw(), fvec4(2, 3, 1, 4));
+	EXPECT_EQ(v.zzzz(), fvec4(3, 3, 3, 3));
+}
+
 // DVEC4 TESTS
 
 TEST(dvec4, DefaultConstructor)
@@ -2388,4 +2493,49 @@ TEST(dvec4, NegateOperator)
 	EXPECT_EQ(v.y, -5);
 	EXPECT_EQ(v.z, -2);
 	EXPECT_EQ(v.w, -1);
-}
\ No newline at end of file
+}
+
+TEST(dvec4, Swizzle)
+{
+	dvec4 v(1, 2, 3, 4);
+	dvec4 r = v.swizzle<3, 1, 2, 0>();
+
+	EXPECT_EQ(r.x, 4);
+	EXPECT_EQ(r.y, 2);
+	EXPECT_EQ(r.z, 3);
+	EXPECT_EQ(r.w, 1);
+
+	EXPECT_EQ(v.wzyx(), dvec4(4, 3, 2, 1));
+	EXPECT_EQ(v.yzxw(), dvec4(2, 3, 1, 4));
+	EXPECT_EQ(v.zzzz(), dvec4(3, 3, 3, 3));
+}
+
+#include "swizzle.h"
+
+// SWIZZLE TESTS
+
+TEST(swizzle, Narrowing)
+{
+	fvec4 v(1, 2, 3, 4);
+
+	fvec3 a = swizzle<3, 2, 1>(v);
+	EXPECT_EQ(a, fvec3(4, 3, 2));
+	EXPECT_EQ(a.v[3], 0);
+
+	dvec2 b = swizzle<3, 0>(dvec4(1, 2, 3, 4));
+	EXPECT_EQ(b, dvec2(4, 1));
+	EXPECT_EQ(b.v[2], 0);
+	EXPECT_EQ(b.v[3], 0);
+}
+
+TEST(swizzle, Widening)
+{
+	fvec4 a = swizzle<0, 1, 0, 1>(fvec2(1, 2));
+	EXPECT_EQ(a, fvec4(1, 2, 1, 2));
+
+	dvec4 b = swizzle<2, 1, 0, 0>(dvec3(1, 2, 3));
+	EXPECT_EQ(b, dvec4(3, 2, 1, 1));
+
+	ivec3 c = swizzle<1, 1, 0>(ivec2(5, 6));
+	EXPECT_EQ(c, ivec3(6, 6, 5));
+}